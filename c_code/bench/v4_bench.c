@@ -0,0 +1,644 @@
+// V4 工具链基准测试：maps 解析、特征码扫描、候选预过滤、候选校验、整库解密
+// 编译命令: gcc v4_bench.c ../linux/proc_maps.c ../common/aes256.c ../common/candidate_filter.c
+//              ../common/derived_keys.c ../common/key_cache.c ../common/log.c
+//              ../common/pattern_scan.c ../common/scan_stats.c ../common/sha1.c ../common/sha512_mb.c
+//              ../common/v3_validate.c ../common/v4_decrypt.c ../common/v4_validate.c -I../common -I../linux -o v4_bench -O3 -pthread
+//
+// 不需要微信进程，也不依赖 OpenSSL：所有输入都由固定种子生成，
+// 同样的参数每次生成完全相同的 maps、内存镜像和数据库，结果可以直接对比。
+// 各阶段分开计时，每个阶段重复 -r 次取最快的一次，结果以 JSON 写到 stdout，
+// 日志写到 stderr。
+//
+// 内存镜像按 -d 指定的密度放置特征码，特征码附近按偏移 -o 放一个随机候选，
+// 其中一处放真正的密钥；-z 指定的比例的 4K 页保持全零，模拟清零的堆内存。
+// 数据库页是随机密文加正确的 HMAC，解密路径与真实数据库完全相同。
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "candidate_filter.h"
+#include "log.h"
+#include "pattern_scan.h"
+#include "proc_maps.h"
+#include "sha512_mb.h"
+#include "v4_decrypt.h"
+#include "v4_validate.h"
+
+#define PAGE_SIZE V4_DECRYPT_PAGE_SIZE
+#define KEY_SIZE V4_DECRYPT_KEY_SIZE
+#define SALT_SIZE V4_DECRYPT_SALT_SIZE
+#define IV_SIZE 16
+#define RESERVE 80
+#define DATA_END (PAGE_SIZE - RESERVE + IV_SIZE)
+#define ITER_COUNT 256000
+
+#define SCAN_MAX_HITS 256
+
+// 与 testkey 工具一致的偏移列表，用于预过滤阶段
+static const int key_offsets[] = {16, -80, 64, -16, 32, -32};
+static const int num_key_offsets = sizeof(key_offsets) / sizeof(key_offsets[0]);
+
+typedef struct {
+    size_t maps_lines;
+    size_t image_mb;
+    double density;       // 每 MB 放置的特征码数
+    int key_offset;       // 密钥相对特征码的偏移
+    int zero_percent;     // 全零页比例
+    size_t candidates;    // 校验阶段的候选数
+    size_t db_pages;
+    int jobs;             // 整库解密的线程数，<= 0 时使用 CPU 数
+    int repeat;
+    uint64_t seed;
+    const char *tmp_dir;
+} bench_options;
+
+// splitmix64，生成可复现的输入
+static uint64_t rng_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void rng_fill(uint64_t *state, unsigned char *buf, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t v = rng_next(state);
+        memcpy(buf + i, &v, 8);
+    }
+    if (i < len) {
+        uint64_t v = rng_next(state);
+        memcpy(buf + i, &v, len - i);
+    }
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double rate(double count, double seconds) {
+    return seconds > 0 ? count / seconds : 0;
+}
+
+/**
+ * 输出 JSON 对象的下一个键，各阶段失败时跳过自己的输出，分隔符由这里统一处理
+ */
+static void json_key(FILE *out, const char *name) {
+    static bool first = true;
+    fprintf(out, "%s\n  \"%s\": ", first ? "" : ",", name);
+    first = false;
+}
+
+static void derive_keys(const unsigned char *key, const unsigned char *salt, unsigned char *enc_key,
+                        unsigned char *mac_key) {
+    unsigned char mac_salt[SALT_SIZE];
+    for (int i = 0; i < SALT_SIZE; i++) {
+        mac_salt[i] = salt[i] ^ 0x3A;
+    }
+    const unsigned char *key_in[1] = {key};
+    const unsigned char *enc_in[1] = {enc_key};
+    unsigned char *enc_out[1] = {enc_key};
+    unsigned char *mac_out[1] = {mac_key};
+    pbkdf2_hmac_sha512_batch(key_in, KEY_SIZE, salt, SALT_SIZE, ITER_COUNT, enc_out, KEY_SIZE, 1);
+    pbkdf2_hmac_sha512_batch(enc_in, KEY_SIZE, mac_salt, SALT_SIZE, 2, mac_out, KEY_SIZE, 1);
+}
+
+/**
+ * 生成一页随机密文并写入正确的 HMAC；第 0 页前 16 字节就是 salt
+ */
+static void make_page(uint64_t *rng, const unsigned char *mac_key, const unsigned char *salt,
+                      uint64_t pgno, unsigned char *page) {
+    rng_fill(rng, page, PAGE_SIZE);
+    size_t offset = 0;
+    if (pgno == 0) {
+        memcpy(page, salt, SALT_SIZE);
+        offset = SALT_SIZE;
+    }
+    uint32_t n = (uint32_t)(pgno + 1);
+    const unsigned char page_no[4] = {n & 0xFF, (n >> 8) & 0xFF, (n >> 16) & 0xFF, n >> 24};
+    hmac_sha512_ctx mac;
+    hmac_sha512_init(&mac, mac_key, KEY_SIZE);
+    hmac_sha512_update(&mac, page + offset, DATA_END - offset);
+    hmac_sha512_update(&mac, page_no, sizeof(page_no));
+    hmac_sha512_final(&mac, page + DATA_END);
+}
+
+/**
+ * 生成 maps 文本：主程序和库的各个段、[heap]、glibc arena、匿名映射、线程栈
+ * @return 行数组，调用方用 free_lines 释放
+ */
+static char **make_maps(size_t lines, uint64_t seed) {
+    static const char *perms[] = {"r--p", "r-xp", "rw-p", "---p"};
+    char **out = calloc(lines, sizeof(char *));
+    if (!out) {
+        return NULL;
+    }
+    uint64_t rng = seed;
+    uint64_t addr = 0x555555554000ULL;
+    for (size_t i = 0; i < lines; i++) {
+        uint64_t r = rng_next(&rng);
+        uint64_t size = ((r >> 8) % 4096 + 1) * 4096;
+        char line[512];
+        switch (r % 8) {
+        case 0:
+            snprintf(line, sizeof(line), "%" PRIx64 "-%" PRIx64 " rw-p 00000000 00:00 0 [heap]",
+                     addr, addr + size);
+            break;
+        case 1:
+            // arena：rw 匿名映射后面紧跟 ---p 预留区
+            snprintf(line, sizeof(line), "%" PRIx64 "-%" PRIx64 " rw-p 00000000 00:00 0", addr,
+                     addr + size);
+            if (i + 1 < lines) {
+                out[i] = strdup(line);
+                addr += size;
+                snprintf(line, sizeof(line), "%" PRIx64 "-%" PRIx64 " ---p 00000000 00:00 0", addr,
+                         addr + (uint64_t)64 * 1024 * 1024 - size);
+                addr += (uint64_t)64 * 1024 * 1024 - size;
+                i++;
+            }
+            break;
+        case 2:
+            snprintf(line, sizeof(line), "%" PRIx64 "-%" PRIx64 " rw-p 00000000 00:00 0 [stack:%zu]",
+                     addr, addr + size, i);
+            break;
+        case 3:
+        case 4:
+            snprintf(line, sizeof(line), "%" PRIx64 "-%" PRIx64 " rw-p 00000000 00:00 0", addr,
+                     addr + size);
+            break;
+        default:
+            snprintf(line, sizeof(line),
+                     "%" PRIx64 "-%" PRIx64 " %s %08" PRIx64 " 08:01 %" PRIu64
+                     " /opt/wechat/lib/libwechat_%zu.so",
+                     addr, addr + size, perms[(r >> 4) % 4], (r >> 20) % 0x100000 * 4096,
+                     (r >> 32) % 1000000, i % 64);
+            break;
+        }
+        out[i] = strdup(line);
+        addr += size;
+    }
+    return out;
+}
+
+static void free_lines(char **lines, size_t n) {
+    if (!lines) {
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        free(lines[i]);
+    }
+    free(lines);
+}
+
+static int bench_maps(const bench_options *opts, FILE *out) {
+    char **lines = make_maps(opts->maps_lines, opts->seed);
+    proc_map_table table = {0};
+    table.items = malloc(opts->maps_lines * sizeof(proc_map_region));
+    if (!lines || !table.items) {
+        free_lines(lines, opts->maps_lines);
+        free(table.items);
+        return -1;
+    }
+    table.cap = opts->maps_lines;
+
+    double best = 0;
+    size_t kept = 0;
+    for (int r = 0; r < opts->repeat; r++) {
+        double t0 = now_sec();
+        table.count = 0;
+        for (size_t i = 0; i < opts->maps_lines; i++) {
+            if (lines[i] && proc_maps_parse_line(lines[i], &table.items[table.count]) == 0) {
+                table.count++;
+            }
+        }
+        proc_maps_rank(&table);
+        double t = now_sec() - t0;
+        if (r == 0 || t < best) {
+            best = t;
+        }
+        kept = table.count;
+    }
+
+    json_key(out, "maps");
+    fprintf(out, "{\"lines\": %zu, \"regions\": %zu, \"seconds\": %.6f, \"lines_per_sec\": %.0f}",
+            opts->maps_lines, kept, best, rate(opts->maps_lines, best));
+    proc_maps_free(&table);
+    free_lines(lines, opts->maps_lines);
+    return 0;
+}
+
+/**
+ * 生成内存镜像并放置特征码和候选
+ * @return 放置的特征码数
+ */
+static size_t make_image(const bench_options *opts, const unsigned char *key, unsigned char *image,
+                         size_t len) {
+    uint64_t rng = opts->seed ^ 0x696D616765ULL;
+    rng_fill(&rng, image, len);
+    for (size_t off = 0; off + PAGE_SIZE <= len; off += PAGE_SIZE) {
+        if ((int)(rng_next(&rng) % 100) < opts->zero_percent) {
+            memset(image + off, 0, PAGE_SIZE);
+        }
+    }
+
+    size_t sites = (size_t)(opts->density * (double)len / (1024 * 1024));
+    if (sites == 0) {
+        sites = 1;
+    }
+    size_t stride = len / sites;
+    size_t margin = 128;
+    size_t planted = 0;
+    for (size_t s = 0; s < sites; s++) {
+        size_t pos = s * stride + margin;
+        if (stride > 2 * margin) {
+            pos += rng_next(&rng) % (stride - 2 * margin);
+        }
+        long key_pos = (long)pos + opts->key_offset;
+        if (key_pos < 0 || (size_t)key_pos + KEY_SIZE > len || pos + PATTERN_SCAN_LEN > len) {
+            continue;
+        }
+        memcpy(image + pos, v4_key_pattern, PATTERN_SCAN_LEN);
+        // 中间那一处放真正的密钥，其余放随机候选
+        if (s == sites / 2) {
+            memcpy(image + key_pos, key, KEY_SIZE);
+        } else {
+            rng_fill(&rng, image + key_pos, KEY_SIZE);
+        }
+        planted++;
+    }
+    return planted;
+}
+
+static int bench_scan(const bench_options *opts, const unsigned char *key, FILE *out) {
+    size_t len = opts->image_mb * 1024 * 1024;
+    unsigned char *image = malloc(len);
+    size_t *hits = malloc(SCAN_MAX_HITS * sizeof(size_t));
+    candidate_filter *filter = malloc(sizeof(candidate_filter));
+    if (!image || !hits || !filter) {
+        free(image);
+        free(hits);
+        free(filter);
+        return -1;
+    }
+    size_t planted = make_image(opts, key, image, len);
+
+    // 特征码扫描
+    double best = 0;
+    size_t found = 0;
+    bool key_found = false;
+    for (int r = 0; r < opts->repeat; r++) {
+        double t0 = now_sec();
+        size_t pos = 0, count = 0;
+        while (pos < len) {
+            count += pattern_scan(image, len, pos, v4_key_pattern, hits, SCAN_MAX_HITS, &pos);
+        }
+        double t = now_sec() - t0;
+        if (r == 0 || t < best) {
+            best = t;
+        }
+        found = count;
+    }
+    json_key(out, "scan");
+    fprintf(out,
+            "{\"engine\": \"%s\", \"bytes\": %zu, \"planted\": %zu, \"hits\": %zu, "
+            "\"seconds\": %.6f, \"gb_per_sec\": %.3f}",
+            pattern_scan_engine(), len, planted, found, best, rate(len / 1e9, best));
+
+    // 命中展开成候选并过预过滤，与 testkey 工具的扫描路径一致
+    double fbest = 0;
+    uint64_t seen = 0, passed = 0;
+    for (int r = 0; r < opts->repeat; r++) {
+        candidate_filter_init(filter);
+        double t0 = now_sec();
+        size_t pos = 0;
+        while (pos < len) {
+            size_t n = pattern_scan(image, len, pos, v4_key_pattern, hits, SCAN_MAX_HITS, &pos);
+            for (size_t h = 0; h < n; h++) {
+                for (int j = 0; j < num_key_offsets; j++) {
+                    long key_pos = (long)hits[h] + key_offsets[j];
+                    if (key_pos < 0 || (size_t)key_pos + KEY_SIZE > len) {
+                        continue;
+                    }
+                    const unsigned char *cand = image + key_pos;
+                    if (candidate_filter_accept(filter, cand, j) && memcmp(cand, key, KEY_SIZE) == 0) {
+                        key_found = true;
+                    }
+                }
+            }
+        }
+        double t = now_sec() - t0;
+        if (r == 0 || t < fbest) {
+            fbest = t;
+        }
+        seen = filter->seen;
+        passed = filter->passed;
+    }
+    json_key(out, "filter");
+    fprintf(out,
+            "{\"candidates\": %" PRIu64 ", \"accepted\": %" PRIu64
+            ", \"key_accepted\": %s, \"seconds\": %.6f, \"candidates_per_sec\": %.0f}",
+            seen, passed, key_found ? "true" : "false", fbest, rate((double)seen, fbest));
+
+    free(filter);
+    free(hits);
+    free(image);
+    return key_found ? 0 : -1;
+}
+
+static int bench_validate(const bench_options *opts, const unsigned char *key, const unsigned char *page,
+                          FILE *out) {
+    size_t n = opts->candidates;
+    unsigned char *keys = malloc(n * KEY_SIZE);
+    const unsigned char **ptrs = malloc(n * sizeof(unsigned char *));
+    bool *results = malloc(n * sizeof(bool));
+    if (!keys || !ptrs || !results) {
+        free(keys);
+        free(ptrs);
+        free(results);
+        return -1;
+    }
+    uint64_t rng = opts->seed ^ 0x76616C6964ULL;
+    rng_fill(&rng, keys, n * KEY_SIZE);
+    memcpy(keys + (n - 1) * KEY_SIZE, key, KEY_SIZE);
+    for (size_t i = 0; i < n; i++) {
+        ptrs[i] = keys + i * KEY_SIZE;
+    }
+
+    // 与扫描时一样按 V4_VALIDATE_BATCH_SIZE 一批批校验
+    double best = 0;
+    int valid = 0;
+    for (int r = 0; r < opts->repeat; r++) {
+        double t0 = now_sec();
+        valid = 0;
+        for (size_t i = 0; i < n; i += V4_VALIDATE_BATCH_SIZE) {
+            size_t m = n - i < V4_VALIDATE_BATCH_SIZE ? n - i : V4_VALIDATE_BATCH_SIZE;
+            valid += testkey_v4_batch(page, ptrs + i, m, results + i);
+        }
+        double t = now_sec() - t0;
+        if (r == 0 || t < best) {
+            best = t;
+        }
+    }
+    json_key(out, "validate");
+    fprintf(out,
+            "{\"engine\": \"%s\", \"lanes\": %d, \"candidates\": %zu, \"valid\": %d, "
+            "\"seconds\": %.6f, \"candidates_per_sec\": %.2f}",
+            sha512_mb_engine(), sha512_mb_lanes(), n, valid, best, rate((double)n, best));
+
+    free(results);
+    free(ptrs);
+    free(keys);
+    return valid == 1 ? 0 : -1;
+}
+
+static int bench_decrypt(const bench_options *opts, const unsigned char *enc_key, const unsigned char *mac_key,
+                         const unsigned char *salt, FILE *out) {
+    size_t pages = opts->db_pages;
+    size_t len = pages * PAGE_SIZE;
+    unsigned char *db = malloc(len);
+    unsigned char *plain = malloc(len);
+    if (!db || !plain) {
+        free(db);
+        free(plain);
+        return -1;
+    }
+    uint64_t rng = opts->seed ^ 0x6462ULL;
+    for (size_t p = 0; p < pages; p++) {
+        make_page(&rng, mac_key, salt, p, db + p * PAGE_SIZE);
+    }
+
+    v4_decrypt_ctx ctx;
+    v4_decrypt_init_keys(&ctx, enc_key, mac_key);
+
+    // 单线程内存内解密：只有 HMAC + AES，不含 I/O
+    double best = 0;
+    int ret = V4_DECRYPT_OK;
+    for (int r = 0; r < opts->repeat && ret == V4_DECRYPT_OK; r++) {
+        double t0 = now_sec();
+        for (size_t p = 0; p < pages && ret == V4_DECRYPT_OK; p++) {
+            ret = v4_decrypt_page_to(&ctx, db + p * PAGE_SIZE, plain + p * PAGE_SIZE, p);
+        }
+        double t = now_sec() - t0;
+        if (r == 0 || t < best) {
+            best = t;
+        }
+    }
+    free(plain);
+    if (ret != V4_DECRYPT_OK) {
+        free(db);
+        log_error("In-memory decrypt failed: %s", v4_decrypt_strerror(ret));
+        return -1;
+    }
+    json_key(out, "decrypt");
+    fprintf(out,
+            "{\"pages\": %zu, \"seconds\": %.6f, \"pages_per_sec\": %.0f, \"mb_per_sec\": %.1f}",
+            pages, best, rate((double)pages, best), rate(len / (1024.0 * 1024.0), best));
+
+    // 整库解密：与 v4_decrypt 工具相同的文件路径，含 pread/pwrite 和多线程调度
+    char in_path[4096], out_path[4096];
+    snprintf(in_path, sizeof(in_path), "%s/v4_bench_%ld.db", opts->tmp_dir, (long)getpid());
+    snprintf(out_path, sizeof(out_path), "%s/v4_bench_%ld.out", opts->tmp_dir, (long)getpid());
+    FILE *fp = fopen(in_path, "wb");
+    bool written = fp && fwrite(db, 1, len, fp) == len;
+    if (fp && fclose(fp) != 0) {
+        written = false;
+    }
+    free(db);
+    if (!written) {
+        log_error("Failed to write %s: %s", in_path, strerror(errno));
+        remove(in_path);
+        return -1;
+    }
+
+    static const struct {
+        const char *name;
+        unsigned flags;
+    } modes[] = {{"pread", 0}, {"mmap", V4_DECRYPT_MMAP}};
+    json_key(out, "decrypt_file");
+    fprintf(out, "[");
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]) && ret == V4_DECRYPT_OK; m++) {
+        double fbest = 0;
+        for (int r = 0; r < opts->repeat && ret == V4_DECRYPT_OK; r++) {
+            uint64_t bad_page = 0;
+            double t0 = now_sec();
+            ret = v4_decrypt_file_ctx(&ctx, in_path, out_path, opts->jobs, modes[m].flags, &bad_page);
+            double t = now_sec() - t0;
+            if (r == 0 || t < fbest) {
+                fbest = t;
+            }
+        }
+        fprintf(out,
+                "%s\n    {\"mode\": \"%s\", \"jobs\": %d, \"pages\": %zu, \"seconds\": %.6f, "
+                "\"pages_per_sec\": %.0f, \"mb_per_sec\": %.1f}",
+                m ? "," : "", modes[m].name, opts->jobs, pages, fbest, rate((double)pages, fbest),
+                rate(len / (1024.0 * 1024.0), fbest));
+    }
+    fprintf(out, "\n  ]");
+    remove(in_path);
+    remove(out_path);
+    if (ret != V4_DECRYPT_OK) {
+        log_error("File decrypt failed: %s", v4_decrypt_strerror(ret));
+        return -1;
+    }
+    return 0;
+}
+
+static bool known_offset(int offset) {
+    for (int i = 0; i < num_key_offsets; i++) {
+        if (key_offsets[i] == offset) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [options]\n", prog);
+    fprintf(stderr, "  -l, --maps-lines N   合成 maps 的行数（默认 20000）\n");
+    fprintf(stderr, "  -s, --image-mb N     内存镜像大小，MB（默认 256）\n");
+    fprintf(stderr, "  -d, --density N      每 MB 放置的特征码数（默认 4）\n");
+    fprintf(stderr, "  -o, --offset N       密钥相对特征码的偏移，取 16/-80/64/-16/32/-32（默认 16）\n");
+    fprintf(stderr, "  -z, --zero PCT       全零页比例（默认 50）\n");
+    fprintf(stderr, "  -n, --candidates N   校验阶段的候选数（默认 64）\n");
+    fprintf(stderr, "  -P, --pages N        数据库页数（默认 16384，即 64MB）\n");
+    fprintf(stderr, "  -j, --jobs N         整库解密线程数（默认使用全部 CPU）\n");
+    fprintf(stderr, "  -r, --repeat N       每个阶段重复次数，取最快的一次（默认 3）\n");
+    fprintf(stderr, "  -S, --seed N         随机种子（默认 1）\n");
+    fprintf(stderr, "  -T, --tmp-dir DIR    整库解密使用的临时目录（默认 /tmp）\n");
+}
+
+int main(int argc, char *argv[]) {
+    bench_options opts = {
+        .maps_lines = 20000,
+        .image_mb = 256,
+        .density = 4,
+        .key_offset = 16,
+        .zero_percent = 50,
+        .candidates = 64,
+        .db_pages = 16384,
+        .jobs = 0,
+        .repeat = 3,
+        .seed = 1,
+        .tmp_dir = "/tmp",
+    };
+
+    static const struct option long_options[] = {
+        {"maps-lines", required_argument, NULL, 'l'},
+        {"image-mb", required_argument, NULL, 's'},
+        {"density", required_argument, NULL, 'd'},
+        {"offset", required_argument, NULL, 'o'},
+        {"zero", required_argument, NULL, 'z'},
+        {"candidates", required_argument, NULL, 'n'},
+        {"pages", required_argument, NULL, 'P'},
+        {"jobs", required_argument, NULL, 'j'},
+        {"repeat", required_argument, NULL, 'r'},
+        {"seed", required_argument, NULL, 'S'},
+        {"tmp-dir", required_argument, NULL, 'T'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "l:s:d:o:z:n:P:j:r:S:T:h", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'l':
+            opts.maps_lines = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            opts.image_mb = strtoul(optarg, NULL, 10);
+            break;
+        case 'd':
+            opts.density = strtod(optarg, NULL);
+            break;
+        case 'o':
+            opts.key_offset = atoi(optarg);
+            break;
+        case 'z':
+            opts.zero_percent = atoi(optarg);
+            break;
+        case 'n':
+            opts.candidates = strtoul(optarg, NULL, 10);
+            break;
+        case 'P':
+            opts.db_pages = strtoul(optarg, NULL, 10);
+            break;
+        case 'j':
+            opts.jobs = atoi(optarg);
+            break;
+        case 'r':
+            opts.repeat = atoi(optarg);
+            break;
+        case 'S':
+            opts.seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'T':
+            opts.tmp_dir = optarg;
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (opts.maps_lines == 0 || opts.image_mb == 0 || opts.candidates == 0 || opts.db_pages == 0 ||
+        opts.repeat <= 0 || opts.density < 0 || opts.zero_percent < 0 || opts.zero_percent > 100 ||
+        !known_offset(opts.key_offset)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (opts.jobs <= 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        opts.jobs = n > 0 ? (int)n : 1;
+    }
+
+    // 已知密钥及其派生结果
+    uint64_t rng = opts.seed;
+    unsigned char key[KEY_SIZE], salt[SALT_SIZE], enc_key[KEY_SIZE], mac_key[KEY_SIZE];
+    rng_fill(&rng, key, sizeof(key));
+    rng_fill(&rng, salt, sizeof(salt));
+    derive_keys(key, salt, enc_key, mac_key);
+    unsigned char page[PAGE_SIZE];
+    make_page(&rng, mac_key, salt, 0, page);
+
+    log_info("Benchmarking: image %zu MB, %zu candidates, %zu pages, repeat %d", opts.image_mb,
+             opts.candidates, opts.db_pages, opts.repeat);
+
+    FILE *out = stdout;
+    fprintf(out, "{");
+    json_key(out, "params");
+    fprintf(out,
+            "{\"maps_lines\": %zu, \"image_mb\": %zu, \"density\": %.3f, \"key_offset\": %d, "
+            "\"zero_percent\": %d, \"candidates\": %zu, \"pages\": %zu, \"jobs\": %d, \"repeat\": %d, "
+            "\"seed\": %" PRIu64 "}",
+            opts.maps_lines, opts.image_mb, opts.density, opts.key_offset, opts.zero_percent,
+            opts.candidates, opts.db_pages, opts.jobs, opts.repeat, opts.seed);
+
+    int ret = 0;
+    if (bench_maps(&opts, out) != 0) {
+        log_error("maps stage failed");
+        ret = 1;
+    }
+    if (bench_scan(&opts, key, out) != 0) {
+        log_error("scan stage did not find the planted key");
+        ret = 1;
+    }
+    if (bench_validate(&opts, key, page, out) != 0) {
+        log_error("validate stage did not accept exactly one candidate");
+        ret = 1;
+    }
+    if (bench_decrypt(&opts, enc_key, mac_key, salt, out) != 0) {
+        ret = 1;
+    }
+    fprintf(out, "\n}\n");
+    return ret;
+}
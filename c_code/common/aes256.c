@@ -0,0 +1,314 @@
+// AES-256-CBC 解密实现，见 aes256.h
+
+#include "aes256.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define AES256_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+#define AES256_ARMV8 1
+#include <arm_neon.h>
+#endif
+
+// S 盒和 GF(2^8) 乘法表在第一次使用时生成
+static unsigned char sbox[256];
+static unsigned char inv_sbox[256];
+static unsigned char mul9[256], mul11[256], mul13[256], mul14[256];
+// 可移植内核的逆向 T 表：InvSubBytes + InvMixColumns 合并成一次查表，行 r 对应 td[r]
+static uint32_t td[4][256];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static unsigned char xtime(unsigned char x) {
+    return (unsigned char)((x << 1) ^ ((x & 0x80) ? 0x1B : 0));
+}
+
+static unsigned char gf_mul(unsigned char a, unsigned char b) {
+    unsigned char p = 0;
+    while (b) {
+        if (b & 1) {
+            p ^= a;
+        }
+        a = xtime(a);
+        b >>= 1;
+    }
+    return p;
+}
+
+static void init_tables(void) {
+    // 乘法逆元 + 仿射变换
+    for (int i = 0; i < 256; i++) {
+        unsigned char inv = 0;
+        for (int j = 1; i && j < 256; j++) {
+            if (gf_mul((unsigned char)i, (unsigned char)j) == 1) {
+                inv = (unsigned char)j;
+                break;
+            }
+        }
+        unsigned char s = inv;
+        unsigned char x = inv;
+        for (int k = 0; k < 4; k++) {
+            x = (unsigned char)((x << 1) | (x >> 7));
+            s ^= x;
+        }
+        sbox[i] = s ^ 0x63;
+    }
+    for (int i = 0; i < 256; i++) {
+        inv_sbox[sbox[i]] = (unsigned char)i;
+        mul9[i] = gf_mul((unsigned char)i, 9);
+        mul11[i] = gf_mul((unsigned char)i, 11);
+        mul13[i] = gf_mul((unsigned char)i, 13);
+        mul14[i] = gf_mul((unsigned char)i, 14);
+    }
+    // 列按大端打包成 32 位字，InvMixColumns 系数矩阵第 r 列依次轮转
+    static const unsigned char coef[4] = {14, 9, 13, 11};
+    for (int i = 0; i < 256; i++) {
+        unsigned char x = inv_sbox[i];
+        for (int row = 0; row < 4; row++) {
+            uint32_t v = 0;
+            for (int k = 0; k < 4; k++) {
+                v = (v << 8) | gf_mul(x, coef[(k - row + 4) % 4]);
+            }
+            td[row][i] = v;
+        }
+    }
+}
+
+static void inv_mix_columns(unsigned char *s) {
+    for (int c = 0; c < 4; c++) {
+        unsigned char *a = s + 4 * c;
+        unsigned char a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3];
+        a[0] = mul14[a0] ^ mul11[a1] ^ mul13[a2] ^ mul9[a3];
+        a[1] = mul9[a0] ^ mul14[a1] ^ mul11[a2] ^ mul13[a3];
+        a[2] = mul13[a0] ^ mul9[a1] ^ mul14[a2] ^ mul11[a3];
+        a[3] = mul11[a0] ^ mul13[a1] ^ mul9[a2] ^ mul14[a3];
+    }
+}
+
+void aes256_dec_init(aes256_dec_key *key, const unsigned char raw[AES256_KEY_SIZE]) {
+    pthread_once(&tables_once, init_tables);
+
+    // 标准的 AES-256 加密轮密钥展开，60 个 32 位字
+    unsigned char w[4 * (AES256_ROUNDS + 1) * 4];
+    memcpy(w, raw, AES256_KEY_SIZE);
+    unsigned char rcon = 1;
+    for (int i = 8; i < 4 * (AES256_ROUNDS + 1); i++) {
+        unsigned char t[4];
+        memcpy(t, w + 4 * (i - 1), 4);
+        if (i % 8 == 0) {
+            unsigned char t0 = t[0];
+            t[0] = sbox[t[1]] ^ rcon;
+            t[1] = sbox[t[2]];
+            t[2] = sbox[t[3]];
+            t[3] = sbox[t0];
+            rcon = xtime(rcon);
+        } else if (i % 8 == 4) {
+            for (int k = 0; k < 4; k++) {
+                t[k] = sbox[t[k]];
+            }
+        }
+        for (int k = 0; k < 4; k++) {
+            w[4 * i + k] = w[4 * (i - 8) + k] ^ t[k];
+        }
+    }
+
+    // 等价逆密码：轮密钥倒序，中间 13 轮先做 InvMixColumns，
+    // 这样 AES-NI 的 aesdec 和 ARMv8 的 aesd/aesimc 可以直接使用
+    for (int r = 0; r <= AES256_ROUNDS; r++) {
+        memcpy(key->rk[r], w + 16 * (AES256_ROUNDS - r), AES256_BLOCK_SIZE);
+        if (r > 0 && r < AES256_ROUNDS) {
+            inv_mix_columns(key->rk[r]);
+        }
+    }
+}
+
+static void xor_block(unsigned char *dst, const unsigned char *a, const unsigned char *b) {
+    for (int i = 0; i < AES256_BLOCK_SIZE; i++) {
+        dst[i] = a[i] ^ b[i];
+    }
+}
+
+static uint32_t load_be32(const unsigned char *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+/**
+ * 状态按列存放，每列一个大端 32 位字；InvShiftRows 使第 r 行取自第 c - r 列
+ */
+static void decrypt_block_portable(const aes256_dec_key *key, const unsigned char *in,
+                                   unsigned char *out) {
+    uint32_t s[4], t[4];
+    for (int c = 0; c < 4; c++) {
+        s[c] = load_be32(in + 4 * c) ^ load_be32(key->rk[0] + 4 * c);
+    }
+    for (int r = 1; r < AES256_ROUNDS; r++) {
+        for (int c = 0; c < 4; c++) {
+            t[c] = td[0][s[c] >> 24] ^ td[1][(s[(c + 3) & 3] >> 16) & 0xFF] ^
+                   td[2][(s[(c + 2) & 3] >> 8) & 0xFF] ^ td[3][s[(c + 1) & 3] & 0xFF] ^
+                   load_be32(key->rk[r] + 4 * c);
+        }
+        memcpy(s, t, sizeof(s));
+    }
+    const unsigned char *last = key->rk[AES256_ROUNDS];
+    for (int c = 0; c < 4; c++) {
+        out[4 * c + 0] = inv_sbox[s[c] >> 24] ^ last[4 * c + 0];
+        out[4 * c + 1] = inv_sbox[(s[(c + 3) & 3] >> 16) & 0xFF] ^ last[4 * c + 1];
+        out[4 * c + 2] = inv_sbox[(s[(c + 2) & 3] >> 8) & 0xFF] ^ last[4 * c + 2];
+        out[4 * c + 3] = inv_sbox[s[(c + 1) & 3] & 0xFF] ^ last[4 * c + 3];
+    }
+}
+
+static void cbc_portable(const aes256_dec_key *key, const unsigned char *iv,
+                         const unsigned char *in, unsigned char *out, size_t len) {
+    unsigned char prev[AES256_BLOCK_SIZE];
+    unsigned char cur[AES256_BLOCK_SIZE];
+    memcpy(prev, iv, AES256_BLOCK_SIZE);
+    for (size_t i = 0; i < len; i += AES256_BLOCK_SIZE) {
+        memcpy(cur, in + i, AES256_BLOCK_SIZE);
+        decrypt_block_portable(key, cur, out + i);
+        xor_block(out + i, out + i, prev);
+        memcpy(prev, cur, AES256_BLOCK_SIZE);
+    }
+}
+
+#if defined(AES256_X86)
+__attribute__((target("aes,sse2")))
+static void cbc_aesni(const aes256_dec_key *key, const unsigned char *iv,
+                      const unsigned char *in, unsigned char *out, size_t len) {
+    __m128i rk[AES256_ROUNDS + 1];
+    for (int r = 0; r <= AES256_ROUNDS; r++) {
+        rk[r] = _mm_load_si128((const __m128i *)key->rk[r]);
+    }
+    __m128i prev = _mm_loadu_si128((const __m128i *)iv);
+
+    // 8 个分组交错执行，掩盖 aesdec 的延迟；先读入密文再写出，支持原地解密
+    size_t i = 0;
+    for (; i + 8 * AES256_BLOCK_SIZE <= len; i += 8 * AES256_BLOCK_SIZE) {
+        __m128i c[8], b[8];
+        for (int j = 0; j < 8; j++) {
+            c[j] = _mm_loadu_si128((const __m128i *)(in + i) + j);
+            b[j] = _mm_xor_si128(c[j], rk[0]);
+        }
+        for (int r = 1; r < AES256_ROUNDS; r++) {
+            for (int j = 0; j < 8; j++) {
+                b[j] = _mm_aesdec_si128(b[j], rk[r]);
+            }
+        }
+        for (int j = 0; j < 8; j++) {
+            b[j] = _mm_aesdeclast_si128(b[j], rk[AES256_ROUNDS]);
+        }
+        _mm_storeu_si128((__m128i *)(out + i), _mm_xor_si128(b[0], prev));
+        for (int j = 1; j < 8; j++) {
+            _mm_storeu_si128((__m128i *)(out + i) + j, _mm_xor_si128(b[j], c[j - 1]));
+        }
+        prev = c[7];
+    }
+    for (; i < len; i += AES256_BLOCK_SIZE) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128i b = _mm_xor_si128(c, rk[0]);
+        for (int r = 1; r < AES256_ROUNDS; r++) {
+            b = _mm_aesdec_si128(b, rk[r]);
+        }
+        b = _mm_aesdeclast_si128(b, rk[AES256_ROUNDS]);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_xor_si128(b, prev));
+        prev = c;
+    }
+}
+#endif
+
+#if defined(AES256_ARMV8)
+// aesd 先异或轮密钥再做 InvShiftRows + InvSubBytes，aesimc 是 InvMixColumns，
+// 所以最后一轮单独异或 rk[14]
+#define ARMV8_DEC_ROUNDS(b)                                 \
+    do {                                                    \
+        for (int r = 0; r < AES256_ROUNDS - 1; r++) {       \
+            b = vaesimcq_u8(vaesdq_u8(b, rk[r]));           \
+        }                                                   \
+        b = veorq_u8(vaesdq_u8(b, rk[AES256_ROUNDS - 1]), rk[AES256_ROUNDS]); \
+    } while (0)
+
+static void cbc_armv8(const aes256_dec_key *key, const unsigned char *iv,
+                      const unsigned char *in, unsigned char *out, size_t len) {
+    uint8x16_t rk[AES256_ROUNDS + 1];
+    for (int r = 0; r <= AES256_ROUNDS; r++) {
+        rk[r] = vld1q_u8(key->rk[r]);
+    }
+    uint8x16_t prev = vld1q_u8(iv);
+
+    size_t i = 0;
+    for (; i + 4 * AES256_BLOCK_SIZE <= len; i += 4 * AES256_BLOCK_SIZE) {
+        uint8x16_t c0 = vld1q_u8(in + i);
+        uint8x16_t c1 = vld1q_u8(in + i + 16);
+        uint8x16_t c2 = vld1q_u8(in + i + 32);
+        uint8x16_t c3 = vld1q_u8(in + i + 48);
+        uint8x16_t b0 = c0, b1 = c1, b2 = c2, b3 = c3;
+        for (int r = 0; r < AES256_ROUNDS - 1; r++) {
+            b0 = vaesimcq_u8(vaesdq_u8(b0, rk[r]));
+            b1 = vaesimcq_u8(vaesdq_u8(b1, rk[r]));
+            b2 = vaesimcq_u8(vaesdq_u8(b2, rk[r]));
+            b3 = vaesimcq_u8(vaesdq_u8(b3, rk[r]));
+        }
+        b0 = veorq_u8(vaesdq_u8(b0, rk[AES256_ROUNDS - 1]), rk[AES256_ROUNDS]);
+        b1 = veorq_u8(vaesdq_u8(b1, rk[AES256_ROUNDS - 1]), rk[AES256_ROUNDS]);
+        b2 = veorq_u8(vaesdq_u8(b2, rk[AES256_ROUNDS - 1]), rk[AES256_ROUNDS]);
+        b3 = veorq_u8(vaesdq_u8(b3, rk[AES256_ROUNDS - 1]), rk[AES256_ROUNDS]);
+        vst1q_u8(out + i, veorq_u8(b0, prev));
+        vst1q_u8(out + i + 16, veorq_u8(b1, c0));
+        vst1q_u8(out + i + 32, veorq_u8(b2, c1));
+        vst1q_u8(out + i + 48, veorq_u8(b3, c2));
+        prev = c3;
+    }
+    for (; i < len; i += AES256_BLOCK_SIZE) {
+        uint8x16_t c = vld1q_u8(in + i);
+        uint8x16_t b = c;
+        ARMV8_DEC_ROUNDS(b);
+        vst1q_u8(out + i, veorq_u8(b, prev));
+        prev = c;
+    }
+}
+#endif
+
+typedef void (*aes256_cbc_fn)(const aes256_dec_key *key, const unsigned char *iv,
+                              const unsigned char *in, unsigned char *out, size_t len);
+
+typedef struct {
+    aes256_cbc_fn fn;
+    const char *name;
+} aes256_engine_info;
+
+static aes256_engine_info engine;
+static pthread_once_t engine_once = PTHREAD_ONCE_INIT;
+
+static void init_engine(void) {
+    pthread_once(&tables_once, init_tables);
+    engine = (aes256_engine_info){cbc_portable, "portable"};
+#if defined(AES256_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("aes")) {
+        engine = (aes256_engine_info){cbc_aesni, "aesni"};
+    }
+#elif defined(AES256_ARMV8)
+    engine = (aes256_engine_info){cbc_armv8, "armv8-ce"};
+#endif
+
+    // CHATLOG_AES=portable 可以强制使用可移植实现，便于对比和排查
+    const char *force = getenv("CHATLOG_AES");
+    if (force && strcmp(force, "portable") == 0) {
+        engine = (aes256_engine_info){cbc_portable, "portable"};
+    }
+}
+
+const char *aes256_engine(void) {
+    pthread_once(&engine_once, init_engine);
+    return engine.name;
+}
+
+void aes256_cbc_decrypt(const aes256_dec_key *key, const unsigned char iv[AES256_BLOCK_SIZE],
+                        const unsigned char *in, unsigned char *out, size_t len) {
+    pthread_once(&engine_once, init_engine);
+    engine.fn(key, iv, in, out, len);
+}
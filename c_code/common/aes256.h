@@ -0,0 +1,39 @@
+// AES-256-CBC 解密，V4 数据库解密使用
+//
+// 轮密钥只展开一次，之后每页直接复用；支持原地解密。
+// CBC 解密各分组之间没有依赖，AES-NI 内核一次并行解密 8 个分组，
+// ARMv8 Crypto Extensions 内核一次 4 个，其余平台使用查表的可移植实现。
+// ARMv8 内核在编译期选择（Apple Silicon 默认开启；Linux aarch64 需要
+// -march=armv8-a+crypto），x86 在运行时用 cpuid 检测。
+
+#ifndef CHATLOG_AES256_H
+#define CHATLOG_AES256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define AES256_KEY_SIZE 32
+#define AES256_BLOCK_SIZE 16
+#define AES256_ROUNDS 14
+
+// 解密用的轮密钥（等价逆密码的顺序），可以被多个线程共用
+typedef struct {
+    _Alignas(16) unsigned char rk[AES256_ROUNDS + 1][AES256_BLOCK_SIZE];
+} aes256_dec_key;
+
+void aes256_dec_init(aes256_dec_key *key, const unsigned char raw[AES256_KEY_SIZE]);
+
+/**
+ * CBC 解密
+ * @param iv 初始向量，不会被修改
+ * @param len 必须是 16 的倍数；in 和 out 可以相同
+ */
+void aes256_cbc_decrypt(const aes256_dec_key *key, const unsigned char iv[AES256_BLOCK_SIZE],
+                        const unsigned char *in, unsigned char *out, size_t len);
+
+/**
+ * 当前使用的解密内核名称："aesni" / "armv8-ce" / "portable"
+ */
+const char *aes256_engine(void);
+
+#endif // CHATLOG_AES256_H
@@ -0,0 +1,166 @@
+// 候选密钥预过滤实现，见 candidate_filter.h
+
+#include "candidate_filter.h"
+
+#include <string.h>
+
+static uint64_t load_u64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+bool candidate_reject_zero(void *state, const unsigned char *key) {
+    (void)state;
+    uint64_t acc = 0;
+    for (int i = 0; i < CANDIDATE_KEY_SIZE; i += 8) {
+        acc |= load_u64(key + i);
+    }
+    return acc == 0;
+}
+
+/**
+ * 以 1/2/4/8/16 字节为周期重复的填充
+ */
+bool candidate_reject_repeat(void *state, const unsigned char *key) {
+    (void)state;
+    for (int period = 1; period < CANDIDATE_KEY_SIZE; period *= 2) {
+        if (memcmp(key, key + period, CANDIDATE_KEY_SIZE - period) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 至少两个 qword 高 16 位全 0 或全 1：用户态指针、小整数或负数
+ * 随机密钥误拒概率约 6 * 2^-30
+ */
+bool candidate_reject_pointer(void *state, const unsigned char *key) {
+    (void)state;
+    int pointers = 0;
+    for (int i = 0; i < CANDIDATE_KEY_SIZE; i += 8) {
+        uint64_t top = load_u64(key + i) >> 48;
+        if (top == 0 || top == 0xFFFF) {
+            pointers++;
+        }
+    }
+    return pointers >= 2;
+}
+
+/**
+ * 字节分布：不同字节值少于 16 个、零字节不少于 8 个、或者全是可打印 ASCII
+ */
+bool candidate_reject_entropy(void *state, const unsigned char *key) {
+    (void)state;
+    uint64_t seen[4] = {0, 0, 0, 0};
+    int distinct = 0;
+    int zeros = 0;
+    bool printable = true;
+    for (int i = 0; i < CANDIDATE_KEY_SIZE; i++) {
+        unsigned char c = key[i];
+        uint64_t bit = 1ULL << (c & 63);
+        if (!(seen[c >> 6] & bit)) {
+            seen[c >> 6] |= bit;
+            distinct++;
+        }
+        zeros += c == 0;
+        printable &= c >= 0x20 && c < 0x7F;
+    }
+    return distinct < 16 || zeros >= 8 || printable;
+}
+
+static uint64_t fingerprint(const unsigned char *key) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < CANDIDATE_KEY_SIZE; i += 8) {
+        h ^= load_u64(key + i);
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 31;
+    }
+    return h | 1;  // 0 表示空槽
+}
+
+/**
+ * 同一个候选在不同偏移、不同命中处反复出现时只保留第一次
+ */
+bool candidate_reject_dup(void *state, const unsigned char *key) {
+    candidate_filter *f = state;
+    uint64_t h = fingerprint(key);
+    uint64_t *slot = &f->dedup[h & (CANDIDATE_DEDUP_SLOTS - 1)];
+    if (*slot == h) {
+        return true;
+    }
+    *slot = h;
+    return false;
+}
+
+void candidate_filter_init_empty(candidate_filter *f) {
+    memset(f, 0, sizeof(*f));
+}
+
+void candidate_filter_init(candidate_filter *f) {
+    candidate_filter_init_empty(f);
+    // 便宜的先执行，去重放在最后，避免垃圾候选占满去重表
+    candidate_filter_add(f, "zero", candidate_reject_zero, NULL);
+    candidate_filter_add(f, "repeat", candidate_reject_repeat, NULL);
+    candidate_filter_add(f, "pointer", candidate_reject_pointer, NULL);
+    candidate_filter_add(f, "entropy", candidate_reject_entropy, NULL);
+    candidate_filter_add(f, "dedup", candidate_reject_dup, f);
+}
+
+void candidate_filter_reset_dedup(candidate_filter *f) {
+    memset(f->dedup, 0, sizeof(f->dedup));
+}
+
+bool candidate_filter_add(candidate_filter *f, const char *name, candidate_filter_fn fn, void *state) {
+    if (f->count == CANDIDATE_FILTER_MAX) {
+        return false;
+    }
+    f->stages[f->count++] = (candidate_filter_stage){name, fn, state, 0};
+    return true;
+}
+
+bool candidate_filter_accept(candidate_filter *f, const unsigned char *key, size_t offset_index) {
+    if (offset_index >= CANDIDATE_MAX_OFFSETS) {
+        offset_index = CANDIDATE_MAX_OFFSETS - 1;
+    }
+    f->seen++;
+    f->offset_seen[offset_index]++;
+
+    for (size_t i = 0; i < f->count; i++) {
+        if (f->stages[i].fn(f->stages[i].state, key)) {
+            f->stages[i].rejected++;
+            return false;
+        }
+    }
+
+    f->passed++;
+    f->offset_passed[offset_index]++;
+    return true;
+}
+
+void candidate_filter_merge(candidate_filter *dst, const candidate_filter *src) {
+    dst->seen += src->seen;
+    dst->passed += src->passed;
+    for (size_t i = 0; i < dst->count && i < src->count; i++) {
+        dst->stages[i].rejected += src->stages[i].rejected;
+    }
+    for (size_t i = 0; i < CANDIDATE_MAX_OFFSETS; i++) {
+        dst->offset_seen[i] += src->offset_seen[i];
+        dst->offset_passed[i] += src->offset_passed[i];
+    }
+}
+
+void candidate_filter_print(const candidate_filter *f, const int *offsets, size_t num_offsets,
+                            FILE *out) {
+    fprintf(out, "Candidate filter: %llu seen, %llu passed to PBKDF2\n",
+            (unsigned long long)f->seen, (unsigned long long)f->passed);
+    for (size_t i = 0; i < f->count; i++) {
+        fprintf(out, "  %-8s rejected %llu\n", f->stages[i].name,
+                (unsigned long long)f->stages[i].rejected);
+    }
+    for (size_t i = 0; i < num_offsets && i < CANDIDATE_MAX_OFFSETS; i++) {
+        fprintf(out, "  offset %+4d: %llu seen, %llu passed\n", offsets[i],
+                (unsigned long long)f->offset_seen[i], (unsigned long long)f->offset_passed[i]);
+    }
+}
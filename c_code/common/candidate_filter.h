@@ -0,0 +1,99 @@
+// 候选密钥预过滤，Linux/macOS 两个 testkey 工具共用
+//
+// 每个特征码命中要尝试若干个偏移（默认 6 个，见 key_offsets.h），每个偏移都要跑一次 256000 轮的 PBKDF2，
+// 而其中大量候选一眼就能看出不是密钥：全零、重复填充、ASCII 文本、指针。
+// 这里在进入批量校验之前先过一串廉价的过滤器，被任一过滤器拒绝就直接丢弃。
+// 过滤器可以按需增减，每个过滤器都统计拒绝数，并按偏移统计通过率，
+// 用来根据实际数据调整偏移列表。
+//
+// 阈值都按 32 字节随机密钥的误拒概率低于 1e-8 选取。
+// 每个扫描线程使用自己的 candidate_filter，结束时用 candidate_filter_merge 汇总。
+
+#ifndef CHATLOG_CANDIDATE_FILTER_H
+#define CHATLOG_CANDIDATE_FILTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define CANDIDATE_KEY_SIZE 32
+#define CANDIDATE_FILTER_MAX 8
+#define CANDIDATE_MAX_OFFSETS 64
+#define CANDIDATE_DEDUP_SLOTS 4096
+
+/**
+ * 过滤函数
+ * @param state 注册时传入的私有状态
+ * @return 返回 true 表示拒绝该候选
+ */
+typedef bool (*candidate_filter_fn)(void *state, const unsigned char *key);
+
+typedef struct {
+    const char *name;
+    candidate_filter_fn fn;
+    void *state;
+    uint64_t rejected;
+} candidate_filter_stage;
+
+typedef struct {
+    candidate_filter_stage stages[CANDIDATE_FILTER_MAX];
+    size_t count;
+    uint64_t seen;
+    uint64_t passed;
+    // 按偏移下标统计
+    uint64_t offset_seen[CANDIDATE_MAX_OFFSETS];
+    uint64_t offset_passed[CANDIDATE_MAX_OFFSETS];
+    // 内置去重过滤器的状态：最近见过的候选的 64 位指纹，直接映射
+    uint64_t dedup[CANDIDATE_DEDUP_SLOTS];
+} candidate_filter;
+
+/**
+ * 初始化并注册内置过滤器：zero / repeat / pointer / entropy / dedup
+ */
+void candidate_filter_init(candidate_filter *f);
+
+/**
+ * 初始化一个不带任何过滤器的空管线
+ */
+void candidate_filter_init_empty(candidate_filter *f);
+
+/**
+ * 追加一个过滤器，按注册顺序执行
+ * @return 过滤器数量已满时返回 false
+ */
+bool candidate_filter_add(candidate_filter *f, const char *name, candidate_filter_fn fn, void *state);
+
+/**
+ * 依次执行所有过滤器
+ * @param offset_index 候选来自偏移列表中的第几个偏移，只用于统计
+ * @return 通过所有过滤器返回 true
+ */
+bool candidate_filter_accept(candidate_filter *f, const unsigned char *key, size_t offset_index);
+
+/**
+ * 清空去重表：同一个扫描线程换到另一个目标进程（另一个 salt）之前调用，
+ * 在前一个进程里见过的候选对新的目标仍然需要校验
+ */
+void candidate_filter_reset_dedup(candidate_filter *f);
+
+/**
+ * 把 src 的计数累加到 dst，两者的过滤器必须按相同顺序注册
+ */
+void candidate_filter_merge(candidate_filter *dst, const candidate_filter *src);
+
+/**
+ * 输出统计信息
+ * @param offsets 偏移列表，用于标注按偏移的统计
+ */
+void candidate_filter_print(const candidate_filter *f, const int *offsets, size_t num_offsets,
+                            FILE *out);
+
+// 内置过滤器，也可以单独注册
+bool candidate_reject_zero(void *state, const unsigned char *key);
+bool candidate_reject_repeat(void *state, const unsigned char *key);
+bool candidate_reject_pointer(void *state, const unsigned char *key);
+bool candidate_reject_entropy(void *state, const unsigned char *key);
+bool candidate_reject_dup(void *state, const unsigned char *key);  // state 为 candidate_filter *
+
+#endif // CHATLOG_CANDIDATE_FILTER_H
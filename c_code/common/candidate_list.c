@@ -0,0 +1,64 @@
+// 候选密钥列表实现，见 candidate_list.h
+
+#include "candidate_list.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void candidate_list_init(candidate_list *list) {
+    memset(list, 0, sizeof(*list));
+}
+
+void candidate_list_free(candidate_list *list) {
+    free(list->keys);
+    free(list->tags);
+    memset(list, 0, sizeof(*list));
+}
+
+static bool reserve(candidate_list *list, size_t need) {
+    if (need <= list->cap) {
+        return true;
+    }
+    size_t cap = list->cap ? list->cap : 64;
+    while (cap < need) {
+        cap *= 2;
+    }
+    void *keys = realloc(list->keys, cap * CANDIDATE_LIST_KEY_SIZE);
+    if (!keys) {
+        return false;
+    }
+    list->keys = keys;
+    uint64_t *tags = realloc(list->tags, cap * sizeof(uint64_t));
+    if (!tags) {
+        return false;
+    }
+    list->tags = tags;
+    list->cap = cap;
+    return true;
+}
+
+bool candidate_list_push(candidate_list *list, const unsigned char *key, uint64_t tag) {
+    if (!reserve(list, list->count + 1)) {
+        return false;
+    }
+    list->tags[list->count] = tag;
+    memcpy(list->keys[list->count++], key, CANDIDATE_LIST_KEY_SIZE);
+    return true;
+}
+
+bool candidate_list_append(candidate_list *dst, const candidate_list *src) {
+    if (src->count == 0) {
+        return true;
+    }
+    if (!reserve(dst, dst->count + src->count)) {
+        return false;
+    }
+    memcpy(dst->keys[dst->count], src->keys, src->count * CANDIDATE_LIST_KEY_SIZE);
+    memcpy(dst->tags + dst->count, src->tags, src->count * sizeof(uint64_t));
+    dst->count += src->count;
+    return true;
+}
+
+void candidate_list_clear(candidate_list *list) {
+    list->count = 0;
+}
@@ -0,0 +1,46 @@
+// 候选密钥列表，Linux/macOS 两个 testkey 工具共用
+//
+// 两阶段扫描时，目标进程停住的那段时间里只做特征码扫描和预过滤，
+// 通过的候选原样拷贝进这个列表；解除暂停之后再离线跑 PBKDF2 校验。
+// 每个候选 32 字节，列表按扫描（优先级）顺序追加，数量通常只有几百到几千个。
+// 每个候选可以带一个 64 位标签（key_hint_tag），找到密钥后用来记录它的位置。
+
+#ifndef CHATLOG_CANDIDATE_LIST_H
+#define CHATLOG_CANDIDATE_LIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CANDIDATE_LIST_KEY_SIZE 32
+
+typedef struct {
+    unsigned char (*keys)[CANDIDATE_LIST_KEY_SIZE];
+    uint64_t *tags;
+    size_t count;
+    size_t cap;
+} candidate_list;
+
+void candidate_list_init(candidate_list *list);
+
+void candidate_list_free(candidate_list *list);
+
+/**
+ * 追加一个候选
+ * @param tag 候选的位置标签，不需要时传 0
+ * @return 内存不足时返回 false
+ */
+bool candidate_list_push(candidate_list *list, const unsigned char *key, uint64_t tag);
+
+/**
+ * 把 src 的候选追加到 dst 末尾，src 保持不变
+ * @return 内存不足时返回 false
+ */
+bool candidate_list_append(candidate_list *dst, const candidate_list *src);
+
+/**
+ * 清空列表，保留已分配的空间
+ */
+void candidate_list_clear(candidate_list *list);
+
+#endif // CHATLOG_CANDIDATE_LIST_H
@@ -0,0 +1,82 @@
+// 数据库格式常量：V3（macOS / Linux 微信 3.x）和 V4
+//
+// 两种格式都是 SQLCipher 布局：第一页前 16 字节是 salt，每页末尾保留 reserve 字节
+// 存放 IV 和 HMAC，HMAC 覆盖 [offset, data_end) 再加上小端序的页码（从 1 开始）。
+// 不同的只有页大小、哈希算法和 PBKDF2 轮数，reserve 和 data_end 都由它们在编译期算出。
+//
+//           页大小  哈希     HMAC  enc_key                     mac_key
+//   V3      1024   SHA-1    20    内存中的密钥本身，不做派生     PBKDF2(enc_key, salt ^ 0x3A, 2)
+//   V4      4096   SHA-512  64    PBKDF2(key, salt, 256000)     PBKDF2(enc_key, salt ^ 0x3A, 2)
+//
+// 与 Go 侧 internal/wechat/decrypt/{darwin,linux}/v3.go、v4.go 的常量一致。
+
+#ifndef CHATLOG_DB_FORMAT_H
+#define CHATLOG_DB_FORMAT_H
+
+#include <stddef.h>
+#include <string.h>
+
+#define DB_KEY_SIZE 32
+#define DB_SALT_SIZE 16
+#define DB_IV_SIZE 16
+#define DB_AES_BLOCK_SIZE 16
+#define DB_MAC_SALT_XOR 0x3A
+#define DB_MAC_ITER_COUNT 2
+
+// IV + HMAC 按 AES 块大小向上取整
+#define DB_RESERVE(hmac_size) \
+    (((DB_IV_SIZE + (hmac_size) + DB_AES_BLOCK_SIZE - 1) / DB_AES_BLOCK_SIZE) * DB_AES_BLOCK_SIZE)
+// HMAC 覆盖范围的终点，同时也是存放 HMAC 的位置；IV 在 HMAC 之前
+#define DB_DATA_END(page_size, hmac_size) ((page_size) - DB_RESERVE(hmac_size) + DB_IV_SIZE)
+
+#define DB_V3_PAGE_SIZE 1024
+#define DB_V3_HMAC_SIZE 20
+#define DB_V3_ITER_COUNT 0 // enc_key 就是原始密钥
+#define DB_V3_RESERVE DB_RESERVE(DB_V3_HMAC_SIZE)
+#define DB_V3_DATA_END DB_DATA_END(DB_V3_PAGE_SIZE, DB_V3_HMAC_SIZE)
+
+#define DB_V4_PAGE_SIZE 4096
+#define DB_V4_HMAC_SIZE 64
+#define DB_V4_ITER_COUNT 256000
+#define DB_V4_RESERVE DB_RESERVE(DB_V4_HMAC_SIZE)
+#define DB_V4_DATA_END DB_DATA_END(DB_V4_PAGE_SIZE, DB_V4_HMAC_SIZE)
+
+_Static_assert(DB_V3_RESERVE == 48 && DB_V3_DATA_END == 992, "V3 page layout");
+_Static_assert(DB_V4_RESERVE == 80 && DB_V4_DATA_END == 4032, "V4 page layout");
+
+// 要尝试的格式，可以组合
+typedef enum {
+    DB_FORMAT_V3 = 0x1,
+    DB_FORMAT_V4 = 0x2,
+} db_format;
+
+static inline const char *db_format_name(db_format format) {
+    return format == DB_FORMAT_V3 ? "v3" : "v4";
+}
+
+/**
+ * 解析逗号分隔的格式列表，例如 "v4,v3"
+ * @return DB_FORMAT_* 的组合，格式错误返回 0
+ */
+static inline unsigned db_formats_parse(const char *list) {
+    unsigned formats = 0;
+    const char *p = list;
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == 2 && strncmp(p, "v3", 2) == 0) {
+            formats |= DB_FORMAT_V3;
+        } else if (len == 2 && strncmp(p, "v4", 2) == 0) {
+            formats |= DB_FORMAT_V4;
+        } else {
+            return 0;
+        }
+        p += len;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return formats;
+}
+
+#endif // CHATLOG_DB_FORMAT_H
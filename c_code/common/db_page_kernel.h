@@ -0,0 +1,96 @@
+// 数据库页校验 / 解密内核模板，只能被 db_page_v3.h / db_page_v4.h 包含
+//
+// 包含前需要定义：
+//   DBP_FN           生成的函数名前缀
+//   DBP_PAGE_SIZE    页大小
+//   DBP_HMAC_SIZE    HMAC 长度，同时决定 reserve 和 data_end
+//   DBP_HMAC_CTX     已经吸收 mac_key 的 HMAC 上下文类型，可以按值复制
+//   DBP_HMAC_UPDATE / DBP_HMAC_FINAL  对应的 update / final 函数
+//
+// 页布局全部是编译期常量，每种格式各自生成一份，HMAC 输入长度、IV 位置和
+// 解密长度都折叠成常数。生成的函数（DBP_FN 为 db_v4 时）：
+//   db_v4_page_mac       计算一页的 HMAC
+//   db_v4_verify_page    校验一页的 HMAC
+//   db_v4_page_is_zero   全零页（SQLite 预分配的空页），见 db_zero.h
+//   db_v4_decrypt_page_to 校验并解密一页，输出与 Go 侧 common.DecryptPage 一致
+
+#include "db_zero.h"
+
+#define DBP_CAT_(a, b) a##b
+#define DBP_CAT(a, b) DBP_CAT_(a, b)
+
+#define DBP_RESERVE DB_RESERVE(DBP_HMAC_SIZE)
+#define DBP_DATA_END DB_DATA_END(DBP_PAGE_SIZE, DBP_HMAC_SIZE)
+
+/**
+ * 计算第 pgno 页（从 0 开始）的 HMAC：[offset, data_end) 加上小端序的 pgno + 1，
+ * 第 0 页的 offset 为 salt 长度
+ */
+static inline void DBP_CAT(DBP_FN, _page_mac)(const DBP_HMAC_CTX *keyed, const unsigned char *page,
+                                               uint64_t pgno, unsigned char out[DBP_HMAC_SIZE]) {
+    size_t offset = pgno == 0 ? DB_SALT_SIZE : 0;
+    DBP_HMAC_CTX mac = *keyed;
+    DBP_HMAC_UPDATE(&mac, page + offset, DBP_DATA_END - offset);
+    uint32_t n = (uint32_t)(pgno + 1);
+    const unsigned char page_no[4] = {n & 0xFF, (n >> 8) & 0xFF, (n >> 16) & 0xFF, n >> 24};
+    DBP_HMAC_UPDATE(&mac, page_no, sizeof(page_no));
+    DBP_HMAC_FINAL(&mac, out);
+}
+
+static inline bool DBP_CAT(DBP_FN, _verify_page)(const DBP_HMAC_CTX *keyed, const unsigned char *page,
+                                                  uint64_t pgno) {
+    unsigned char calculated[DBP_HMAC_SIZE];
+    DBP_CAT(DBP_FN, _page_mac)(keyed, page, pgno, calculated);
+    return memcmp(calculated, page + DBP_DATA_END, DBP_HMAC_SIZE) == 0;
+}
+
+_Static_assert(DBP_PAGE_SIZE % DB_ZERO_STRIDE == 0, "page size must be a multiple of the zero-check stride");
+
+static inline bool DBP_CAT(DBP_FN, _page_is_zero)(const unsigned char *page) {
+    return db_is_zero(page, DBP_PAGE_SIZE);
+}
+
+/**
+ * 校验并解密一页，结果写到 out（可以与 page 相同）
+ * [offset, page_size - reserve) 解密，尾部 reserve 字节原样保留，第 0 页的 salt 换成
+ * SQLite 文件头；第 0 页之后的全零页原样写出
+ * @return HMAC 不匹配时返回 false，此时 out 不变
+ */
+static inline bool DBP_CAT(DBP_FN, _decrypt_page_to)(const aes256_dec_key *aes,
+                                                      const DBP_HMAC_CTX *keyed,
+                                                      const unsigned char *page, unsigned char *out,
+                                                      uint64_t pgno) {
+    // 第 0 页没有全零的情况：解密前总是先用第一页校验密钥
+    if (pgno > 0 && DBP_CAT(DBP_FN, _page_is_zero)(page)) {
+        if (out != page) {
+            memset(out, 0, DBP_PAGE_SIZE);
+        }
+        return true;
+    }
+    if (!DBP_CAT(DBP_FN, _verify_page)(keyed, page, pgno)) {
+        return false;
+    }
+
+    static const char sqlite_header[DB_SALT_SIZE] = "SQLite format 3";
+    size_t offset = pgno == 0 ? DB_SALT_SIZE : 0;
+    const unsigned char *iv = page + DBP_PAGE_SIZE - DBP_RESERVE;
+    aes256_cbc_decrypt(aes, iv, page + offset, out + offset, DBP_PAGE_SIZE - DBP_RESERVE - offset);
+    if (out != page) {
+        memcpy(out + DBP_PAGE_SIZE - DBP_RESERVE, page + DBP_PAGE_SIZE - DBP_RESERVE, DBP_RESERVE);
+    }
+    if (pgno == 0) {
+        memcpy(out, sqlite_header, DB_SALT_SIZE);
+    }
+    return true;
+}
+
+#undef DBP_RESERVE
+#undef DBP_DATA_END
+#undef DBP_CAT
+#undef DBP_CAT_
+#undef DBP_FN
+#undef DBP_PAGE_SIZE
+#undef DBP_HMAC_SIZE
+#undef DBP_HMAC_CTX
+#undef DBP_HMAC_UPDATE
+#undef DBP_HMAC_FINAL
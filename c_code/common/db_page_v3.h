@@ -0,0 +1,24 @@
+// V3 数据库页校验 / 解密内核：1024 字节页，HMAC-SHA1
+// 生成 db_v3_page_mac / db_v3_verify_page / db_v3_page_is_zero / db_v3_decrypt_page_to，
+// 见 db_page_kernel.h
+
+#ifndef CHATLOG_DB_PAGE_V3_H
+#define CHATLOG_DB_PAGE_V3_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "aes256.h"
+#include "db_format.h"
+#include "sha1.h"
+
+#define DBP_FN db_v3
+#define DBP_PAGE_SIZE DB_V3_PAGE_SIZE
+#define DBP_HMAC_SIZE DB_V3_HMAC_SIZE
+#define DBP_HMAC_CTX hmac_sha1_ctx
+#define DBP_HMAC_UPDATE hmac_sha1_update
+#define DBP_HMAC_FINAL hmac_sha1_final
+#include "db_page_kernel.h"
+
+#endif // CHATLOG_DB_PAGE_V3_H
@@ -0,0 +1,24 @@
+// V4 数据库页校验 / 解密内核：4096 字节页，HMAC-SHA512
+// 生成 db_v4_page_mac / db_v4_verify_page / db_v4_page_is_zero / db_v4_decrypt_page_to，
+// 见 db_page_kernel.h
+
+#ifndef CHATLOG_DB_PAGE_V4_H
+#define CHATLOG_DB_PAGE_V4_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "aes256.h"
+#include "db_format.h"
+#include "sha512_mb.h"
+
+#define DBP_FN db_v4
+#define DBP_PAGE_SIZE DB_V4_PAGE_SIZE
+#define DBP_HMAC_SIZE DB_V4_HMAC_SIZE
+#define DBP_HMAC_CTX hmac_sha512_ctx
+#define DBP_HMAC_UPDATE hmac_sha512_update
+#define DBP_HMAC_FINAL hmac_sha512_final
+#include "db_page_kernel.h"
+
+#endif // CHATLOG_DB_PAGE_V4_H
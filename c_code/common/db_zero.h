@@ -0,0 +1,79 @@
+// 全零页检测，db_page_kernel.h 和整库解密共用
+//
+// SQLite 预分配或刚扩展出来的页全为零，不加密也不带 HMAC。密文页的前几个字节就不为零，
+// 所以检测的开销主要在真正的全零页上：每 64 字节（一个缓存行）做一次 OR 归约再判断，
+// SSE2 / AVX2 / NEON 都是编译期选择（x86-64 和 aarch64 的基线指令集不需要运行时检测），
+// 其他平台用 8 个 64 位字的 OR 归约。
+
+#ifndef CHATLOG_DB_ZERO_H
+#define CHATLOG_DB_ZERO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define DB_ZERO_AVX2 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DB_ZERO_SSE2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define DB_ZERO_NEON 1
+#endif
+
+#define DB_ZERO_STRIDE 64
+
+/**
+ * [p, p + len) 是否全为零
+ * @param len DB_ZERO_STRIDE 的整数倍（两种页大小都满足）
+ */
+static inline bool db_is_zero(const unsigned char *p, size_t len) {
+    for (size_t i = 0; i < len; i += DB_ZERO_STRIDE) {
+        const unsigned char *b = p + i;
+#if defined(DB_ZERO_AVX2)
+        __m256i v = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)b),
+                                    _mm256_loadu_si256((const __m256i *)(b + 32)));
+        if (!_mm256_testz_si256(v, v)) {
+            return false;
+        }
+#elif defined(DB_ZERO_SSE2)
+        __m128i v = _mm_or_si128(_mm_or_si128(_mm_loadu_si128((const __m128i *)b),
+                                              _mm_loadu_si128((const __m128i *)(b + 16))),
+                                 _mm_or_si128(_mm_loadu_si128((const __m128i *)(b + 32)),
+                                              _mm_loadu_si128((const __m128i *)(b + 48))));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF) {
+            return false;
+        }
+#elif defined(DB_ZERO_NEON)
+        uint8x16_t v = vorrq_u8(vorrq_u8(vld1q_u8(b), vld1q_u8(b + 16)),
+                                vorrq_u8(vld1q_u8(b + 32), vld1q_u8(b + 48)));
+        if (vmaxvq_u32(vreinterpretq_u32_u8(v)) != 0) {
+            return false;
+        }
+#else
+        uint64_t w[DB_ZERO_STRIDE / sizeof(uint64_t)];
+        memcpy(w, b, sizeof(w));
+        if (w[0] | w[1] | w[2] | w[3] | w[4] | w[5] | w[6] | w[7]) {
+            return false;
+        }
+#endif
+    }
+    return true;
+}
+
+/**
+ * data 中从 first 开始连续的全零页数，最多检查到第 count 页
+ */
+static inline size_t db_zero_run(const unsigned char *data, size_t page_size, size_t first,
+                                 size_t count) {
+    size_t n = first;
+    while (n < count && db_is_zero(data + n * page_size, page_size)) {
+        n++;
+    }
+    return n - first;
+}
+
+#endif // CHATLOG_DB_ZERO_H
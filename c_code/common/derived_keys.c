@@ -0,0 +1,285 @@
+// 派生密钥存储实现，见 derived_keys.h
+
+#include "derived_keys.h"
+#include "log.h"
+#include "sha512_mb.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DERIVED_KEYS_MAGIC "CLDKEYS1"
+#define MAGIC_SIZE 8
+
+static const char SEAL_LABEL[] = "chatlog derived key seal";
+static const char ID_LABEL[] = "chatlog derived key id:";
+
+// 防止编译器把释放前的清零优化掉
+static void secure_zero(void *p, size_t len) {
+    volatile unsigned char *v = p;
+    while (len--) {
+        *v++ = 0;
+    }
+}
+
+static bool equal_ct(const unsigned char *a, const unsigned char *b, size_t len) {
+    unsigned char diff = 0;
+    for (size_t i = 0; i < len; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+static void hmac(const unsigned char *key, size_t key_len, const void *a, size_t a_len,
+                 const void *b, size_t b_len, unsigned char out[SHA512_DIGEST_SIZE]) {
+    hmac_sha512_ctx ctx;
+    hmac_sha512_init(&ctx, key, key_len);
+    hmac_sha512_update(&ctx, a, a_len);
+    if (b_len > 0) {
+        hmac_sha512_update(&ctx, b, b_len);
+    }
+    hmac_sha512_final(&ctx, out);
+    secure_zero(&ctx, sizeof(ctx));
+}
+
+static void record_id(const char *kdf, const unsigned char *key, const unsigned char *salt,
+                      unsigned char id[DERIVED_KEYS_ID_SIZE]) {
+    hmac_sha512_ctx ctx;
+    unsigned char digest[SHA512_DIGEST_SIZE];
+    hmac_sha512_init(&ctx, key, DERIVED_KEYS_KEY_SIZE);
+    hmac_sha512_update(&ctx, ID_LABEL, sizeof(ID_LABEL) - 1);
+    hmac_sha512_update(&ctx, kdf, strlen(kdf));
+    hmac_sha512_update(&ctx, ":", 1);
+    hmac_sha512_update(&ctx, salt, DERIVED_KEYS_SALT_SIZE);
+    hmac_sha512_final(&ctx, digest);
+    memcpy(id, digest, DERIVED_KEYS_ID_SIZE);
+    secure_zero(&ctx, sizeof(ctx));
+}
+
+/**
+ * 计算 id 对应的密钥流和认证标签；sealed 为 NULL 时只计算密钥流
+ */
+static void seal_material(const unsigned char *key, const unsigned char *id,
+                          const unsigned char *sealed, unsigned char stream[SHA512_DIGEST_SIZE],
+                          unsigned char tag[DERIVED_KEYS_TAG_SIZE]) {
+    unsigned char seal[SHA512_DIGEST_SIZE];
+    hmac(key, DERIVED_KEYS_KEY_SIZE, SEAL_LABEL, sizeof(SEAL_LABEL) - 1, NULL, 0, seal);
+    hmac(seal, 32, id, DERIVED_KEYS_ID_SIZE, NULL, 0, stream);
+    if (sealed) {
+        unsigned char digest[SHA512_DIGEST_SIZE];
+        hmac(seal + 32, 32, id, DERIVED_KEYS_ID_SIZE, sealed, DERIVED_KEYS_KEY_SIZE * 2, digest);
+        memcpy(tag, digest, DERIVED_KEYS_TAG_SIZE);
+    }
+    secure_zero(seal, sizeof(seal));
+}
+
+static derived_keys_record *find(derived_keys *store, const unsigned char *id) {
+    for (size_t i = 0; i < store->count; i++) {
+        if (memcmp(store->records[i].id, id, DERIVED_KEYS_ID_SIZE) == 0) {
+            return &store->records[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * 加入一条记录，id 已存在时覆盖
+ */
+static bool insert(derived_keys *store, const derived_keys_record *rec) {
+    derived_keys_record *slot = find(store, rec->id);
+    if (!slot) {
+        if (store->count == store->cap) {
+            size_t cap = store->cap ? store->cap * 2 : 16;
+            derived_keys_record *records = realloc(store->records, cap * sizeof(*records));
+            if (!records) {
+                return false;
+            }
+            store->records = records;
+            store->cap = cap;
+        }
+        slot = &store->records[store->count++];
+    }
+    *slot = *rec;
+    return true;
+}
+
+/**
+ * 读取落盘文件中的记录，已经在内存中的 id 保持不变
+ */
+static void load_file(derived_keys *store) {
+    FILE *fp = fopen(store->path, "rb");
+    if (!fp) {
+        return;
+    }
+
+    char magic[MAGIC_SIZE];
+    if (fread(magic, sizeof(magic), 1, fp) != 1 || memcmp(magic, DERIVED_KEYS_MAGIC, MAGIC_SIZE) != 0) {
+        fclose(fp);
+        return;
+    }
+
+    derived_keys_record rec;
+    while (fread(&rec, sizeof(rec), 1, fp) == 1) {
+        if (!find(store, rec.id)) {
+            insert(store, &rec);
+        }
+    }
+    fclose(fp);
+}
+
+derived_keys *derived_keys_open(const char *path) {
+    derived_keys *store = calloc(1, sizeof(derived_keys));
+    if (!store) {
+        return NULL;
+    }
+    pthread_mutex_init(&store->lock, NULL);
+
+    if (path && path[0]) {
+        store->path = strdup(path);
+        if (!store->path) {
+            free(store);
+            return NULL;
+        }
+        load_file(store);
+    }
+    return store;
+}
+
+bool derived_keys_get(derived_keys *store, const char *kdf,
+                      const unsigned char key[DERIVED_KEYS_KEY_SIZE],
+                      const unsigned char salt[DERIVED_KEYS_SALT_SIZE],
+                      unsigned char enc_key[DERIVED_KEYS_KEY_SIZE],
+                      unsigned char mac_key[DERIVED_KEYS_KEY_SIZE]) {
+    if (!store) {
+        return false;
+    }
+
+    unsigned char id[DERIVED_KEYS_ID_SIZE];
+    record_id(kdf, key, salt, id);
+
+    pthread_mutex_lock(&store->lock);
+    derived_keys_record *found = find(store, id);
+    derived_keys_record rec;
+    if (found) {
+        rec = *found;
+    }
+    pthread_mutex_unlock(&store->lock);
+    if (!found) {
+        return false;
+    }
+
+    unsigned char stream[SHA512_DIGEST_SIZE];
+    unsigned char tag[DERIVED_KEYS_TAG_SIZE];
+    seal_material(key, id, rec.sealed, stream, tag);
+    if (!equal_ct(tag, rec.tag, DERIVED_KEYS_TAG_SIZE)) {
+        log_debug("Derived key record failed authentication, ignoring");
+        secure_zero(stream, sizeof(stream));
+        return false;
+    }
+    for (int i = 0; i < DERIVED_KEYS_KEY_SIZE; i++) {
+        enc_key[i] = rec.sealed[i] ^ stream[i];
+        mac_key[i] = rec.sealed[DERIVED_KEYS_KEY_SIZE + i] ^ stream[DERIVED_KEYS_KEY_SIZE + i];
+    }
+    secure_zero(stream, sizeof(stream));
+    return true;
+}
+
+void derived_keys_put(derived_keys *store, const char *kdf,
+                      const unsigned char key[DERIVED_KEYS_KEY_SIZE],
+                      const unsigned char salt[DERIVED_KEYS_SALT_SIZE],
+                      const unsigned char enc_key[DERIVED_KEYS_KEY_SIZE],
+                      const unsigned char mac_key[DERIVED_KEYS_KEY_SIZE]) {
+    if (!store) {
+        return;
+    }
+
+    derived_keys_record rec;
+    unsigned char stream[SHA512_DIGEST_SIZE];
+    record_id(kdf, key, salt, rec.id);
+    seal_material(key, rec.id, NULL, stream, NULL);
+    for (int i = 0; i < DERIVED_KEYS_KEY_SIZE; i++) {
+        rec.sealed[i] = enc_key[i] ^ stream[i];
+        rec.sealed[DERIVED_KEYS_KEY_SIZE + i] = mac_key[i] ^ stream[DERIVED_KEYS_KEY_SIZE + i];
+    }
+    seal_material(key, rec.id, rec.sealed, stream, rec.tag);
+    secure_zero(stream, sizeof(stream));
+
+    pthread_mutex_lock(&store->lock);
+    if (insert(store, &rec)) {
+        store->dirty = true;
+    }
+    pthread_mutex_unlock(&store->lock);
+}
+
+static int save_locked(derived_keys *store) {
+    if (!store->dirty) {
+        return 0;
+    }
+
+    // 其他进程（Go 服务、另一个工具）可能在此期间写入了新记录
+    load_file(store);
+
+    // 先写临时文件再 rename，避免中途失败留下损坏的文件
+    size_t len = strlen(store->path) + 5;
+    char *tmp_path = malloc(len);
+    if (!tmp_path) {
+        return -1;
+    }
+    snprintf(tmp_path, len, "%s.tmp", store->path);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    FILE *fp = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!fp) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        log_warn("Failed to write derived key store %s", tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+
+    bool ok = fwrite(DERIVED_KEYS_MAGIC, MAGIC_SIZE, 1, fp) == 1;
+    if (ok && store->count > 0) {
+        ok = fwrite(store->records, sizeof(derived_keys_record), store->count, fp) == store->count;
+    }
+    if (fclose(fp) != 0) {
+        ok = false;
+    }
+
+    if (!ok || rename(tmp_path, store->path) != 0) {
+        log_warn("Failed to write derived key store %s", store->path);
+        remove(tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+
+    free(tmp_path);
+    store->dirty = false;
+    return 0;
+}
+
+int derived_keys_save(derived_keys *store) {
+    if (!store || !store->path) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&store->lock);
+    int ret = save_locked(store);
+    pthread_mutex_unlock(&store->lock);
+    return ret;
+}
+
+void derived_keys_close(derived_keys *store) {
+    if (!store) {
+        return;
+    }
+    if (store->records) {
+        secure_zero(store->records, store->cap * sizeof(derived_keys_record));
+    }
+    free(store->records);
+    free(store->path);
+    pthread_mutex_destroy(&store->lock);
+    free(store);
+}
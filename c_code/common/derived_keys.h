@@ -0,0 +1,85 @@
+// 派生密钥存储，C 工具与 Go 侧 internal/wechat/decrypt/common/keystore.go 共用
+//
+// 一个微信账号下所有数据库的原始密钥相同，但每个数据库第一页的 salt 不同，
+// 每个 (原始密钥, salt) 都要跑一遍 256000 轮 PBKDF2 才能得到 enc_key/mac_key。
+// 这里按 (kdf, 原始密钥, salt) 记录已经校验通过的派生结果，进程内只派生一次；
+// 可选地落盘，文件格式与 Go 侧一致，testkey 找到密钥后写入，
+// v4_decrypt 和 Go 服务启动时直接读出，不再为每个数据库重新派生。
+//
+// 落盘内容由原始密钥封装，没有原始密钥既无法解开也无法判断属于哪个数据库：
+//   seal   = HMAC-SHA512(key, "chatlog derived key seal")，前 32 字节加密、后 32 字节认证
+//   id     = HMAC-SHA512(key, "chatlog derived key id:" || kdf || ":" || salt)[:16]
+//   sealed = (enc_key || mac_key) XOR HMAC-SHA512(seal[0:32], id)
+//   tag    = HMAC-SHA512(seal[32:64], id || sealed)[:16]
+// 文件格式：magic "CLDKEYS1" | 记录(id | sealed | tag) * n
+
+#ifndef CHATLOG_DERIVED_KEYS_H
+#define CHATLOG_DERIVED_KEYS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define DERIVED_KEYS_KEY_SIZE 32
+#define DERIVED_KEYS_SALT_SIZE 16
+#define DERIVED_KEYS_ID_SIZE 16
+#define DERIVED_KEYS_TAG_SIZE 16
+
+// 与 Go 侧 common.KDFV4 一致
+#define DERIVED_KEYS_KDF_V4 "pbkdf2-sha512-256000"
+
+typedef struct {
+    unsigned char id[DERIVED_KEYS_ID_SIZE];
+    unsigned char sealed[DERIVED_KEYS_KEY_SIZE * 2];
+    unsigned char tag[DERIVED_KEYS_TAG_SIZE];
+} derived_keys_record;
+
+// 所有接口都是线程安全的
+typedef struct {
+    pthread_mutex_t lock;
+    derived_keys_record *records;
+    size_t count;
+    size_t cap;
+    char *path;  // 为 NULL 时只在进程内
+    bool dirty;
+} derived_keys;
+
+/**
+ * 打开存储
+ * @param path 落盘文件，为 NULL 时只使用进程内存储；文件不存在或格式错误时视为空
+ * @return 存储对象，失败返回 NULL
+ */
+derived_keys *derived_keys_open(const char *path);
+
+/**
+ * 查询派生结果
+ * @return 命中并通过认证时返回 true，并写出 enc_key/mac_key
+ */
+bool derived_keys_get(derived_keys *store, const char *kdf,
+                      const unsigned char key[DERIVED_KEYS_KEY_SIZE],
+                      const unsigned char salt[DERIVED_KEYS_SALT_SIZE],
+                      unsigned char enc_key[DERIVED_KEYS_KEY_SIZE],
+                      unsigned char mac_key[DERIVED_KEYS_KEY_SIZE]);
+
+/**
+ * 记录一个已经用数据库第一页校验过的派生结果，不要存未经校验的候选
+ */
+void derived_keys_put(derived_keys *store, const char *kdf,
+                      const unsigned char key[DERIVED_KEYS_KEY_SIZE],
+                      const unsigned char salt[DERIVED_KEYS_SALT_SIZE],
+                      const unsigned char enc_key[DERIVED_KEYS_KEY_SIZE],
+                      const unsigned char mac_key[DERIVED_KEYS_KEY_SIZE]);
+
+/**
+ * 写回落盘文件（未配置文件或没有新记录时什么都不做）
+ * 先合并文件中其他进程写入的记录，再写临时文件改名替换
+ * @return 0 成功，-1 失败
+ */
+int derived_keys_save(derived_keys *store);
+
+/**
+ * 释放存储，不会自动保存
+ */
+void derived_keys_close(derived_keys *store);
+
+#endif // CHATLOG_DERIVED_KEYS_H
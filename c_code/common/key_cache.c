@@ -0,0 +1,338 @@
+// 候选密钥派生结果缓存实现，见 key_cache.h
+
+#include "key_cache.h"
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_CACHE_MAGIC "CLKC"
+#define KEY_CACHE_VERSION 1
+
+// 磁盘文件头，后面紧跟 count 个 16 字节指纹（本机字节序）
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+    unsigned char salt[KEY_CACHE_SALT_SIZE];
+} key_cache_file_header;
+
+// 防止编译器把释放前的清零优化掉
+static void secure_zero(void *p, size_t len) {
+    volatile unsigned char *v = p;
+    while (len--) {
+        *v++ = 0;
+    }
+}
+
+static uint64_t load_u64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * 计算 (salt, candidate) 的 128 位指纹
+ * 不需要抗碰撞，只要求分布均匀，两个不同种子各算一遍
+ */
+static void fingerprint(const unsigned char *salt, const unsigned char *candidate,
+                        uint64_t fp[2]) {
+    uint64_t words[6];
+    words[0] = load_u64(salt);
+    words[1] = load_u64(salt + 8);
+    for (int i = 0; i < 4; i++) {
+        words[2 + i] = load_u64(candidate + i * 8);
+    }
+
+    uint64_t a = 0x9e3779b97f4a7c15ULL;
+    uint64_t b = 0x6a09e667f3bcc908ULL;
+    for (int i = 0; i < 6; i++) {
+        a = mix64(a ^ words[i]) + 0x9e3779b97f4a7c15ULL;
+        b = mix64(b + words[5 - i]) ^ 0xbb67ae8584caa73bULL;
+    }
+    fp[0] = a ? a : 1; // 0 保留给空槽
+    fp[1] = b;
+}
+
+static size_t round_up_pow2(size_t v) {
+    size_t n = 1;
+    while (n < v) {
+        n <<= 1;
+    }
+    return n;
+}
+
+static key_cache_entry *find_slot(key_cache *cache, const uint64_t fp[2]) {
+    key_cache_entry *set = cache->entries + (fp[0] & (cache->num_sets - 1)) * KEY_CACHE_WAYS;
+    for (int i = 0; i < KEY_CACHE_WAYS; i++) {
+        if (set[i].fp[0] == fp[0] && set[i].fp[1] == fp[1]) {
+            return &set[i];
+        }
+    }
+    return NULL;
+}
+
+static void touch(key_cache *cache, key_cache_entry *entry) {
+    size_t index = (size_t)(entry - cache->entries);
+    key_cache_entry *set = cache->entries + (index / KEY_CACHE_WAYS) * KEY_CACHE_WAYS;
+    for (int i = 0; i < KEY_CACHE_WAYS; i++) {
+        if (set[i].age < UINT8_MAX) {
+            set[i].age++;
+        }
+    }
+    entry->age = 0;
+}
+
+/**
+ * 选择替换槽位：优先空槽，其次最久未用的失败条目，
+ * 只有整组都是有效密钥时才会替换有效密钥
+ */
+static key_cache_entry *victim_slot(key_cache *cache, const uint64_t fp[2]) {
+    key_cache_entry *set = cache->entries + (fp[0] & (cache->num_sets - 1)) * KEY_CACHE_WAYS;
+    key_cache_entry *victim = NULL;
+    for (int i = 0; i < KEY_CACHE_WAYS; i++) {
+        if (set[i].fp[0] == 0) {
+            return &set[i];
+        }
+        if (!victim ||
+            (victim->verdict == KEY_CACHE_GOOD && set[i].verdict != KEY_CACHE_GOOD) ||
+            (victim->verdict == set[i].verdict && set[i].age > victim->age)) {
+            victim = &set[i];
+        }
+    }
+    return victim;
+}
+
+static void insert(key_cache *cache, const uint64_t fp[2], bool good,
+                   const unsigned char *enc_key, const unsigned char *mac_key) {
+    key_cache_entry *entry = find_slot(cache, fp);
+    if (!entry) {
+        entry = victim_slot(cache, fp);
+    }
+
+    entry->fp[0] = fp[0];
+    entry->fp[1] = fp[1];
+    entry->verdict = good ? KEY_CACHE_GOOD : KEY_CACHE_BAD;
+    if (good) {
+        memcpy(entry->enc_key, enc_key, KEY_CACHE_KEY_SIZE);
+        memcpy(entry->mac_key, mac_key, KEY_CACHE_KEY_SIZE);
+    } else {
+        memset(entry->enc_key, 0, KEY_CACHE_KEY_SIZE);
+        memset(entry->mac_key, 0, KEY_CACHE_KEY_SIZE);
+    }
+    touch(cache, entry);
+}
+
+/**
+ * 读取磁盘缓存文件，salt 不匹配或格式错误时忽略整个文件
+ */
+static void load_disk(key_cache *cache) {
+    FILE *fp = fopen(cache->disk_path, "rb");
+    if (!fp) {
+        return;
+    }
+
+    key_cache_file_header header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, KEY_CACHE_MAGIC, 4) != 0 ||
+        header.version != KEY_CACHE_VERSION ||
+        memcmp(header.salt, cache->salt, KEY_CACHE_SALT_SIZE) != 0) {
+        fclose(fp);
+        return;
+    }
+
+    uint64_t fpr[2];
+    for (uint32_t i = 0; i < header.count; i++) {
+        if (fread(fpr, sizeof(fpr), 1, fp) != 1) {
+            break;
+        }
+        if (fpr[0] == 0) {
+            continue;
+        }
+        insert(cache, fpr, false, NULL, NULL);
+        cache->loaded++;
+    }
+    fclose(fp);
+}
+
+key_cache *key_cache_open(const unsigned char *salt, size_t max_entries,
+                          const char *cache_dir) {
+    if (!salt) {
+        return NULL;
+    }
+    if (max_entries == 0) {
+        max_entries = KEY_CACHE_DEFAULT_ENTRIES;
+    }
+
+    key_cache *cache = calloc(1, sizeof(key_cache));
+    if (!cache) {
+        return NULL;
+    }
+
+    cache->num_sets = round_up_pow2((max_entries + KEY_CACHE_WAYS - 1) / KEY_CACHE_WAYS);
+    cache->entries = calloc(cache->num_sets * KEY_CACHE_WAYS, sizeof(key_cache_entry));
+    if (!cache->entries) {
+        free(cache);
+        return NULL;
+    }
+    memcpy(cache->salt, salt, KEY_CACHE_SALT_SIZE);
+    pthread_mutex_init(&cache->lock, NULL);
+
+    if (cache_dir && cache_dir[0]) {
+        // <dir>/v4_<salt hex>.kcache
+        size_t len = strlen(cache_dir) + KEY_CACHE_SALT_SIZE * 2 + 16;
+        cache->disk_path = malloc(len);
+        if (cache->disk_path) {
+            int n = snprintf(cache->disk_path, len, "%s/v4_", cache_dir);
+            for (int i = 0; i < KEY_CACHE_SALT_SIZE; i++) {
+                n += snprintf(cache->disk_path + n, len - n, "%02x", salt[i]);
+            }
+            snprintf(cache->disk_path + n, len - n, ".kcache");
+            load_disk(cache);
+        }
+    }
+
+    return cache;
+}
+
+key_cache_verdict key_cache_lookup(key_cache *cache, const unsigned char *candidate,
+                                   unsigned char *enc_key, unsigned char *mac_key) {
+    if (!cache || !candidate) {
+        return KEY_CACHE_MISS;
+    }
+
+    uint64_t fp[2];
+    fingerprint(cache->salt, candidate, fp);
+
+    pthread_mutex_lock(&cache->lock);
+    key_cache_entry *entry = find_slot(cache, fp);
+    if (!entry) {
+        cache->misses++;
+        pthread_mutex_unlock(&cache->lock);
+        return KEY_CACHE_MISS;
+    }
+
+    touch(cache, entry);
+    cache->hits++;
+    key_cache_verdict verdict = (key_cache_verdict)entry->verdict;
+    if (verdict == KEY_CACHE_GOOD) {
+        if (enc_key) {
+            memcpy(enc_key, entry->enc_key, KEY_CACHE_KEY_SIZE);
+        }
+        if (mac_key) {
+            memcpy(mac_key, entry->mac_key, KEY_CACHE_KEY_SIZE);
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return verdict;
+}
+
+void key_cache_store(key_cache *cache, const unsigned char *candidate, bool good,
+                     const unsigned char *enc_key, const unsigned char *mac_key) {
+    if (!cache || !candidate || (good && (!enc_key || !mac_key))) {
+        return;
+    }
+
+    uint64_t fp[2];
+    fingerprint(cache->salt, candidate, fp);
+
+    pthread_mutex_lock(&cache->lock);
+    insert(cache, fp, good, enc_key, mac_key);
+    if (!good) {
+        cache->dirty = true;
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+static int save_locked(key_cache *cache);
+
+int key_cache_save(key_cache *cache) {
+    if (!cache || !cache->disk_path) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    int ret = save_locked(cache);
+    pthread_mutex_unlock(&cache->lock);
+    return ret;
+}
+
+static int save_locked(key_cache *cache) {
+    if (!cache->dirty) {
+        return 0;
+    }
+
+    size_t total = cache->num_sets * KEY_CACHE_WAYS;
+    key_cache_file_header header;
+    memcpy(header.magic, KEY_CACHE_MAGIC, 4);
+    header.version = KEY_CACHE_VERSION;
+    header.count = 0;
+    header.reserved = 0;
+    memcpy(header.salt, cache->salt, KEY_CACHE_SALT_SIZE);
+    for (size_t i = 0; i < total; i++) {
+        if (cache->entries[i].fp[0] != 0 && cache->entries[i].verdict == KEY_CACHE_BAD) {
+            header.count++;
+        }
+    }
+
+    // 先写临时文件再 rename，避免中途失败留下损坏的缓存
+    size_t len = strlen(cache->disk_path) + 5;
+    char *tmp_path = malloc(len);
+    if (!tmp_path) {
+        return -1;
+    }
+    snprintf(tmp_path, len, "%s.tmp", cache->disk_path);
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        log_warn("Failed to write key cache %s", tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    for (size_t i = 0; ok && i < total; i++) {
+        const key_cache_entry *entry = &cache->entries[i];
+        if (entry->fp[0] != 0 && entry->verdict == KEY_CACHE_BAD) {
+            ok = fwrite(entry->fp, sizeof(entry->fp), 1, fp) == 1;
+        }
+    }
+    if (fclose(fp) != 0) {
+        ok = false;
+    }
+
+    if (!ok || rename(tmp_path, cache->disk_path) != 0) {
+        log_warn("Failed to write key cache %s", cache->disk_path);
+        remove(tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+
+    free(tmp_path);
+    cache->dirty = false;
+    return 0;
+}
+
+void key_cache_close(key_cache *cache) {
+    if (!cache) {
+        return;
+    }
+    key_cache_save(cache);
+    pthread_mutex_destroy(&cache->lock);
+    // 有效密钥的派生结果不应残留在已释放的内存里
+    secure_zero(cache->entries, cache->num_sets * KEY_CACHE_WAYS * sizeof(key_cache_entry));
+    free(cache->entries);
+    free(cache->disk_path);
+    free(cache);
+}
@@ -0,0 +1,86 @@
+// 候选密钥派生结果缓存，Linux/macOS 两个 testkey 工具共用
+//
+// testkey_v4 每个候选都要跑一遍 256000 轮 PBKDF2-SHA512，而进程堆里同一段
+// 32 字节经常出现很多次，同一个数据库 salt 也会在多次运行之间反复使用。
+// 这里按 (salt, candidate) 做一个有界的组相联缓存：
+//   - 已验证失败的候选直接返回 KEY_CACHE_BAD，O(1) 跳过
+//   - 验证成功的候选连同派生出的 enc_key / mac_key 一起保存
+// 另外可选地为每个 salt 维护一个磁盘文件，只记录被拒绝候选的指纹
+// （不落盘任何密钥材料），微信重启后重跑可以直接跳过这些候选。
+
+#ifndef CHATLOG_KEY_CACHE_H
+#define CHATLOG_KEY_CACHE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define KEY_CACHE_KEY_SIZE 32
+#define KEY_CACHE_SALT_SIZE 16
+#define KEY_CACHE_WAYS 4
+#define KEY_CACHE_DEFAULT_ENTRIES 16384
+
+typedef enum {
+    KEY_CACHE_MISS = 0,
+    KEY_CACHE_BAD = 1,
+    KEY_CACHE_GOOD = 2,
+} key_cache_verdict;
+
+typedef struct {
+    uint64_t fp[2];    // (salt, candidate) 的 128 位指纹，fp[0] == 0 表示空槽
+    uint8_t verdict;   // key_cache_verdict
+    uint8_t age;       // 组内替换用的时钟计数
+    unsigned char enc_key[KEY_CACHE_KEY_SIZE];
+    unsigned char mac_key[KEY_CACHE_KEY_SIZE];
+} key_cache_entry;
+
+// 所有接口都是线程安全的，多个扫描线程可以共用一个缓存
+typedef struct {
+    pthread_mutex_t lock;
+    key_cache_entry *entries;
+    size_t num_sets;   // 2 的幂
+    unsigned char salt[KEY_CACHE_SALT_SIZE];
+    char *disk_path;   // 为 NULL 时不落盘
+    bool dirty;
+    // 统计信息
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t loaded;
+} key_cache;
+
+/**
+ * 创建缓存
+ * @param salt 数据库第一页前16字节
+ * @param max_entries 最大条目数，0 表示使用默认值，会向上取整到 2 的幂
+ * @param cache_dir 磁盘缓存目录，为 NULL 时只使用进程内缓存
+ * @return 缓存对象，失败返回 NULL
+ */
+key_cache *key_cache_open(const unsigned char *salt, size_t max_entries,
+                          const char *cache_dir);
+
+/**
+ * 查询候选密钥
+ * @param enc_key/mac_key 命中 KEY_CACHE_GOOD 时写出派生密钥，可以为 NULL
+ */
+key_cache_verdict key_cache_lookup(key_cache *cache, const unsigned char *candidate,
+                                   unsigned char *enc_key, unsigned char *mac_key);
+
+/**
+ * 记录一次验证结果，good 为 true 时必须提供 enc_key/mac_key
+ */
+void key_cache_store(key_cache *cache, const unsigned char *candidate, bool good,
+                     const unsigned char *enc_key, const unsigned char *mac_key);
+
+/**
+ * 把被拒绝的候选指纹写回磁盘缓存文件（未配置目录时什么都不做）
+ * @return 0 成功，-1 失败
+ */
+int key_cache_save(key_cache *cache);
+
+/**
+ * 保存并释放缓存
+ */
+void key_cache_close(key_cache *cache);
+
+#endif // CHATLOG_KEY_CACHE_H
@@ -0,0 +1,210 @@
+// 密钥位置提示实现，见 key_hint.h
+
+#include "key_hint.h"
+#include "log.h"
+#include "pattern_scan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_HINT_MAGIC "CLKH"
+#define KEY_HINT_FILE_VERSION 1
+#define KEY_HINT_KEY_SIZE CANDIDATE_LIST_KEY_SIZE
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+} key_hint_file_header;
+
+static uint32_t size_class(uint64_t size) {
+    uint32_t c = 0;
+    while (size > 1) {
+        size >>= 1;
+        c++;
+    }
+    return c;
+}
+
+static void load_file(key_hint_store *store) {
+    FILE *fp = fopen(store->path, "rb");
+    if (!fp) {
+        return;
+    }
+
+    key_hint_file_header header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, KEY_HINT_MAGIC, 4) != 0 ||
+        header.version != KEY_HINT_FILE_VERSION) {
+        fclose(fp);
+        return;
+    }
+
+    for (uint32_t i = 0; i < header.count && store->count < KEY_HINT_MAX_ENTRIES; i++) {
+        key_hint *h = &store->items[store->count];
+        if (fread(h, sizeof(*h), 1, fp) != 1) {
+            break;
+        }
+        h->app_version[KEY_HINT_VERSION_SIZE - 1] = '\0';
+        store->count++;
+    }
+    fclose(fp);
+}
+
+key_hint_store *key_hint_open(const char *path) {
+    key_hint_store *store = calloc(1, sizeof(key_hint_store));
+    if (!store) {
+        return NULL;
+    }
+    if (path) {
+        store->path = strdup(path);
+        if (!store->path) {
+            free(store);
+            return NULL;
+        }
+        load_file(store);
+    }
+    return store;
+}
+
+static bool same_version(const key_hint *h, const char *app_version) {
+    return strncmp(h->app_version, app_version ? app_version : "", KEY_HINT_VERSION_SIZE - 1) == 0;
+}
+
+size_t key_hint_collect(const key_hint_store *store, const char *app_version,
+                        const key_hint_region *regions, size_t n,
+                        region_stream_read_fn read, void *ctx, candidate_list *out) {
+    if (!store) {
+        return 0;
+    }
+
+    size_t found = 0;
+    for (size_t i = 0; i < store->count && found < KEY_HINT_MAX_PROBES; i++) {
+        const key_hint *h = &store->items[i];
+        if (!same_version(h, app_version)) {
+            continue;
+        }
+        for (size_t r = 0; r < n && found < KEY_HINT_MAX_PROBES; r++) {
+            const key_hint_region *region = &regions[r];
+            uint64_t size = region->end - region->start;
+            uint32_t c = size_class(size);
+            if (region->kind != h->kind || c + 1 < h->size_class || c > h->size_class + 1) {
+                continue;
+            }
+            // 特征码和密钥都要落在区域内
+            int64_t key_pos = (int64_t)h->offset + h->key_offset;
+            if (h->offset + PATTERN_SCAN_LEN > size || key_pos < 0 ||
+                (uint64_t)key_pos + KEY_HINT_KEY_SIZE > size) {
+                continue;
+            }
+
+            unsigned char pattern[PATTERN_SCAN_LEN];
+            unsigned char key[KEY_HINT_KEY_SIZE];
+            uint64_t addr = region->start + h->offset;
+            if (read(ctx, addr, pattern, sizeof(pattern)) != 0 ||
+                memcmp(pattern, v4_key_pattern, PATTERN_SCAN_LEN) != 0 ||
+                read(ctx, region->start + (uint64_t)key_pos, key, sizeof(key)) != 0) {
+                continue;
+            }
+            log_trace("Hinted pattern at 0x%llx, key offset %d", (unsigned long long)addr,
+                      h->key_offset);
+            if (candidate_list_push(out, key, key_hint_tag(addr, h->key_offset))) {
+                found++;
+            }
+            memset(key, 0, sizeof(key));
+        }
+    }
+    return found;
+}
+
+void key_hint_record(key_hint_store *store, const char *app_version,
+                     const key_hint_region *region, uint64_t tag) {
+    if (!store || !region || tag == 0) {
+        return;
+    }
+    uint64_t addr = key_hint_tag_addr(tag);
+    if (addr < region->start || addr >= region->end) {
+        return;
+    }
+
+    key_hint h;
+    memset(&h, 0, sizeof(h));
+    snprintf(h.app_version, sizeof(h.app_version), "%s", app_version ? app_version : "");
+    h.kind = region->kind;
+    h.size_class = size_class(region->end - region->start);
+    h.offset = addr - region->start;
+    h.key_offset = key_hint_tag_key_offset(tag);
+    h.hits = 1;
+
+    // 同一位置只保留一条，大小量级以最近一次为准
+    size_t pos = store->count < KEY_HINT_MAX_ENTRIES ? store->count : KEY_HINT_MAX_ENTRIES - 1;
+    for (size_t i = 0; i < store->count; i++) {
+        const key_hint *old = &store->items[i];
+        if (old->kind == h.kind && old->offset == h.offset && old->key_offset == h.key_offset &&
+            same_version(old, h.app_version)) {
+            h.hits = old->hits + 1;
+            pos = i;
+            break;
+        }
+    }
+    if (pos == store->count) {
+        store->count++;
+    }
+    memmove(&store->items[1], &store->items[0], pos * sizeof(key_hint));
+    store->items[0] = h;
+    store->dirty = true;
+}
+
+int key_hint_save(key_hint_store *store) {
+    if (!store || !store->path || !store->dirty) {
+        return 0;
+    }
+
+    key_hint_file_header header;
+    memcpy(header.magic, KEY_HINT_MAGIC, 4);
+    header.version = KEY_HINT_FILE_VERSION;
+    header.count = (uint32_t)store->count;
+    header.reserved = 0;
+
+    // 先写临时文件再 rename，避免中途失败留下损坏的文件
+    size_t len = strlen(store->path) + 5;
+    char *tmp_path = malloc(len);
+    if (!tmp_path) {
+        return -1;
+    }
+    snprintf(tmp_path, len, "%s.tmp", store->path);
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        log_warn("Failed to write key hints %s", tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(store->items, sizeof(key_hint), store->count, fp) == store->count;
+    if (fclose(fp) != 0) {
+        ok = false;
+    }
+
+    if (!ok || rename(tmp_path, store->path) != 0) {
+        log_warn("Failed to write key hints %s", store->path);
+        remove(tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+
+    free(tmp_path);
+    store->dirty = false;
+    return 0;
+}
+
+void key_hint_close(key_hint_store *store) {
+    if (!store) {
+        return;
+    }
+    key_hint_save(store);
+    free(store->path);
+    free(store);
+}
@@ -0,0 +1,108 @@
+// 密钥位置提示，Linux/macOS 两个 testkey 工具共用
+//
+// 微信每次重启后都要从头扫描整个进程，但密钥几乎总是出现在同一类区域里、
+// 距离区域起点同样的偏移处。找到密钥之后记下它的位置：
+//   区域类型 + 区域大小量级 + 特征码相对区域起点的偏移 + 密钥相对特征码的偏移，
+// 连同微信版本一起写进一个小文件。下次启动时先只读这几个位置：特征码对得上才
+// 取出候选做一次校验，命中就不用再扫描；版本变了或者都没命中时照常完整扫描。
+//
+// 提示文件只记录位置，不含任何密钥材料，按最近命中排序，最多 KEY_HINT_MAX_ENTRIES 条。
+// 文件格式：key_hint_file_header | key_hint * count（本机字节序）
+
+#ifndef CHATLOG_KEY_HINT_H
+#define CHATLOG_KEY_HINT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "candidate_list.h"
+#include "region_stream.h"
+
+#define KEY_HINT_MAX_ENTRIES 16
+#define KEY_HINT_VERSION_SIZE 64
+// 一次最多按提示取出的候选数，超过的提示位置不再尝试
+#define KEY_HINT_MAX_PROBES 64
+
+typedef struct {
+    char app_version[KEY_HINT_VERSION_SIZE]; // 微信版本，以 '\0' 结尾
+    uint32_t kind;        // 平台相关的区域类型：Linux 为 proc_map_kind，macOS 为 VM_MEMORY_MALLOC_*
+    uint32_t size_class;  // 区域大小的 log2，向下取整
+    uint64_t offset;      // 特征码相对区域起点的偏移
+    int32_t key_offset;   // 密钥相对特征码的偏移，即 key_offsets 中的一项
+    uint32_t hits;        // 命中次数，只用于日志
+} key_hint;
+
+typedef struct {
+    key_hint items[KEY_HINT_MAX_ENTRIES]; // items[0] 是最近命中的位置
+    size_t count;
+    char *path;
+    bool dirty;
+} key_hint_store;
+
+// 按提示探测的区域，由各平台的区域表转换而来
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    uint32_t kind;
+} key_hint_region;
+
+// 标签低 12 位存密钥偏移，用户态地址不超过 52 位，密钥偏移范围为 ±KEY_HINT_TAG_MAX_KEY_OFFSET
+#define KEY_HINT_TAG_OFFSET_BITS 12
+#define KEY_HINT_TAG_MAX_KEY_OFFSET ((1 << (KEY_HINT_TAG_OFFSET_BITS - 1)) - 1)
+
+/**
+ * 候选的位置标签：特征码地址和密钥偏移打包成一个 64 位整数，0 表示未知
+ * 扫描时随候选一起进入 v4_candidate_batch / candidate_list，找到密钥后据此记录提示
+ */
+static inline uint64_t key_hint_tag(uint64_t pattern_addr, int key_offset) {
+    return (pattern_addr << KEY_HINT_TAG_OFFSET_BITS) |
+           (uint64_t)(key_offset + KEY_HINT_TAG_MAX_KEY_OFFSET + 1);
+}
+
+static inline uint64_t key_hint_tag_addr(uint64_t tag) {
+    return tag >> KEY_HINT_TAG_OFFSET_BITS;
+}
+
+static inline int key_hint_tag_key_offset(uint64_t tag) {
+    return (int)(tag & ((1u << KEY_HINT_TAG_OFFSET_BITS) - 1)) - (KEY_HINT_TAG_MAX_KEY_OFFSET + 1);
+}
+
+/**
+ * 打开提示文件，文件不存在或格式错误时视为空
+ * @return 提示对象，内存不足时返回 NULL
+ */
+key_hint_store *key_hint_open(const char *path);
+
+/**
+ * 按提示读出候选，提示按最近命中的顺序尝试
+ * 只有区域类型相同、大小量级相差不超过 1、且特征码仍在原来偏移处的位置才会取出候选
+ * @param app_version 当前微信版本，与提示中记录的不同时跳过该提示
+ * @param read 读取目标进程内存，与 region_stream 的回调相同
+ * @param out 候选追加到这里，标签为 key_hint_tag
+ * @return 取出的候选数
+ */
+size_t key_hint_collect(const key_hint_store *store, const char *app_version,
+                        const key_hint_region *regions, size_t n,
+                        region_stream_read_fn read, void *ctx, candidate_list *out);
+
+/**
+ * 记录一次命中：已有的相同位置移到最前面，否则新增一条，超过上限时丢弃最久未命中的
+ * @param region 密钥所在的区域
+ * @param tag 找到的密钥的 key_hint_tag
+ */
+void key_hint_record(key_hint_store *store, const char *app_version,
+                     const key_hint_region *region, uint64_t tag);
+
+/**
+ * 有改动时写回文件，先写临时文件再改名替换
+ * @return 0 成功，-1 失败
+ */
+int key_hint_save(key_hint_store *store);
+
+/**
+ * 保存并释放
+ */
+void key_hint_close(key_hint_store *store);
+
+#endif // CHATLOG_KEY_HINT_H
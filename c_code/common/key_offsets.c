@@ -0,0 +1,228 @@
+// 候选密钥偏移表实现，见 key_offsets.h
+
+#include "key_offsets.h"
+#include "key_hint.h"
+#include "log.h"
+#include "pattern_scan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const int default_offsets[] = {16, -80, 64, -16, 32, -32};
+
+static int find(const key_offset_table *t, int offset) {
+    for (size_t i = 0; i < t->count; i++) {
+        if (t->offsets[i] == offset) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static bool append(key_offset_table *t, int offset, uint32_t hits, bool swept) {
+    if (t->count == KEY_OFFSETS_MAX) {
+        return false;
+    }
+    t->offsets[t->count] = offset;
+    t->hits[t->count] = hits;
+    t->swept[t->count] = swept;
+    t->count++;
+    return true;
+}
+
+/**
+ * 按命中次数从高到低稳定排序，次数相同时保持原来的顺序
+ */
+static void sort_by_hits(key_offset_table *t) {
+    for (size_t i = 1; i < t->count; i++) {
+        int offset = t->offsets[i];
+        uint32_t hits = t->hits[i];
+        bool swept = t->swept[i];
+        size_t j = i;
+        while (j > 0 && t->hits[j - 1] < hits) {
+            t->offsets[j] = t->offsets[j - 1];
+            t->hits[j] = t->hits[j - 1];
+            t->swept[j] = t->swept[j - 1];
+            j--;
+        }
+        t->offsets[j] = offset;
+        t->hits[j] = hits;
+        t->swept[j] = swept;
+    }
+}
+
+void key_offsets_default(key_offset_table *t) {
+    memset(t, 0, sizeof(*t));
+    for (size_t i = 0; i < sizeof(default_offsets) / sizeof(default_offsets[0]); i++) {
+        append(t, default_offsets[i], 0, false);
+    }
+}
+
+int key_offsets_load(key_offset_table *t, const char *path) {
+    key_offsets_default(t);
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        return 0;
+    }
+
+    key_offset_table loaded;
+    memset(&loaded, 0, sizeof(loaded));
+    char line[128];
+    int lineno = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), fp)) {
+        lineno++;
+        char *p = line + strspn(line, " \t");
+        if (*p == '#' || *p == '\n' || *p == '\0') {
+            continue;
+        }
+        // "偏移 [命中次数]"，之后只允许空白
+        char *end;
+        long offset = strtol(p, &end, 10);
+        bool valid = end != p && offset >= -KEY_HINT_TAG_MAX_KEY_OFFSET &&
+                     offset <= KEY_HINT_TAG_MAX_KEY_OFFSET;
+        unsigned long hits = 0;
+        if (valid && *end != '\n' && *end != '\0') {
+            p = end;
+            hits = strtoul(p, &end, 10);
+            valid = end != p && hits <= UINT32_MAX && *p != '-';
+        }
+        valid = valid && end[strspn(end, " \t\r\n")] == '\0';
+        if (!valid || find(&loaded, (int)offset) >= 0 ||
+            !append(&loaded, (int)offset, (uint32_t)hits, false)) {
+            log_warn("Invalid key offset at %s:%d", path, lineno);
+            ok = false;
+        }
+    }
+    fclose(fp);
+
+    if (!ok || loaded.count == 0) {
+        return ok ? 0 : -1;
+    }
+    *t = loaded;
+    sort_by_hits(t);
+    return 0;
+}
+
+void key_offsets_sweep(key_offset_table *t, int radius) {
+    if (radius > KEY_OFFSETS_MAX_SWEEP) {
+        radius = KEY_OFFSETS_MAX_SWEEP;
+    }
+    // 离特征码近的偏移先加入：0, -8, 8, -16, 16 ...
+    for (int d = 0; d <= radius; d += KEY_OFFSETS_SWEEP_STEP) {
+        for (int sign = -1; sign <= 1; sign += 2) {
+            int offset = d * sign;
+            if ((d == 0 && sign > 0) || find(t, offset) >= 0) {
+                continue;
+            }
+            if (!append(t, offset, 0, true)) {
+                log_warn("Key offset table full, sweep stopped at +-%d", d);
+                return;
+            }
+        }
+    }
+}
+
+void key_offsets_record_hit(key_offset_table *t, int offset) {
+    int i = find(t, offset);
+    if (i < 0) {
+        if (!append(t, offset, 0, false)) {
+            return;
+        }
+        i = (int)t->count - 1;
+    }
+    t->hits[i]++;
+    t->swept[i] = false;
+    sort_by_hits(t);
+}
+
+int key_offsets_save(const key_offset_table *t, const char *path) {
+    size_t len = strlen(path) + 5;
+    char *tmp_path = malloc(len);
+    if (!tmp_path) {
+        return -1;
+    }
+    snprintf(tmp_path, len, "%s.tmp", path);
+
+    FILE *fp = fopen(tmp_path, "w");
+    if (!fp) {
+        log_warn("Failed to write key offsets %s", tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+    bool ok = fprintf(fp, "# key offset from the pattern, hits; tried in this order\n") > 0;
+    for (size_t i = 0; ok && i < t->count; i++) {
+        if (!t->swept[i]) {
+            ok = fprintf(fp, "%d %u\n", t->offsets[i], t->hits[i]) > 0;
+        }
+    }
+    if (fclose(fp) != 0) {
+        ok = false;
+    }
+
+    if (!ok || rename(tmp_path, path) != 0) {
+        log_warn("Failed to write key offsets %s", path);
+        remove(tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+    free(tmp_path);
+    return 0;
+}
+
+void key_offsets_span(const key_offset_table *t, size_t *back, size_t *fwd) {
+    int lo = 0;
+    int hi = PATTERN_SCAN_LEN - KEY_OFFSETS_KEY_SIZE;
+    for (size_t i = 0; i < t->count; i++) {
+        if (t->offsets[i] < lo) {
+            lo = t->offsets[i];
+        }
+        if (t->offsets[i] > hi) {
+            hi = t->offsets[i];
+        }
+    }
+    *back = (size_t)-lo;
+    *fwd = (size_t)(hi + KEY_OFFSETS_KEY_SIZE);
+}
+
+void key_offsets_order_candidates(const key_offset_table *t, candidate_list *list) {
+    size_t n = list->count;
+    if (n < 2) {
+        return;
+    }
+
+    // 按偏移在表中的位置做计数排序，最后一个桶放标签未知的候选
+    size_t counts[KEY_OFFSETS_MAX + 2] = {0};
+    unsigned char *rank = malloc(n);
+    unsigned char (*keys)[CANDIDATE_LIST_KEY_SIZE] = malloc(n * CANDIDATE_LIST_KEY_SIZE);
+    uint64_t *tags = malloc(n * sizeof(uint64_t));
+    if (!rank || !keys || !tags) {
+        free(rank);
+        free(keys);
+        free(tags);
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        int r = list->tags[i] ? find(t, key_hint_tag_key_offset(list->tags[i])) : -1;
+        rank[i] = (unsigned char)(r < 0 ? KEY_OFFSETS_MAX : r);
+        counts[rank[i] + 1]++;
+    }
+    for (size_t r = 1; r <= KEY_OFFSETS_MAX + 1; r++) {
+        counts[r] += counts[r - 1];
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t pos = counts[rank[i]]++;
+        memcpy(keys[pos], list->keys[i], CANDIDATE_LIST_KEY_SIZE);
+        tags[pos] = list->tags[i];
+    }
+
+    // 原数组里的候选不再需要，清零后释放
+    memset(list->keys, 0, n * CANDIDATE_LIST_KEY_SIZE);
+    free(list->keys);
+    free(list->tags);
+    list->keys = keys;
+    list->tags = tags;
+    list->cap = n;
+    free(rank);
+}
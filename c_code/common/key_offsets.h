@@ -0,0 +1,76 @@
+// 特征码附近的候选密钥偏移表，Linux/macOS 两个 testkey 工具、v4poc 和 libchatlogkey 共用
+//
+// 原来每个工具各自写死 {16, -80, 64, -16, 32, -32}（v4poc 只有前三个）：没中的偏移
+// 白白多跑 PBKDF2，微信调整结构体布局之后又可能一个都不中。这里改成数据驱动：
+//   - 偏移表可以从配置文件读入，每行 "偏移 命中次数"，'#' 开头为注释，
+//     偏移范围受候选标签限制（见 key_hint.h 的 KEY_HINT_TAG_MAX_KEY_OFFSET）
+//   - 按命中次数从高到低排序，最可能的偏移排在第一个最先尝试
+//   - 找到密钥后把命中的偏移累加回文件，下次按新的顺序尝试
+//   - 可选的扫描模式：±N 字节内每个 8 字节对齐的偏移都作为候选，交给批量校验
+// 文件不存在时使用默认表，保存时写出默认表和累计的命中次数。
+
+#ifndef CHATLOG_KEY_OFFSETS_H
+#define CHATLOG_KEY_OFFSETS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "candidate_filter.h"
+#include "candidate_list.h"
+
+#define KEY_OFFSETS_MAX CANDIDATE_MAX_OFFSETS
+#define KEY_OFFSETS_KEY_SIZE 32
+#define KEY_OFFSETS_SWEEP_STEP 8
+// 扫描模式的最大半径，±248 字节正好是 63 个偏移，加上表里的非对齐偏移也不会超过上限
+#define KEY_OFFSETS_MAX_SWEEP 248
+
+typedef struct {
+    int offsets[KEY_OFFSETS_MAX];   // 按命中次数从高到低排序
+    uint32_t hits[KEY_OFFSETS_MAX];
+    bool swept[KEY_OFFSETS_MAX];    // 由扫描模式加入、还没有命中过，不写回文件
+    size_t count;
+} key_offset_table;
+
+/**
+ * 默认偏移表：{16, -80, 64, -16, 32, -32}，命中次数都为 0
+ */
+void key_offsets_default(key_offset_table *t);
+
+/**
+ * 从配置文件读入偏移表并按命中次数排序，文件不存在时使用默认表
+ * @return 0 成功，-1 文件格式错误（此时 t 为默认表）
+ */
+int key_offsets_load(key_offset_table *t, const char *path);
+
+/**
+ * 扫描模式：把 [-radius, radius] 内每个 8 字节对齐、表里还没有的偏移追加到表尾
+ * @param radius 超过 KEY_OFFSETS_MAX_SWEEP 时按 KEY_OFFSETS_MAX_SWEEP 处理
+ */
+void key_offsets_sweep(key_offset_table *t, int radius);
+
+/**
+ * 记录一次命中并重新排序，偏移不在表中时追加
+ */
+void key_offsets_record_hit(key_offset_table *t, int offset);
+
+/**
+ * 写回配置文件，先写临时文件再改名替换
+ * @return 0 成功，-1 失败
+ */
+int key_offsets_save(const key_offset_table *t, const char *path);
+
+/**
+ * 流式读取时窗口需要的重叠：向前 back 字节（最小负偏移），
+ * 向后 fwd 字节（最大偏移加上密钥长度，至少覆盖特征码本身）
+ */
+void key_offsets_span(const key_offset_table *t, size_t *back, size_t *fwd);
+
+/**
+ * 快照模式下离线校验之前，按候选的偏移在表中的顺序重排（同一偏移内保持扫描顺序），
+ * 所有命中的第一个偏移先于任何一个第二偏移校验；标签未知的候选排在最后
+ * 内存不足时保持原顺序
+ */
+void key_offsets_order_candidates(const key_offset_table *t, candidate_list *list);
+
+#endif // CHATLOG_KEY_OFFSETS_H
@@ -0,0 +1,71 @@
+// 分级日志实现，见 log.h
+
+#include "log.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+int log_level = LOG_LEVEL_INFO;
+
+static const char *const level_prefix[] = {
+    "error: ", "warning: ", "", "[debug] ", "[trace] ",
+};
+
+void log_set_level(int level) {
+    if (level < LOG_LEVEL_ERROR) {
+        level = LOG_LEVEL_ERROR;
+    }
+    if (level > LOG_LEVEL_TRACE) {
+        level = LOG_LEVEL_TRACE;
+    }
+    log_level = level;
+}
+
+void log_write(int level, const char *fmt, ...) {
+    // 整行一次写出，多线程输出不会交错
+    char line[1024];
+    int n = snprintf(line, sizeof(line), "%s", level_prefix[level]);
+
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line + n, sizeof(line) - n, fmt, ap);
+    va_end(ap);
+
+    fprintf(stderr, "%s\n", line);
+}
+
+void log_write_hex(int level, const char *label, const unsigned char *data, size_t len) {
+    char hex[2 * 128 + 1];
+    if (len > 128) {
+        len = 128;
+    }
+    for (size_t i = 0; i < len; i++) {
+        snprintf(hex + i * 2, 3, "%02x", data[i]);
+    }
+    hex[len * 2] = '\0';
+    log_write(level, "%s: %s", label, hex);
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void log_progress_init(log_progress *p, unsigned interval_ms) {
+    p->interval_ns = (uint64_t)interval_ms * 1000000ULL;
+    atomic_init(&p->last_ns, now_ns());
+}
+
+bool log_progress_due(log_progress *p) {
+    if (p->interval_ns == 0 || !LOG_ENABLED(LOG_LEVEL_INFO)) {
+        return false;
+    }
+    uint64_t now = now_ns();
+    uint64_t last = atomic_load_explicit(&p->last_ns, memory_order_relaxed);
+    if (now - last < p->interval_ns) {
+        return false;
+    }
+    return atomic_compare_exchange_strong(&p->last_ns, &last, now);
+}
@@ -0,0 +1,74 @@
+// 分级日志，Linux/macOS 两个 testkey 工具共用
+//
+// 所有日志写到 stderr，stdout 只留给最终结果。运行时级别默认 INFO，
+// 命令行 -v 打开 DEBUG，-vv 打开 TRACE。编译时定义 CHATLOG_LOG_LEVEL
+// 可以把更低级别的调用整体去掉，例如 -DCHATLOG_LOG_LEVEL=2 只保留 INFO 及以上。
+//
+// 扫描热路径里只允许 TRACE 级别的日志；常规输出通过 log_progress
+// 限频，最多每隔 interval 毫秒输出一行汇总进度。
+
+#ifndef CHATLOG_LOG_H
+#define CHATLOG_LOG_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARN 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+#define LOG_LEVEL_TRACE 4
+
+#ifndef CHATLOG_LOG_LEVEL
+#define CHATLOG_LOG_LEVEL LOG_LEVEL_TRACE
+#endif
+
+extern int log_level;
+
+void log_set_level(int level);
+
+void log_write(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * 以十六进制输出一段数据
+ */
+void log_write_hex(int level, const char *label, const unsigned char *data, size_t len);
+
+#define LOG_ENABLED(level) ((level) <= CHATLOG_LOG_LEVEL && (level) <= log_level)
+
+#define LOG_AT(level, ...)                  \
+    do {                                    \
+        if (LOG_ENABLED(level)) {           \
+            log_write((level), __VA_ARGS__); \
+        }                                   \
+    } while (0)
+
+#define log_error(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define log_warn(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define log_info(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define log_debug(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define log_trace(...) LOG_AT(LOG_LEVEL_TRACE, __VA_ARGS__)
+
+#define log_trace_hex(label, data, len)                                \
+    do {                                                               \
+        if (LOG_ENABLED(LOG_LEVEL_TRACE)) {                            \
+            log_write_hex(LOG_LEVEL_TRACE, (label), (data), (len));    \
+        }                                                              \
+    } while (0)
+
+// 进度输出限频器，可以被多个线程共用
+typedef struct {
+    uint64_t interval_ns;       // 0 表示关闭进度输出
+    _Atomic uint64_t last_ns;
+} log_progress;
+
+void log_progress_init(log_progress *p, unsigned interval_ms);
+
+/**
+ * 距离上次输出已超过 interval 时返回 true，并发调用时只有一个线程得到 true
+ */
+bool log_progress_due(log_progress *p);
+
+#endif // CHATLOG_LOG_H
@@ -0,0 +1,368 @@
+// 离线内存镜像实现，见 mem_image.h
+
+#include "mem_image.h"
+#include "log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// macOS 没有 <elf.h>，这里只定义用到的 ELF64 结构，字段顺序与 ELF 规范一致
+#define ELF_CLASS64 2
+#define ELF_DATA_LSB 1
+#define ELF_TYPE_CORE 4
+#define ELF_PT_LOAD 1
+#define ELF_PT_NOTE 4
+#define ELF_PF_X 0x1
+#define ELF_PF_W 0x2
+#define ELF_PF_R 0x4
+#define ELF_NT_FILE 0x46494c45
+
+typedef struct {
+    unsigned char e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint64_t e_entry;
+    uint64_t e_phoff;
+    uint64_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} elf64_ehdr;
+
+typedef struct {
+    uint32_t p_type;
+    uint32_t p_flags;
+    uint64_t p_offset;
+    uint64_t p_vaddr;
+    uint64_t p_paddr;
+    uint64_t p_filesz;
+    uint64_t p_memsz;
+    uint64_t p_align;
+} elf64_phdr;
+
+typedef struct {
+    uint32_t n_namesz;
+    uint32_t n_descsz;
+    uint32_t n_type;
+} elf64_nhdr;
+
+static bool push_region(mem_image *img, size_t *cap, const mem_image_region *r) {
+    if (img->count == *cap) {
+        size_t n = *cap ? *cap * 2 : 64;
+        mem_image_region *items = realloc(img->items, n * sizeof(*items));
+        if (!items) {
+            return false;
+        }
+        img->items = items;
+        *cap = n;
+    }
+    img->items[img->count++] = *r;
+    return true;
+}
+
+/**
+ * 文件中保存的部分不能超出镜像文件本身
+ */
+static uint64_t clamp_file_size(const mem_image *img, uint64_t offset, uint64_t size) {
+    if (offset >= img->size) {
+        return 0;
+    }
+    return img->size - offset < size ? img->size - offset : size;
+}
+
+/**
+ * NT_FILE：count、page_size、count 个 {start, end, file_ofs}，之后是 count 个路径
+ */
+static void apply_nt_file(mem_image *img, const unsigned char *desc, size_t len) {
+    uint64_t count;
+    if (len < 16) {
+        return;
+    }
+    memcpy(&count, desc, sizeof(count));
+    if (count > (len - 16) / 24) {
+        return;
+    }
+    const unsigned char *names = desc + 16 + count * 24;
+    const unsigned char *end = desc + len;
+    for (uint64_t i = 0; i < count && names < end; i++) {
+        uint64_t range[2];
+        memcpy(range, desc + 16 + i * 24, sizeof(range));
+        size_t name_len = strnlen((const char *)names, (size_t)(end - names));
+        for (size_t r = 0; r < img->count; r++) {
+            mem_image_region *region = &img->items[r];
+            if (region->start >= range[0] && region->start < range[1]) {
+                size_t n = name_len < MEM_IMAGE_NAME_MAX - 1 ? name_len : MEM_IMAGE_NAME_MAX - 1;
+                memcpy(region->name, names, n);
+                region->name[n] = '\0';
+            }
+        }
+        names += name_len + 1;
+    }
+}
+
+static void load_elf_notes(mem_image *img, const elf64_phdr *ph) {
+    if (ph->p_offset >= img->size || img->size - ph->p_offset < ph->p_filesz) {
+        return;
+    }
+    const unsigned char *p = img->data + ph->p_offset;
+    const unsigned char *end = p + ph->p_filesz;
+    while ((size_t)(end - p) >= sizeof(elf64_nhdr)) {
+        elf64_nhdr nh;
+        memcpy(&nh, p, sizeof(nh));
+        size_t name_len = (nh.n_namesz + 3u) & ~3u;
+        size_t desc_len = (nh.n_descsz + 3u) & ~3u;
+        p += sizeof(nh);
+        if ((size_t)(end - p) < name_len || (size_t)(end - p) - name_len < nh.n_descsz) {
+            return;
+        }
+        p += name_len;
+        if (nh.n_type == ELF_NT_FILE) {
+            apply_nt_file(img, p, nh.n_descsz);
+        }
+        // 最后一个注释的填充可能被截掉
+        p += (size_t)(end - p) < desc_len ? (size_t)(end - p) : desc_len;
+    }
+}
+
+static int load_elf_core(mem_image *img, const char *path) {
+    elf64_ehdr eh;
+    memcpy(&eh, img->data, sizeof(eh));
+    if (eh.e_ident[4] != ELF_CLASS64 || eh.e_ident[5] != ELF_DATA_LSB ||
+        eh.e_type != ELF_TYPE_CORE || eh.e_phentsize != sizeof(elf64_phdr) ||
+        eh.e_phoff > img->size || (img->size - eh.e_phoff) / sizeof(elf64_phdr) < eh.e_phnum) {
+        log_error("%s: not a 64-bit little-endian ELF core file", path);
+        return -1;
+    }
+
+    size_t cap = 0;
+    for (uint16_t i = 0; i < eh.e_phnum; i++) {
+        elf64_phdr ph;
+        memcpy(&ph, img->data + eh.e_phoff + (uint64_t)i * sizeof(ph), sizeof(ph));
+        if (ph.p_type != ELF_PT_LOAD || ph.p_memsz == 0) {
+            continue;
+        }
+        mem_image_region r;
+        memset(&r, 0, sizeof(r));
+        r.start = ph.p_vaddr;
+        r.end = ph.p_vaddr + ph.p_memsz;
+        r.file_offset = ph.p_offset;
+        r.file_size = clamp_file_size(img, ph.p_offset, ph.p_filesz < ph.p_memsz ? ph.p_filesz : ph.p_memsz);
+        snprintf(r.perms, sizeof(r.perms), "%c%c%cp", ph.p_flags & ELF_PF_R ? 'r' : '-',
+                 ph.p_flags & ELF_PF_W ? 'w' : '-', ph.p_flags & ELF_PF_X ? 'x' : '-');
+        if (r.end > r.start && !push_region(img, &cap, &r)) {
+            log_error("Out of memory loading %s", path);
+            return -1;
+        }
+    }
+
+    // 文件映射的路径在 PT_NOTE 的 NT_FILE 里，必须在区域表建好之后再套上去
+    for (uint16_t i = 0; i < eh.e_phnum; i++) {
+        elf64_phdr ph;
+        memcpy(&ph, img->data + eh.e_phoff + (uint64_t)i * sizeof(ph), sizeof(ph));
+        if (ph.p_type == ELF_PT_NOTE) {
+            load_elf_notes(img, &ph);
+        }
+    }
+    img->format = MEM_IMAGE_ELF_CORE;
+    return 0;
+}
+
+/**
+ * 读入 <path>.regions，不存在时整个文件作为一个区域
+ */
+static int load_raw(mem_image *img, const char *path) {
+    size_t cap = 0;
+    size_t len = strlen(path) + sizeof(MEM_IMAGE_MANIFEST_SUFFIX);
+    char *manifest = malloc(len);
+    if (!manifest) {
+        return -1;
+    }
+    snprintf(manifest, len, "%s%s", path, MEM_IMAGE_MANIFEST_SUFFIX);
+    FILE *fp = fopen(manifest, "r");
+    img->format = MEM_IMAGE_RAW;
+
+    if (!fp) {
+        mem_image_region r;
+        memset(&r, 0, sizeof(r));
+        r.end = img->size;
+        r.file_size = img->size;
+        memcpy(r.perms, "rw-p", sizeof(r.perms));
+        log_warn("No region manifest %s, scanning %s as one region at address 0", manifest, path);
+        free(manifest);
+        return push_region(img, &cap, &r) ? 0 : -1;
+    }
+
+    char line[MEM_IMAGE_NAME_MAX + 128];
+    int lineno = 0;
+    int ret = 0;
+    while (ret == 0 && fgets(line, sizeof(line), fp)) {
+        lineno++;
+        char *p = line + strspn(line, " \t");
+        if (*p == '#' || *p == '\n' || *p == '\0') {
+            continue;
+        }
+        mem_image_region r;
+        memset(&r, 0, sizeof(r));
+        unsigned long long start, end, offset;
+        int name_pos = 0;
+        if (sscanf(p, "%llx %llx %llx %4s %n", &start, &end, &offset, r.perms, &name_pos) != 4 ||
+            end <= start) {
+            log_error("Invalid region at %s:%d", manifest, lineno);
+            ret = -1;
+            break;
+        }
+        r.start = start;
+        r.end = end;
+        r.file_offset = offset;
+        r.file_size = clamp_file_size(img, offset, end - start);
+        size_t n = strcspn(p + name_pos, "\r\n");
+        n = n < MEM_IMAGE_NAME_MAX - 1 ? n : MEM_IMAGE_NAME_MAX - 1;
+        memcpy(r.name, p + name_pos, n);
+        r.name[n] = '\0';
+        if (!push_region(img, &cap, &r)) {
+            ret = -1;
+        }
+    }
+    fclose(fp);
+    free(manifest);
+    return ret;
+}
+
+static int compare_region(const void *a, const void *b) {
+    const mem_image_region *ra = a;
+    const mem_image_region *rb = b;
+    return ra->start < rb->start ? -1 : ra->start > rb->start;
+}
+
+int mem_image_open(mem_image *img, const char *path) {
+    memset(img, 0, sizeof(*img));
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        log_error("Failed to open memory image %s: %s", path, fd < 0 ? strerror(errno) : "empty file");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        log_error("Failed to map memory image %s: %s", path, strerror(errno));
+        return -1;
+    }
+    img->data = data;
+    img->size = (size_t)st.st_size;
+
+    int ret;
+    if (img->size >= sizeof(elf64_ehdr) && memcmp(img->data, "\x7f" "ELF", 4) == 0) {
+        ret = load_elf_core(img, path);
+    } else {
+        ret = load_raw(img, path);
+    }
+    if (ret != 0 || img->count == 0) {
+        if (ret == 0) {
+            log_error("No memory regions in %s", path);
+        }
+        mem_image_close(img);
+        return -1;
+    }
+
+    // 拷贝时按地址二分查找，重叠的区域只保留先出现的那个
+    qsort(img->items, img->count, sizeof(*img->items), compare_region);
+    size_t kept = 0;
+    for (size_t i = 0; i < img->count; i++) {
+        if (kept > 0 && img->items[i].start < img->items[kept - 1].end) {
+            log_warn("Overlapping region 0x%llx in %s ignored",
+                     (unsigned long long)img->items[i].start, path);
+            continue;
+        }
+        img->items[kept++] = img->items[i];
+    }
+    img->count = kept;
+    return 0;
+}
+
+void mem_image_close(mem_image *img) {
+    if (img->data) {
+        munmap((void *)img->data, img->size);
+    }
+    free(img->items);
+    memset(img, 0, sizeof(*img));
+}
+
+const char *mem_image_format_name(mem_image_format format) {
+    return format == MEM_IMAGE_ELF_CORE ? "ELF core" : "raw";
+}
+
+/**
+ * 包含 addr 的区域，没有时返回 addr 之后的第一个区域，都没有返回 NULL
+ */
+static const mem_image_region *find_region(const mem_image *img, uint64_t addr) {
+    size_t lo = 0, hi = img->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (img->items[mid].end <= addr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < img->count ? &img->items[lo] : NULL;
+}
+
+size_t mem_image_copy(const mem_image *img, uint64_t addr, void *buf, size_t len) {
+    unsigned char *out = buf;
+    size_t done = 0;
+    size_t copied = 0;
+    const mem_image_region *r = find_region(img, addr);
+    while (done < len) {
+        uint64_t pos = addr + done;
+        if (!r || r->start >= addr + len) {
+            memset(out + done, 0, len - done);
+            break;
+        }
+        if (pos < r->start) {
+            // 区域之间的空洞
+            memset(out + done, 0, (size_t)(r->start - pos));
+            done += (size_t)(r->start - pos);
+            continue;
+        }
+        uint64_t in_region = pos - r->start;
+        uint64_t region_left = r->end - pos;
+        size_t take = region_left < len - done ? (size_t)region_left : len - done;
+        size_t saved = in_region < r->file_size ? (size_t)(r->file_size - in_region) : 0;
+        saved = saved < take ? saved : take;
+        memcpy(out + done, img->data + r->file_offset + in_region, saved);
+        memset(out + done + saved, 0, take - saved);
+        copied += saved;
+        done += take;
+        r = r + 1 < img->items + img->count ? r + 1 : NULL;
+    }
+    return copied;
+}
+
+const unsigned char *mem_image_data(const mem_image *img, uint64_t addr, size_t len) {
+    const mem_image_region *r = find_region(img, addr);
+    if (!r || addr < r->start || r->end - addr < len || addr - r->start + len > r->file_size) {
+        return NULL;
+    }
+    return img->data + r->file_offset + (addr - r->start);
+}
+
+int mem_image_read(void *ctx, uint64_t addr, void *buf, size_t len) {
+    return mem_image_copy(ctx, addr, buf, len) > 0 ? 0 : -1;
+}
@@ -0,0 +1,71 @@
+// 离线内存镜像，Linux/macOS 两个 testkey 工具共用
+//
+// 调参或排查问题时每次都要 root、要附加到正在运行的微信并让它停顿一下。这里改成
+// 可以对保存下来的内存镜像反复扫描，完全不碰目标进程：
+//   - ELF core 文件（gcore、内核 core dump）：PT_LOAD 段就是区域，NT_FILE 注释给出
+//     文件映射的路径
+//   - chatlog dumpmemory 写出的原始 wechat_<ver>_<pid>_<session>.bin：区域清单在旁边的
+//     <path>.regions 里，每行 "起始地址 结束地址 文件偏移 权限 [名称]"（数字都是十六进制），
+//     '#' 开头为注释；没有清单时整个文件视为从地址 0 开始的一个可读写区域
+// 整个文件只读地 mmap 进来，之后的扫描和校验与在线扫描走同样的流程，只是读内存变成了
+// 从页缓存拷贝。
+
+#ifndef CHATLOG_MEM_IMAGE_H
+#define CHATLOG_MEM_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MEM_IMAGE_NAME_MAX 256
+#define MEM_IMAGE_MANIFEST_SUFFIX ".regions"
+
+typedef enum {
+    MEM_IMAGE_RAW,      // 原始内存转储，区域来自清单
+    MEM_IMAGE_ELF_CORE, // ELF64 小端 core 文件
+} mem_image_format;
+
+typedef struct {
+    uint64_t start;       // 原进程中的地址范围 [start, end)
+    uint64_t end;
+    uint64_t file_offset; // 区域内容在镜像文件中的偏移
+    uint64_t file_size;   // 文件中实际保存的字节数，超出部分视为读不到
+    char perms[5];        // 与 /proc/<pid>/maps 相同的 "rw-p" 形式
+    char name[MEM_IMAGE_NAME_MAX]; // 映射的文件路径或清单中的区域类型，匿名映射为空
+} mem_image_region;
+
+typedef struct {
+    mem_image_format format;
+    const unsigned char *data; // 整个镜像文件的只读映射
+    size_t size;
+    mem_image_region *items;   // 按起始地址排序，互不重叠
+    size_t count;
+} mem_image;
+
+/**
+ * 打开镜像文件：ELF core 按段表解析，否则按原始转储读取 <path>.regions
+ * @return 0 成功，-1 失败（已输出错误日志）
+ */
+int mem_image_open(mem_image *img, const char *path);
+
+void mem_image_close(mem_image *img);
+
+const char *mem_image_format_name(mem_image_format format);
+
+/**
+ * 读取 [addr, addr + len)，镜像里没有保存的部分补零，与 proc_mem_read 的语义一致
+ * @return 实际读到的字节数
+ */
+size_t mem_image_copy(const mem_image *img, uint64_t addr, void *buf, size_t len);
+
+/**
+ * [addr, addr + len) 完整保存在镜像里时直接返回映射中的指针，不用拷贝
+ * @return 数据指针，跨越区域或有部分没有保存时返回 NULL
+ */
+const unsigned char *mem_image_data(const mem_image *img, uint64_t addr, size_t len);
+
+/**
+ * region_stream 的读取回调，ctx 指向 mem_image；一个字节都没读到时返回 -1
+ */
+int mem_image_read(void *ctx, uint64_t addr, void *buf, size_t len);
+
+#endif // CHATLOG_MEM_IMAGE_H
@@ -0,0 +1,264 @@
+// 8 字节特征码扫描实现，见 pattern_scan.h
+
+#include "pattern_scan.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PATTERN_SCAN_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PATTERN_SCAN_NEON 1
+#endif
+
+const unsigned char v4_key_pattern[PATTERN_SCAN_LEN] = {0x20, 0x66, 0x74, 0x73, 0x35, 0x28, 0x25, 0x00};
+
+typedef size_t (*pattern_scan_fn)(const unsigned char *buf, size_t len, size_t start,
+                                  const unsigned char *pattern, size_t anchor,
+                                  size_t *hits, size_t max_hits, size_t *next);
+
+static uint64_t load_u64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * 选择第二个过滤字节：最后一个非零字节
+ */
+static size_t pick_anchor(const unsigned char *pattern) {
+    for (size_t i = PATTERN_SCAN_LEN - 1; i > 0; i--) {
+        if (pattern[i] != 0) {
+            return i;
+        }
+    }
+    return PATTERN_SCAN_LEN - 1;
+}
+
+/**
+ * 标量实现：memchr 找首字节，再做整字比较；SIMD 内核也用它处理尾部
+ */
+static size_t scan_scalar(const unsigned char *buf, size_t len, size_t start,
+                          const unsigned char *pattern, size_t anchor,
+                          size_t *hits, size_t max_hits, size_t *next) {
+    (void)anchor;
+    uint64_t want = load_u64(pattern);
+    size_t count = 0;
+    size_t i = start;
+
+    while (i + PATTERN_SCAN_LEN <= len) {
+        const unsigned char *p = memchr(buf + i, pattern[0], len - PATTERN_SCAN_LEN + 1 - i);
+        if (!p) {
+            break;
+        }
+        i = (size_t)(p - buf);
+        if (load_u64(p) == want) {
+            hits[count++] = i;
+            if (count == max_hits) {
+                *next = i + 1;
+                return count;
+            }
+        }
+        i++;
+    }
+
+    *next = len;
+    return count;
+}
+
+#if defined(PATTERN_SCAN_X86)
+// 块内命中位逐个整字比较，命中数组满时提前返回
+#define PATTERN_SCAN_EMIT_BITS(mask, base)                         \
+    while (mask) {                                                 \
+        size_t pos = (base) + (size_t)__builtin_ctz(mask);         \
+        mask &= mask - 1;                                          \
+        if (load_u64(buf + pos) == want) {                         \
+            hits[count++] = pos;                                   \
+            if (count == max_hits) {                               \
+                *next = pos + 1;                                   \
+                return count;                                      \
+            }                                                      \
+        }                                                          \
+    }
+
+static size_t scan_sse2(const unsigned char *buf, size_t len, size_t start,
+                        const unsigned char *pattern, size_t anchor,
+                        size_t *hits, size_t max_hits, size_t *next) {
+    const __m128i first = _mm_set1_epi8((char)pattern[0]);
+    const __m128i last = _mm_set1_epi8((char)pattern[anchor]);
+    uint64_t want = load_u64(pattern);
+    size_t count = 0;
+    size_t i = start;
+
+    // 保证块内每个位置都有完整的 8 字节可比较
+    while (i + 16 + PATTERN_SCAN_LEN - 1 <= len) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(buf + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(buf + i + anchor));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        PATTERN_SCAN_EMIT_BITS(mask, i);
+        i += 16;
+    }
+
+    size_t tail_next;
+    size_t tail = scan_scalar(buf, len, i, pattern, anchor, hits + count, max_hits - count, &tail_next);
+    *next = tail_next;
+    return count + tail;
+}
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(const unsigned char *buf, size_t len, size_t start,
+                        const unsigned char *pattern, size_t anchor,
+                        size_t *hits, size_t max_hits, size_t *next) {
+    const __m256i first = _mm256_set1_epi8((char)pattern[0]);
+    const __m256i last = _mm256_set1_epi8((char)pattern[anchor]);
+    uint64_t want = load_u64(pattern);
+    size_t count = 0;
+    size_t i = start;
+
+    while (i + 32 + PATTERN_SCAN_LEN - 1 <= len) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(buf + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(buf + i + anchor));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        PATTERN_SCAN_EMIT_BITS(mask, i);
+        i += 32;
+    }
+
+    size_t tail_next;
+    size_t tail = scan_scalar(buf, len, i, pattern, anchor, hits + count, max_hits - count, &tail_next);
+    *next = tail_next;
+    return count + tail;
+}
+
+#undef PATTERN_SCAN_EMIT_BITS
+
+// AVX-512BW 的比较结果直接是 64 位掩码，不需要 movemask
+__attribute__((target("avx512f,avx512bw")))
+static size_t scan_avx512(const unsigned char *buf, size_t len, size_t start,
+                          const unsigned char *pattern, size_t anchor,
+                          size_t *hits, size_t max_hits, size_t *next) {
+    const __m512i first = _mm512_set1_epi8((char)pattern[0]);
+    const __m512i last = _mm512_set1_epi8((char)pattern[anchor]);
+    uint64_t want = load_u64(pattern);
+    size_t count = 0;
+    size_t i = start;
+
+    while (i + 64 + PATTERN_SCAN_LEN - 1 <= len) {
+        __m512i a = _mm512_loadu_si512((const void *)(buf + i));
+        __m512i b = _mm512_loadu_si512((const void *)(buf + i + anchor));
+        uint64_t mask = (uint64_t)(_mm512_cmpeq_epi8_mask(a, first) & _mm512_cmpeq_epi8_mask(b, last));
+        while (mask) {
+            size_t pos = i + (size_t)__builtin_ctzll(mask);
+            mask &= mask - 1;
+            if (load_u64(buf + pos) == want) {
+                hits[count++] = pos;
+                if (count == max_hits) {
+                    *next = pos + 1;
+                    return count;
+                }
+            }
+        }
+        i += 64;
+    }
+
+    size_t tail_next;
+    size_t tail = scan_scalar(buf, len, i, pattern, anchor, hits + count, max_hits - count, &tail_next);
+    *next = tail_next;
+    return count + tail;
+}
+#endif
+
+#if defined(PATTERN_SCAN_NEON)
+static size_t scan_neon(const unsigned char *buf, size_t len, size_t start,
+                        const unsigned char *pattern, size_t anchor,
+                        size_t *hits, size_t max_hits, size_t *next) {
+    const uint8x16_t first = vdupq_n_u8(pattern[0]);
+    const uint8x16_t last = vdupq_n_u8(pattern[anchor]);
+    uint64_t want = load_u64(pattern);
+    size_t count = 0;
+    size_t i = start;
+
+    while (i + 16 + PATTERN_SCAN_LEN - 1 <= len) {
+        uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(buf + i), first),
+                                 vceqq_u8(vld1q_u8(buf + i + anchor), last));
+        // 每个字节压缩成 4 位，得到 64 位掩码
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        while (mask) {
+            size_t pos = i + ((size_t)__builtin_ctzll(mask) >> 2);
+            mask &= ~(0xFULL << ((pos - i) * 4));
+            if (load_u64(buf + pos) == want) {
+                hits[count++] = pos;
+                if (count == max_hits) {
+                    *next = pos + 1;
+                    return count;
+                }
+            }
+        }
+        i += 16;
+    }
+
+    size_t tail_next;
+    size_t tail = scan_scalar(buf, len, i, pattern, anchor, hits + count, max_hits - count, &tail_next);
+    *next = tail_next;
+    return count + tail;
+}
+#endif
+
+typedef struct {
+    pattern_scan_fn fn;
+    const char *name;
+} pattern_scan_engine_info;
+
+static pattern_scan_engine_info engine;
+static pthread_once_t engine_once = PTHREAD_ONCE_INIT;
+
+static void init_engine(void) {
+    pattern_scan_engine_info chosen = {scan_scalar, "scalar"};
+#if defined(PATTERN_SCAN_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) {
+        chosen = (pattern_scan_engine_info){scan_avx512, "avx512"};
+    } else if (__builtin_cpu_supports("avx2")) {
+        chosen = (pattern_scan_engine_info){scan_avx2, "avx2"};
+    } else if (__builtin_cpu_supports("sse2")) {
+        chosen = (pattern_scan_engine_info){scan_sse2, "sse2"};
+    }
+#elif defined(PATTERN_SCAN_NEON)
+    chosen = (pattern_scan_engine_info){scan_neon, "neon"};
+#endif
+
+    // CHATLOG_PATTERN_SCAN=scalar/sse2/avx2 可以强制降级，与 CHATLOG_SHA512_MB 相同
+    const char *force = getenv("CHATLOG_PATTERN_SCAN");
+    if (force && strcmp(force, "scalar") == 0) {
+        chosen = (pattern_scan_engine_info){scan_scalar, "scalar"};
+    }
+#if defined(PATTERN_SCAN_X86)
+    if (force && strcmp(force, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        chosen = (pattern_scan_engine_info){scan_avx2, "avx2"};
+    } else if (force && strcmp(force, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        chosen = (pattern_scan_engine_info){scan_sse2, "sse2"};
+    }
+#endif
+    engine = chosen;
+}
+
+const char *pattern_scan_engine(void) {
+    pthread_once(&engine_once, init_engine);
+    return engine.name;
+}
+
+size_t pattern_scan(const unsigned char *buf, size_t len, size_t start,
+                    const unsigned char pattern[PATTERN_SCAN_LEN],
+                    size_t *hits, size_t max_hits, size_t *next) {
+    if (!buf || !hits || max_hits == 0 || start + PATTERN_SCAN_LEN > len) {
+        *next = len;
+        return 0;
+    }
+    pthread_once(&engine_once, init_engine);
+    return engine.fn(buf, len, start, pattern, pick_anchor(pattern), hits, max_hits, next);
+}
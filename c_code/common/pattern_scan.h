@@ -0,0 +1,36 @@
+// 8 字节特征码扫描，Linux/macOS 两个 testkey 工具共用
+//
+// 取特征码的首字节和最后一个非零字节做广播比较（SSE2 / AVX2 / AVX-512BW / NEON，
+// 运行时按 CPU 特性选择），两者同时命中的位置再做一次 8 字节整字比较。
+// 全部命中偏移写入调用方预分配的数组，便于后续按批次校验候选。
+// 特征码末字节是 0x00，在清零的堆内存里几乎处处命中，所以不用它做过滤。
+
+#ifndef CHATLOG_PATTERN_SCAN_H
+#define CHATLOG_PATTERN_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PATTERN_SCAN_LEN 8
+
+// V4 密钥附近的特征码
+extern const unsigned char v4_key_pattern[PATTERN_SCAN_LEN];
+
+/**
+ * 在 buf[start, len) 中查找 8 字节特征码
+ * @param pattern 特征码
+ * @param hits 输出命中偏移（相对于 buf），按升序排列
+ * @param max_hits hits 容量
+ * @param next 输出下一次应当继续扫描的起始偏移；扫描完成时等于 len
+ * @return 本次写入的命中数，等于 max_hits 时可能还有剩余，需要从 *next 继续
+ */
+size_t pattern_scan(const unsigned char *buf, size_t len, size_t start,
+                    const unsigned char pattern[PATTERN_SCAN_LEN],
+                    size_t *hits, size_t max_hits, size_t *next);
+
+/**
+ * 当前使用的扫描内核名称："avx512" / "avx2" / "sse2" / "neon" / "scalar"
+ */
+const char *pattern_scan_engine(void);
+
+#endif // CHATLOG_PATTERN_SCAN_H
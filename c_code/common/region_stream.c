@@ -0,0 +1,80 @@
+// 内存区域分块流式读取实现，见 region_stream.h
+
+#include "region_stream.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int region_stream_init(region_stream *s, size_t chunk, size_t back, size_t fwd,
+                       region_stream_read_fn read, void *ctx) {
+    memset(s, 0, sizeof(*s));
+    s->read = read;
+    s->ctx = ctx;
+    s->chunk = chunk ? chunk : REGION_STREAM_DEFAULT_CHUNK;
+    s->back = back;
+    s->fwd = fwd;
+    s->cap = s->chunk + back + fwd;
+
+    s->buf[0] = malloc(s->cap);
+    s->buf[1] = malloc(s->cap);
+    if (!s->buf[0] || !s->buf[1]) {
+        region_stream_destroy(s);
+        return -1;
+    }
+    return 0;
+}
+
+void region_stream_begin(region_stream *s, uint64_t start, uint64_t end) {
+    s->start = start;
+    s->end = end;
+    s->off = start;
+    s->prev_valid = false;
+}
+
+bool region_stream_next(region_stream *s, region_window *w) {
+    while (s->off < s->end) {
+        uint64_t off = s->off;
+        uint64_t lo = off - s->start > s->back ? off - s->back : s->start;
+        uint64_t hi = s->end - off > s->chunk + s->fwd ? off + s->chunk + s->fwd : s->end;
+        uint64_t own_end = s->end - off > s->chunk ? off + s->chunk : s->end;
+        s->off = own_end;
+
+        unsigned char *buf = s->buf[s->cur ^ 1];
+        uint64_t read_from = lo;
+
+        // 与上一个窗口重叠的部分直接拷贝
+        if (s->prev_valid && s->prev_hi > lo && s->prev_lo <= lo) {
+            uint64_t copy_end = s->prev_hi < hi ? s->prev_hi : hi;
+            memcpy(buf, s->buf[s->cur] + (lo - s->prev_lo), (size_t)(copy_end - lo));
+            read_from = copy_end;
+        }
+
+        if (read_from < hi &&
+            s->read(s->ctx, read_from, buf + (read_from - lo), (size_t)(hi - read_from)) != 0) {
+            s->prev_valid = false;
+            s->failed_windows++;
+            continue;
+        }
+        s->bytes_read += hi - read_from;
+
+        s->cur ^= 1;
+        s->prev_valid = true;
+        s->prev_lo = lo;
+        s->prev_hi = hi;
+
+        w->data = buf;
+        w->len = (size_t)(hi - lo);
+        w->addr = lo;
+        w->scan_begin = (size_t)(off - lo);
+        w->scan_end = (size_t)(own_end - lo);
+        return true;
+    }
+    return false;
+}
+
+void region_stream_destroy(region_stream *s) {
+    free(s->buf[0]);
+    free(s->buf[1]);
+    s->buf[0] = NULL;
+    s->buf[1] = NULL;
+}
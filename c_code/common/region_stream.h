@@ -0,0 +1,75 @@
+// 内存区域分块流式读取，Linux/macOS 两个 testkey 工具共用
+//
+// 不再为整个区域 malloc 一块缓冲区，而是按固定窗口（默认 4MB）依次读取，
+// 相邻窗口之间保留 back + fwd 字节的重叠，保证落在窗口边界附近的特征码
+// 及其各个偏移处的候选密钥都完整地出现在同一个窗口里。
+// 两块缓冲区交替使用：重叠部分直接从上一个窗口拷贝，不再重复读取目标进程。
+// 峰值内存只取决于窗口大小，与目标区域大小无关，大堆也不再被跳过。
+
+#ifndef CHATLOG_REGION_STREAM_H
+#define CHATLOG_REGION_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define REGION_STREAM_DEFAULT_CHUNK (4 * 1024 * 1024)
+
+/**
+ * 读取目标进程内存的回调
+ * @return 0 成功，-1 失败（该窗口被跳过，继续读下一个）
+ */
+typedef int (*region_stream_read_fn)(void *ctx, uint64_t addr, void *buf, size_t len);
+
+// 一个扫描窗口
+typedef struct {
+    const unsigned char *data;  // 窗口数据，下一次 region_stream_next 之后失效
+    size_t len;                 // 窗口字节数
+    uint64_t addr;              // data[0] 对应的目标进程地址
+    size_t scan_begin;          // 本窗口负责的特征码起始位置 [scan_begin, scan_end)
+    size_t scan_end;            // 相邻窗口负责的范围互不重叠
+} region_window;
+
+typedef struct {
+    region_stream_read_fn read;
+    void *ctx;
+    size_t chunk;               // 每个窗口负责的字节数
+    size_t back;                // 窗口向前多读的字节数（负偏移）
+    size_t fwd;                 // 窗口向后多读的字节数（正偏移 + 密钥长度）
+    unsigned char *buf[2];
+    size_t cap;
+    int cur;
+    // 当前区域的迭代状态
+    uint64_t start;
+    uint64_t end;
+    uint64_t off;               // 下一个窗口负责范围的起始地址
+    bool prev_valid;            // 上一个窗口是否读取成功，可以拷贝重叠部分
+    uint64_t prev_lo;
+    uint64_t prev_hi;
+    // 统计信息
+    uint64_t bytes_read;
+    uint64_t failed_windows;
+} region_stream;
+
+/**
+ * 初始化流式读取器，分配两块 chunk + back + fwd 字节的缓冲区
+ * @param chunk 窗口大小，0 表示使用默认值
+ * @return 0 成功，-1 内存不足
+ */
+int region_stream_init(region_stream *s, size_t chunk, size_t back, size_t fwd,
+                       region_stream_read_fn read, void *ctx);
+
+/**
+ * 开始读取一个新的区域 [start, end)
+ */
+void region_stream_begin(region_stream *s, uint64_t start, uint64_t end);
+
+/**
+ * 读取下一个窗口，读取失败的窗口会被跳过
+ * @return 得到一个窗口返回 true，区域读完返回 false
+ */
+bool region_stream_next(region_stream *s, region_window *w);
+
+void region_stream_destroy(region_stream *s);
+
+#endif // CHATLOG_REGION_STREAM_H
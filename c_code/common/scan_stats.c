@@ -0,0 +1,124 @@
+// 扫描统计实现，见 scan_stats.h
+
+#include "scan_stats.h"
+
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+#include "log.h"
+
+static const char *const stage_names[SCAN_STAGE_COUNT] = {"setup", "hint", "regions", "scan", "validate"};
+static const char *const skip_names[SCAN_SKIP_COUNT] = {"perms", "kind", "unreadable", "canceled"};
+
+static uint64_t clock_ns(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t scan_stats_now_ns(void) {
+    return clock_ns(CLOCK_MONOTONIC);
+}
+
+void scan_stats_init(scan_stats *s) {
+    memset(s, 0, sizeof(*s));
+    s->start_ns = scan_stats_now_ns();
+}
+
+void scan_stage_begin(scan_stage_timer *timer) {
+    timer->wall_ns = scan_stats_now_ns();
+    timer->cpu_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+void scan_stage_end(scan_stats *s, scan_stage stage, const scan_stage_timer *timer) {
+    if (!s) {
+        return;
+    }
+    s->stages[stage].wall_ns += scan_stats_now_ns() - timer->wall_ns;
+    s->stages[stage].cpu_ns += clock_ns(CLOCK_PROCESS_CPUTIME_ID) - timer->cpu_ns;
+}
+
+void scan_stats_key_found(scan_stats *s) {
+    if (!s) {
+        return;
+    }
+    uint64_t elapsed = scan_stats_now_ns() - s->start_ns;
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+    uint64_t expected = 0;
+    atomic_compare_exchange_strong(&s->first_key_ns, &expected, elapsed);
+}
+
+void scan_stats_key_offset(scan_stats *s, int offset) {
+    if (s) {
+        s->has_key_offset = true;
+        s->key_offset = offset;
+    }
+}
+
+static double ms(uint64_t ns) {
+    return ns / 1e6;
+}
+
+void scan_stats_print_json(const scan_stats *s, bool found, FILE *out) {
+    uint64_t total_wall = 0, total_cpu = 0;
+    for (int i = 0; i < SCAN_STAGE_COUNT; i++) {
+        total_wall += s->stages[i].wall_ns;
+        total_cpu += s->stages[i].cpu_ns;
+    }
+
+    fprintf(out, "{\"found\": %s", found ? "true" : "false");
+    fprintf(out, ", \"regions\": {\"seen\": %" PRIu64 ", \"scanned\": %" PRIu64 ", \"skipped\": {",
+            atomic_load(&s->regions_seen), atomic_load(&s->regions_scanned));
+    for (int i = 0; i < SCAN_SKIP_COUNT; i++) {
+        fprintf(out, "%s\"%s\": %" PRIu64, i ? ", " : "", skip_names[i],
+                atomic_load(&s->regions_skipped[i]));
+    }
+    fprintf(out, "}}");
+    fprintf(out, ", \"bytes_read\": %" PRIu64 ", \"read_errors\": %" PRIu64, atomic_load(&s->bytes_read),
+            atomic_load(&s->read_errors));
+    fprintf(out, ", \"pattern_hits\": %" PRIu64, atomic_load(&s->pattern_hits));
+    fprintf(out,
+            ", \"candidates\": {\"seen\": %" PRIu64 ", \"filtered\": %" PRIu64 ", \"cached\": %" PRIu64
+            ", \"pbkdf2\": %" PRIu64 "}",
+            atomic_load(&s->candidates_seen), atomic_load(&s->candidates_filtered),
+            atomic_load(&s->candidates_cached), atomic_load(&s->pbkdf2_calls));
+    fprintf(out, ", \"stages\": {");
+    for (int i = 0; i < SCAN_STAGE_COUNT; i++) {
+        fprintf(out, "%s\"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f}", i ? ", " : "", stage_names[i],
+                ms(s->stages[i].wall_ns), ms(s->stages[i].cpu_ns));
+    }
+    fprintf(out, ", \"total\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f}}", ms(total_wall), ms(total_cpu));
+    uint64_t first = atomic_load(&s->first_key_ns);
+    if (first) {
+        fprintf(out, ", \"time_to_first_key_ms\": %.3f", ms(first));
+    } else {
+        fprintf(out, ", \"time_to_first_key_ms\": null");
+    }
+    if (s->has_key_offset) {
+        fprintf(out, ", \"key_offset\": %d", s->key_offset);
+    } else {
+        fprintf(out, ", \"key_offset\": null");
+    }
+    fprintf(out, "}\n");
+}
+
+int scan_stats_write(const scan_stats *s, bool found, const char *path) {
+    if (strcmp(path, "-") == 0) {
+        scan_stats_print_json(s, found, stderr);
+        return 0;
+    }
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        log_warn("Failed to write stats to %s", path);
+        return -1;
+    }
+    scan_stats_print_json(s, found, fp);
+    if (fclose(fp) != 0) {
+        log_warn("Failed to write stats to %s", path);
+        return -1;
+    }
+    return 0;
+}
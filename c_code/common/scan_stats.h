@@ -0,0 +1,113 @@
+// 扫描统计，Linux/macOS 两个 testkey 工具和 libchatlogkey 共用
+//
+// "Key not found" 本身说明不了问题：可能一个字节都没读到，可能全部区域都没有读权限，
+// 也可能已经校验了上万个候选。这里按阶段记录区域、字节、命中、候选和 PBKDF2 次数，
+// 以及每个阶段的墙钟时间和 CPU 时间，testkey 工具用 --stats 输出成 JSON，
+// libchatlogkey 通过 chatlogkey_get_stats 导出同一组计数给 Go 侧记录。
+//
+// 计数器都是原子变量，扫描线程直接累加，不需要加锁；统计对象可以为 NULL，
+// 此时所有累加操作都被跳过。
+
+#ifndef CHATLOG_SCAN_STATS_H
+#define CHATLOG_SCAN_STATS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// 计时阶段
+typedef enum {
+    SCAN_STAGE_SETUP,    // 读取数据库第一页、打开缓存、暂停目标进程
+    SCAN_STAGE_HINT,     // 按上次记录的位置提示读取并校验候选
+    SCAN_STAGE_REGIONS,  // 枚举并排序内存区域
+    SCAN_STAGE_SCAN,     // 读取内存、特征码扫描（full/none 模式下包含校验）
+    SCAN_STAGE_VALIDATE, // snapshot 模式下目标进程恢复后的离线校验
+    SCAN_STAGE_COUNT,
+} scan_stage;
+
+// 区域被跳过的原因
+typedef enum {
+    SCAN_SKIP_PERMS,      // 不可读写
+    SCAN_SKIP_KIND,       // 类型不需要扫描：vdso/vvar 等特殊映射、未选中的 malloc 区域
+    SCAN_SKIP_UNREADABLE, // 一个字节都没读到
+    SCAN_SKIP_CANCELED,   // 已经找到密钥或扫描被取消，没有轮到
+    SCAN_SKIP_COUNT,
+} scan_skip_reason;
+
+typedef struct {
+    uint64_t wall_ns;
+    uint64_t cpu_ns;   // 整个进程所有线程的 CPU 时间
+} scan_stage_time;
+
+typedef struct {
+    _Atomic uint64_t regions_seen;     // 枚举到的所有区域
+    _Atomic uint64_t regions_scanned;  // 至少读到一部分内容的区域
+    _Atomic uint64_t regions_skipped[SCAN_SKIP_COUNT];
+    _Atomic uint64_t bytes_read;
+    _Atomic uint64_t read_errors;      // 读取失败或只读到一部分的窗口/区域
+    _Atomic uint64_t pattern_hits;
+    _Atomic uint64_t candidates_seen;     // 特征码命中后按偏移取出的候选
+    _Atomic uint64_t candidates_filtered; // 被预过滤拒绝的候选
+    _Atomic uint64_t candidates_cached;   // key_cache 直接给出结论的候选
+    _Atomic uint64_t pbkdf2_calls;        // 实际跑了 256000 轮 PBKDF2 的候选
+    scan_stage_time stages[SCAN_STAGE_COUNT];
+    uint64_t start_ns;
+    _Atomic uint64_t first_key_ns;     // 从 scan_stats_init 到找到密钥，0 表示没有找到
+    bool has_key_offset;               // 找到的密钥相对特征码的偏移是否已知
+    int key_offset;
+} scan_stats;
+
+// 一个阶段的起始时间
+typedef struct {
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+} scan_stage_timer;
+
+void scan_stats_init(scan_stats *s);
+
+/**
+ * 累加一个计数器，s 为 NULL 时什么都不做
+ */
+#define SCAN_STATS_ADD(s, field, n)                                                   \
+    do {                                                                              \
+        if (s) {                                                                      \
+            atomic_fetch_add_explicit(&(s)->field, (uint64_t)(n), memory_order_relaxed); \
+        }                                                                             \
+    } while (0)
+
+#define SCAN_STATS_SKIP(s, reason, n) SCAN_STATS_ADD(s, regions_skipped[reason], n)
+
+uint64_t scan_stats_now_ns(void);
+
+void scan_stage_begin(scan_stage_timer *timer);
+
+/**
+ * 结束一个阶段，时间累加到 s->stages[stage]，同一阶段可以分几段计时
+ */
+void scan_stage_end(scan_stats *s, scan_stage stage, const scan_stage_timer *timer);
+
+/**
+ * 记录找到第一个密钥的时间，只有第一次调用生效
+ */
+void scan_stats_key_found(scan_stats *s);
+
+/**
+ * 记录找到的密钥相对特征码的偏移，离线汇总后可以用来调整 key_offsets 的顺序
+ * 只在找到密钥之后由一个线程调用
+ */
+void scan_stats_key_offset(scan_stats *s, int offset);
+
+/**
+ * 以单个 JSON 对象输出全部统计
+ * @param found 是否找到了密钥
+ */
+void scan_stats_print_json(const scan_stats *s, bool found, FILE *out);
+
+/**
+ * 按 --stats 参数输出：'-' 写到 stderr，否则写到（覆盖）指定文件
+ * @return 0 成功，-1 无法写入
+ */
+int scan_stats_write(const scan_stats *s, bool found, const char *path);
+
+#endif // CHATLOG_SCAN_STATS_H
@@ -0,0 +1,191 @@
+// 标量 SHA-1 / HMAC-SHA1 / PBKDF2-HMAC-SHA1 实现，见 sha1.h
+
+#include "sha1.h"
+
+#include <string.h>
+
+static uint32_t load_be32(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void store_be32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static uint32_t rol32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static void sha1_block(uint32_t h[5], const unsigned char *block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = load_be32(block + i * 4);
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = rol32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol32(b, 30);
+        b = a;
+        a = t;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+void sha1_init(sha1_ctx *ctx) {
+    ctx->h[0] = 0x67452301;
+    ctx->h[1] = 0xEFCDAB89;
+    ctx->h[2] = 0x98BADCFE;
+    ctx->h[3] = 0x10325476;
+    ctx->h[4] = 0xC3D2E1F0;
+    ctx->total = 0;
+    ctx->buf_len = 0;
+}
+
+void sha1_update(sha1_ctx *ctx, const void *data, size_t len) {
+    const unsigned char *p = data;
+    ctx->total += len;
+
+    if (ctx->buf_len > 0) {
+        size_t take = SHA1_BLOCK_SIZE - ctx->buf_len;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(ctx->buf + ctx->buf_len, p, take);
+        ctx->buf_len += take;
+        p += take;
+        len -= take;
+        if (ctx->buf_len < SHA1_BLOCK_SIZE) {
+            return;
+        }
+        sha1_block(ctx->h, ctx->buf);
+        ctx->buf_len = 0;
+    }
+
+    while (len >= SHA1_BLOCK_SIZE) {
+        sha1_block(ctx->h, p);
+        p += SHA1_BLOCK_SIZE;
+        len -= SHA1_BLOCK_SIZE;
+    }
+
+    if (len > 0) {
+        memcpy(ctx->buf, p, len);
+        ctx->buf_len = len;
+    }
+}
+
+void sha1_final(sha1_ctx *ctx, unsigned char out[SHA1_DIGEST_SIZE]) {
+    uint64_t bits = ctx->total * 8;
+
+    ctx->buf[ctx->buf_len++] = 0x80;
+    if (ctx->buf_len > SHA1_BLOCK_SIZE - 8) {
+        memset(ctx->buf + ctx->buf_len, 0, SHA1_BLOCK_SIZE - ctx->buf_len);
+        sha1_block(ctx->h, ctx->buf);
+        ctx->buf_len = 0;
+    }
+    memset(ctx->buf + ctx->buf_len, 0, SHA1_BLOCK_SIZE - 8 - ctx->buf_len);
+    store_be32(ctx->buf + SHA1_BLOCK_SIZE - 8, (uint32_t)(bits >> 32));
+    store_be32(ctx->buf + SHA1_BLOCK_SIZE - 4, (uint32_t)bits);
+    sha1_block(ctx->h, ctx->buf);
+
+    for (int i = 0; i < 5; i++) {
+        store_be32(out + i * 4, ctx->h[i]);
+    }
+}
+
+void hmac_sha1_init(hmac_sha1_ctx *ctx, const unsigned char *key, size_t key_len) {
+    unsigned char block[SHA1_BLOCK_SIZE] = {0};
+    if (key_len > SHA1_BLOCK_SIZE) {
+        sha1_ctx kctx;
+        sha1_init(&kctx);
+        sha1_update(&kctx, key, key_len);
+        sha1_final(&kctx, block);
+    } else {
+        memcpy(block, key, key_len);
+    }
+
+    unsigned char pad[SHA1_BLOCK_SIZE];
+    for (int i = 0; i < SHA1_BLOCK_SIZE; i++) {
+        pad[i] = block[i] ^ 0x36;
+    }
+    sha1_init(&ctx->inner);
+    sha1_update(&ctx->inner, pad, SHA1_BLOCK_SIZE);
+
+    for (int i = 0; i < SHA1_BLOCK_SIZE; i++) {
+        pad[i] = block[i] ^ 0x5c;
+    }
+    sha1_init(&ctx->outer);
+    sha1_update(&ctx->outer, pad, SHA1_BLOCK_SIZE);
+}
+
+void hmac_sha1_update(hmac_sha1_ctx *ctx, const void *data, size_t len) {
+    sha1_update(&ctx->inner, data, len);
+}
+
+void hmac_sha1_final(hmac_sha1_ctx *ctx, unsigned char out[SHA1_DIGEST_SIZE]) {
+    unsigned char inner_hash[SHA1_DIGEST_SIZE];
+    sha1_final(&ctx->inner, inner_hash);
+    sha1_update(&ctx->outer, inner_hash, SHA1_DIGEST_SIZE);
+    sha1_final(&ctx->outer, out);
+}
+
+void pbkdf2_hmac_sha1(const unsigned char *password, size_t password_len,
+                      const unsigned char *salt, size_t salt_len, uint32_t iterations,
+                      unsigned char *out, size_t out_len) {
+    hmac_sha1_ctx keyed;
+    hmac_sha1_init(&keyed, password, password_len);
+
+    for (uint32_t block = 1; out_len > 0; block++) {
+        const unsigned char index[4] = {block >> 24, (block >> 16) & 0xFF, (block >> 8) & 0xFF,
+                                        block & 0xFF};
+        unsigned char u[SHA1_DIGEST_SIZE];
+        unsigned char t[SHA1_DIGEST_SIZE];
+
+        hmac_sha1_ctx mac = keyed;
+        hmac_sha1_update(&mac, salt, salt_len);
+        hmac_sha1_update(&mac, index, sizeof(index));
+        hmac_sha1_final(&mac, u);
+        memcpy(t, u, SHA1_DIGEST_SIZE);
+
+        for (uint32_t i = 1; i < iterations; i++) {
+            mac = keyed;
+            hmac_sha1_update(&mac, u, SHA1_DIGEST_SIZE);
+            hmac_sha1_final(&mac, u);
+            for (int j = 0; j < SHA1_DIGEST_SIZE; j++) {
+                t[j] ^= u[j];
+            }
+        }
+
+        size_t take = out_len < SHA1_DIGEST_SIZE ? out_len : SHA1_DIGEST_SIZE;
+        memcpy(out, t, take);
+        out += take;
+        out_len -= take;
+    }
+}
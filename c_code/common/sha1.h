@@ -0,0 +1,41 @@
+// 标量 SHA-1 / HMAC-SHA1 / PBKDF2-HMAC-SHA1
+//
+// 只用于 V3 数据库（macOS / Linux 微信 3.x）：mac_key 是 2 轮 PBKDF2-HMAC-SHA1，
+// 页面 HMAC 是 HMAC-SHA1。轮数很少，不需要 sha512_mb 那样的多路实现；
+// 不依赖 OpenSSL / CommonCrypto，两个平台共用。
+
+#ifndef CHATLOG_SHA1_H
+#define CHATLOG_SHA1_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA1_DIGEST_SIZE 20
+#define SHA1_BLOCK_SIZE 64
+
+typedef struct {
+    uint32_t h[5];
+    uint64_t total;
+    unsigned char buf[SHA1_BLOCK_SIZE];
+    size_t buf_len;
+} sha1_ctx;
+
+// ipad / opad 已经吸收进两个 SHA-1 状态，复制一份就可以对新消息计算 HMAC
+typedef struct {
+    sha1_ctx inner;
+    sha1_ctx outer;
+} hmac_sha1_ctx;
+
+void sha1_init(sha1_ctx *ctx);
+void sha1_update(sha1_ctx *ctx, const void *data, size_t len);
+void sha1_final(sha1_ctx *ctx, unsigned char out[SHA1_DIGEST_SIZE]);
+
+void hmac_sha1_init(hmac_sha1_ctx *ctx, const unsigned char *key, size_t key_len);
+void hmac_sha1_update(hmac_sha1_ctx *ctx, const void *data, size_t len);
+void hmac_sha1_final(hmac_sha1_ctx *ctx, unsigned char out[SHA1_DIGEST_SIZE]);
+
+void pbkdf2_hmac_sha1(const unsigned char *password, size_t password_len,
+                      const unsigned char *salt, size_t salt_len, uint32_t iterations,
+                      unsigned char *out, size_t out_len);
+
+#endif // CHATLOG_SHA1_H
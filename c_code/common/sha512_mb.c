@@ -0,0 +1,392 @@
+// 多路并行 SHA-512 / PBKDF2-HMAC-SHA512 实现，见 sha512_mb.h
+
+#include "sha512_mb.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHA512_MB_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SHA512_MB_NEON 1
+#endif
+
+static const uint64_t sha512_k[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL,
+};
+
+static const uint64_t sha512_iv[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL,
+};
+
+static uint64_t load_be64(const unsigned char *p) {
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) |
+           ((uint64_t)p[3] << 32) | ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+           ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+}
+
+static void store_be64(unsigned char *p, uint64_t v) {
+    for (int i = 7; i >= 0; i--) {
+        p[i] = (unsigned char)v;
+        v >>= 8;
+    }
+}
+
+static inline uint64_t ror64(uint64_t x, int n) {
+    return (x >> n) | (x << (64 - n));
+}
+
+/**
+ * 标准 SHA-512 单块压缩
+ */
+static void sha512_block(uint64_t h[8], const unsigned char *block) {
+    uint64_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = load_be64(block + i * 8);
+    }
+    for (int i = 16; i < 80; i++) {
+        uint64_t s0 = ror64(w[i - 15], 1) ^ ror64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+        uint64_t s1 = ror64(w[i - 2], 19) ^ ror64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint64_t a = h[0], b = h[1], c = h[2], d = h[3];
+    uint64_t e = h[4], f = h[5], g = h[6], hh = h[7];
+    for (int i = 0; i < 80; i++) {
+        uint64_t t1 = hh + (ror64(e, 14) ^ ror64(e, 18) ^ ror64(e, 41)) +
+                      ((e & f) ^ (~e & g)) + sha512_k[i] + w[i];
+        uint64_t t2 = (ror64(a, 28) ^ ror64(a, 34) ^ ror64(a, 39)) +
+                      ((a & b) | (c & (a | b)));
+        hh = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += hh;
+}
+
+void sha512_init(sha512_ctx *ctx) {
+    memcpy(ctx->h, sha512_iv, sizeof(sha512_iv));
+    ctx->total = 0;
+    ctx->buf_len = 0;
+}
+
+void sha512_update(sha512_ctx *ctx, const void *data, size_t len) {
+    const unsigned char *p = data;
+    ctx->total += len;
+
+    if (ctx->buf_len > 0) {
+        size_t take = SHA512_BLOCK_SIZE - ctx->buf_len;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(ctx->buf + ctx->buf_len, p, take);
+        ctx->buf_len += take;
+        p += take;
+        len -= take;
+        if (ctx->buf_len < SHA512_BLOCK_SIZE) {
+            return;
+        }
+        sha512_block(ctx->h, ctx->buf);
+        ctx->buf_len = 0;
+    }
+
+    while (len >= SHA512_BLOCK_SIZE) {
+        sha512_block(ctx->h, p);
+        p += SHA512_BLOCK_SIZE;
+        len -= SHA512_BLOCK_SIZE;
+    }
+
+    if (len > 0) {
+        memcpy(ctx->buf, p, len);
+        ctx->buf_len = len;
+    }
+}
+
+void sha512_final(sha512_ctx *ctx, unsigned char out[SHA512_DIGEST_SIZE]) {
+    uint64_t bits = ctx->total * 8;
+
+    ctx->buf[ctx->buf_len++] = 0x80;
+    if (ctx->buf_len > SHA512_BLOCK_SIZE - 16) {
+        memset(ctx->buf + ctx->buf_len, 0, SHA512_BLOCK_SIZE - ctx->buf_len);
+        sha512_block(ctx->h, ctx->buf);
+        ctx->buf_len = 0;
+    }
+    memset(ctx->buf + ctx->buf_len, 0, SHA512_BLOCK_SIZE - 8 - ctx->buf_len);
+    // 长度字段高 64 位恒为 0
+    store_be64(ctx->buf + SHA512_BLOCK_SIZE - 8, bits);
+    sha512_block(ctx->h, ctx->buf);
+
+    for (int i = 0; i < 8; i++) {
+        store_be64(out + i * 8, ctx->h[i]);
+    }
+}
+
+void hmac_sha512_init(hmac_sha512_ctx *ctx, const unsigned char *key, size_t key_len) {
+    unsigned char block[SHA512_BLOCK_SIZE] = {0};
+    if (key_len > SHA512_BLOCK_SIZE) {
+        sha512_ctx kctx;
+        sha512_init(&kctx);
+        sha512_update(&kctx, key, key_len);
+        sha512_final(&kctx, block);
+    } else {
+        memcpy(block, key, key_len);
+    }
+
+    unsigned char pad[SHA512_BLOCK_SIZE];
+    for (int i = 0; i < SHA512_BLOCK_SIZE; i++) {
+        pad[i] = block[i] ^ 0x36;
+    }
+    sha512_init(&ctx->inner);
+    sha512_update(&ctx->inner, pad, SHA512_BLOCK_SIZE);
+
+    for (int i = 0; i < SHA512_BLOCK_SIZE; i++) {
+        pad[i] = block[i] ^ 0x5c;
+    }
+    sha512_init(&ctx->outer);
+    sha512_update(&ctx->outer, pad, SHA512_BLOCK_SIZE);
+}
+
+void hmac_sha512_update(hmac_sha512_ctx *ctx, const void *data, size_t len) {
+    sha512_update(&ctx->inner, data, len);
+}
+
+void hmac_sha512_final(hmac_sha512_ctx *ctx, unsigned char out[SHA512_DIGEST_SIZE]) {
+    unsigned char inner_hash[SHA512_DIGEST_SIZE];
+    sha512_final(&ctx->inner, inner_hash);
+    sha512_update(&ctx->outer, inner_hash, SHA512_DIGEST_SIZE);
+    sha512_final(&ctx->outer, out);
+}
+
+// ---------------------------------------------------------------------------
+// 多路迭代内核
+// ---------------------------------------------------------------------------
+
+typedef void (*sha512_mb_iter_fn)(const uint64_t ipad[8][SHA512_MB_MAX_LANES],
+                                  const uint64_t opad[8][SHA512_MB_MAX_LANES],
+                                  uint64_t u[8][SHA512_MB_MAX_LANES],
+                                  uint64_t t[8][SHA512_MB_MAX_LANES],
+                                  size_t lanes, uint32_t count);
+
+// 标量版本：每个"向量"只有一个通道
+#define MB_FN pbkdf2_iter_scalar
+#define MB_TARGET
+#define MB_WIDTH 1
+#define MB_V uint64_t
+#define MB_LOAD(p) (*(p))
+#define MB_STORE(p, v) (*(p) = (v))
+#define MB_SET1(x) ((uint64_t)(x))
+#define MB_ADD(a, b) ((a) + (b))
+#define MB_XOR(a, b) ((a) ^ (b))
+#define MB_AND(a, b) ((a) & (b))
+#define MB_OR(a, b) ((a) | (b))
+#define MB_ANDNOT(a, b) (~(a) & (b))
+#define MB_ROR(x, n) ror64((x), (n))
+#define MB_SHR(x, n) ((x) >> (n))
+#include "sha512_mb_kernel.h"
+
+#if defined(SHA512_MB_X86)
+#define MB_FN pbkdf2_iter_avx2
+#define MB_TARGET __attribute__((target("avx2")))
+#define MB_WIDTH 4
+#define MB_V __m256i
+#define MB_LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+#define MB_STORE(p, v) _mm256_storeu_si256((__m256i *)(p), (v))
+#define MB_SET1(x) _mm256_set1_epi64x((long long)(x))
+#define MB_ADD(a, b) _mm256_add_epi64((a), (b))
+#define MB_XOR(a, b) _mm256_xor_si256((a), (b))
+#define MB_AND(a, b) _mm256_and_si256((a), (b))
+#define MB_OR(a, b) _mm256_or_si256((a), (b))
+#define MB_ANDNOT(a, b) _mm256_andnot_si256((a), (b))
+#define MB_ROR(x, n) _mm256_or_si256(_mm256_srli_epi64((x), (n)), _mm256_slli_epi64((x), 64 - (n)))
+#define MB_SHR(x, n) _mm256_srli_epi64((x), (n))
+#include "sha512_mb_kernel.h"
+
+#define MB_FN pbkdf2_iter_avx512
+#define MB_TARGET __attribute__((target("avx512f")))
+#define MB_WIDTH 8
+#define MB_V __m512i
+#define MB_LOAD(p) _mm512_loadu_si512((const void *)(p))
+#define MB_STORE(p, v) _mm512_storeu_si512((void *)(p), (v))
+#define MB_SET1(x) _mm512_set1_epi64((long long)(x))
+#define MB_ADD(a, b) _mm512_add_epi64((a), (b))
+#define MB_XOR(a, b) _mm512_xor_si512((a), (b))
+#define MB_AND(a, b) _mm512_and_si512((a), (b))
+#define MB_OR(a, b) _mm512_or_si512((a), (b))
+#define MB_ANDNOT(a, b) _mm512_andnot_si512((a), (b))
+#define MB_ROR(x, n) _mm512_ror_epi64((x), (n))
+#define MB_SHR(x, n) _mm512_srli_epi64((x), (n))
+#include "sha512_mb_kernel.h"
+#endif
+
+#if defined(SHA512_MB_NEON)
+#define MB_FN pbkdf2_iter_neon
+#define MB_TARGET
+#define MB_WIDTH 2
+#define MB_V uint64x2_t
+#define MB_LOAD(p) vld1q_u64(p)
+#define MB_STORE(p, v) vst1q_u64((p), (v))
+#define MB_SET1(x) vdupq_n_u64((uint64_t)(x))
+#define MB_ADD(a, b) vaddq_u64((a), (b))
+#define MB_XOR(a, b) veorq_u64((a), (b))
+#define MB_AND(a, b) vandq_u64((a), (b))
+#define MB_OR(a, b) vorrq_u64((a), (b))
+#define MB_ANDNOT(a, b) vbicq_u64((b), (a))
+#define MB_ROR(x, n) vsriq_n_u64(vshlq_n_u64((x), 64 - (n)), (x), (n))
+#define MB_SHR(x, n) vshrq_n_u64((x), (n))
+#include "sha512_mb_kernel.h"
+#endif
+
+typedef struct {
+    sha512_mb_iter_fn fn;
+    int lanes;
+    const char *name;
+} sha512_mb_engine_info;
+
+static sha512_mb_engine_info engine;
+static pthread_once_t engine_once = PTHREAD_ONCE_INIT;
+
+static void init_engine(void) {
+    sha512_mb_engine_info chosen = {pbkdf2_iter_scalar, 1, "scalar"};
+#if defined(SHA512_MB_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        chosen = (sha512_mb_engine_info){pbkdf2_iter_avx512, 8, "avx512"};
+    } else if (__builtin_cpu_supports("avx2")) {
+        chosen = (sha512_mb_engine_info){pbkdf2_iter_avx2, 4, "avx2"};
+    }
+#elif defined(SHA512_MB_NEON)
+    chosen = (sha512_mb_engine_info){pbkdf2_iter_neon, 2, "neon"};
+#endif
+
+    // CHATLOG_SHA512_MB=scalar/avx2 可以强制降级，便于对比和排查
+    const char *force = getenv("CHATLOG_SHA512_MB");
+    if (force && strcmp(force, "scalar") == 0) {
+        chosen = (sha512_mb_engine_info){pbkdf2_iter_scalar, 1, "scalar"};
+    }
+#if defined(SHA512_MB_X86)
+    if (force && strcmp(force, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        chosen = (sha512_mb_engine_info){pbkdf2_iter_avx2, 4, "avx2"};
+    }
+#endif
+    engine = chosen;
+}
+
+static const sha512_mb_engine_info *select_engine(void) {
+    pthread_once(&engine_once, init_engine);
+    return &engine;
+}
+
+const char *sha512_mb_engine(void) {
+    return select_engine()->name;
+}
+
+int sha512_mb_lanes(void) {
+    return select_engine()->lanes;
+}
+
+/**
+ * 处理不超过 SHA512_MB_MAX_LANES 个口令的一组
+ */
+static void pbkdf2_group(sha512_mb_iter_fn iter,
+                         const unsigned char *const passwords[], size_t password_len,
+                         const unsigned char *salt, size_t salt_len,
+                         uint32_t iterations,
+                         unsigned char *const out[], size_t out_len, size_t lanes) {
+    _Alignas(64) uint64_t ipad[8][SHA512_MB_MAX_LANES] = {{0}};
+    _Alignas(64) uint64_t opad[8][SHA512_MB_MAX_LANES] = {{0}};
+    _Alignas(64) uint64_t u[8][SHA512_MB_MAX_LANES] = {{0}};
+    _Alignas(64) uint64_t t[8][SHA512_MB_MAX_LANES] = {{0}};
+    hmac_sha512_ctx keyed[SHA512_MB_MAX_LANES];
+
+    for (size_t lane = 0; lane < lanes; lane++) {
+        hmac_sha512_init(&keyed[lane], passwords[lane], password_len);
+        for (int i = 0; i < 8; i++) {
+            ipad[i][lane] = keyed[lane].inner.h[i];
+            opad[i][lane] = keyed[lane].outer.h[i];
+        }
+    }
+
+    uint32_t block_index = 1;
+    for (size_t done = 0; done < out_len; done += SHA512_DIGEST_SIZE, block_index++) {
+        // U1 = HMAC(P, S || INT(i))，每个口令只算一次，标量即可
+        unsigned char be_index[4] = {
+            (unsigned char)(block_index >> 24), (unsigned char)(block_index >> 16),
+            (unsigned char)(block_index >> 8), (unsigned char)block_index,
+        };
+        for (size_t lane = 0; lane < lanes; lane++) {
+            hmac_sha512_ctx ctx = keyed[lane];
+            unsigned char u1[SHA512_DIGEST_SIZE];
+            hmac_sha512_update(&ctx, salt, salt_len);
+            hmac_sha512_update(&ctx, be_index, sizeof(be_index));
+            hmac_sha512_final(&ctx, u1);
+            for (int i = 0; i < 8; i++) {
+                u[i][lane] = t[i][lane] = load_be64(u1 + i * 8);
+            }
+        }
+
+        // U2..Uc 在各通道中同步迭代
+        if (iterations > 1) {
+            iter((const uint64_t(*)[SHA512_MB_MAX_LANES])ipad,
+                 (const uint64_t(*)[SHA512_MB_MAX_LANES])opad, u, t, lanes, iterations - 1);
+        }
+
+        size_t take = out_len - done < SHA512_DIGEST_SIZE ? out_len - done : SHA512_DIGEST_SIZE;
+        for (size_t lane = 0; lane < lanes; lane++) {
+            unsigned char block[SHA512_DIGEST_SIZE];
+            for (int i = 0; i < 8; i++) {
+                store_be64(block + i * 8, t[i][lane]);
+            }
+            memcpy(out[lane] + done, block, take);
+        }
+    }
+}
+
+void pbkdf2_hmac_sha512_batch(const unsigned char *const passwords[], size_t password_len,
+                              const unsigned char *salt, size_t salt_len,
+                              uint32_t iterations,
+                              unsigned char *const out[], size_t out_len, size_t n) {
+    const sha512_mb_engine_info *engine = select_engine();
+    for (size_t i = 0; i < n; i += SHA512_MB_MAX_LANES) {
+        size_t lanes = n - i < SHA512_MB_MAX_LANES ? n - i : SHA512_MB_MAX_LANES;
+        // 只剩一个口令时 SIMD 内核的其余通道都在空转，标量内核反而更快
+        sha512_mb_iter_fn iter = lanes == 1 ? pbkdf2_iter_scalar : engine->fn;
+        pbkdf2_group(iter, passwords + i, password_len, salt, salt_len,
+                     iterations, out + i, out_len, lanes);
+    }
+}
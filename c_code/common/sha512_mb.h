@@ -0,0 +1,63 @@
+// 多路并行 SHA-512 / PBKDF2-HMAC-SHA512
+//
+// V4 校验的耗时几乎全部在 256000 轮 PBKDF2-HMAC-SHA512 上，每一轮是两次
+// SHA-512 压缩，且块布局固定（上一轮 64 字节摘要 + 固定填充）。这里把 N 个
+// 候选放进 SIMD 的不同通道同步迭代：
+//   - x86: AVX-512 8 路 / AVX2 4 路，运行时按 CPU 特性选择
+//   - arm64: NEON 2 路
+//   - 其他: 标量逐个计算
+// 同时提供一个不依赖 OpenSSL / CommonCrypto 的标量 SHA-512 与 HMAC-SHA512，
+// 供页面 HMAC 校验使用。
+
+#ifndef CHATLOG_SHA512_MB_H
+#define CHATLOG_SHA512_MB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA512_DIGEST_SIZE 64
+#define SHA512_BLOCK_SIZE 128
+#define SHA512_MB_MAX_LANES 8
+
+typedef struct {
+    uint64_t h[8];
+    uint64_t total;   // 已处理的字节数
+    unsigned char buf[SHA512_BLOCK_SIZE];
+    size_t buf_len;
+} sha512_ctx;
+
+typedef struct {
+    sha512_ctx inner;  // 已吸收 key ^ ipad
+    sha512_ctx outer;  // 已吸收 key ^ opad
+} hmac_sha512_ctx;
+
+void sha512_init(sha512_ctx *ctx);
+void sha512_update(sha512_ctx *ctx, const void *data, size_t len);
+void sha512_final(sha512_ctx *ctx, unsigned char out[SHA512_DIGEST_SIZE]);
+
+void hmac_sha512_init(hmac_sha512_ctx *ctx, const unsigned char *key, size_t key_len);
+void hmac_sha512_update(hmac_sha512_ctx *ctx, const void *data, size_t len);
+void hmac_sha512_final(hmac_sha512_ctx *ctx, unsigned char out[SHA512_DIGEST_SIZE]);
+
+/**
+ * 批量 PBKDF2-HMAC-SHA512，n 个口令共用同一个 salt 和迭代次数
+ * 内部按 SHA512_MB_MAX_LANES 分组，每组在 SIMD 通道中同步迭代
+ * @param passwords n 个口令指针，长度均为 password_len
+ * @param out n 个输出缓冲区，长度均为 out_len
+ */
+void pbkdf2_hmac_sha512_batch(const unsigned char *const passwords[], size_t password_len,
+                              const unsigned char *salt, size_t salt_len,
+                              uint32_t iterations,
+                              unsigned char *const out[], size_t out_len, size_t n);
+
+/**
+ * 当前使用的多路内核名称："avx512" / "avx2" / "neon" / "scalar"
+ */
+const char *sha512_mb_engine(void);
+
+/**
+ * 当前内核的 SIMD 通道数
+ */
+int sha512_mb_lanes(void);
+
+#endif // CHATLOG_SHA512_MB_H
@@ -0,0 +1,132 @@
+// PBKDF2-HMAC-SHA512 多路迭代内核模板，只能被 sha512_mb.c 包含
+//
+// 包含前需要定义：
+//   MB_FN          生成的函数名
+//   MB_TARGET      函数属性（如 __attribute__((target("avx2")))），可以为空
+//   MB_WIDTH       每个向量的通道数
+//   MB_V           向量类型，每个通道一个 uint64_t
+//   MB_LOAD(p)     从 uint64_t 数组加载 MB_WIDTH 个通道
+//   MB_STORE(p, v) 写回 MB_WIDTH 个通道
+//   MB_SET1(x)     广播常量
+//   MB_ADD / MB_XOR / MB_AND / MB_OR
+//   MB_ANDNOT(a, b) 计算 ~a & b
+//   MB_ROR(x, n) / MB_SHR(x, n) n 为编译期常量
+//
+// 生成的函数签名与 sha512_mb_iter_fn 一致：对 lanes 个通道执行 count 轮
+//   u = HMAC(key, u); t ^= u
+// ipad/opad 为已吸收 key^ipad / key^opad 之后的中间状态。
+
+#define MB_CAT_(a, b) a##b
+#define MB_CAT(a, b) MB_CAT_(a, b)
+#define MB_COMPRESS MB_CAT(MB_FN, _compress)
+
+#define MB_S0(x) MB_XOR(MB_XOR(MB_ROR(x, 28), MB_ROR(x, 34)), MB_ROR(x, 39))
+#define MB_S1(x) MB_XOR(MB_XOR(MB_ROR(x, 14), MB_ROR(x, 18)), MB_ROR(x, 41))
+#define MB_s0(x) MB_XOR(MB_XOR(MB_ROR(x, 1), MB_ROR(x, 8)), MB_SHR(x, 7))
+#define MB_s1(x) MB_XOR(MB_XOR(MB_ROR(x, 19), MB_ROR(x, 61)), MB_SHR(x, 6))
+#define MB_CH(e, f, g) MB_XOR(MB_AND(e, f), MB_ANDNOT(e, g))
+#define MB_MAJ(a, b, c) MB_OR(MB_AND(a, b), MB_AND(c, MB_OR(a, b)))
+
+/**
+ * 对 64 字节摘要做一次压缩：块内容为 msg[0..7] + 0x80 填充 + 长度 1536 位
+ * （HMAC 内外两层在第二轮之后的块都是这个布局）
+ * out = state + compress(state, block)
+ */
+static inline MB_TARGET void MB_COMPRESS(const MB_V state[8], const MB_V msg[8], MB_V out[8]) {
+    MB_V w[16];
+    for (int i = 0; i < 8; i++) {
+        w[i] = msg[i];
+    }
+    w[8] = MB_SET1(0x8000000000000000ULL);
+    for (int i = 9; i < 15; i++) {
+        w[i] = MB_SET1(0);
+    }
+    w[15] = MB_SET1((SHA512_BLOCK_SIZE + SHA512_DIGEST_SIZE) * 8);
+
+    MB_V a = state[0], b = state[1], c = state[2], d = state[3];
+    MB_V e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 80; t++) {
+        MB_V wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            wt = MB_ADD(MB_ADD(MB_s1(w[(t - 2) & 15]), w[(t - 7) & 15]),
+                        MB_ADD(MB_s0(w[(t - 15) & 15]), w[t & 15]));
+            w[t & 15] = wt;
+        }
+        MB_V t1 = MB_ADD(MB_ADD(MB_ADD(h, MB_S1(e)), MB_ADD(MB_CH(e, f, g), MB_SET1(sha512_k[t]))), wt);
+        MB_V t2 = MB_ADD(MB_S0(a), MB_MAJ(a, b, c));
+        h = g;
+        g = f;
+        f = e;
+        e = MB_ADD(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = MB_ADD(t1, t2);
+    }
+
+    out[0] = MB_ADD(state[0], a);
+    out[1] = MB_ADD(state[1], b);
+    out[2] = MB_ADD(state[2], c);
+    out[3] = MB_ADD(state[3], d);
+    out[4] = MB_ADD(state[4], e);
+    out[5] = MB_ADD(state[5], f);
+    out[6] = MB_ADD(state[6], g);
+    out[7] = MB_ADD(state[7], h);
+}
+
+static MB_TARGET void MB_FN(const uint64_t ipad[8][SHA512_MB_MAX_LANES],
+                            const uint64_t opad[8][SHA512_MB_MAX_LANES],
+                            uint64_t u[8][SHA512_MB_MAX_LANES],
+                            uint64_t t[8][SHA512_MB_MAX_LANES],
+                            size_t lanes, uint32_t count) {
+    for (size_t base = 0; base < lanes; base += MB_WIDTH) {
+        MB_V ih[8], oh[8], cu[8], ct[8], inner[8];
+        for (int i = 0; i < 8; i++) {
+            ih[i] = MB_LOAD(&ipad[i][base]);
+            oh[i] = MB_LOAD(&opad[i][base]);
+            cu[i] = MB_LOAD(&u[i][base]);
+            ct[i] = MB_LOAD(&t[i][base]);
+        }
+
+        for (uint32_t c = 0; c < count; c++) {
+            MB_COMPRESS(ih, cu, inner);
+            MB_COMPRESS(oh, inner, cu);
+            for (int i = 0; i < 8; i++) {
+                ct[i] = MB_XOR(ct[i], cu[i]);
+            }
+        }
+
+        for (int i = 0; i < 8; i++) {
+            MB_STORE(&u[i][base], cu[i]);
+            MB_STORE(&t[i][base], ct[i]);
+        }
+    }
+}
+
+#undef MB_CAT_
+#undef MB_CAT
+#undef MB_COMPRESS
+#undef MB_S0
+#undef MB_S1
+#undef MB_s0
+#undef MB_s1
+#undef MB_CH
+#undef MB_MAJ
+
+#undef MB_FN
+#undef MB_TARGET
+#undef MB_WIDTH
+#undef MB_V
+#undef MB_LOAD
+#undef MB_STORE
+#undef MB_SET1
+#undef MB_ADD
+#undef MB_XOR
+#undef MB_AND
+#undef MB_OR
+#undef MB_ANDNOT
+#undef MB_ROR
+#undef MB_SHR
@@ -0,0 +1,28 @@
+// V3 候选密钥校验实现，见 v3_validate.h
+
+#include "v3_validate.h"
+
+#include "db_page_v3.h"
+
+void v3_derive_mac_key(const unsigned char key[DB_KEY_SIZE], const unsigned char salt[DB_SALT_SIZE],
+                       unsigned char mac_key[DB_KEY_SIZE]) {
+    unsigned char mac_salt[DB_SALT_SIZE];
+    for (int i = 0; i < DB_SALT_SIZE; i++) {
+        mac_salt[i] = salt[i] ^ DB_MAC_SALT_XOR;
+    }
+    pbkdf2_hmac_sha1(key, DB_KEY_SIZE, mac_salt, DB_SALT_SIZE, DB_MAC_ITER_COUNT,
+                     mac_key, DB_KEY_SIZE);
+}
+
+bool testkey_v3(const unsigned char *page, const unsigned char *key) {
+    if (!page || !key) {
+        return false;
+    }
+
+    unsigned char mac_key[DB_KEY_SIZE];
+    v3_derive_mac_key(key, page, mac_key);
+
+    hmac_sha1_ctx mac;
+    hmac_sha1_init(&mac, mac_key, DB_KEY_SIZE);
+    return db_v3_verify_page(&mac, page, 0);
+}
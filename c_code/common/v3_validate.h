@@ -0,0 +1,27 @@
+// V3 候选密钥校验，Linux/macOS 两个 testkey 工具和 v4poc 共用
+//
+// macOS / Linux 的 V3 数据库直接用内存中的密钥作为 enc_key，mac_key 只是 2 轮
+// PBKDF2-HMAC-SHA1，单个候选只需要几十次 SHA-1 压缩，不需要攒批，
+// 扫描时可以对每个候选先做一次 V3 校验再送进 V4 批次。
+
+#ifndef CHATLOG_V3_VALIDATE_H
+#define CHATLOG_V3_VALIDATE_H
+
+#include <stdbool.h>
+
+#include "db_format.h"
+
+/**
+ * 由密钥和第一页的 salt 派生 mac_key
+ */
+void v3_derive_mac_key(const unsigned char key[DB_KEY_SIZE], const unsigned char salt[DB_SALT_SIZE],
+                       unsigned char mac_key[DB_KEY_SIZE]);
+
+/**
+ * 校验 V3 候选密钥，逻辑与 V3Decryptor.Validate 一致
+ * @param page 数据库第一页内容（至少 1024 字节）
+ * @param key 候选密钥，32 字节
+ */
+bool testkey_v3(const unsigned char *page, const unsigned char *key);
+
+#endif // CHATLOG_V3_VALIDATE_H
@@ -0,0 +1,618 @@
+// V4 数据库整库解密实现，见 v4_decrypt.h
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "v4_decrypt.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "db_page_v4.h"
+#include "db_zero.h"
+
+// V4 页布局见 db_format.h，页校验和解密由 db_page_v4.h 按编译期常量生成
+#define PAGE_SIZE V4_DECRYPT_PAGE_SIZE
+#define SALT_SIZE V4_DECRYPT_SALT_SIZE
+_Static_assert(PAGE_SIZE == DB_V4_PAGE_SIZE && SALT_SIZE == DB_SALT_SIZE, "V4 page layout");
+
+// 每次读写的页数，减少系统调用次数
+#define CHUNK_PAGES 256
+// 并行解密时每个 worker 一次领取的页数
+#define PARALLEL_CHUNK_PAGES 64
+#define MAX_JOBS 256
+
+void v4_decrypt_init_keys(v4_decrypt_ctx *ctx, const unsigned char enc_key[V4_DECRYPT_KEY_SIZE],
+                          const unsigned char mac_key[V4_DECRYPT_KEY_SIZE]) {
+    aes256_dec_init(&ctx->aes, enc_key);
+    hmac_sha512_init(&ctx->mac, mac_key, V4_DECRYPT_KEY_SIZE);
+}
+
+/**
+ * enc_key = PBKDF2(key, salt, 256000)，mac_key = PBKDF2(enc_key, salt ^ 0x3A, 2)
+ */
+static void derive_keys(const unsigned char key[V4_DECRYPT_KEY_SIZE],
+                        const unsigned char salt[V4_DECRYPT_SALT_SIZE],
+                        unsigned char enc_key[V4_DECRYPT_KEY_SIZE],
+                        unsigned char mac_key[V4_DECRYPT_KEY_SIZE]) {
+    unsigned char mac_salt[SALT_SIZE];
+    for (int i = 0; i < SALT_SIZE; i++) {
+        mac_salt[i] = salt[i] ^ DB_MAC_SALT_XOR;
+    }
+
+    const unsigned char *key_in[1] = {key};
+    const unsigned char *enc_in[1] = {enc_key};
+    unsigned char *enc_out[1] = {enc_key};
+    unsigned char *mac_out[1] = {mac_key};
+    pbkdf2_hmac_sha512_batch(key_in, V4_DECRYPT_KEY_SIZE, salt, SALT_SIZE, DB_V4_ITER_COUNT,
+                             enc_out, V4_DECRYPT_KEY_SIZE, 1);
+    pbkdf2_hmac_sha512_batch(enc_in, V4_DECRYPT_KEY_SIZE, mac_salt, SALT_SIZE, DB_MAC_ITER_COUNT,
+                             mac_out, V4_DECRYPT_KEY_SIZE, 1);
+}
+
+void v4_decrypt_init(v4_decrypt_ctx *ctx, const unsigned char key[V4_DECRYPT_KEY_SIZE],
+                     const unsigned char salt[V4_DECRYPT_SALT_SIZE]) {
+    unsigned char enc_key[V4_DECRYPT_KEY_SIZE];
+    unsigned char mac_key[V4_DECRYPT_KEY_SIZE];
+    derive_keys(key, salt, enc_key, mac_key);
+    v4_decrypt_init_keys(ctx, enc_key, mac_key);
+    memset(enc_key, 0, sizeof(enc_key));
+    memset(mac_key, 0, sizeof(mac_key));
+}
+
+int v4_decrypt_page_to(const v4_decrypt_ctx *ctx, const unsigned char *page, unsigned char *out,
+                       uint64_t pgno) {
+    return db_v4_decrypt_page_to(&ctx->aes, &ctx->mac, page, out, pgno) ? V4_DECRYPT_OK
+                                                                          : V4_DECRYPT_EHMAC;
+}
+
+int v4_decrypt_page(const v4_decrypt_ctx *ctx, unsigned char *page, uint64_t pgno) {
+    return v4_decrypt_page_to(ctx, page, page, pgno);
+}
+
+/**
+ * 读满 len 字节或读到文件末尾
+ * @return 实际读到的字节数，出错返回 -1
+ */
+static ssize_t read_full(int fd, unsigned char *buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = read(fd, buf + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+    return (ssize_t)done;
+}
+
+static bool write_full(int fd, const unsigned char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * 顺序写出解密后的页面，sparse 时全零页用 lseek 跳过，在输出里留下空洞
+ * @param hole 输出最后一段是否是跳过的空洞，结束时需要 ftruncate 补上文件长度
+ */
+static bool write_pages(int fd, const unsigned char *buf, size_t pages, bool sparse, bool *hole) {
+    size_t i = 0;
+    while (i < pages) {
+        size_t zeros = sparse ? db_zero_run(buf, PAGE_SIZE, i, pages) : 0;
+        if (zeros > 0) {
+            if (lseek(fd, (off_t)(zeros * PAGE_SIZE), SEEK_CUR) == -1) {
+                return false;
+            }
+            *hole = true;
+            i += zeros;
+            continue;
+        }
+        size_t j = i + 1;
+        while (j < pages && !(sparse && db_is_zero(buf + j * PAGE_SIZE, PAGE_SIZE))) {
+            j++;
+        }
+        if (!write_full(fd, buf + i * PAGE_SIZE, (j - i) * PAGE_SIZE)) {
+            return false;
+        }
+        *hole = false;
+        i = j;
+    }
+    return true;
+}
+
+int v4_decrypt_fd(int in_fd, int out_fd, const unsigned char key[V4_DECRYPT_KEY_SIZE],
+                  uint64_t *bad_page) {
+    unsigned char *buf = malloc((size_t)CHUNK_PAGES * PAGE_SIZE);
+    if (!buf) {
+        return V4_DECRYPT_ENOMEM;
+    }
+
+    // 输出是普通文件时全零页留成空洞，管道等不能定位的输出照常写零
+    struct stat st;
+    bool sparse = fstat(out_fd, &st) == 0 && S_ISREG(st.st_mode) && lseek(out_fd, 0, SEEK_CUR) != -1;
+    bool hole = false;
+
+    v4_decrypt_ctx ctx;
+    uint64_t pgno = 0;
+    int ret = V4_DECRYPT_OK;
+    for (;;) {
+        ssize_t n = read_full(in_fd, buf, (size_t)CHUNK_PAGES * PAGE_SIZE);
+        if (n < 0) {
+            ret = V4_DECRYPT_EREAD;
+            break;
+        }
+        size_t pages = (size_t)n / PAGE_SIZE;
+        if (pgno == 0) {
+            if (pages == 0) {
+                ret = V4_DECRYPT_ESHORT;
+                break;
+            }
+            v4_decrypt_init(&ctx, key, buf);
+        }
+
+        for (size_t i = 0; i < pages; i++) {
+            if (v4_decrypt_page(&ctx, buf + i * PAGE_SIZE, pgno + i) != V4_DECRYPT_OK) {
+                ret = pgno + i == 0 ? V4_DECRYPT_EKEY : V4_DECRYPT_EHMAC;
+                if (bad_page) {
+                    *bad_page = pgno + i;
+                }
+                break;
+            }
+        }
+        if (ret != V4_DECRYPT_OK) {
+            break;
+        }
+        if (!write_pages(out_fd, buf, pages, sparse, &hole)) {
+            ret = V4_DECRYPT_EWRITE;
+            break;
+        }
+        pgno += pages;
+
+        // 读到末尾，不足一页的部分忽略
+        if ((size_t)n < (size_t)CHUNK_PAGES * PAGE_SIZE) {
+            break;
+        }
+    }
+
+    // 末尾是空洞时文件长度还停在最后一次写入处
+    if (ret == V4_DECRYPT_OK && hole) {
+        off_t end = lseek(out_fd, 0, SEEK_CUR);
+        if (end == -1 || ftruncate(out_fd, end) != 0) {
+            ret = V4_DECRYPT_EWRITE;
+        }
+    }
+
+    memset(&ctx, 0, sizeof(ctx));
+    free(buf);
+    return ret;
+}
+
+static bool pread_full(int fd, unsigned char *buf, size_t len, off_t off) {
+    while (len > 0) {
+        ssize_t n = pread(fd, buf, len, off);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= (size_t)n;
+        off += n;
+    }
+    return true;
+}
+
+static bool pwrite_full(int fd, const unsigned char *buf, size_t len, off_t off) {
+    while (len > 0) {
+        ssize_t n = pwrite(fd, buf, len, off);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        buf += n;
+        len -= (size_t)n;
+        off += n;
+    }
+    return true;
+}
+
+typedef struct {
+    const v4_decrypt_ctx *ctx;
+    int in_fd;
+    int out_fd;
+    const unsigned char *src;  // mmap 模式下输入和输出的映射，否则为 NULL
+    unsigned char *dst;
+    uint64_t total_pages;
+    atomic_uint_fast64_t next;  // 下一个待领取的页号
+    atomic_int ret;             // 第一个错误，出错后其余 worker 不再领取新区间
+    _Atomic uint64_t bad_page;  // 出错页号中最小的一个
+} parallel_job;
+
+/**
+ * 写出一段解密后的页面，全零页跳过：输出已经扩展到最终长度，没写到的地方就是空洞
+ */
+static bool pwrite_pages(int fd, const unsigned char *buf, size_t pages, off_t off) {
+    size_t i = 0;
+    while (i < pages) {
+        i += db_zero_run(buf, PAGE_SIZE, i, pages);
+        size_t j = i;
+        while (j < pages && !db_is_zero(buf + j * PAGE_SIZE, PAGE_SIZE)) {
+            j++;
+        }
+        if (j > i && !pwrite_full(fd, buf + i * PAGE_SIZE, (j - i) * PAGE_SIZE,
+                                  off + (off_t)(i * PAGE_SIZE))) {
+            return false;
+        }
+        i = j;
+    }
+    return true;
+}
+
+/**
+ * 释放一段预分配的磁盘空间，文件长度不变，读出来仍然全为零
+ * 平台或文件系统不支持时什么都不做，输出内容不受影响，只是不省空间
+ */
+static void punch_hole(int fd, off_t off, off_t len) {
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+    (void)fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, off, len);
+#elif defined(__APPLE__) && defined(F_PUNCHHOLE)
+    fpunchhole_t hole = {0, 0, off, len};
+    (void)fcntl(fd, F_PUNCHHOLE, &hole);
+#else
+    (void)fd;
+    (void)off;
+    (void)len;
+#endif
+}
+
+static void parallel_fail(parallel_job *job, int code, uint64_t pgno) {
+    int expected = V4_DECRYPT_OK;
+    atomic_compare_exchange_strong(&job->ret, &expected, code);
+    if (code == V4_DECRYPT_EHMAC) {
+        uint64_t cur = atomic_load(&job->bad_page);
+        while (pgno < cur && !atomic_compare_exchange_weak(&job->bad_page, &cur, pgno)) {
+        }
+    }
+}
+
+/**
+ * mmap 模式：直接从输入映射解密到输出映射，不经过中间缓冲区
+ * 输出文件刚被扩展，内容全为零，全零页不需要写入；预分配给它们的磁盘空间随后释放掉
+ */
+static void parallel_worker_mmap(parallel_job *job) {
+    while (atomic_load_explicit(&job->ret, memory_order_relaxed) == V4_DECRYPT_OK) {
+        uint64_t start = atomic_fetch_add(&job->next, PARALLEL_CHUNK_PAGES);
+        if (start >= job->total_pages) {
+            break;
+        }
+        uint64_t end = job->total_pages - start < PARALLEL_CHUNK_PAGES ? job->total_pages
+                                                                       : start + PARALLEL_CHUNK_PAGES;
+        uint64_t pgno = start;
+        while (pgno < end) {
+            size_t zeros = db_zero_run(job->src, PAGE_SIZE, (size_t)pgno, (size_t)end);
+            if (zeros > 0) {
+                // 这些页在映射里从未被写过，释放磁盘块不会丢失任何内容
+                punch_hole(job->out_fd, (off_t)(pgno * PAGE_SIZE), (off_t)(zeros * PAGE_SIZE));
+                pgno += zeros;
+                continue;
+            }
+            const unsigned char *src = job->src + pgno * PAGE_SIZE;
+            if (v4_decrypt_page_to(job->ctx, src, job->dst + pgno * PAGE_SIZE, pgno) != V4_DECRYPT_OK) {
+                parallel_fail(job, V4_DECRYPT_EHMAC, pgno);
+                return;
+            }
+            pgno++;
+        }
+    }
+}
+
+static void *parallel_worker(void *arg) {
+    parallel_job *job = arg;
+    if (job->src) {
+        parallel_worker_mmap(job);
+        return NULL;
+    }
+
+    unsigned char *buf = malloc((size_t)PARALLEL_CHUNK_PAGES * PAGE_SIZE);
+    if (!buf) {
+        parallel_fail(job, V4_DECRYPT_ENOMEM, 0);
+        return NULL;
+    }
+
+    while (atomic_load_explicit(&job->ret, memory_order_relaxed) == V4_DECRYPT_OK) {
+        uint64_t start = atomic_fetch_add(&job->next, PARALLEL_CHUNK_PAGES);
+        if (start >= job->total_pages) {
+            break;
+        }
+        size_t pages = job->total_pages - start < PARALLEL_CHUNK_PAGES
+                           ? (size_t)(job->total_pages - start)
+                           : PARALLEL_CHUNK_PAGES;
+        off_t off = (off_t)(start * PAGE_SIZE);
+        if (!pread_full(job->in_fd, buf, pages * PAGE_SIZE, off)) {
+            parallel_fail(job, V4_DECRYPT_EREAD, 0);
+            break;
+        }
+
+        bool ok = true;
+        for (size_t i = 0; i < pages; i++) {
+            if (v4_decrypt_page(job->ctx, buf + i * PAGE_SIZE, start + i) != V4_DECRYPT_OK) {
+                parallel_fail(job, V4_DECRYPT_EHMAC, start + i);
+                ok = false;
+                break;
+            }
+        }
+        if (!ok) {
+            break;
+        }
+        if (!pwrite_pages(job->out_fd, buf, pages, off)) {
+            parallel_fail(job, V4_DECRYPT_EWRITE, 0);
+            break;
+        }
+    }
+
+    free(buf);
+    return NULL;
+}
+
+/**
+ * 为输出文件预先分配磁盘空间
+ * 写 MAP_SHARED 映射时磁盘已满会触发 SIGBUS，必须在映射之前拿到空间
+ * @return 0 成功，ENOSPC 等错误码失败，ENOTSUP 表示当前平台或文件系统不支持
+ */
+static int preallocate(int fd, off_t size) {
+#if defined(__linux__)
+    int err = posix_fallocate(fd, 0, size);
+    return err == EINVAL || err == EOPNOTSUPP ? ENOTSUP : err;
+#elif defined(__APPLE__)
+    fstore_t store = {F_ALLOCATEALL, F_PEOFPOSMODE, 0, size, 0};
+    if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+        return errno == ENOSPC ? ENOSPC : ENOTSUP;
+    }
+    return ftruncate(fd, size) == 0 ? 0 : errno;
+#else
+    (void)fd;
+    (void)size;
+    return ENOTSUP;
+#endif
+}
+
+/**
+ * 建立输入和输出的映射，不支持时返回 false，调用方退回 pread/pwrite
+ */
+static bool map_files(parallel_job *job, unsigned flags, int *ret) {
+    size_t len = (size_t)(job->total_pages * PAGE_SIZE);
+    int err = preallocate(job->out_fd, (off_t)len);
+    if (err == ENOTSUP) {
+        return false;
+    }
+    if (err != 0) {
+        *ret = V4_DECRYPT_EWRITE;
+        return true;
+    }
+
+    int in_flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (flags & V4_DECRYPT_POPULATE) {
+        in_flags |= MAP_POPULATE;
+    }
+#else
+    (void)flags;
+#endif
+    void *src = mmap(NULL, len, PROT_READ, in_flags, job->in_fd, 0);
+    if (src == MAP_FAILED) {
+        return false;
+    }
+    void *dst = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, job->out_fd, 0);
+    if (dst == MAP_FAILED) {
+        munmap(src, len);
+        return false;
+    }
+
+    // 每个 worker 在自己领取的区间内顺序访问，整体上也是从前往后推进
+    madvise(src, len, MADV_SEQUENTIAL);
+    madvise(dst, len, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    madvise(dst, len, MADV_HUGEPAGE);
+#endif
+    job->src = src;
+    job->dst = dst;
+    return true;
+}
+
+/**
+ * 读取第一页，派生密钥并用第一页的 HMAC 校验
+ * store 中已有这个 salt 的派生结果时直接使用，否则派生并在校验通过后记录下来
+ */
+static int init_from_fd(v4_decrypt_ctx *ctx, int fd, const unsigned char key[V4_DECRYPT_KEY_SIZE],
+                        derived_keys *store) {
+    unsigned char first[PAGE_SIZE];
+    ssize_t n = pread(fd, first, PAGE_SIZE, 0);
+    if (n < 0) {
+        return V4_DECRYPT_EREAD;
+    }
+    if (n < PAGE_SIZE && !pread_full(fd, first + n, PAGE_SIZE - (size_t)n, n)) {
+        return V4_DECRYPT_ESHORT;
+    }
+
+    unsigned char salt[SALT_SIZE];
+    unsigned char enc_key[V4_DECRYPT_KEY_SIZE];
+    unsigned char mac_key[V4_DECRYPT_KEY_SIZE];
+    memcpy(salt, first, SALT_SIZE);
+    bool cached = derived_keys_get(store, DERIVED_KEYS_KDF_V4, key, salt, enc_key, mac_key);
+    if (!cached) {
+        derive_keys(key, salt, enc_key, mac_key);
+    }
+    v4_decrypt_init_keys(ctx, enc_key, mac_key);
+
+    int ret = V4_DECRYPT_OK;
+    if (v4_decrypt_page(ctx, first, 0) != V4_DECRYPT_OK) {
+        memset(ctx, 0, sizeof(*ctx));
+        ret = V4_DECRYPT_EKEY;
+    } else if (!cached) {
+        derived_keys_put(store, DERIVED_KEYS_KDF_V4, key, salt, enc_key, mac_key);
+    }
+    memset(enc_key, 0, sizeof(enc_key));
+    memset(mac_key, 0, sizeof(mac_key));
+    return ret;
+}
+
+int v4_decrypt_init_path(v4_decrypt_ctx *ctx, const char *db_path,
+                         const unsigned char key[V4_DECRYPT_KEY_SIZE], derived_keys *store) {
+    int fd = open(db_path, O_RDONLY);
+    if (fd < 0) {
+        return V4_DECRYPT_EOPEN;
+    }
+    int ret = init_from_fd(ctx, fd, key, store);
+    close(fd);
+    return ret;
+}
+
+int v4_decrypt_file(const char *in_path, const char *out_path,
+                    const unsigned char key[V4_DECRYPT_KEY_SIZE], int jobs, unsigned flags,
+                    uint64_t *bad_page) {
+    // 先用第一页校验密钥，密钥错误时不创建输出文件
+    v4_decrypt_ctx ctx;
+    int ret = v4_decrypt_init_path(&ctx, in_path, key, NULL);
+    if (ret == V4_DECRYPT_OK) {
+        ret = v4_decrypt_file_ctx(&ctx, in_path, out_path, jobs, flags, bad_page);
+    }
+    memset(&ctx, 0, sizeof(ctx));
+    return ret;
+}
+
+int v4_decrypt_file_ctx(const v4_decrypt_ctx *ctx, const char *in_path, const char *out_path,
+                        int jobs, unsigned flags, uint64_t *bad_page) {
+    int in_fd = open(in_path, O_RDONLY);
+    if (in_fd < 0) {
+        return V4_DECRYPT_EOPEN;
+    }
+    struct stat st;
+    if (fstat(in_fd, &st) != 0) {
+        close(in_fd);
+        return V4_DECRYPT_EREAD;
+    }
+    // 末尾不足一页的部分忽略，与 Go 实现一致
+    uint64_t total_pages = (uint64_t)st.st_size / PAGE_SIZE;
+    if (total_pages == 0) {
+        close(in_fd);
+        return V4_DECRYPT_ESHORT;
+    }
+
+    // 可写的共享映射要求文件以读写方式打开
+    int out_fd = open(out_path, ((flags & V4_DECRYPT_MMAP) ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) {
+        close(in_fd);
+        return V4_DECRYPT_EOPEN;
+    }
+
+    parallel_job job;
+    job.ctx = ctx;
+    job.in_fd = in_fd;
+    job.out_fd = out_fd;
+    job.src = NULL;
+    job.dst = NULL;
+    job.total_pages = total_pages;
+    atomic_init(&job.next, 0);
+    atomic_init(&job.ret, V4_DECRYPT_OK);
+    atomic_init(&job.bad_page, UINT64_MAX);
+
+    // 先把输出扩展到最终长度，各 worker 直接写到自己的偏移处
+    int ret = V4_DECRYPT_OK;
+    if (!(flags & V4_DECRYPT_MMAP) || !map_files(&job, flags, &ret)) {
+        if (ftruncate(out_fd, (off_t)(total_pages * PAGE_SIZE)) != 0) {
+            ret = V4_DECRYPT_EWRITE;
+        }
+    }
+    atomic_store(&job.ret, ret);
+
+    if (jobs <= 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = n > 0 ? (int)n : 1;
+    }
+    uint64_t chunks = (total_pages + PARALLEL_CHUNK_PAGES - 1) / PARALLEL_CHUNK_PAGES;
+    if ((uint64_t)jobs > chunks) {
+        jobs = (int)chunks;
+    }
+    if (jobs > MAX_JOBS) {
+        jobs = MAX_JOBS;
+    }
+
+    pthread_t threads[MAX_JOBS];
+    int started = 0;
+    for (int i = 1; i < jobs; i++) {
+        if (pthread_create(&threads[started], NULL, parallel_worker, &job) != 0) {
+            break;
+        }
+        started++;
+    }
+    // 当前线程也作为一个 worker
+    parallel_worker(&job);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    ret = atomic_load(&job.ret);
+    if (ret == V4_DECRYPT_EHMAC && bad_page) {
+        *bad_page = atomic_load(&job.bad_page);
+    }
+    if (job.src) {
+        munmap((void *)job.src, (size_t)(total_pages * PAGE_SIZE));
+        munmap(job.dst, (size_t)(total_pages * PAGE_SIZE));
+    }
+    if (close(out_fd) != 0 && ret == V4_DECRYPT_OK) {
+        ret = V4_DECRYPT_EWRITE;
+    }
+    close(in_fd);
+    return ret;
+}
+
+const char *v4_decrypt_strerror(int code) {
+    switch (code) {
+    case V4_DECRYPT_OK:
+        return "success";
+    case V4_DECRYPT_EKEY:
+        return "incorrect key";
+    case V4_DECRYPT_EHMAC:
+        return "page hash verification failed";
+    case V4_DECRYPT_EREAD:
+        return "read failed";
+    case V4_DECRYPT_EWRITE:
+        return "write failed";
+    case V4_DECRYPT_ESHORT:
+        return "file is smaller than one page";
+    case V4_DECRYPT_ENOMEM:
+        return "out of memory";
+    case V4_DECRYPT_EOPEN:
+        return "cannot open input or create output";
+    default:
+        return "unknown error";
+    }
+}
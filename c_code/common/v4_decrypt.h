@@ -0,0 +1,111 @@
+// V4 数据库整库解密
+//
+// 输出与 Go 侧 V4Decryptor.Decrypt 逐字节一致：第一页的 salt 换成 SQLite 文件头，
+// 每页 [offset, 4016) 解密，尾部 80 字节保留区（IV + HMAC）原样保留，全零页原样保留。
+// 输出是普通文件时全零页不写入，留成空洞（读出来同样全为零），预分配或刚扩展的数据库
+// 解密更快，明文副本也不占这部分磁盘空间。
+// 与 Go 的 common.DecryptPage 不同，AES 轮密钥和 HMAC 的 ipad/opad 状态只计算一次，
+// 之后每页只复制一份 HMAC 上下文并原地解密，整个过程不分配内存。
+
+#ifndef CHATLOG_V4_DECRYPT_H
+#define CHATLOG_V4_DECRYPT_H
+
+#include <stdint.h>
+
+#include "aes256.h"
+#include "derived_keys.h"
+#include "sha512_mb.h"
+
+#define V4_DECRYPT_PAGE_SIZE 4096
+#define V4_DECRYPT_KEY_SIZE 32
+#define V4_DECRYPT_SALT_SIZE 16
+
+// 返回码
+#define V4_DECRYPT_OK 0
+#define V4_DECRYPT_EKEY (-1)    // 第一页 HMAC 不匹配，密钥错误
+#define V4_DECRYPT_EHMAC (-2)   // 其余某一页 HMAC 不匹配，文件损坏或正在被写入
+#define V4_DECRYPT_EREAD (-3)
+#define V4_DECRYPT_EWRITE (-4)
+#define V4_DECRYPT_ESHORT (-5)  // 文件不足一页
+#define V4_DECRYPT_ENOMEM (-6)
+#define V4_DECRYPT_EOPEN (-7)   // 无法打开输入或创建输出文件
+
+// 一个数据库的解密上下文，初始化后只读，可以被多个线程共用
+typedef struct {
+    aes256_dec_key aes;
+    hmac_sha512_ctx mac;  // 已吸收 mac_key，每页复制一份使用
+} v4_decrypt_ctx;
+
+/**
+ * 由原始密钥和第一页的 salt 派生 enc_key/mac_key（256000 轮 PBKDF2）
+ */
+void v4_decrypt_init(v4_decrypt_ctx *ctx, const unsigned char key[V4_DECRYPT_KEY_SIZE],
+                     const unsigned char salt[V4_DECRYPT_SALT_SIZE]);
+
+/**
+ * 直接使用已经派生好的 enc_key/mac_key
+ */
+void v4_decrypt_init_keys(v4_decrypt_ctx *ctx, const unsigned char enc_key[V4_DECRYPT_KEY_SIZE],
+                          const unsigned char mac_key[V4_DECRYPT_KEY_SIZE]);
+
+/**
+ * 读取数据库第一页，派生密钥并用第一页的 HMAC 校验
+ * @param store 派生密钥存储，命中时跳过 PBKDF2，未命中时校验通过后写入；可以为 NULL
+ * @return V4_DECRYPT_OK / V4_DECRYPT_EKEY / V4_DECRYPT_EOPEN / V4_DECRYPT_EREAD / V4_DECRYPT_ESHORT
+ */
+int v4_decrypt_init_path(v4_decrypt_ctx *ctx, const char *db_path,
+                         const unsigned char key[V4_DECRYPT_KEY_SIZE], derived_keys *store);
+
+/**
+ * 原地解密一页，结果就是要写入输出文件的 4096 字节
+ * 第 0 页会把 salt 换成 SQLite 文件头；全零页不做处理
+ * @param pgno 从 0 开始的页号
+ * @return V4_DECRYPT_OK 或 V4_DECRYPT_EHMAC（此时页面内容不变）
+ */
+int v4_decrypt_page(const v4_decrypt_ctx *ctx, unsigned char *page, uint64_t pgno);
+
+/**
+ * 同 v4_decrypt_page，结果写到 out 而不修改 page；out 可以与 page 相同
+ */
+int v4_decrypt_page_to(const v4_decrypt_ctx *ctx, const unsigned char *page, unsigned char *out,
+                       uint64_t pgno);
+
+/**
+ * 从 in_fd 读取整个数据库，解密后写入 out_fd
+ * 末尾不足一页的部分被忽略，与 Go 实现一致
+ * out_fd 是普通文件时全零页用 lseek 跳过，最后用 ftruncate 补齐长度；管道照常写零
+ * @param bad_page 返回 V4_DECRYPT_EHMAC 时写出出错的页号，可以为 NULL
+ */
+int v4_decrypt_fd(int in_fd, int out_fd, const unsigned char key[V4_DECRYPT_KEY_SIZE],
+                  uint64_t *bad_page);
+
+// v4_decrypt_file 的选项
+// V4_DECRYPT_MMAP：输入只读映射、输出预分配后共享映射，直接从输入映射解密到输出映射，
+//   省掉 pread/pwrite 的两次拷贝。解密期间输入文件被截断会触发 SIGBUS，
+//   所以只用于不会被同时写入的文件（例如已经复制出来的数据库）。
+//   平台或文件系统不支持预分配/映射时自动退回 pread/pwrite。
+// V4_DECRYPT_POPULATE：配合 MMAP，在 Linux 上用 MAP_POPULATE 预先读入整个输入
+#define V4_DECRYPT_MMAP 0x1
+#define V4_DECRYPT_POPULATE 0x2
+
+/**
+ * 多线程解密 in_path 到 out_path
+ * 页面之间没有依赖：worker 按区间领取页面，pread 读入后原地校验、解密，
+ * 再 pwrite 到同样的偏移处，不需要排序。输出会先截断到完整页数的长度。
+ * @param jobs 线程数，<= 0 时使用在线 CPU 数
+ * @param flags V4_DECRYPT_* 选项
+ * @param bad_page 返回 V4_DECRYPT_EHMAC 时写出出错的页号，可以为 NULL
+ */
+int v4_decrypt_file(const char *in_path, const char *out_path,
+                    const unsigned char key[V4_DECRYPT_KEY_SIZE], int jobs, unsigned flags,
+                    uint64_t *bad_page);
+
+/**
+ * 同 v4_decrypt_file，使用已经初始化好的解密上下文（例如同时解密 WAL 时只派生一次）
+ */
+int v4_decrypt_file_ctx(const v4_decrypt_ctx *ctx, const char *in_path, const char *out_path,
+                        int jobs, unsigned flags, uint64_t *bad_page);
+
+const char *v4_decrypt_strerror(int code);
+
+#endif // CHATLOG_V4_DECRYPT_H
@@ -0,0 +1,160 @@
+// V4 候选密钥批量校验实现，见 v4_validate.h
+
+#include "v4_validate.h"
+
+#include <string.h>
+
+#include "db_page_v4.h"
+#include "sha512_mb.h"
+#include "v3_validate.h"
+
+#define SALT_SIZE DB_SALT_SIZE
+
+/**
+ * 用派生出的 mac_key 校验第一页的 HMAC
+ */
+static bool check_page_hmac(const unsigned char *page, const unsigned char *mac_key) {
+    hmac_sha512_ctx ctx;
+    hmac_sha512_init(&ctx, mac_key, V4_VALIDATE_KEY_SIZE);
+    return db_v4_verify_page(&ctx, page, 0);
+}
+
+int testkey_v4_batch_derive(const unsigned char *page, const unsigned char *const keys[],
+                            size_t n, bool results[],
+                            unsigned char (*enc_keys)[V4_VALIDATE_KEY_SIZE],
+                            unsigned char (*mac_keys)[V4_VALIDATE_KEY_SIZE]) {
+    if (!page || !keys || !results) {
+        return 0;
+    }
+
+    const unsigned char *salt = page;
+    unsigned char mac_salt[SALT_SIZE];
+    for (int i = 0; i < SALT_SIZE; i++) {
+        mac_salt[i] = salt[i] ^ DB_MAC_SALT_XOR;
+    }
+
+    int valid = 0;
+    for (size_t base = 0; base < n; base += V4_VALIDATE_BATCH_SIZE) {
+        size_t count = n - base < V4_VALIDATE_BATCH_SIZE ? n - base : V4_VALIDATE_BATCH_SIZE;
+
+        unsigned char enc[V4_VALIDATE_BATCH_SIZE][V4_VALIDATE_KEY_SIZE];
+        unsigned char mac[V4_VALIDATE_BATCH_SIZE][V4_VALIDATE_KEY_SIZE];
+        unsigned char *enc_out[V4_VALIDATE_BATCH_SIZE];
+        unsigned char *mac_out[V4_VALIDATE_BATCH_SIZE];
+        const unsigned char *enc_in[V4_VALIDATE_BATCH_SIZE];
+        for (size_t i = 0; i < count; i++) {
+            enc_out[i] = enc[i];
+            mac_out[i] = mac[i];
+            enc_in[i] = enc[i];
+        }
+
+        // enc_key = PBKDF2(key, salt, 256000)，mac_key = PBKDF2(enc_key, salt ^ 0x3A, 2)
+        pbkdf2_hmac_sha512_batch(keys + base, V4_VALIDATE_KEY_SIZE, salt, SALT_SIZE,
+                                 DB_V4_ITER_COUNT, enc_out, V4_VALIDATE_KEY_SIZE, count);
+        pbkdf2_hmac_sha512_batch(enc_in, V4_VALIDATE_KEY_SIZE, mac_salt, SALT_SIZE,
+                                 DB_MAC_ITER_COUNT, mac_out, V4_VALIDATE_KEY_SIZE, count);
+
+        for (size_t i = 0; i < count; i++) {
+            results[base + i] = check_page_hmac(page, mac[i]);
+            if (results[base + i]) {
+                valid++;
+            }
+            if (enc_keys) {
+                memcpy(enc_keys[base + i], enc[i], V4_VALIDATE_KEY_SIZE);
+            }
+            if (mac_keys) {
+                memcpy(mac_keys[base + i], mac[i], V4_VALIDATE_KEY_SIZE);
+            }
+        }
+    }
+
+    return valid;
+}
+
+int testkey_v4_batch(const unsigned char *page, const unsigned char *const keys[],
+                     size_t n, bool results[]) {
+    return testkey_v4_batch_derive(page, keys, n, results, NULL, NULL);
+}
+
+void v4_batch_init(v4_candidate_batch *batch, const unsigned char *page, key_cache *cache) {
+    memset(batch, 0, sizeof(*batch));
+    batch->page = page;
+    batch->cache = cache;
+    batch->formats = DB_FORMAT_V4;
+    batch->format = DB_FORMAT_V4;
+}
+
+bool v4_batch_flush(v4_candidate_batch *batch) {
+    if (batch->found) {
+        return true;
+    }
+    if (batch->count == 0) {
+        return false;
+    }
+
+    bool results[V4_VALIDATE_BATCH_SIZE];
+    unsigned char enc[V4_VALIDATE_BATCH_SIZE][V4_VALIDATE_KEY_SIZE];
+    unsigned char mac[V4_VALIDATE_BATCH_SIZE][V4_VALIDATE_KEY_SIZE];
+    const unsigned char *keys[V4_VALIDATE_BATCH_SIZE];
+    for (size_t i = 0; i < batch->count; i++) {
+        keys[i] = batch->keys[i];
+    }
+    testkey_v4_batch_derive(batch->page, keys, batch->count, results, enc, mac);
+    SCAN_STATS_ADD(batch->stats, pbkdf2_calls, batch->count);
+
+    for (size_t i = 0; i < batch->count; i++) {
+        key_cache_store(batch->cache, batch->keys[i], results[i], enc[i], mac[i]);
+        if (results[i] && !batch->found) {
+            memcpy(batch->key, batch->keys[i], V4_VALIDATE_KEY_SIZE);
+            batch->tag = batch->tags[i];
+            batch->format = DB_FORMAT_V4;
+            batch->found = true;
+        }
+    }
+    batch->count = 0;
+    return batch->found;
+}
+
+bool v4_batch_add(v4_candidate_batch *batch, const unsigned char *key) {
+    return v4_batch_add_tagged(batch, key, 0);
+}
+
+bool v4_batch_add_tagged(v4_candidate_batch *batch, const unsigned char *key, uint64_t tag) {
+    if (batch->found) {
+        return true;
+    }
+
+    // V3 只要 2 轮 PBKDF2-HMAC-SHA1，逐个校验，不进入批次也不进缓存
+    if ((batch->formats & DB_FORMAT_V3) && testkey_v3(batch->page, key)) {
+        memcpy(batch->key, key, V4_VALIDATE_KEY_SIZE);
+        batch->tag = tag;
+        batch->format = DB_FORMAT_V3;
+        batch->found = true;
+        return true;
+    }
+    if (!(batch->formats & DB_FORMAT_V4)) {
+        return false;
+    }
+
+    switch (key_cache_lookup(batch->cache, key, NULL, NULL)) {
+    case KEY_CACHE_GOOD:
+        SCAN_STATS_ADD(batch->stats, candidates_cached, 1);
+        memcpy(batch->key, key, V4_VALIDATE_KEY_SIZE);
+        batch->tag = tag;
+        batch->format = DB_FORMAT_V4;
+        batch->found = true;
+        return true;
+    case KEY_CACHE_BAD:
+        SCAN_STATS_ADD(batch->stats, candidates_cached, 1);
+        return false;
+    default:
+        break;
+    }
+
+    batch->tags[batch->count] = tag;
+    memcpy(batch->keys[batch->count++], key, V4_VALIDATE_KEY_SIZE);
+    if (batch->count == V4_VALIDATE_BATCH_SIZE) {
+        return v4_batch_flush(batch);
+    }
+    return false;
+}
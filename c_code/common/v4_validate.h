@@ -0,0 +1,75 @@
+// V4 候选密钥批量校验，Linux/macOS 两个 testkey 工具共用
+//
+// 基于 sha512_mb 的多路 PBKDF2 实现，N 个候选的 256000 轮迭代同步进行。
+// 批量大小与 Go 侧 internal/wechat/key/linux/v4.go 的 BatchValidateSize 一致。
+
+#ifndef CHATLOG_V4_VALIDATE_H
+#define CHATLOG_V4_VALIDATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "db_format.h"
+#include "key_cache.h"
+#include "scan_stats.h"
+
+#define V4_VALIDATE_BATCH_SIZE 8
+#define V4_VALIDATE_KEY_SIZE 32
+
+/**
+ * 批量校验 V4 候选密钥，逻辑与 testkey_v4 / V4Decryptor.Validate 一致
+ * @param page 数据库第一页内容（4096字节）
+ * @param keys n 个候选密钥，每个 32 字节
+ * @param n 候选数量，不限于 V4_VALIDATE_BATCH_SIZE
+ * @param results 输出每个候选是否有效
+ * @return 有效候选数量
+ */
+int testkey_v4_batch(const unsigned char *page, const unsigned char *const keys[],
+                     size_t n, bool results[]);
+
+/**
+ * 同 testkey_v4_batch，额外输出每个候选派生出的 enc_key/mac_key
+ * （无论是否有效都会写出，调用方按 results 取用）
+ */
+int testkey_v4_batch_derive(const unsigned char *page, const unsigned char *const keys[],
+                            size_t n, bool results[],
+                            unsigned char (*enc_keys)[V4_VALIDATE_KEY_SIZE],
+                            unsigned char (*mac_keys)[V4_VALIDATE_KEY_SIZE]);
+
+// 扫描时积攒候选，满一批再统一校验
+// 候选会被拷贝进批次，扫描缓冲区可以在 flush 之前复用（流式读取跨窗口攒批）
+// formats 包含 DB_FORMAT_V3 时，每个候选加入时先做一次 V3 校验，同一遍扫描同时覆盖两种格式
+typedef struct {
+    const unsigned char *page;
+    key_cache *cache;  // 可以为NULL
+    scan_stats *stats; // 可以为NULL，v4_batch_init 之后赋值
+    unsigned formats;  // 要尝试的 DB_FORMAT_* 组合，默认只有 V4，v4_batch_init 之后赋值
+    unsigned char keys[V4_VALIDATE_BATCH_SIZE][V4_VALIDATE_KEY_SIZE];
+    uint64_t tags[V4_VALIDATE_BATCH_SIZE];
+    size_t count;
+    bool found;
+    db_format format;  // 找到的密钥属于哪种格式
+    unsigned char key[V4_VALIDATE_KEY_SIZE];
+    uint64_t tag;      // 找到的密钥加入时带的标签
+} v4_candidate_batch;
+
+void v4_batch_init(v4_candidate_batch *batch, const unsigned char *page, key_cache *cache);
+
+/**
+ * 加入一个候选，缓存命中时直接给出结论，批次满时自动校验
+ * @return 已经找到有效密钥时返回 true，结果在 batch->key 中
+ */
+bool v4_batch_add(v4_candidate_batch *batch, const unsigned char *key);
+
+/**
+ * 同 v4_batch_add，候选带一个标签（例如 key_hint_tag），找到时写到 batch->tag
+ */
+bool v4_batch_add_tagged(v4_candidate_batch *batch, const unsigned char *key, uint64_t tag);
+
+/**
+ * 校验批次中剩余的候选
+ * @return 已经找到有效密钥时返回 true
+ */
+bool v4_batch_flush(v4_candidate_batch *batch);
+
+#endif // CHATLOG_V4_VALIDATE_H
@@ -0,0 +1,371 @@
+// V4 数据库 WAL 文件解密实现，见 v4_wal.h
+
+#include "v4_wal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PAGE_SIZE V4_DECRYPT_PAGE_SIZE
+#define FRAME_SIZE (V4_WAL_FRAME_HEADER_SIZE + PAGE_SIZE)
+
+// 文件头 magic 的最低位表示校验和按大端还是小端读取 32 位字
+#define WAL_MAGIC 0x377f0682
+
+// 续传记录：magic(8) | 帧数(8, 大端) | 输入在最后一帧处的累积校验和(2 x 4, 大端)
+#define RESUME_MAGIC "CLWALCK1"
+#define RESUME_SIZE 24
+
+static uint32_t load_be32(const unsigned char *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static void store_be32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static uint32_t load_le32(const unsigned char *p) {
+    return (uint32_t)p[3] << 24 | (uint32_t)p[2] << 16 | (uint32_t)p[1] << 8 | p[0];
+}
+
+/**
+ * SQLite WAL 校验和（wal.c 的 walChecksumBytes），在 ck 的基础上累积
+ */
+static void wal_checksum(bool big_endian, const unsigned char *data, size_t len, uint32_t ck[2]) {
+    uint32_t s1 = ck[0];
+    uint32_t s2 = ck[1];
+    for (size_t i = 0; i < len; i += 8) {
+        uint32_t x0 = big_endian ? load_be32(data + i) : load_le32(data + i);
+        uint32_t x1 = big_endian ? load_be32(data + i + 4) : load_le32(data + i + 4);
+        s1 += x0 + s2;
+        s2 += x1 + s1;
+    }
+    ck[0] = s1;
+    ck[1] = s2;
+}
+
+static bool read_at(int fd, unsigned char *buf, size_t len, off_t off) {
+    while (len > 0) {
+        ssize_t n = pread(fd, buf, len, off);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= (size_t)n;
+        off += n;
+    }
+    return true;
+}
+
+static bool write_at(int fd, const unsigned char *buf, size_t len, off_t off) {
+    while (len > 0) {
+        ssize_t n = pwrite(fd, buf, len, off);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        buf += n;
+        len -= (size_t)n;
+        off += n;
+    }
+    return true;
+}
+
+static off_t frame_offset(uint64_t i) {
+    return (off_t)(V4_WAL_HEADER_SIZE + i * FRAME_SIZE);
+}
+
+/**
+ * 文件头有效时返回 true，并给出校验和字节序和文件头校验和
+ */
+static bool parse_header(const unsigned char *hdr, bool *big_endian, uint32_t ck[2]) {
+    uint32_t magic = load_be32(hdr);
+    if ((magic & ~1u) != WAL_MAGIC || load_be32(hdr + 8) != PAGE_SIZE) {
+        return false;
+    }
+    *big_endian = magic & 1;
+    ck[0] = 0;
+    ck[1] = 0;
+    wal_checksum(*big_endian, hdr, 24, ck);
+    return ck[0] == load_be32(hdr + 24) && ck[1] == load_be32(hdr + 28);
+}
+
+/**
+ * 按 SQLite 的规则校验一帧：salt 与文件头一致、页号非零、累积校验和匹配
+ * 通过时 ck 更新为这一帧的校验和
+ */
+static bool check_frame(const unsigned char *hdr, const unsigned char *frame, bool big_endian,
+                        uint32_t ck[2]) {
+    if (memcmp(frame + 8, hdr + 16, 8) != 0 || load_be32(frame) == 0) {
+        return false;
+    }
+    uint32_t next[2] = {ck[0], ck[1]};
+    wal_checksum(big_endian, frame, 8, next);
+    wal_checksum(big_endian, frame + V4_WAL_FRAME_HEADER_SIZE, PAGE_SIZE, next);
+    if (next[0] != load_be32(frame + 16) || next[1] != load_be32(frame + 20)) {
+        return false;
+    }
+    ck[0] = next[0];
+    ck[1] = next[1];
+    return true;
+}
+
+static char *resume_path(const char *out_path) {
+    size_t len = strlen(out_path) + sizeof(V4_WAL_RESUME_SUFFIX);
+    char *path = malloc(len);
+    if (path) {
+        snprintf(path, len, "%s%s", out_path, V4_WAL_RESUME_SUFFIX);
+    }
+    return path;
+}
+
+/**
+ * 读取续传记录，不存在或格式不对时返回 false
+ */
+static bool load_resume(const char *out_path, uint64_t *frames, uint32_t ck[2]) {
+    char *path = resume_path(out_path);
+    FILE *fp = path ? fopen(path, "rb") : NULL;
+    free(path);
+    if (!fp) {
+        return false;
+    }
+    unsigned char buf[RESUME_SIZE];
+    bool ok = fread(buf, 1, sizeof(buf), fp) == sizeof(buf) && memcmp(buf, RESUME_MAGIC, 8) == 0;
+    fclose(fp);
+    if (ok) {
+        *frames = (uint64_t)load_be32(buf + 8) << 32 | load_be32(buf + 12);
+        ck[0] = load_be32(buf + 16);
+        ck[1] = load_be32(buf + 20);
+    }
+    return ok;
+}
+
+/**
+ * 写出续传记录，先写临时文件再改名；frames 为 0 时只删除旧记录
+ * 写不成功只影响下次能否续传，不影响这次的输出
+ */
+static void save_resume(const char *out_path, uint64_t frames, const uint32_t ck[2]) {
+    char *path = resume_path(out_path);
+    if (!path) {
+        return;
+    }
+    if (frames == 0) {
+        unlink(path);
+        free(path);
+        return;
+    }
+    size_t len = strlen(path) + 5;
+    char *tmp = malloc(len);
+    if (!tmp) {
+        unlink(path);
+        free(path);
+        return;
+    }
+    snprintf(tmp, len, "%s.tmp", path);
+
+    unsigned char buf[RESUME_SIZE];
+    memcpy(buf, RESUME_MAGIC, 8);
+    store_be32(buf + 8, (uint32_t)(frames >> 32));
+    store_be32(buf + 12, (uint32_t)frames);
+    store_be32(buf + 16, ck[0]);
+    store_be32(buf + 20, ck[1]);
+    FILE *fp = fopen(tmp, "wb");
+    bool ok = fp && fwrite(buf, 1, sizeof(buf), fp) == sizeof(buf);
+    if (fp && fclose(fp) != 0) {
+        ok = false;
+    }
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        unlink(path);
+    }
+    free(tmp);
+    free(path);
+}
+
+/**
+ * 确认输出已有的 frames 帧仍与输入对应
+ * 输出只写到最后一个 commit 帧为止，续传记录保存了当时输入在这一帧处的累积校验和。
+ * 回滚之后 SQLite 会用同样的 salt 原地覆盖未提交的帧，所以只比较最后一帧的帧头不够：
+ * 要求输入的第 frames-1 帧仍然有效、是 commit 帧，且帧头里的累积校验和与记录一致。
+ * 累积校验和覆盖之前所有帧的内容，之前任何一帧被改写都对不上，此时从第 0 帧重新解密。
+ */
+static bool can_resume(int in_fd, int out_fd, const char *out_path, const unsigned char *hdr,
+                       bool big_endian, const uint32_t hdr_ck[2], uint64_t frames, uint32_t in_ck[2],
+                       uint32_t out_ck[2], unsigned char *frame) {
+    uint32_t ck[2] = {hdr_ck[0], hdr_ck[1]};
+    if (frames == 0) {
+        in_ck[0] = out_ck[0] = ck[0];
+        in_ck[1] = out_ck[1] = ck[1];
+        return true;
+    }
+    uint64_t saved_frames;
+    uint32_t saved_ck[2];
+    if (!load_resume(out_path, &saved_frames, saved_ck) || saved_frames != frames) {
+        return false;
+    }
+    if (frames >= 2) {
+        unsigned char prev[V4_WAL_FRAME_HEADER_SIZE];
+        if (!read_at(in_fd, prev, sizeof(prev), frame_offset(frames - 2))) {
+            return false;
+        }
+        ck[0] = load_be32(prev + 16);
+        ck[1] = load_be32(prev + 20);
+    }
+    if (!read_at(in_fd, frame, FRAME_SIZE, frame_offset(frames - 1)) ||
+        !check_frame(hdr, frame, big_endian, ck) || load_be32(frame + 4) == 0 ||
+        ck[0] != saved_ck[0] || ck[1] != saved_ck[1]) {
+        return false;
+    }
+
+    unsigned char last[V4_WAL_FRAME_HEADER_SIZE];
+    if (!read_at(out_fd, last, sizeof(last), frame_offset(frames - 1)) || memcmp(last, frame, 16) != 0) {
+        return false;
+    }
+    in_ck[0] = ck[0];
+    in_ck[1] = ck[1];
+    out_ck[0] = load_be32(last + 16);
+    out_ck[1] = load_be32(last + 20);
+    return true;
+}
+
+int v4_wal_decrypt_file(const v4_decrypt_ctx *ctx, const char *wal_path, const char *out_path,
+                        v4_wal_stats *stats, uint64_t *bad_frame) {
+    v4_wal_stats local;
+    if (!stats) {
+        stats = &local;
+    }
+    memset(stats, 0, sizeof(*stats));
+
+    int out_fd = open(out_path, O_RDWR | O_CREAT, 0644);
+    if (out_fd < 0) {
+        return V4_DECRYPT_EOPEN;
+    }
+    struct stat out_st;
+    if (fstat(out_fd, &out_st) != 0) {
+        close(out_fd);
+        return V4_DECRYPT_EREAD;
+    }
+
+    // 输入不存在或文件头无效：SQLite 同样视为空 WAL
+    unsigned char hdr[V4_WAL_HEADER_SIZE];
+    bool big_endian = false;
+    uint32_t hdr_ck[2];
+    int in_fd = open(wal_path, O_RDONLY);
+    if (in_fd < 0 || !read_at(in_fd, hdr, sizeof(hdr), 0) || !parse_header(hdr, &big_endian, hdr_ck)) {
+        if (in_fd >= 0) {
+            close(in_fd);
+        }
+        stats->reset = out_st.st_size > 0;
+        save_resume(out_path, 0, NULL);
+        int ret = ftruncate(out_fd, 0) == 0 ? V4_DECRYPT_OK : V4_DECRYPT_EWRITE;
+        if (close(out_fd) != 0 && ret == V4_DECRYPT_OK) {
+            ret = V4_DECRYPT_EWRITE;
+        }
+        return ret;
+    }
+
+    unsigned char frame[FRAME_SIZE];
+    unsigned char out[FRAME_SIZE];
+    uint32_t in_ck[2];
+    uint32_t out_ck[2];
+    uint64_t start = 0;
+
+    unsigned char out_hdr[V4_WAL_HEADER_SIZE];
+    bool same_header = out_st.st_size >= V4_WAL_HEADER_SIZE &&
+                       read_at(out_fd, out_hdr, sizeof(out_hdr), 0) &&
+                       memcmp(out_hdr, hdr, sizeof(hdr)) == 0;
+    if (same_header) {
+        start = ((uint64_t)out_st.st_size - V4_WAL_HEADER_SIZE) / FRAME_SIZE;
+        if (!can_resume(in_fd, out_fd, out_path, hdr, big_endian, hdr_ck, start, in_ck, out_ck, frame)) {
+            same_header = false;
+        }
+    }
+    if (!same_header) {
+        // 文件头只覆盖自身的校验和，解密后不变，原样写出
+        start = 0;
+        in_ck[0] = out_ck[0] = hdr_ck[0];
+        in_ck[1] = out_ck[1] = hdr_ck[1];
+        stats->reset = true;
+        if (ftruncate(out_fd, 0) != 0 || !write_at(out_fd, hdr, sizeof(hdr), 0)) {
+            close(in_fd);
+            close(out_fd);
+            return V4_DECRYPT_EWRITE;
+        }
+    }
+
+    // 先只按校验和找到最后一个 commit 帧（帧头第二个字段非零）：之后的帧属于还没提交的事务，
+    // 回滚后会被原地覆盖，SQLite 打开时也会忽略，不解密也不写出
+    // 末尾写了一半的帧或上个周期遗留的旧帧都不能通过校验，到此为止
+    uint64_t commit_end = start;
+    uint32_t commit_ck[2] = {in_ck[0], in_ck[1]};
+    for (uint64_t i = start;; i++) {
+        if (!read_at(in_fd, frame, FRAME_SIZE, frame_offset(i)) ||
+            !check_frame(hdr, frame, big_endian, in_ck)) {
+            break;
+        }
+        if (load_be32(frame + 4) != 0) {
+            commit_end = i + 1;
+            commit_ck[0] = in_ck[0];
+            commit_ck[1] = in_ck[1];
+        }
+    }
+
+    int ret = V4_DECRYPT_OK;
+    uint64_t i = start;
+    for (; i < commit_end; i++) {
+        if (!read_at(in_fd, frame, FRAME_SIZE, frame_offset(i))) {
+            ret = V4_DECRYPT_EREAD;
+            break;
+        }
+
+        uint32_t pgno = load_be32(frame);
+        if (v4_decrypt_page_to(ctx, frame + V4_WAL_FRAME_HEADER_SIZE, out + V4_WAL_FRAME_HEADER_SIZE,
+                               pgno - 1) != V4_DECRYPT_OK) {
+            ret = V4_DECRYPT_EHMAC;
+            if (bad_frame) {
+                *bad_frame = i;
+            }
+            break;
+        }
+
+        // 页号、commit 标记和 salt 不变，校验和按明文重新累积
+        memcpy(out, frame, 16);
+        wal_checksum(big_endian, out, 8, out_ck);
+        wal_checksum(big_endian, out + V4_WAL_FRAME_HEADER_SIZE, PAGE_SIZE, out_ck);
+        store_be32(out + 16, out_ck[0]);
+        store_be32(out + 20, out_ck[1]);
+        if (!write_at(out_fd, out, FRAME_SIZE, frame_offset(i))) {
+            ret = V4_DECRYPT_EWRITE;
+            break;
+        }
+    }
+
+    stats->frames = i;
+    stats->new_frames = i - start;
+    if (ftruncate(out_fd, frame_offset(i)) != 0 && ret == V4_DECRYPT_OK) {
+        ret = V4_DECRYPT_EWRITE;
+    }
+    // 只有完整写到 commit 边界时才能从这里续传，出错时删除记录，下次从头解密
+    if (ret == V4_DECRYPT_OK) {
+        save_resume(out_path, commit_end, commit_ck);
+    } else {
+        save_resume(out_path, 0, NULL);
+    }
+    close(in_fd);
+    if (close(out_fd) != 0 && ret == V4_DECRYPT_OK) {
+        ret = V4_DECRYPT_EWRITE;
+    }
+    return ret;
+}
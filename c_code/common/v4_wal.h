@@ -0,0 +1,44 @@
+// V4 数据库 WAL 文件解密
+//
+// 微信 V4 的最新写入先进入 <db>-wal，checkpoint 之后才写回主库。WAL 文件头和
+// 每帧 24 字节的帧头是明文，帧内的页面与主库一样按页加密，HMAC 使用帧头中的页号。
+// 解密后帧内容变了，SQLite 按帧累积的校验和需要对明文重新计算，否则打开时会
+// 丢弃这些帧；文件头原样保留（其校验和只覆盖文件头本身）。
+//
+// 只解密到最后一个 commit 帧为止：之后的帧属于还没提交的事务，SQLite 打开时同样忽略，
+// 而且回滚后会用同样的 salt 被原地覆盖。
+//
+// 支持增量：输出 WAL 的文件头与输入一致，且输入在输出最后一帧处的累积校验和与
+// <out_path>.resume 中记录的一致时，从这一帧之后继续，只解密新提交的帧；
+// 之前有帧被改写时累积校验和对不上，从第 0 帧重新解密。checkpoint 之后 WAL 被重置
+// （文件头 salt 改变）时同样从头开始，此时主库也已经变化，需要重新解密主库。
+
+#ifndef CHATLOG_V4_WAL_H
+#define CHATLOG_V4_WAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "v4_decrypt.h"
+
+#define V4_WAL_HEADER_SIZE 32
+#define V4_WAL_FRAME_HEADER_SIZE 24
+// 续传记录的文件名后缀，与输出 WAL 放在一起
+#define V4_WAL_RESUME_SUFFIX ".resume"
+
+typedef struct {
+    uint64_t frames;      // 输入中到最后一个 commit 帧为止的帧数，与输出的帧数相同
+    uint64_t new_frames;  // 本次解密写出的帧数
+    bool reset;           // 输出从头重新生成（首次解密、WAL 被重置或输出与输入对不上）
+} v4_wal_stats;
+
+/**
+ * 解密 wal_path 到 out_path，out_path 已存在时增量更新
+ * 输入不存在、为空或文件头无效时输出被截断为空（续传记录被删除），返回 V4_DECRYPT_OK
+ * @param ctx 用主库第一页初始化的解密上下文
+ * @param bad_frame 返回 V4_DECRYPT_EHMAC 时写出出错的帧序号，可以为 NULL
+ */
+int v4_wal_decrypt_file(const v4_decrypt_ctx *ctx, const char *wal_path, const char *out_path,
+                        v4_wal_stats *stats, uint64_t *bad_frame);
+
+#endif // CHATLOG_V4_WAL_H
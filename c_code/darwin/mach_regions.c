@@ -0,0 +1,189 @@
+// 目标进程内存区域枚举与读取实现 (macOS)，见 mach_regions.h
+
+#include "mach_regions.h"
+
+#include <mach/mach_vm.h>
+#include <mach/vm_statistics.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int tag_priority(unsigned tag, unsigned tags) {
+    if (tag == VM_MEMORY_MALLOC_NANO && (tags & MACH_REGIONS_NANO)) {
+        return 0;
+    }
+    if (tag == VM_MEMORY_MALLOC_TINY && (tags & MACH_REGIONS_TINY)) {
+        return 1;
+    }
+    if (tag == VM_MEMORY_MALLOC_SMALL && (tags & MACH_REGIONS_SMALL)) {
+        return 2;
+    }
+    return -1;
+}
+
+static int compare_region(const void *a, const void *b) {
+    const mach_region *x = a;
+    const mach_region *y = b;
+    if (x->priority != y->priority) {
+        return x->priority - y->priority;
+    }
+    return x->start < y->start ? -1 : x->start > y->start;
+}
+
+/**
+ * 统计一个枚举到的区域，可读写且 tag 被选中时加入表中
+ * @return 0 成功，-1 内存不足
+ */
+static int add_region(mach_region_table *table, uint64_t start, uint64_t end, unsigned tag,
+                      bool rw, unsigned tags) {
+    int priority = tag_priority(tag, tags);
+    table->seen++;
+    if (!rw) {
+        table->skipped_perms++;
+        return 0;
+    }
+    if (priority < 0) {
+        table->skipped_tag++;
+        return 0;
+    }
+    if (table->count == table->cap) {
+        size_t cap = table->cap ? table->cap * 2 : 256;
+        mach_region *items = realloc(table->items, cap * sizeof(*items));
+        if (!items) {
+            return -1;
+        }
+        table->items = items;
+        table->cap = cap;
+    }
+    mach_region *r = &table->items[table->count++];
+    r->start = start;
+    r->end = end;
+    r->tag = tag;
+    r->priority = priority;
+    return 0;
+}
+
+int mach_regions_load(mach_port_name_t task, unsigned tags, mach_region_table *table) {
+    memset(table, 0, sizeof(*table));
+
+    mach_vm_address_t address = 0;
+    while (1) {
+        mach_vm_size_t size = 0;
+        vm_region_extended_info_data_t info;
+        mach_msg_type_number_t info_cnt = VM_REGION_EXTENDED_INFO_COUNT;
+        mach_port_t object_name;
+        kern_return_t kr = mach_vm_region(task, &address, &size, VM_REGION_EXTENDED_INFO,
+                                          (vm_region_info_t)&info, &info_cnt, &object_name);
+        if (kr != KERN_SUCCESS) {
+            break;
+        }
+
+        bool rw = (info.protection & VM_PROT_READ) && (info.protection & VM_PROT_WRITE);
+        if (add_region(table, address, address + size, info.user_tag, rw, tags) != 0) {
+            mach_regions_free(table);
+            return -1;
+        }
+        address += size;
+    }
+
+    // mach_vm_region 按地址顺序返回，稳定性由 compare_region 的地址比较保证
+    qsort(table->items, table->count, sizeof(mach_region), compare_region);
+    return 0;
+}
+
+static unsigned image_region_tag(const mem_image_region *r) {
+    if (r->name[0] == '\0' || strcmp(r->name, "MALLOC_NANO") == 0) {
+        return VM_MEMORY_MALLOC_NANO;
+    }
+    if (strcmp(r->name, "MALLOC_TINY") == 0) {
+        return VM_MEMORY_MALLOC_TINY;
+    }
+    if (strcmp(r->name, "MALLOC_SMALL") == 0) {
+        return VM_MEMORY_MALLOC_SMALL;
+    }
+    return 0;
+}
+
+int mach_regions_load_image(const mem_image *image, unsigned tags, mach_region_table *table) {
+    memset(table, 0, sizeof(*table));
+    for (size_t i = 0; i < image->count; i++) {
+        const mem_image_region *r = &image->items[i];
+        bool rw = r->perms[0] == 'r' && r->perms[1] == 'w';
+        if (add_region(table, r->start, r->end, image_region_tag(r), rw, tags) != 0) {
+            mach_regions_free(table);
+            return -1;
+        }
+    }
+    qsort(table->items, table->count, sizeof(mach_region), compare_region);
+    return 0;
+}
+
+void mach_regions_free(mach_region_table *table) {
+    free(table->items);
+    memset(table, 0, sizeof(*table));
+}
+
+const char *mach_region_tag_name(unsigned tag) {
+    switch (tag) {
+    case VM_MEMORY_MALLOC_NANO:
+        return "nano";
+    case VM_MEMORY_MALLOC_TINY:
+        return "tiny";
+    case VM_MEMORY_MALLOC_SMALL:
+        return "small";
+    default:
+        return "other";
+    }
+}
+
+unsigned mach_regions_parse_tags(const char *list) {
+    unsigned tags = 0;
+    const char *p = list;
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == 4 && strncmp(p, "nano", 4) == 0) {
+            tags |= MACH_REGIONS_NANO;
+        } else if (len == 4 && strncmp(p, "tiny", 4) == 0) {
+            tags |= MACH_REGIONS_TINY;
+        } else if (len == 5 && strncmp(p, "small", 5) == 0) {
+            tags |= MACH_REGIONS_SMALL;
+        } else {
+            return 0;
+        }
+        p += len;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return tags;
+}
+
+int mach_region_read(void *ctx, uint64_t addr, void *buf, size_t len) {
+    mach_vm_size_t outsize = 0;
+    kern_return_t kr = mach_vm_read_overwrite(*(mach_port_name_t *)ctx, addr, len,
+                                              (mach_vm_address_t)buf, &outsize);
+    return (kr == KERN_SUCCESS && outsize == len) ? 0 : -1;
+}
+
+const unsigned char *mach_region_remap(mach_port_name_t task, uint64_t addr, size_t size) {
+    mach_vm_address_t local = 0;
+    vm_prot_t cur_prot = VM_PROT_NONE;
+    vm_prot_t max_prot = VM_PROT_NONE;
+    kern_return_t kr = mach_vm_remap(mach_task_self(), &local, size, 0, VM_FLAGS_ANYWHERE, task,
+                                     addr, TRUE, &cur_prot, &max_prot, VM_INHERIT_NONE);
+    if (kr != KERN_SUCCESS) {
+        return NULL;
+    }
+    if (!(cur_prot & VM_PROT_READ)) {
+        mach_vm_deallocate(mach_task_self(), local, size);
+        return NULL;
+    }
+    return (const unsigned char *)(uintptr_t)local;
+}
+
+void mach_region_unmap(const unsigned char *data, size_t size) {
+    if (data) {
+        mach_vm_deallocate(mach_task_self(), (mach_vm_address_t)(uintptr_t)data, size);
+    }
+}
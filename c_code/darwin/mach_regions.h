@@ -0,0 +1,85 @@
+// 目标进程内存区域枚举与读取 (macOS)
+//
+// 原来的扫描循环边枚举边处理：每个 MALLOC_NANO 区域 malloc 一块 size 字节的缓冲区，
+// mach_vm_read_overwrite 整块读入后再释放。这里先把候选区域枚举成表，按 tag 排出
+// 扫描优先级，再用两种方式之一读取：
+//   - 分块读取：region_stream 按固定窗口读入两块复用的缓冲区（默认）
+//   - 映射：mach_vm_remap(copy = TRUE) 把整个区域写时复制地映射进本进程，
+//     扫描时不拷贝数据，映射失败时退回分块读取
+// 单个区域或窗口读取失败只跳过它本身，不影响其余区域。
+//
+// 密钥所在的对象通常分配在 MALLOC_NANO 中；微信用 MallocNanoZone=0 启动或
+// 对象较大时会落到 MALLOC_TINY / MALLOC_SMALL，这两类可选地排在后面扫描。
+
+#ifndef CHATLOG_MACH_REGIONS_H
+#define CHATLOG_MACH_REGIONS_H
+
+#include <mach/mach.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mem_image.h"
+
+// 要扫描的 malloc 区域类型
+#define MACH_REGIONS_NANO 0x1
+#define MACH_REGIONS_TINY 0x2
+#define MACH_REGIONS_SMALL 0x4
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    unsigned tag;     // VM_MEMORY_MALLOC_*
+    int priority;     // 越小越先扫描：NANO 0，TINY 1，SMALL 2
+} mach_region;
+
+typedef struct {
+    mach_region *items;
+    size_t count;
+    size_t cap;
+    // 枚举统计：全部区域数，以及因不可读写、tag 未选中而被丢弃的区域数
+    size_t seen;
+    size_t skipped_perms;
+    size_t skipped_tag;
+} mach_region_table;
+
+/**
+ * 枚举目标进程中可读写、tag 属于 tags 的区域，按优先级排序，同优先级保持地址顺序
+ * @param tags MACH_REGIONS_* 的组合
+ * @return 0 成功，-1 内存不足
+ */
+int mach_regions_load(mach_port_name_t task, unsigned tags, mach_region_table *table);
+
+/**
+ * 从离线镜像的区域表构造，区域类型取自清单中的名称（vmmap 的 MALLOC_NANO 等），
+ * 没有名称的区域按 NANO 处理：dumpmemory 原来只转储第一个 MALLOC_NANO 区域
+ * @return 0 成功，-1 内存不足
+ */
+int mach_regions_load_image(const mem_image *image, unsigned tags, mach_region_table *table);
+
+void mach_regions_free(mach_region_table *table);
+
+/**
+ * 区域 tag 的名称，用于日志
+ */
+const char *mach_region_tag_name(unsigned tag);
+
+/**
+ * 解析逗号分隔的区域类型列表，例如 "nano,tiny,small"
+ * @return MACH_REGIONS_* 的组合，格式错误返回 0
+ */
+unsigned mach_regions_parse_tags(const char *list);
+
+/**
+ * region_stream 的读取回调，ctx 指向 mach_port_name_t
+ */
+int mach_region_read(void *ctx, uint64_t addr, void *buf, size_t len);
+
+/**
+ * 把 [addr, addr + size) 写时复制地映射到本进程
+ * @return 映射地址，失败返回 NULL
+ */
+const unsigned char *mach_region_remap(mach_port_name_t task, uint64_t addr, size_t size);
+
+void mach_region_unmap(const unsigned char *data, size_t size);
+
+#endif // CHATLOG_MACH_REGIONS_H
@@ -1,30 +1,56 @@
-// clang v4_testkey_darwin.c -o v4_testkey_darwin -O3 -flto
+// clang v4_testkey_darwin.c ../common/candidate_filter.c ../common/candidate_list.c ../common/derived_keys.c
+//       ../common/key_cache.c ../common/key_hint.c ../common/key_offsets.c ../common/log.c
+//       ../common/mem_image.c ../common/pattern_scan.c ../common/region_stream.c ../common/scan_stats.c ../common/sha1.c ../common/sha512_mb.c
+//       ../common/v3_validate.c ../common/v4_validate.c mach_regions.c -I../common -o v4_testkey_darwin -O3 -flto
 // 这是真正的V4版本testkey实现，与v4.go逻辑一致
 
 #include <CommonCrypto/CommonCrypto.h>
+#include <libproc.h>
 #include <mach/mach.h>
 #include <mach/mach_vm.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <getopt.h>
+#include <sys/stat.h>
 
-// V4版本常量 - 与Go代码中的常量保持一致
-#define V4_PAGE_SIZE 4096
-#define KEY_SIZE 32
-#define SALT_SIZE 16
-#define HMAC_SHA512_SIZE 64
-#define IV_SIZE 16
-#define AES_BLOCK_SIZE 16
-#define V4_ITER_COUNT 256000
+#include "candidate_filter.h"
+#include "db_format.h"
+#include "db_page_v4.h"
+#include "derived_keys.h"
+#include "key_cache.h"
+#include "key_hint.h"
+#include "key_offsets.h"
+#include "log.h"
+#include "mach_regions.h"
+#include "mem_image.h"
+#include "pattern_scan.h"
+#include "region_stream.h"
+#include "scan_stats.h"
+#include "v3_validate.h"
+#include "v4_validate.h"
+
+// V4版本常量 - 与Go代码中的常量保持一致，页布局见 db_format.h
+#define V4_PAGE_SIZE DB_V4_PAGE_SIZE
+#define KEY_SIZE DB_KEY_SIZE
+#define SALT_SIZE DB_SALT_SIZE
+#define HMAC_SHA512_SIZE DB_V4_HMAC_SIZE
+#define V4_ITER_COUNT DB_V4_ITER_COUNT
+
+// 每次特征码扫描最多取回的命中数
+#define SCAN_MAX_HITS 256
 
 /**
  * V4版本的testkey函数 - 与Go代码中的V4Decryptor.Validate逻辑完全一致
  * @param page 数据库第一页内容
  * @param key 待验证的密钥
+ * @param out_enc_key 验证成功时写出派生的加密密钥，可以为NULL
+ * @param out_mac_key 验证成功时写出派生的MAC密钥，可以为NULL
  * @return 密钥是否有效
  */
-bool testkey_v4(const unsigned char *page, const unsigned char *key) {
+bool testkey_v4_derive(const unsigned char *page, const unsigned char *key,
+                       unsigned char *out_enc_key, unsigned char *out_mac_key) {
     if (!page || !key) {
         return false;
     }
@@ -48,7 +74,7 @@ bool testkey_v4(const unsigned char *page, const unsigned char *key) {
     // 3. 生成MAC salt - salt XOR 0x3A
     unsigned char mac_salt[SALT_SIZE];
     for (int i = 0; i < SALT_SIZE; i++) {
-        mac_salt[i] = salt[i] ^ 0x3A;
+        mac_salt[i] = salt[i] ^ DB_MAC_SALT_XOR;
     }
 
     // 4. 派生MAC密钥 - 使用enc_key作为输入，迭代2次
@@ -57,56 +83,68 @@ bool testkey_v4(const unsigned char *page, const unsigned char *key) {
                                  (const char *)enc_key, KEY_SIZE,
                                  mac_salt, SALT_SIZE,
                                  kCCPRFHmacAlgSHA512,  // 使用SHA512
-                                 2,                    // 2次迭代
+                                 DB_MAC_ITER_COUNT,    // 2次迭代
                                  mac_key, KEY_SIZE);
     if (result != kCCSuccess) {
         return false;
     }
 
-    // 5. 计算reserve大小
-    int reserve = IV_SIZE + HMAC_SHA512_SIZE;
-    if (reserve % AES_BLOCK_SIZE != 0) {
-        reserve = ((reserve / AES_BLOCK_SIZE) + 1) * AES_BLOCK_SIZE;
-    }
+    // 5. 计算HMAC-SHA512 - 从salt后开始到数据结束位置，再追加页码 (第一页 = 1，小端序)
+    //    reserve 和数据结束位置是编译期常量，见 db_format.h
+    hmac_sha512_ctx hmac;
+    hmac_sha512_init(&hmac, mac_key, KEY_SIZE);
+    unsigned char calculated_hmac[HMAC_SHA512_SIZE];
+    db_v4_page_mac(&hmac, page, 0, calculated_hmac);
 
-    // 6. 计算数据结束位置
-    int data_end = V4_PAGE_SIZE - reserve + IV_SIZE;
+    // 6. 提取存储的HMAC并比较
+    const unsigned char *stored_hmac = page + DB_V4_DATA_END;
+    
+    // 调试输出，-vv 时打开
+    log_trace("Reserve: %d, Data end: %d", DB_V4_RESERVE, DB_V4_DATA_END);
+    log_trace_hex("Calculated HMAC", calculated_hmac, HMAC_SHA512_SIZE);
+    log_trace_hex("Stored HMAC", stored_hmac, HMAC_SHA512_SIZE);
 
-    // 7. 初始化HMAC-SHA512上下文
-    CCHmacContext hmac_context;
-    CCHmacInit(&hmac_context, kCCHmacAlgSHA512, mac_key, KEY_SIZE);
+    // 7. 比较HMAC值
+    if (memcmp(calculated_hmac, stored_hmac, HMAC_SHA512_SIZE) != 0) {
+        return false;
+    }
 
-    // 8. 更新HMAC - 从salt后开始到数据结束位置
-    CCHmacUpdate(&hmac_context, page + SALT_SIZE, data_end - SALT_SIZE);
+    if (out_enc_key) {
+        memcpy(out_enc_key, enc_key, KEY_SIZE);
+    }
+    if (out_mac_key) {
+        memcpy(out_mac_key, mac_key, KEY_SIZE);
+    }
+    return true;
+}
 
-    // 9. 更新HMAC - 添加页码 (第一页 = 1，小端序)
-    unsigned char page_no[4] = {1, 0, 0, 0};  // 小端序的1
-    CCHmacUpdate(&hmac_context, page_no, 4);
+bool testkey_v4(const unsigned char *page, const unsigned char *key) {
+    return testkey_v4_derive(page, key, NULL, NULL);
+}
 
-    // 10. 计算最终HMAC
-    unsigned char calculated_hmac[HMAC_SHA512_SIZE];
-    CCHmacFinal(&hmac_context, calculated_hmac);
+/**
+ * 带缓存的testkey_v4，重复出现的候选直接使用缓存结论
+ * @param cache 派生结果缓存，为NULL时等同于testkey_v4
+ */
+bool testkey_v4_cached(key_cache *cache, const unsigned char *page, const unsigned char *key) {
+    if (!cache) {
+        return testkey_v4(page, key);
+    }
 
-    // 11. 提取存储的HMAC并比较
-    const unsigned char *stored_hmac = page + data_end;
-    
-    // 调试输出（可选）
-    #ifdef DEBUG
-    printf("Reserve: %d, Data end: %d\n", reserve, data_end);
-    printf("Calculated HMAC: ");
-    for (int i = 0; i < HMAC_SHA512_SIZE; i++) {
-        printf("%02x", calculated_hmac[i]);
-    }
-    printf("\n");
-    printf("Stored HMAC: ");
-    for (int i = 0; i < HMAC_SHA512_SIZE; i++) {
-        printf("%02x", stored_hmac[i]);
-    }
-    printf("\n");
-    #endif
-
-    // 12. 比较HMAC值
-    return memcmp(calculated_hmac, stored_hmac, HMAC_SHA512_SIZE) == 0;
+    switch (key_cache_lookup(cache, key, NULL, NULL)) {
+    case KEY_CACHE_GOOD:
+        return true;
+    case KEY_CACHE_BAD:
+        return false;
+    default:
+        break;
+    }
+
+    unsigned char enc_key[KEY_SIZE];
+    unsigned char mac_key[KEY_SIZE];
+    bool ok = testkey_v4_derive(page, key, enc_key, mac_key);
+    key_cache_store(cache, key, ok, enc_key, mac_key);
+    return ok;
 }
 
 /**
@@ -118,140 +156,560 @@ bool testkey_v4(const unsigned char *page, const unsigned char *key) {
 bool testkey(const unsigned char *page, const unsigned char *key) {
     // 先尝试V4版本
     if (testkey_v4(page, key)) {
-        printf("Key validated with V4 algorithm\n");
+        log_debug("Key validated with V4 algorithm");
         return true;
     }
     
-    // 如果V4失败，可以在这里添加V3的fallback逻辑
-    printf("Key validation failed with V4 algorithm\n");
+    // V4失败时再按V3校验，只需要2轮PBKDF2-HMAC-SHA1
+    if (testkey_v3(page, key)) {
+        log_debug("Key validated with V3 algorithm");
+        return true;
+    }
+    log_debug("Key validation failed with V4 and V3 algorithms");
     return false;
 }
 
+/**
+ * 把找到的密钥对这个数据库的派生结果写入派生密钥存储，之后 v4_decrypt -k 和
+ * chatlog 服务解密这个数据库时不用再跑一遍 PBKDF2
+ * 派生结果在校验时已经存进 key_cache，缓存不可用时才重新派生
+ */
+static void remember_derived_keys(const char *path, key_cache *cache, const unsigned char *page,
+                                  const unsigned char *key) {
+    // 派生密钥存储只记录 V4 的 256000 轮派生结果，V3 的派生本来就只有 2 轮
+    if (testkey_v3(page, key)) {
+        log_info("Key belongs to a V3 database, nothing to save to %s", path);
+        return;
+    }
+
+    unsigned char enc_key[KEY_SIZE];
+    unsigned char mac_key[KEY_SIZE];
+    if (key_cache_lookup(cache, key, enc_key, mac_key) != KEY_CACHE_GOOD &&
+        !testkey_v4_derive(page, key, enc_key, mac_key)) {
+        return;
+    }
+
+    derived_keys *store = derived_keys_open(path);
+    derived_keys_put(store, DERIVED_KEYS_KDF_V4, key, page, enc_key, mac_key);
+    if (store && derived_keys_save(store) == 0) {
+        log_info("Saved derived keys to %s", path);
+    }
+    derived_keys_close(store);
+    memset(enc_key, 0, sizeof(enc_key));
+    memset(mac_key, 0, sizeof(mac_key));
+}
+
+// 扫描参数
+typedef struct {
+    const char *cache_dir;  // 磁盘缓存目录，为NULL时只使用进程内缓存
+    const char *key_store;  // 派生密钥存储文件，为NULL时不写出
+    unsigned progress_ms;   // 进度输出间隔，0 表示不输出
+    unsigned tags;          // 要扫描的区域类型，MACH_REGIONS_*
+    bool remap;             // 用 mach_vm_remap 映射区域，失败时退回分块读取
+    const char *stats;      // 统计输出文件，"-" 表示 stderr，为NULL时不输出
+    unsigned formats;       // 要尝试的 DB_FORMAT_* 组合
+    const char *hints;      // 密钥位置提示文件，为NULL时不使用
+    const char *app_version; // 微信版本，为NULL时用可执行文件的大小和修改时间代替
+    const char *offsets;    // 偏移表文件，为NULL时使用默认偏移表且不记录命中
+    int sweep;              // > 0 时额外尝试 ±sweep 字节内每个 8 字节对齐的偏移
+    const char *image;      // 离线内存镜像，不为NULL时不读取目标进程
+} scan_options;
+
+// 区域内容的来源：目标进程，或者离线镜像
+typedef struct {
+    mach_port_name_t task;
+    const mem_image *image; // 不为NULL时从镜像读取，task 不使用
+} scan_source;
+
+/**
+ * region_stream 的读取回调，ctx 指向 scan_source
+ */
+static int source_read(void *ctx, uint64_t addr, void *buf, size_t len) {
+    scan_source *src = ctx;
+    return src->image ? mem_image_read((void *)src->image, addr, buf, len)
+                      : mach_region_read(&src->task, addr, buf, len);
+}
+
+// 特征码附近尝试的密钥偏移量，按命中次数排序，main 中读入后扫描期间只读
+static key_offset_table key_offsets;
+
+/**
+ * 扫描一个窗口内的特征码，候选攒批校验
+ * @return 已经找到有效密钥时返回 true
+ */
+static bool scan_window(v4_candidate_batch *batch, candidate_filter *filter, const region_window *w) {
+    size_t hits[SCAN_MAX_HITS];
+    // 只接受起点落在本窗口负责范围内的特征码，重叠部分留给相邻窗口
+    size_t limit = w->len - w->scan_end > PATTERN_SCAN_LEN - 1
+                       ? w->scan_end + PATTERN_SCAN_LEN - 1
+                       : w->len;
+    size_t pos = w->scan_begin;
+    while (!batch->found && pos + PATTERN_SCAN_LEN <= limit) {
+        size_t n = pattern_scan(w->data, limit, pos, v4_key_pattern, hits, SCAN_MAX_HITS, &pos);
+        SCAN_STATS_ADD(batch->stats, pattern_hits, n);
+        for (size_t h = 0; h < n && !batch->found; h++) {
+            log_trace("Pattern hit at 0x%llx", (unsigned long long)(w->addr + hits[h]));
+            for (size_t i = 0; i < key_offsets.count; i++) {
+                uint64_t tag = key_hint_tag(w->addr + hits[h], key_offsets.offsets[i]);
+                long key_offset = (long)hits[h] + key_offsets.offsets[i];
+
+                // 检查边界
+                if (key_offset < 0 || key_offset + KEY_SIZE > (long)w->len) {
+                    continue;
+                }
+
+                if (!candidate_filter_accept(filter, w->data + key_offset, i)) {
+                    continue;
+                }
+
+                if (v4_batch_add_tagged(batch, w->data + key_offset, tag)) {
+                    break;
+                }
+            }
+        }
+    }
+    return batch->found;
+}
+
+/**
+ * 扫描一个区域：能映射时整个区域作为一个窗口直接扫描，否则分块读取
+ * 离线镜像里完整保存的区域直接扫描镜像的映射，不拷贝
+ * 读取失败的部分只跳过本身
+ * @return 已经找到有效密钥时返回 true
+ */
+static bool scan_region(const scan_source *src, const mach_region *r, const scan_options *opts,
+                        region_stream *stream, v4_candidate_batch *batch, candidate_filter *filter,
+                        uint64_t *remapped) {
+    size_t size = (size_t)(r->end - r->start);
+    const unsigned char *mapped = NULL;
+    if (src->image) {
+        mapped = mem_image_data(src->image, r->start, size);
+    } else if (opts->remap) {
+        mapped = mach_region_remap(src->task, r->start, size);
+    }
+    if (mapped) {
+        region_window w = {mapped, size, r->start, 0, size};
+        scan_window(batch, filter, &w);
+        if (!src->image) {
+            mach_region_unmap(mapped, size);
+        }
+        (*remapped)++;
+        SCAN_STATS_ADD(batch->stats, bytes_read, size);
+        SCAN_STATS_ADD(batch->stats, regions_scanned, 1);
+    } else {
+        uint64_t bytes_read = stream->bytes_read;
+        uint64_t failed_windows = stream->failed_windows;
+        region_window w;
+        region_stream_begin(stream, r->start, r->end);
+        while (!batch->found && region_stream_next(stream, &w)) {
+            scan_window(batch, filter, &w);
+        }
+        bytes_read = stream->bytes_read - bytes_read;
+        SCAN_STATS_ADD(batch->stats, bytes_read, bytes_read);
+        SCAN_STATS_ADD(batch->stats, read_errors, stream->failed_windows - failed_windows);
+        if (bytes_read > 0) {
+            SCAN_STATS_ADD(batch->stats, regions_scanned, 1);
+        } else {
+            SCAN_STATS_SKIP(batch->stats, SCAN_SKIP_UNREADABLE, 1);
+        }
+    }
+    // 校验剩余的候选
+    return v4_batch_flush(batch);
+}
+
+/**
+ * 微信版本：优先使用 --app-version（Go 侧由 pkg/appver 取得），
+ * 否则用可执行文件的大小和修改时间代替，升级之后旧的提示自然不再匹配
+ */
+static void app_version_of(pid_t pid, const mem_image *image, const char *given, char *out,
+                           size_t len) {
+    if (given || image) {
+        // 离线镜像没有可执行文件可看，只按 --app-version 区分
+        snprintf(out, len, "%s", given ? given : "");
+        return;
+    }
+    char path[PROC_PIDPATHINFO_MAXSIZE];
+    struct stat st;
+    if (proc_pidpath(pid, path, sizeof(path)) > 0 && stat(path, &st) == 0) {
+        snprintf(out, len, "exe:%llx-%llx", (unsigned long long)st.st_size,
+                 (unsigned long long)st.st_mtime);
+    } else {
+        out[0] = '\0';
+    }
+}
+
+static void record_hint(key_hint_store *hints, const char *version, const mach_region *r,
+                        uint64_t tag) {
+    key_hint_region region = {r->start, r->end, r->tag};
+    key_hint_record(hints, version, &region, tag);
+}
+
+/**
+ * 先只读位置提示指向的几个地址，命中就不用完整扫描
+ * @return 命中的区域，没有命中时返回 NULL
+ */
+static const mach_region *probe_hints(scan_source *src, key_hint_store *hints,
+                                      const char *version, const mach_region_table *regions,
+                                      const unsigned char *page, const scan_options *opts,
+                                      key_cache *cache, scan_stats *stats,
+                                      v4_candidate_batch *batch) {
+    key_hint_region *items = malloc((regions->count ? regions->count : 1) * sizeof(*items));
+    if (!items) {
+        return NULL;
+    }
+    for (size_t i = 0; i < regions->count; i++) {
+        items[i] = (key_hint_region){regions->items[i].start, regions->items[i].end,
+                                     regions->items[i].tag};
+    }
+    candidate_list candidates;
+    candidate_list_init(&candidates);
+    key_hint_collect(hints, version, items, regions->count, source_read, src, &candidates);
+    free(items);
+
+    v4_batch_init(batch, page, cache);
+    batch->stats = stats;
+    batch->formats = opts->formats;
+    for (size_t i = 0; i < candidates.count &&
+                       !v4_batch_add_tagged(batch, candidates.keys[i], candidates.tags[i]); i++) {
+    }
+    bool found = v4_batch_flush(batch);
+    log_info("Key location hints: %zu candidates, %s", candidates.count, found ? "hit" : "miss");
+    candidate_list_free(&candidates);
+    if (!found) {
+        return NULL;
+    }
+
+    uint64_t addr = key_hint_tag_addr(batch->tag);
+    for (size_t i = 0; i < regions->count; i++) {
+        if (addr >= regions->items[i].start && addr < regions->items[i].end) {
+            return &regions->items[i];
+        }
+    }
+    return NULL;
+}
+
 // 以下是完整的dumpkey函数实现
-int dumpkey(pid_t pid, const char *filename, char *outkey) {
-    mach_port_name_t target_task;
-    kern_return_t kr;
-    
-    kr = task_for_pid(mach_task_self(), pid, &target_task);
-    if (kr != KERN_SUCCESS) {
-        fprintf(stderr, "task_for_pid failed: %s (%d)\n", mach_error_string(kr), kr);
-        return -1;
+// image 不为NULL时扫描这个离线镜像，pid 不使用
+// stats 输出扫描统计，调用前由 scan_stats_init 初始化，可以为NULL
+int dumpkey(pid_t pid, const mem_image *image, const char *filename, const scan_options *opts,
+            scan_stats *stats, char *outkey) {
+    scan_stage_timer timer;
+    scan_stage_begin(&timer);
+    scan_source src = {MACH_PORT_NULL, image};
+
+    if (!image) {
+        kern_return_t kr = task_for_pid(mach_task_self(), pid, &src.task);
+        if (kr != KERN_SUCCESS) {
+            log_error("task_for_pid failed: %s (%d)", mach_error_string(kr), kr);
+            return -1;
+        }
     }
 
-    // 读取数据库第一页
-    unsigned char page[V4_PAGE_SIZE];
+    // 读取数据库第一页；要尝试 V3 时只要求完整的 1024 字节 V3 页，其余补零
+    unsigned char page[V4_PAGE_SIZE] = {0};
     FILE *fp = fopen(filename, "rb");
     if (!fp) {
-        fprintf(stderr, "Failed to open db file: %s\n", filename);
+        log_error("Failed to open db file: %s", filename);
         return -1;
     }
     
     size_t read_size = fread(page, 1, V4_PAGE_SIZE, fp);
     fclose(fp);
     
-    if (read_size != V4_PAGE_SIZE) {
-        fprintf(stderr, "Failed to read complete first page (read %zu bytes, expected %d)\n", 
-                read_size, V4_PAGE_SIZE);
+    size_t need = (opts->formats & DB_FORMAT_V3) ? DB_V3_PAGE_SIZE : V4_PAGE_SIZE;
+    if (read_size < need) {
+        log_error("Failed to read complete first page (read %zu bytes, expected %zu)",
+                  read_size, need);
         return -1;
     }
 
-    // 搜索内存中的密钥
-    mach_vm_address_t address = 0;
-    mach_vm_size_t size;
-    vm_region_extended_info_data_t info;
-    mach_msg_type_number_t infoCnt = VM_REGION_EXTENDED_INFO_COUNT;
-    mach_port_t object_name;
-    
-    // 密钥搜索模式
-    unsigned char pattern[8] = {0x20, 0x66, 0x74, 0x73, 0x35, 0x28, 0x25, 0x00};
+    scan_stage_end(stats, SCAN_STAGE_SETUP, &timer);
 
-    while (1) {
-        kr = mach_vm_region(target_task, &address, &size, VM_REGION_EXTENDED_INFO,
-                           (vm_region_info_t)&info, &infoCnt, &object_name);
-        if (kr != KERN_SUCCESS) {
+    // 先枚举候选区域，NANO 在前，TINY / SMALL 按需排在后面
+    scan_stage_begin(&timer);
+    mach_region_table regions;
+    int loaded = image ? mach_regions_load_image(image, opts->tags, &regions)
+                       : mach_regions_load(src.task, opts->tags, &regions);
+    if (loaded != 0) {
+        log_error("Failed to enumerate memory regions");
+        return -1;
+    }
+    SCAN_STATS_ADD(stats, regions_seen, regions.seen);
+    SCAN_STATS_SKIP(stats, SCAN_SKIP_PERMS, regions.skipped_perms);
+    SCAN_STATS_SKIP(stats, SCAN_SKIP_KIND, regions.skipped_tag);
+    scan_stage_end(stats, SCAN_STAGE_REGIONS, &timer);
+    uint64_t scan_bytes = 0;
+    for (size_t i = 0; i < regions.count; i++) {
+        scan_bytes += regions.items[i].end - regions.items[i].start;
+    }
+    log_info("Scanning %zu regions (%llu MB)", regions.count, (unsigned long long)(scan_bytes >> 20));
+
+    // 同一salt下的派生结果缓存，磁盘缓存只记录被拒绝候选的指纹
+    key_cache *cache = key_cache_open(page, 0, opts->cache_dir);
+    if (cache && cache->loaded > 0) {
+        log_info("Loaded %llu rejected candidates from key cache",
+                 (unsigned long long)cache->loaded);
+    }
+
+    // 明显不是密钥的候选不进入PBKDF2
+    candidate_filter filter;
+    candidate_filter_init(&filter);
+
+    // 微信重启后密钥通常还在上次的位置，先按提示试几个候选
+    key_hint_store *hints = opts->hints ? key_hint_open(opts->hints) : NULL;
+    char version[KEY_HINT_VERSION_SIZE];
+    app_version_of(pid, image, opts->app_version, version, sizeof(version));
+    const mach_region *found = NULL;
+    v4_candidate_batch batch;
+    if (hints && hints->count > 0) {
+        scan_stage_begin(&timer);
+        found = probe_hints(&src, hints, version, &regions, page, opts, cache, stats, &batch);
+        scan_stage_end(stats, SCAN_STAGE_HINT, &timer);
+    }
+
+    log_progress progress;
+    log_progress_init(&progress, opts->progress_ms);
+    uint64_t done_bytes = 0;
+    uint64_t remapped = 0;
+
+    // 区域按固定窗口分块读取，两块缓冲区在所有区域之间复用
+    // 窗口重叠：最小负偏移，以及最大偏移再加上密钥长度
+    region_stream stream;
+    size_t back, fwd;
+    key_offsets_span(&key_offsets, &back, &fwd);
+    if (region_stream_init(&stream, 0, back, fwd, source_read, &src) != 0) {
+        log_error("Failed to allocate scan buffers");
+        mach_regions_free(&regions);
+        key_hint_close(hints);
+        key_cache_close(cache);
+        return -1;
+    }
+
+    int ret = -1;
+    size_t done = 0;
+    scan_stage_begin(&timer);
+    for (size_t i = 0; !found && i < regions.count; i++) {
+        const mach_region *r = &regions.items[i];
+
+        // 候选先攒成一批，再用多路PBKDF2统一校验
+        v4_batch_init(&batch, page, cache);
+        batch.stats = stats;
+        batch.formats = opts->formats;
+        done = i + 1;
+        if (scan_region(&src, r, opts, &stream, &batch, &filter, &remapped)) {
+            found = r;
             break;
         }
 
-        // 检查内存区域是否可读写且为malloc nano区域
-        if ((info.protection & VM_PROT_READ) && 
-            (info.protection & VM_PROT_WRITE) &&
-            (info.user_tag == VM_MEMORY_MALLOC_NANO)) {
+        done_bytes += r->end - r->start;
+        if (log_progress_due(&progress)) {
+            log_info("Progress: %zu/%zu regions, %llu MB, %llu candidates validated",
+                     i + 1, regions.count, (unsigned long long)(done_bytes >> 20),
+                     (unsigned long long)filter.passed);
+        }
+    }
 
-            unsigned char *data = malloc(size);
-            if (!data) {
-                address += size;
-                continue;
+    scan_stage_end(stats, SCAN_STAGE_SCAN, &timer);
+    if (found) {
+        scan_stats_key_found(stats);
+        // 找到有效密钥，转换为十六进制字符串
+        for (int j = 0; j < KEY_SIZE; j++) {
+            sprintf(outkey + j * 2, "%02x", batch.key[j]);
+        }
+        outkey[KEY_SIZE * 2] = '\0';
+        log_debug("Key found in %s region 0x%llx, validated with %s algorithm",
+                  mach_region_tag_name(found->tag), (unsigned long long)found->start,
+                  db_format_name(batch.format));
+        record_hint(hints, version, found, batch.tag);
+        if (batch.tag) {
+            // 命中的偏移写进统计，指定了 -O 时累加到偏移表文件
+            int offset = key_hint_tag_key_offset(batch.tag);
+            scan_stats_key_offset(stats, offset);
+            if (opts->offsets) {
+                key_offsets_record_hit(&key_offsets, offset);
+                key_offsets_save(&key_offsets, opts->offsets);
             }
+        }
+        if (opts->key_store) {
+            remember_derived_keys(opts->key_store, cache, page, batch.key);
+        }
+        ret = 0;
+    }
+    SCAN_STATS_SKIP(stats, SCAN_SKIP_CANCELED, regions.count - done);
+    SCAN_STATS_ADD(stats, candidates_seen, filter.seen);
+    SCAN_STATS_ADD(stats, candidates_filtered, filter.seen - filter.passed);
 
-            mach_vm_size_t outsize = 0;
-            kr = mach_vm_read_overwrite(target_task, address, size,
-                                       (mach_vm_address_t)data, &outsize);
-            if (kr != KERN_SUCCESS) {
-                free(data);
-                address += size;
-                continue;
-            }
+    log_debug("Regions mapped: %llu, windows read: %llu MB, failed windows: %llu",
+              (unsigned long long)remapped, (unsigned long long)(stream.bytes_read >> 20),
+              (unsigned long long)stream.failed_windows);
+    if (LOG_ENABLED(LOG_LEVEL_DEBUG)) {
+        candidate_filter_print(&filter, key_offsets.offsets, key_offsets.count, stderr);
+    }
+    region_stream_destroy(&stream);
+    mach_regions_free(&regions);
+    key_hint_close(hints);
+    key_cache_close(cache);
+    return ret;
+}
 
-            // 搜索模式
-            unsigned char *pos = data;
-            unsigned char *end = pos + outsize;
-            
-            while ((pos = memmem(pos, end - pos, pattern, sizeof(pattern)))) {
-                // 尝试不同的偏移量
-                int offsets[] = {16, -80, 64, -16, 32, -32};
-                int num_offsets = sizeof(offsets) / sizeof(offsets[0]);
-
-                for (int i = 0; i < num_offsets; i++) {
-                    unsigned char *key = pos + offsets[i];
-                    
-                    // 检查边界
-                    if (key < data || key + KEY_SIZE > end) {
-                        continue;
-                    }
-
-                    // 测试密钥
-                    if (testkey_v4(page, key)) {
-                        // 找到有效密钥，转换为十六进制字符串
-                        for (int j = 0; j < KEY_SIZE; j++) {
-                            sprintf(outkey + j * 2, "%02x", key[j]);
-                        }
-                        outkey[KEY_SIZE * 2] = '\0';
-                        
-                        free(data);
-                        return 0;
-                    }
-                }
-                pos++;
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-v] [-c cache_dir] [-k file] [-t tags] [-m] [-f formats] [-H file] [-O file] [-w bytes] [-p ms] [--stats file] <pid> <dbfile>\n", prog);
+    fprintf(stderr, "       %s [options] -i image <dbfile>\n", prog);
+    fprintf(stderr, "Extract WeChat database encryption key from process memory (V4)\n");
+    fprintf(stderr, "  -c, --cache-dir DIR  remember rejected candidates per DB salt in DIR\n");
+    fprintf(stderr, "  -k, --key-store FILE save the keys derived for <dbfile> to FILE for v4_decrypt -k\n");
+    fprintf(stderr, "  -t, --tags LIST      malloc regions to scan, in priority order (default: nano)\n");
+    fprintf(stderr, "                         e.g. nano,tiny,small; tiny and small come after nano\n");
+    fprintf(stderr, "  -m, --remap          map regions copy-on-write with mach_vm_remap instead of\n");
+    fprintf(stderr, "                       reading them in chunks; falls back to reads per region\n");
+    fprintf(stderr, "  -f, --format LIST    database formats to test each candidate against (default: v4)\n");
+    fprintf(stderr, "                         e.g. v4,v3 to find a V3 or V4 key in one scan\n");
+    fprintf(stderr, "  -H, --hints FILE     try the key locations remembered in FILE before a full scan,\n");
+    fprintf(stderr, "                       and remember where the key was found\n");
+    fprintf(stderr, "      --app-version V  WeChat version the hints are keyed by\n");
+    fprintf(stderr, "                       (default: size and mtime of the target executable)\n");
+    fprintf(stderr, "  -O, --offsets FILE   key offsets around the pattern, one \"offset hits\" per line;\n");
+    fprintf(stderr, "                       tried by hit count, updated when the key is found\n");
+    fprintf(stderr, "  -w, --sweep N        also try every 8-byte aligned offset within +-N bytes\n");
+    fprintf(stderr, "  -i, --image FILE     scan a saved memory image instead of a live process:\n");
+    fprintf(stderr, "                       a chatlog dumpmemory .bin with FILE.regions, or an ELF core\n");
+    fprintf(stderr, "  -p, --progress-ms N  print progress at most every N ms, 0 to disable (default: 1000)\n");
+    fprintf(stderr, "      --stats FILE     write scan statistics as JSON to FILE, - for stderr\n");
+    fprintf(stderr, "  -v, --verbose        print debug output, repeat (-vv) for per-candidate trace\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"app-version", required_argument, NULL, 'A'},
+        {"cache-dir", required_argument, NULL, 'c'},
+        {"format", required_argument, NULL, 'f'},
+        {"hints", required_argument, NULL, 'H'},
+        {"image", required_argument, NULL, 'i'},
+        {"key-store", required_argument, NULL, 'k'},
+        {"remap", no_argument, NULL, 'm'},
+        {"offsets", required_argument, NULL, 'O'},
+        {"progress-ms", required_argument, NULL, 'p'},
+        {"stats", required_argument, NULL, 'S'},
+        {"sweep", required_argument, NULL, 'w'},
+        {"tags", required_argument, NULL, 't'},
+        {"verbose", no_argument, NULL, 'v'},
+        {NULL, 0, NULL, 0},
+    };
+
+    scan_options opts = {NULL, NULL, 1000, MACH_REGIONS_NANO, false, NULL, DB_FORMAT_V4, NULL, NULL, NULL, 0, NULL};
+    int verbose = 0;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "c:f:H:i:k:mO:p:t:vw:", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'A':
+            opts.app_version = optarg;
+            break;
+        case 'c':
+            opts.cache_dir = optarg;
+            break;
+        case 'f':
+            opts.formats = db_formats_parse(optarg);
+            if (opts.formats == 0) {
+                log_error("Invalid database formats: %s", optarg);
+                return -1;
+            }
+            break;
+        case 'H':
+            opts.hints = optarg;
+            break;
+        case 'i':
+            opts.image = optarg;
+            break;
+        case 'k':
+            opts.key_store = optarg;
+            break;
+        case 'm':
+            opts.remap = true;
+            break;
+        case 'O':
+            opts.offsets = optarg;
+            break;
+        case 'w':
+            opts.sweep = atoi(optarg);
+            if (opts.sweep <= 0) {
+                log_error("Invalid sweep radius: %s", optarg);
+                return -1;
+            }
+            break;
+        case 'S':
+            opts.stats = optarg;
+            break;
+        case 'p':
+            opts.progress_ms = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            opts.tags = mach_regions_parse_tags(optarg);
+            if (opts.tags == 0) {
+                log_error("Invalid region tags: %s", optarg);
+                return -1;
             }
-            free(data);
+            break;
+        case 'v':
+            verbose++;
+            break;
+        default:
+            print_usage(argv[0]);
+            return -1;
         }
-        address += size;
     }
 
-    return -1;
-}
+    log_set_level(LOG_LEVEL_INFO + verbose);
+    if (opts.offsets) {
+        if (key_offsets_load(&key_offsets, opts.offsets) != 0) {
+            return -1;
+        }
+    } else {
+        key_offsets_default(&key_offsets);
+    }
+    if (opts.sweep > 0) {
+        key_offsets_sweep(&key_offsets, opts.sweep);
+    }
+    log_debug("Trying %zu key offsets, most likely %+d", key_offsets.count, key_offsets.offsets[0]);
 
-int main(int argc, char *argv[]) {
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <pid> <dbfile>\n", argv[0]);
-        fprintf(stderr, "Extract WeChat database encryption key from process memory (V4)\n");
+    // 扫描离线镜像时只有数据库一个位置参数
+    if (argc - optind < (opts.image ? 1 : 2)) {
+        print_usage(argv[0]);
         return -1;
     }
 
-    pid_t pid = atoi(argv[1]);
-    if (pid <= 0) {
-        fprintf(stderr, "Invalid PID: %s\n", argv[1]);
-        return -1;
+    pid_t pid = 0;
+    mem_image image;
+    if (opts.image) {
+        if (mem_image_open(&image, opts.image) != 0) {
+            return -1;
+        }
+        log_info("Searching for V4 encryption key in %s image %s (%zu regions)...",
+                 mem_image_format_name(image.format), opts.image, image.count);
+    } else {
+        pid = atoi(argv[optind]);
+        if (pid <= 0) {
+            log_error("Invalid PID: %s", argv[optind]);
+            return -1;
+        }
+        log_info("Searching for V4 encryption key in process %d...", pid);
     }
+    const char *dbfile = argv[opts.image ? optind : optind + 1];
 
     char key[KEY_SIZE * 2 + 1] = {0};
-    printf("Searching for V4 encryption key in process %d...\n", pid);
-    
-    if (dumpkey(pid, argv[2], key) == 0) {
+    scan_stats stats;
+    scan_stats_init(&stats);
+    int ret = dumpkey(pid, opts.image ? &image : NULL, dbfile, &opts, &stats, key);
+    if (opts.image) {
+        mem_image_close(&image);
+    }
+    if (opts.stats) {
+        scan_stats_write(&stats, ret == 0, opts.stats);
+    }
+    if (ret == 0) {
         printf("Found key: %s\n", key);
         return 0;
     } else {
         printf("Key not found\n");
         return -1;
     }
-}
\ No newline at end of file
+}
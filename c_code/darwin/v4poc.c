@@ -1,49 +1,23 @@
-// clang poc.c -o dumpkey -O3 -flto
+// clang v4poc.c mach_regions.c ../common/key_offsets.c ../common/log.c ../common/region_stream.c
+//       ../common/sha1.c ../common/v3_validate.c -I../common -o dumpkey -O3 -flto
 
-#include <CommonCrypto/CommonCrypto.h>
 #include <mach/mach.h>
 #include <mach/mach_vm.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-#define DBPAGE_SIZE 1024
-#define KEY_SIZE 32
-#define SALT_SIZE 16
-#define HMAC_SIZE 20
-#define IV_SIZE 16
-#define AES_BLOCK_SIZE 16
+#include "db_format.h"
+#include "key_offsets.h"
+#include "mach_regions.h"
+#include "region_stream.h"
+#include "v3_validate.h"
 
-bool testkey(const unsigned char *page, const unsigned char *key) {
-  // 原有testkey函数保持不变
-  if (!page || !key)
-    return false;
+// V3 的页布局和校验逻辑见 db_format.h / v3_validate.c
+#define DBPAGE_SIZE DB_V3_PAGE_SIZE
+#define KEY_SIZE DB_KEY_SIZE
 
-  unsigned char mac_salt[SALT_SIZE];
-  for (int i = 0; i < SALT_SIZE; i++)
-    mac_salt[i] = page[i] ^ 0x3A;
-
-  unsigned char mac_key[KEY_SIZE];
-
-  CCKeyDerivationPBKDF(kCCPBKDF2, (const char *)key, KEY_SIZE, mac_salt,
-                       SALT_SIZE, kCCPRFHmacAlgSHA1, 2, mac_key, KEY_SIZE);
-
-  int reserve = ((IV_SIZE + HMAC_SIZE + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE) *
-                AES_BLOCK_SIZE;
-  int end = DBPAGE_SIZE - reserve + IV_SIZE;
-
-  CCHmacContext hmacContext;
-  CCHmacInit(&hmacContext, kCCHmacAlgSHA1, mac_key, KEY_SIZE);
-  CCHmacUpdate(&hmacContext, page + SALT_SIZE, end - SALT_SIZE);
-
-  unsigned char page_no[4] = {1, 0, 0, 0};
-  CCHmacUpdate(&hmacContext, page_no, 4);
-
-  unsigned char hmac_result[HMAC_SIZE];
-  CCHmacFinal(&hmacContext, hmac_result);
-
-  return memcmp(hmac_result, page + end, HMAC_SIZE) == 0;
-}
-
-int dumpkey(pid_t pid, const char *filename, char *outkey) {
+int dumpkey(pid_t pid, const char *filename, const key_offset_table *offsets, char *outkey) {
   // 省略task_for_pid等初始化代码（保持不变）
   mach_port_name_t target_task;
   kern_return_t kr;
@@ -63,80 +37,84 @@ int dumpkey(pid_t pid, const char *filename, char *outkey) {
   }
   fclose(fp);
 
-  mach_vm_address_t address = 0;
-  mach_vm_size_t size;
-  vm_region_extended_info_data_t info;
-  mach_msg_type_number_t infoCnt = VM_REGION_EXTENDED_INFO_COUNT;
-  mach_port_t object_name;
   unsigned char pattern[9] = {0x20, 0x66, 0x74, 0x73, 0x35, 0x28, 0x25, 0x00};
 
-  while (1) {
-    kr = mach_vm_region(target_task, &address, &size, VM_REGION_EXTENDED_INFO,
-                        (vm_region_info_t)&info, &infoCnt, &object_name);
-    if (kr != KERN_SUCCESS)
-      break;
-
-    if ((info.protection & VM_PROT_READ) && (info.protection & VM_PROT_WRITE) &&
-        (info.user_tag == VM_MEMORY_MALLOC_NANO)) {
-
-      unsigned char *data = malloc(size);
-
-      mach_vm_size_t outsize = 0;
-      kr = mach_vm_read_overwrite(target_task, address, size,
-                                  (mach_vm_address_t)data, &outsize);
-      if (kr != KERN_SUCCESS) {
-        free(data);
-        break;
-      }
-
-      unsigned char *pos = data, *end = pos + outsize;
-      while ((pos = memmem(pos, end - pos, pattern, 9))) {
-        printf("pos: %d\n", *end);
-        // 定义要尝试的偏移量数组
-        int offsets[] = {16, -80, 64};
-        int num_offsets = sizeof(offsets) / sizeof(offsets[0]);
+  // 区域按固定窗口读入两块复用的缓冲区，单个窗口读取失败只跳过它本身
+  mach_region_table regions;
+  if (mach_regions_load(target_task, MACH_REGIONS_NANO, &regions) != 0) {
+    fprintf(stderr, "failed to enumerate memory regions\n");
+    return -1;
+  }
+  region_stream stream;
+  size_t back, fwd;
+  key_offsets_span(offsets, &back, &fwd);
+  if (region_stream_init(&stream, 0, back, fwd, mach_region_read, &target_task) != 0) {
+    fprintf(stderr, "failed to allocate scan buffers\n");
+    mach_regions_free(&regions);
+    return -1;
+  }
 
-        for (int i = 0; i < num_offsets; i++) {
-          int offset = offsets[i];
+  int ret = -1;
+  for (size_t r = 0; r < regions.count && ret != 0; r++) {
+    region_window w;
+    region_stream_begin(&stream, regions.items[r].start, regions.items[r].end);
+    while (ret != 0 && region_stream_next(&stream, &w)) {
+      // 只接受起点落在本窗口负责范围内的特征码，重叠部分留给相邻窗口
+      const unsigned char *data = w.data, *end = data + w.len;
+      const unsigned char *pos = data + w.scan_begin;
+      const unsigned char *limit = data + w.scan_end;
+      while (pos < limit &&
+             (pos = memmem(pos, end - pos, pattern, sizeof(pattern))) &&
+             pos < limit) {
+        for (size_t i = 0; i < offsets->count; i++) {
           // 计算密钥位置 = 模式位置 + 偏移量
-          unsigned char *key = pos + offset;
-          printf("offset: %hhu\n", *key);
+          const unsigned char *key = pos + offsets->offsets[i];
 
           // 验证密钥地址有效性
           if (key < data || key + KEY_SIZE > end) {
             continue;  // 越界则跳过
           }
 
-          if (testkey(page, key)) {
-            // 输出密钥并清理资源
+          if (testkey_v3(page, key)) {
+            // 输出密钥
             for (int j = 0; j < KEY_SIZE; j++) {
               sprintf(outkey + j * 2, "%02x", key[j]);
             }
-            free(data);
-            return 0;
+            ret = 0;
+            break;
           }
         }
+        if (ret == 0) {
+          break;
+        }
         pos++;  // 继续搜索下一个模式匹配位置
       }
-      free(data);
     }
-    address += size;
   }
 
-  return -1;
+  region_stream_destroy(&stream);
+  mach_regions_free(&regions);
+  return ret;
 }
 
 int main(int argc, char *argv[]) {
   // main函数保持不变
   if (argc < 3) {
-    fprintf(stderr, "Usage: %s <pid> <dbfile>\n", argv[0]);
+    fprintf(stderr, "Usage: %s <pid> <dbfile> [offsets_file]\n", argv[0]);
     return -1;
   }
 
   pid_t pid = atoi(argv[1]);
 
+  // 偏移表与 v4_testkey -O 的文件格式相同，不指定时使用默认表
+  key_offset_table offsets;
+  key_offsets_default(&offsets);
+  if (argc > 3 && key_offsets_load(&offsets, argv[3]) != 0) {
+    return -1;
+  }
+
   char key[100] = {0};
-  if (dumpkey(pid, argv[2], key) == 0) {
+  if (dumpkey(pid, argv[2], &offsets, key) == 0) {
     printf("key: %s\n", key);
   } else {
     printf("not found key\n");
@@ -0,0 +1,20 @@
+#!/bin/bash
+# 编译 v4_decrypt 的脚本，Linux 和 macOS 通用，不依赖 OpenSSL
+# 实际构建由顶层 Makefile 完成，参数原样传过去，例如 ./build.sh LTO=1
+
+cd "$(dirname "$0")"
+
+CC=${CC:-cc}
+
+echo "Compiling v4_decrypt..."
+make -C ../.. c_code/decrypt/v4_decrypt CC="$CC" "$@"
+
+if [ $? -eq 0 ]; then
+    echo "Compilation successful!"
+    echo "Binary created: v4_decrypt"
+    echo ""
+    echo "Usage: ./v4_decrypt <dbfile> <hexkey> <output>"
+else
+    echo "Compilation failed!"
+    exit 1
+fi
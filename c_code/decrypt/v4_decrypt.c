@@ -0,0 +1,233 @@
+// V4 数据库解密工具，输出与 chatlog decrypt 的结果逐字节一致
+// 编译命令: gcc v4_decrypt.c ../common/aes256.c ../common/log.c ../common/sha512_mb.c
+//              ../common/derived_keys.c ../common/v4_decrypt.c ../common/v4_wal.c -I../common
+//              -o v4_decrypt -O3 -pthread
+//
+// 不依赖 OpenSSL，Linux 和 macOS 通用
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "aes256.h"
+#include "derived_keys.h"
+#include "log.h"
+#include "sha512_mb.h"
+#include "v4_decrypt.h"
+#include "v4_wal.h"
+
+static int hex_to_bytes(const char *hex, unsigned char *out, size_t len) {
+    if (strlen(hex) != len * 2) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        unsigned int b;
+        if (sscanf(hex + 2 * i, "%2x", &b) != 1) {
+            return -1;
+        }
+        out[i] = (unsigned char)b;
+    }
+    return 0;
+}
+
+static double elapsed_ms(const struct timespec *since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1000.0 + (now.tv_nsec - since->tv_nsec) / 1e6;
+}
+
+/**
+ * 解密 <dbfile>-wal 到 <output>-wal，已有输出时只解密新提交的帧
+ * 没有 WAL 时删除旧的输出 WAL，避免 SQLite 把过期的帧叠加到新的主库上
+ */
+static int decrypt_wal(const v4_decrypt_ctx *ctx, const char *dbfile, const char *output, bool wal_only) {
+    char wal_in[PATH_MAX];
+    char wal_out[PATH_MAX];
+    if (snprintf(wal_in, sizeof(wal_in), "%s-wal", dbfile) >= (int)sizeof(wal_in) ||
+        snprintf(wal_out, sizeof(wal_out), "%s-wal", output) >= (int)sizeof(wal_out)) {
+        log_error("Path too long: %s", dbfile);
+        return -1;
+    }
+
+    if (access(wal_in, F_OK) != 0) {
+        if (unlink(wal_out) != 0 && errno != ENOENT) {
+            log_warn("Cannot remove stale %s: %s", wal_out, strerror(errno));
+        }
+        char resume[PATH_MAX];
+        if (snprintf(resume, sizeof(resume), "%s%s", wal_out, V4_WAL_RESUME_SUFFIX) < (int)sizeof(resume)) {
+            unlink(resume);
+        }
+        log_debug("No WAL file for %s", dbfile);
+        return 0;
+    }
+
+    v4_wal_stats stats;
+    uint64_t bad_frame = 0;
+    int ret = v4_wal_decrypt_file(ctx, wal_in, wal_out, &stats, &bad_frame);
+    if (ret == V4_DECRYPT_EHMAC) {
+        log_error("WAL decrypt failed: %s (frame %llu)", v4_decrypt_strerror(ret), (unsigned long long)bad_frame);
+        return -1;
+    }
+    if (ret != V4_DECRYPT_OK) {
+        log_error("WAL decrypt failed: %s", v4_decrypt_strerror(ret));
+        return -1;
+    }
+
+    log_info("WAL: %llu frames, %llu new%s", (unsigned long long)stats.frames,
+             (unsigned long long)stats.new_frames, stats.reset ? " (restarted)" : "");
+    if (wal_only && stats.reset) {
+        log_warn("WAL was reset, the main database has probably been checkpointed; decrypt it again");
+    }
+    return 0;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-v] [-m] [-j jobs] [-k file] [-w | -W] <dbfile> <hexkey> <output>\n", prog);
+    fprintf(stderr, "Decrypt a WeChat V4 database into a plain SQLite file\n");
+    fprintf(stderr, "  <output>             output path, \"-\" for stdout (always single-threaded, no WAL)\n");
+    fprintf(stderr, "                       <dbfile>-wal, if present, is decrypted to <output>-wal\n");
+    fprintf(stderr, "  -j, --jobs N         decrypt with N threads (default: online CPU count)\n");
+    fprintf(stderr, "  -k, --key-store FILE reuse derived keys sealed in FILE, add this database's if missing\n");
+    fprintf(stderr, "                       (same format as the chatlog server's <work_dir>/.derived_keys)\n");
+    fprintf(stderr, "  -m, --mmap           decrypt directly between memory-mapped input and output;\n");
+    fprintf(stderr, "                       only for files nobody else is writing to\n");
+    fprintf(stderr, "      --populate       with -m, prefault the whole input (Linux MAP_POPULATE)\n");
+    fprintf(stderr, "  -w, --wal-only       only bring <output>-wal up to date with <dbfile>-wal\n");
+    fprintf(stderr, "  -W, --no-wal         do not touch the WAL\n");
+    fprintf(stderr, "  -v, --verbose        print debug output\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"jobs", required_argument, NULL, 'j'},
+        {"key-store", required_argument, NULL, 'k'},
+        {"mmap", no_argument, NULL, 'm'},
+        {"populate", no_argument, NULL, 'P'},
+        {"wal-only", no_argument, NULL, 'w'},
+        {"no-wal", no_argument, NULL, 'W'},
+        {"verbose", no_argument, NULL, 'v'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int jobs = 0;
+    const char *key_store = NULL;
+    unsigned flags = 0;
+    bool wal_only = false;
+    bool no_wal = false;
+    int verbose = 0;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "j:k:mvwW", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'j':
+            jobs = atoi(optarg);
+            if (jobs <= 0) {
+                log_error("Invalid job count: %s", optarg);
+                return -1;
+            }
+            break;
+        case 'k':
+            key_store = optarg;
+            break;
+        case 'm':
+            flags |= V4_DECRYPT_MMAP;
+            break;
+        case 'P':
+            flags |= V4_DECRYPT_MMAP | V4_DECRYPT_POPULATE;
+            break;
+        case 'w':
+            wal_only = true;
+            break;
+        case 'W':
+            no_wal = true;
+            break;
+        case 'v':
+            verbose++;
+            break;
+        default:
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    log_set_level(LOG_LEVEL_INFO + verbose);
+
+    if (argc - optind < 3 || (wal_only && no_wal)) {
+        print_usage(argv[0]);
+        return -1;
+    }
+    const char *dbfile = argv[optind];
+    const char *output = argv[optind + 2];
+
+    unsigned char key[V4_DECRYPT_KEY_SIZE];
+    if (hex_to_bytes(argv[optind + 1], key, sizeof(key)) != 0) {
+        log_error("Invalid key: expected %d hex characters", V4_DECRYPT_KEY_SIZE * 2);
+        return -1;
+    }
+
+    log_debug("AES engine: %s, SHA-512 engine: %s", aes256_engine(), sha512_mb_engine());
+
+    struct stat st;
+    if (stat(dbfile, &st) != 0) {
+        log_error("Cannot open %s: %s", dbfile, strerror(errno));
+        return -1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t bad_page = 0;
+    int ret;
+    if (strcmp(output, "-") == 0) {
+        // 管道不能按偏移写入，只能顺序解密
+        int in_fd = open(dbfile, O_RDONLY);
+        if (in_fd < 0) {
+            log_error("Cannot open %s: %s", dbfile, strerror(errno));
+            return -1;
+        }
+        ret = v4_decrypt_fd(in_fd, STDOUT_FILENO, key, &bad_page);
+        close(in_fd);
+    } else {
+        // 主库和 WAL 共用同一次密钥派生，存储中已有这个数据库的派生结果时不再派生
+        derived_keys *store = key_store ? derived_keys_open(key_store) : NULL;
+        v4_decrypt_ctx ctx;
+        ret = v4_decrypt_init_path(&ctx, dbfile, key, store);
+        log_debug("Key setup: %.1f ms", elapsed_ms(&start));
+        derived_keys_save(store);
+        derived_keys_close(store);
+        if (ret == V4_DECRYPT_OK && !wal_only) {
+            ret = v4_decrypt_file_ctx(&ctx, dbfile, output, jobs, flags, &bad_page);
+        }
+        if (ret == V4_DECRYPT_OK && !no_wal && decrypt_wal(&ctx, dbfile, output, wal_only) != 0) {
+            memset(&ctx, 0, sizeof(ctx));
+            memset(key, 0, sizeof(key));
+            return 1;
+        }
+        memset(&ctx, 0, sizeof(ctx));
+    }
+    double ms = elapsed_ms(&start);
+    memset(key, 0, sizeof(key));
+
+    if (ret == V4_DECRYPT_EHMAC) {
+        log_error("Decrypt failed: %s (page %llu)", v4_decrypt_strerror(ret), (unsigned long long)bad_page);
+        return 1;
+    }
+    if (ret != V4_DECRYPT_OK) {
+        log_error("Decrypt failed: %s", v4_decrypt_strerror(ret));
+        return 1;
+    }
+    if (wal_only) {
+        log_info("Updated WAL in %.1f ms", ms);
+        return 0;
+    }
+
+    double mb = st.st_size / (1024.0 * 1024.0);
+    log_info("Decrypted %.1f MB in %.1f ms (%.0f MB/s)", mb, ms, ms > 0 ? mb * 1000.0 / ms : 0.0);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#!/bin/bash
+# 编译 libchatlogkey 静态库和动态库
+# Go 侧通过 go build -tags chatlogkey 静态链接 libchatlogkey.a
+# 实际构建由顶层 Makefile 的 c-lib 目标完成，参数原样传过去，例如 ./build.sh LTO=1
+
+cd "$(dirname "$0")"
+
+case "$(uname -s)" in
+    Linux)
+        CC=${CC:-gcc}
+        SHARED=libchatlogkey.so
+        ;;
+    Darwin)
+        CC=${CC:-clang}
+        SHARED=libchatlogkey.dylib
+        ;;
+    *)
+        echo "Error: unsupported platform $(uname -s)"
+        exit 1
+        ;;
+esac
+
+echo "Compiling libchatlogkey..."
+make -C ../.. c-lib CC="$CC" "$@" || { echo "Compilation failed!"; exit 1; }
+
+echo "Compilation successful!"
+echo "Libraries created: libchatlogkey.a $SHARED"
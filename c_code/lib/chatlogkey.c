@@ -0,0 +1,372 @@
+// libchatlogkey 实现，见 chatlogkey.h
+// 扫描流程与 linux/v4_testkey_linux.c 的 full/none 模式一致：区域按优先级分给工作线程，
+// 每个区域分块流式读取，特征码命中后按偏移取候选，预过滤后攒批做多路 PBKDF2 校验。
+
+#include "chatlogkey.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "candidate_filter.h"
+#include "chatlogkey_platform.h"
+#include "key_cache.h"
+#include "key_offsets.h"
+#include "pattern_scan.h"
+#include "region_stream.h"
+#include "scan_stats.h"
+#include "v4_validate.h"
+
+// 每次特征码扫描最多取回的命中数
+#define SCAN_MAX_HITS 256
+
+struct chatlogkey_target {
+    chatlogkey_platform *platform;
+    unsigned char page[CHATLOGKEY_PAGE_SIZE];
+    key_cache *cache;   // 只在进程内，多次扫描之间复用已校验过的结论
+    key_offset_table offsets; // 特征码附近尝试的密钥偏移量，与 v4_testkey 工具的默认表一致
+    atomic_bool cancel;
+    _Atomic uint64_t bytes_scanned;
+    scan_stats stats;   // 扫描线程直接累加，stages 只保留最近一次扫描
+};
+
+// 一次 chatlogkey_scan 的共享状态
+typedef struct {
+    chatlogkey_target *target;
+    const chatlogkey_region *regions;
+    size_t count;
+    atomic_size_t next;
+    atomic_size_t processed;     // 已经处理完的区域数
+    atomic_bool done;            // 任意线程找到密钥后置位
+    atomic_int workers_failed;   // 分配缓冲区失败的线程数
+    pthread_mutex_t lock;        // 保护 found/key
+    bool found;
+    unsigned char key[CHATLOGKEY_KEY_SIZE];
+} scan_job;
+
+int chatlogkey_abi_version(void) {
+    return CHATLOGKEY_ABI_VERSION;
+}
+
+const char *chatlogkey_strerror(int err) {
+    switch (err) {
+    case CHATLOGKEY_OK:
+        return "ok";
+    case CHATLOGKEY_NOT_FOUND:
+        return "no valid key found";
+    case CHATLOGKEY_EINVAL:
+        return "invalid argument";
+    case CHATLOGKEY_EOPEN:
+        return "failed to open target process";
+    case CHATLOGKEY_ENOMEM:
+        return "out of memory";
+    case CHATLOGKEY_ECANCELED:
+        return "canceled";
+    case CHATLOGKEY_EUNSUPPORTED:
+        return "unsupported platform";
+    default:
+        return "unknown error";
+    }
+}
+
+int chatlogkey_open(int32_t pid, const unsigned char *page, size_t page_len,
+                    chatlogkey_target **out) {
+    if (pid <= 0 || !page || page_len != CHATLOGKEY_PAGE_SIZE || !out) {
+        return CHATLOGKEY_EINVAL;
+    }
+
+    chatlogkey_target *t = calloc(1, sizeof(*t));
+    if (!t) {
+        return CHATLOGKEY_ENOMEM;
+    }
+    int ret = chatlogkey_platform_open(pid, &t->platform);
+    if (ret != CHATLOGKEY_OK) {
+        free(t);
+        return ret;
+    }
+    memcpy(t->page, page, CHATLOGKEY_PAGE_SIZE);
+    t->cache = key_cache_open(t->page, 0, NULL);
+    key_offsets_default(&t->offsets);
+    atomic_init(&t->cancel, false);
+    scan_stats_init(&t->stats);
+    *out = t;
+    return CHATLOGKEY_OK;
+}
+
+void chatlogkey_close(chatlogkey_target *t) {
+    if (!t) {
+        return;
+    }
+    key_cache_close(t->cache);
+    chatlogkey_platform_close(t->platform);
+    free(t);
+}
+
+int chatlogkey_regions(chatlogkey_target *t, chatlogkey_region *out, size_t cap, size_t *count) {
+    if (!t || !count || (!out && cap > 0)) {
+        return CHATLOGKEY_EINVAL;
+    }
+    chatlogkey_region *regions;
+    size_t n;
+    int ret = chatlogkey_platform_regions(t->platform, &regions, &n);
+    if (ret != CHATLOGKEY_OK) {
+        return ret;
+    }
+    if (out) {
+        memcpy(out, regions, (n < cap ? n : cap) * sizeof(*regions));
+    }
+    *count = n;
+    free(regions);
+    return CHATLOGKEY_OK;
+}
+
+static bool job_stopped(scan_job *job) {
+    return atomic_load_explicit(&job->done, memory_order_relaxed) ||
+           atomic_load_explicit(&job->target->cancel, memory_order_relaxed);
+}
+
+/**
+ * 扫描一个窗口，命中的候选加入批次
+ * 每个命中检查一次取消标志：一个窗口里的候选全部校验完可能要几秒
+ * @return 已经找到有效密钥时返回 true
+ */
+static bool scan_window(scan_job *job, v4_candidate_batch *batch, candidate_filter *filter,
+                        const region_window *w) {
+    // 只接受起点落在本窗口负责范围内的特征码，重叠部分留给相邻窗口
+    size_t limit = w->len - w->scan_end > PATTERN_SCAN_LEN - 1
+                       ? w->scan_end + PATTERN_SCAN_LEN - 1
+                       : w->len;
+    size_t hits[SCAN_MAX_HITS];
+    size_t pos = w->scan_begin;
+    while (!batch->found && pos + PATTERN_SCAN_LEN <= limit) {
+        size_t n = pattern_scan(w->data, limit, pos, v4_key_pattern, hits, SCAN_MAX_HITS, &pos);
+        SCAN_STATS_ADD(batch->stats, pattern_hits, n);
+        for (size_t h = 0; h < n && !batch->found; h++) {
+            if (job_stopped(job)) {
+                return false;
+            }
+            const key_offset_table *offsets = &job->target->offsets;
+            for (size_t j = 0; j < offsets->count; j++) {
+                long key_offset = (long)hits[h] + offsets->offsets[j];
+                if (key_offset < 0 || key_offset + CHATLOGKEY_KEY_SIZE > (long)w->len) {
+                    continue;
+                }
+                if (!candidate_filter_accept(filter, w->data + key_offset, j)) {
+                    continue;
+                }
+                if (v4_batch_add(batch, w->data + key_offset)) {
+                    break;
+                }
+            }
+        }
+    }
+    return batch->found;
+}
+
+static void *scan_worker(void *arg) {
+    scan_job *job = arg;
+    chatlogkey_target *t = job->target;
+
+    region_stream stream;
+    candidate_filter *filter = malloc(sizeof(*filter));
+    // 窗口重叠：最小负偏移，以及最大偏移再加上密钥长度
+    size_t back, fwd;
+    key_offsets_span(&t->offsets, &back, &fwd);
+    if (!filter || region_stream_init(&stream, 0, back, fwd,
+                                      chatlogkey_platform_read, t->platform) != 0) {
+        free(filter);
+        atomic_fetch_add(&job->workers_failed, 1);
+        return NULL;
+    }
+    candidate_filter_init(filter);
+
+    while (!job_stopped(job)) {
+        size_t i = atomic_fetch_add(&job->next, 1);
+        if (i >= job->count) {
+            break;
+        }
+        const chatlogkey_region *r = &job->regions[i];
+        uint64_t seen = filter->seen;
+        uint64_t passed = filter->passed;
+        uint64_t bytes_read = stream.bytes_read;
+        uint64_t failed_windows = stream.failed_windows;
+
+        v4_candidate_batch batch;
+        v4_batch_init(&batch, t->page, t->cache);
+        batch.stats = &t->stats;
+        region_window w;
+        region_stream_begin(&stream, r->start, r->end);
+        while (!job_stopped(job) && region_stream_next(&stream, &w)) {
+            if (scan_window(job, &batch, filter, &w)) {
+                break;
+            }
+        }
+        bool found = !job_stopped(job) && v4_batch_flush(&batch);
+
+        bytes_read = stream.bytes_read - bytes_read;
+        atomic_fetch_add(&job->processed, 1);
+        atomic_fetch_add(&t->bytes_scanned, r->end - r->start);
+        SCAN_STATS_ADD(&t->stats, bytes_read, bytes_read);
+        SCAN_STATS_ADD(&t->stats, read_errors, stream.failed_windows - failed_windows);
+        if (bytes_read > 0) {
+            SCAN_STATS_ADD(&t->stats, regions_scanned, 1);
+        } else {
+            SCAN_STATS_SKIP(&t->stats, SCAN_SKIP_UNREADABLE, 1);
+        }
+        SCAN_STATS_ADD(&t->stats, candidates_seen, filter->seen - seen);
+        SCAN_STATS_ADD(&t->stats, candidates_filtered, (filter->seen - seen) - (filter->passed - passed));
+
+        if (found) {
+            scan_stats_key_found(&t->stats);
+            pthread_mutex_lock(&job->lock);
+            if (!job->found) {
+                job->found = true;
+                memcpy(job->key, batch.key, CHATLOGKEY_KEY_SIZE);
+            }
+            pthread_mutex_unlock(&job->lock);
+            atomic_store(&job->done, true);
+            break;
+        }
+    }
+
+    region_stream_destroy(&stream);
+    free(filter);
+    return NULL;
+}
+
+int chatlogkey_scan(chatlogkey_target *t, const chatlogkey_region *regions, size_t n, int jobs,
+                    unsigned char *key_out) {
+    if (!t || !key_out || (!regions && n > 0)) {
+        return CHATLOGKEY_EINVAL;
+    }
+    if (atomic_load(&t->cancel)) {
+        return CHATLOGKEY_ECANCELED;
+    }
+
+    chatlogkey_region *owned = NULL;
+    if (!regions) {
+        int ret = chatlogkey_platform_regions(t->platform, &owned, &n);
+        if (ret != CHATLOGKEY_OK) {
+            return ret;
+        }
+        regions = owned;
+    }
+
+    if (jobs <= 0) {
+        jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if ((size_t)jobs > n) {
+        jobs = (int)n;
+    }
+    if (jobs < 1) {
+        jobs = 1;
+    }
+
+    scan_job job;
+    memset(&job, 0, sizeof(job));
+    job.target = t;
+    job.regions = regions;
+    job.count = n;
+    atomic_init(&job.next, 0);
+    atomic_init(&job.processed, 0);
+    atomic_init(&job.done, false);
+    atomic_init(&job.workers_failed, 0);
+    pthread_mutex_init(&job.lock, NULL);
+
+    // 第一个密钥的时间按本次扫描计算，计数器继续累加
+    t->stats.start_ns = scan_stats_now_ns();
+    atomic_store(&t->stats.first_key_ns, 0);
+    t->stats.stages[SCAN_STAGE_SCAN] = (scan_stage_time){0, 0};
+    scan_stage_timer timer;
+    scan_stage_begin(&timer);
+    pthread_t *workers = calloc(jobs, sizeof(pthread_t));
+    int started = 0;
+    for (int i = 0; workers && i < jobs; i++) {
+        if (pthread_create(&workers[i], NULL, scan_worker, &job) != 0) {
+            break;
+        }
+        started++;
+    }
+    // 一个线程都起不来时在当前线程扫描
+    if (started == 0) {
+        scan_worker(&job);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    scan_stage_end(&t->stats, SCAN_STAGE_SCAN, &timer);
+    size_t processed = atomic_load(&job.processed);
+    SCAN_STATS_SKIP(&t->stats, SCAN_SKIP_CANCELED, n > processed ? n - processed : 0);
+
+    pthread_mutex_destroy(&job.lock);
+    free(owned);
+
+    if (job.found) {
+        memcpy(key_out, job.key, CHATLOGKEY_KEY_SIZE);
+        return CHATLOGKEY_OK;
+    }
+    if (atomic_load(&t->cancel)) {
+        return CHATLOGKEY_ECANCELED;
+    }
+    if (atomic_load(&job.workers_failed) == (started ? started : 1)) {
+        return CHATLOGKEY_ENOMEM;
+    }
+    return CHATLOGKEY_NOT_FOUND;
+}
+
+void chatlogkey_cancel(chatlogkey_target *t) {
+    if (t) {
+        atomic_store(&t->cancel, true);
+    }
+}
+
+void chatlogkey_get_stats(const chatlogkey_target *t, chatlogkey_stats *out, size_t size) {
+    if (!t || !out) {
+        return;
+    }
+    const scan_stats *s = &t->stats;
+    uint64_t seen = atomic_load(&s->candidates_seen);
+    chatlogkey_stats stats = {
+        atomic_load(&s->regions_scanned),
+        atomic_load(&t->bytes_scanned),
+        seen,
+        seen - atomic_load(&s->candidates_filtered),
+        s->stages[SCAN_STAGE_SCAN].wall_ns,
+        atomic_load(&s->regions_skipped[SCAN_SKIP_UNREADABLE]),
+        atomic_load(&s->regions_skipped[SCAN_SKIP_CANCELED]),
+        atomic_load(&s->bytes_read),
+        atomic_load(&s->read_errors),
+        atomic_load(&s->pattern_hits),
+        atomic_load(&s->candidates_cached),
+        atomic_load(&s->pbkdf2_calls),
+        s->stages[SCAN_STAGE_SCAN].cpu_ns,
+        atomic_load(&s->first_key_ns),
+    };
+    memcpy(out, &stats, size < sizeof(stats) ? size : sizeof(stats));
+}
+
+int chatlogkey_validate(const unsigned char *page, size_t page_len,
+                        const unsigned char *keys, size_t n, uint8_t *results) {
+    if (!page || page_len != CHATLOGKEY_PAGE_SIZE || (n > 0 && (!keys || !results))) {
+        return CHATLOGKEY_EINVAL;
+    }
+
+    int valid = 0;
+    for (size_t base = 0; base < n; base += V4_VALIDATE_BATCH_SIZE) {
+        size_t count = n - base < V4_VALIDATE_BATCH_SIZE ? n - base : V4_VALIDATE_BATCH_SIZE;
+        const unsigned char *batch[V4_VALIDATE_BATCH_SIZE];
+        bool ok[V4_VALIDATE_BATCH_SIZE];
+        for (size_t i = 0; i < count; i++) {
+            batch[i] = keys + (base + i) * CHATLOGKEY_KEY_SIZE;
+        }
+        valid += testkey_v4_batch(page, batch, count, ok);
+        for (size_t i = 0; i < count; i++) {
+            results[base + i] = ok[i];
+        }
+    }
+    return valid;
+}
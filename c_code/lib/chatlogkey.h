@@ -0,0 +1,136 @@
+// libchatlogkey：V4 密钥扫描与校验库
+//
+// 把 c_code 下 testkey 工具的扫描和校验逻辑打包成静态库/动态库，供 Go 侧
+// internal/wechat/key/native 通过 cgo 调用（go build -tags chatlogkey）。
+// 库内不暂停目标进程，与 Go 提取器一样只依赖对目标内存的读权限；
+// 不依赖 OpenSSL，PBKDF2/HMAC 使用 common/sha512_mb 的多路实现。
+//
+// ABI 约定：
+// - 动态库只导出本文件中的 chatlogkey_ 前缀函数，其余符号都以 -fvisibility=hidden 编译
+// - 结构体只在末尾追加字段；带 size 参数的接口按调用方给出的大小读写
+// - 新增不兼容修改时提升 CHATLOGKEY_ABI_VERSION
+// - 同一个 target 可以在任意线程调用 chatlogkey_cancel，其余接口不要并发调用
+
+#ifndef CHATLOGKEY_H
+#define CHATLOGKEY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define CHATLOGKEY_API __attribute__((visibility("default")))
+#else
+#define CHATLOGKEY_API
+#endif
+
+#define CHATLOGKEY_ABI_VERSION 1
+
+#define CHATLOGKEY_PAGE_SIZE 4096
+#define CHATLOGKEY_KEY_SIZE 32
+
+// 返回码
+#define CHATLOGKEY_OK 0
+#define CHATLOGKEY_NOT_FOUND 1          // 扫描完所有区域也没有找到有效密钥
+#define CHATLOGKEY_EINVAL (-1)          // 参数错误
+#define CHATLOGKEY_EOPEN (-2)           // 无法打开目标进程：进程不存在或权限不足
+#define CHATLOGKEY_ENOMEM (-3)
+#define CHATLOGKEY_ECANCELED (-4)       // 被 chatlogkey_cancel 取消
+#define CHATLOGKEY_EUNSUPPORTED (-5)    // 当前平台不支持
+
+// 区域类型，按扫描优先级从高到低
+#define CHATLOGKEY_REGION_HEAP 0
+#define CHATLOGKEY_REGION_ARENA 1
+#define CHATLOGKEY_REGION_ANON 2
+#define CHATLOGKEY_REGION_FILE 3
+#define CHATLOGKEY_REGION_STACK 4
+#define CHATLOGKEY_REGION_OTHER 5
+
+typedef struct chatlogkey_target chatlogkey_target;
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    int32_t kind;   // CHATLOGKEY_REGION_*
+    int32_t score;  // 扫描优先级，越大越先扫描
+} chatlogkey_region;
+
+// 计数器在同一个 target 的多次扫描之间累加，*_ns 只对应最近一次 chatlogkey_scan
+// 字段含义与 testkey 工具 --stats 输出的 JSON 一致（common/scan_stats.h）
+typedef struct {
+    uint64_t regions_scanned;
+    uint64_t bytes_scanned;
+    uint64_t candidates_seen;    // 特征码命中后按偏移取出的候选
+    uint64_t candidates_passed;  // 通过预过滤、进入 PBKDF2 的候选
+    uint64_t scan_ns;            // 最近一次 chatlogkey_scan 的耗时
+    uint64_t regions_unreadable; // 一个字节都没读到的区域
+    uint64_t regions_skipped;    // 找到密钥或被取消时还没有轮到的区域
+    uint64_t bytes_read;         // 实际读到的字节数
+    uint64_t read_errors;        // 读取失败的窗口数
+    uint64_t pattern_hits;
+    uint64_t candidates_cached;  // 进程内缓存直接给出结论的候选
+    uint64_t pbkdf2_calls;       // 实际跑了 PBKDF2 的候选
+    uint64_t scan_cpu_ns;        // 最近一次扫描整个进程的 CPU 时间
+    uint64_t first_key_ns;       // 最近一次扫描开始到找到密钥，0 表示没有找到
+} chatlogkey_stats;
+
+CHATLOGKEY_API int chatlogkey_abi_version(void);
+
+CHATLOGKEY_API const char *chatlogkey_strerror(int err);
+
+/**
+ * 打开目标进程
+ * @param page 数据库第一页内容，库内会复制一份
+ * @param page_len 必须为 CHATLOGKEY_PAGE_SIZE
+ */
+CHATLOGKEY_API int chatlogkey_open(int32_t pid, const unsigned char *page, size_t page_len,
+                                   chatlogkey_target **out);
+
+CHATLOGKEY_API void chatlogkey_close(chatlogkey_target *t);
+
+/**
+ * 按扫描优先级列出可扫描的区域
+ * @param out 可以为 NULL，只取数量
+ * @param count 输出区域总数，可能大于 cap
+ */
+CHATLOGKEY_API int chatlogkey_regions(chatlogkey_target *t, chatlogkey_region *out, size_t cap,
+                                      size_t *count);
+
+/**
+ * 多线程扫描并校验，找到第一个有效密钥即返回
+ * @param regions 要扫描的区域，为 NULL 时扫描 chatlogkey_regions 列出的全部区域
+ * @param jobs 线程数，<= 0 时使用在线 CPU 数
+ * @param key_out 找到时写出 32 字节原始密钥
+ * @return CHATLOGKEY_OK / CHATLOGKEY_NOT_FOUND / 错误码
+ */
+CHATLOGKEY_API int chatlogkey_scan(chatlogkey_target *t, const chatlogkey_region *regions,
+                                   size_t n, int jobs, unsigned char *key_out);
+
+/**
+ * 取消正在进行的扫描，可以在任意线程调用；取消之后该 target 上的扫描都直接返回
+ */
+CHATLOGKEY_API void chatlogkey_cancel(chatlogkey_target *t);
+
+/**
+ * @param size 调用方的 sizeof(chatlogkey_stats)
+ */
+CHATLOGKEY_API void chatlogkey_get_stats(const chatlogkey_target *t, chatlogkey_stats *out,
+                                         size_t size);
+
+/**
+ * 批量校验候选密钥，不需要打开目标进程
+ * @param keys n 个候选，每个 32 字节连续存放
+ * @param results 输出每个候选是否有效（1/0）
+ * @return 有效候选数量，或错误码
+ */
+CHATLOGKEY_API int chatlogkey_validate(const unsigned char *page, size_t page_len,
+                                       const unsigned char *keys, size_t n, uint8_t *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHATLOGKEY_H
@@ -0,0 +1,79 @@
+// libchatlogkey 平台层 (macOS)，区域选择与 darwin/v4_testkey_darwin.c 一致
+
+#include "chatlogkey_platform.h"
+
+#include <mach/mach.h>
+#include <mach/mach_vm.h>
+#include <stdlib.h>
+
+struct chatlogkey_platform {
+    mach_port_name_t task;
+};
+
+int chatlogkey_platform_open(int32_t pid, chatlogkey_platform **out) {
+    mach_port_name_t task;
+    if (task_for_pid(mach_task_self(), pid, &task) != KERN_SUCCESS) {
+        return CHATLOGKEY_EOPEN;
+    }
+
+    chatlogkey_platform *p = calloc(1, sizeof(*p));
+    if (!p) {
+        return CHATLOGKEY_ENOMEM;
+    }
+    p->task = task;
+    *out = p;
+    return CHATLOGKEY_OK;
+}
+
+void chatlogkey_platform_close(chatlogkey_platform *p) {
+    free(p);
+}
+
+int chatlogkey_platform_regions(chatlogkey_platform *p, chatlogkey_region **out, size_t *count) {
+    size_t n = 0;
+    size_t cap = 64;
+    chatlogkey_region *regions = malloc(cap * sizeof(*regions));
+    if (!regions) {
+        return CHATLOGKEY_ENOMEM;
+    }
+
+    mach_vm_address_t address = 0;
+    mach_vm_size_t size;
+    vm_region_extended_info_data_t info;
+    mach_port_t object_name;
+    while (1) {
+        mach_msg_type_number_t info_count = VM_REGION_EXTENDED_INFO_COUNT;
+        if (mach_vm_region(p->task, &address, &size, VM_REGION_EXTENDED_INFO,
+                           (vm_region_info_t)&info, &info_count, &object_name) != KERN_SUCCESS) {
+            break;
+        }
+
+        // 可读写的 malloc nano 区域，mach_vm_region 已经按地址顺序返回
+        if ((info.protection & VM_PROT_READ) && (info.protection & VM_PROT_WRITE) &&
+            info.user_tag == VM_MEMORY_MALLOC_NANO) {
+            if (n == cap) {
+                cap *= 2;
+                chatlogkey_region *grown = realloc(regions, cap * sizeof(*regions));
+                if (!grown) {
+                    free(regions);
+                    return CHATLOGKEY_ENOMEM;
+                }
+                regions = grown;
+            }
+            regions[n++] = (chatlogkey_region){address, address + size, CHATLOGKEY_REGION_HEAP, 100};
+        }
+        address += size;
+    }
+
+    *out = regions;
+    *count = n;
+    return CHATLOGKEY_OK;
+}
+
+int chatlogkey_platform_read(void *p, uint64_t addr, void *buf, size_t len) {
+    chatlogkey_platform *platform = p;
+    mach_vm_size_t outsize = 0;
+    kern_return_t kr = mach_vm_read_overwrite(platform->task, addr, len,
+                                              (mach_vm_address_t)buf, &outsize);
+    return (kr == KERN_SUCCESS && outsize == len) ? 0 : -1;
+}
@@ -0,0 +1,84 @@
+// libchatlogkey 平台层 (Linux)，复用 linux/proc_maps 和 linux/proc_mem
+
+#include "chatlogkey_platform.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "proc_maps.h"
+#include "proc_mem.h"
+
+struct chatlogkey_platform {
+    proc_mem mem;
+};
+
+int chatlogkey_platform_open(int32_t pid, chatlogkey_platform **out) {
+    // 与 process_vm_readv 使用同一套权限检查，进程不存在或无权访问时尽早失败
+    if (kill(pid, 0) != 0 && errno == ESRCH) {
+        return CHATLOGKEY_EOPEN;
+    }
+
+    chatlogkey_platform *p = calloc(1, sizeof(*p));
+    if (!p) {
+        return CHATLOGKEY_ENOMEM;
+    }
+    proc_mem_open(&p->mem, pid);
+    *out = p;
+    return CHATLOGKEY_OK;
+}
+
+void chatlogkey_platform_close(chatlogkey_platform *p) {
+    if (!p) {
+        return;
+    }
+    proc_mem_close(&p->mem);
+    free(p);
+}
+
+static int32_t region_kind(proc_map_kind kind) {
+    switch (kind) {
+    case PROC_MAP_HEAP:
+        return CHATLOGKEY_REGION_HEAP;
+    case PROC_MAP_ARENA:
+        return CHATLOGKEY_REGION_ARENA;
+    case PROC_MAP_ANON:
+        return CHATLOGKEY_REGION_ANON;
+    case PROC_MAP_FILE:
+        return CHATLOGKEY_REGION_FILE;
+    case PROC_MAP_STACK:
+        return CHATLOGKEY_REGION_STACK;
+    default:
+        return CHATLOGKEY_REGION_OTHER;
+    }
+}
+
+int chatlogkey_platform_regions(chatlogkey_platform *p, chatlogkey_region **out, size_t *count) {
+    proc_map_table maps;
+    if (proc_maps_load(p->mem.pid, &maps) != 0) {
+        return CHATLOGKEY_EOPEN;
+    }
+    proc_maps_rank(&maps);
+
+    chatlogkey_region *regions = malloc((maps.count ? maps.count : 1) * sizeof(*regions));
+    if (!regions) {
+        proc_maps_free(&maps);
+        return CHATLOGKEY_ENOMEM;
+    }
+    for (size_t i = 0; i < maps.count; i++) {
+        regions[i].start = maps.items[i].start;
+        regions[i].end = maps.items[i].end;
+        regions[i].kind = region_kind(maps.items[i].kind);
+        regions[i].score = maps.items[i].score;
+    }
+    *out = regions;
+    *count = maps.count;
+    proc_maps_free(&maps);
+    return CHATLOGKEY_OK;
+}
+
+int chatlogkey_platform_read(void *p, uint64_t addr, void *buf, size_t len) {
+    chatlogkey_platform *platform = p;
+    return proc_mem_read(&platform->mem, addr, buf, len) > 0 ? 0 : -1;
+}
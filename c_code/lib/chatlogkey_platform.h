@@ -0,0 +1,35 @@
+// libchatlogkey 平台层，库内部使用
+//
+// 每个平台实现一份：chatlogkey_linux.c 基于 /proc/<pid>/maps 和 process_vm_readv，
+// chatlogkey_darwin.c 基于 task_for_pid 和 mach_vm_region。
+
+#ifndef CHATLOGKEY_PLATFORM_H
+#define CHATLOGKEY_PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chatlogkey.h"
+
+typedef struct chatlogkey_platform chatlogkey_platform;
+
+/**
+ * @return CHATLOGKEY_OK 或错误码
+ */
+int chatlogkey_platform_open(int32_t pid, chatlogkey_platform **out);
+
+void chatlogkey_platform_close(chatlogkey_platform *p);
+
+/**
+ * 枚举并排序可扫描的区域
+ * @param out 输出数组，由调用方 free
+ */
+int chatlogkey_platform_regions(chatlogkey_platform *p, chatlogkey_region **out, size_t *count);
+
+/**
+ * 读取目标内存，签名与 region_stream_read_fn 一致，可以被多个线程同时调用
+ * @return 0 表示读到了内容（读不到的页已补零），-1 表示整段不可读
+ */
+int chatlogkey_platform_read(void *p, uint64_t addr, void *buf, size_t len);
+
+#endif // CHATLOGKEY_PLATFORM_H
@@ -1,5 +1,5 @@
 #!/bin/bash
-# Ubuntu环境下编译v4_testkey的脚本
+# Ubuntu环境下编译v4_testkey的脚本，实际构建由顶层 Makefile 完成
 
 # 检查是否安装了必要的依赖
 echo "Checking dependencies..."
@@ -20,9 +20,10 @@ fi
 
 echo "Dependencies OK"
 
-# 编译
+# 编译：交给顶层 Makefile，参数原样传过去，例如 ./build.sh LTO=1
 echo "Compiling v4_testkey..."
-gcc v4_testkey.c -o v4_testkey -O3 -lcrypto
+cd "$(dirname "$0")"
+make -C ../.. c_code/linux/v4_testkey "$@"
 
 if [ $? -eq 0 ]; then
     echo "Compilation successful!"
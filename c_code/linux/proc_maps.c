@@ -0,0 +1,183 @@
+// /proc/<pid>/maps 解析与扫描顺序排序实现，见 proc_maps.h
+
+#include "proc_maps.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// glibc 64 位下非主 arena 的 heap 按 HEAP_MAX_SIZE 对齐和预留
+#define GLIBC_HEAP_MAX_SIZE (64ULL * 1024 * 1024)
+// pthread 栈前的保护页一般只有一两页
+#define STACK_GUARD_MAX_SIZE (64 * 1024)
+
+// 各类区域的分数
+#define SCORE_HEAP 100
+#define SCORE_ARENA 90
+#define SCORE_ANON_LARGE 80
+#define SCORE_ANON_SMALL 40
+#define SCORE_FILE 10
+#define SCORE_STACK 5
+#define SCORE_DROP (-1)
+
+int proc_maps_parse_line(const char *line, proc_map_region *region) {
+    memset(region, 0, sizeof(*region));
+
+    unsigned int dev_major, dev_minor;
+    int path_pos = 0;
+    if (sscanf(line, "%" SCNx64 "-%" SCNx64 " %4s %" SCNx64 " %x:%x %" SCNu64 " %n",
+               &region->start, &region->end, region->perms, &region->offset,
+               &dev_major, &dev_minor, &region->inode, &path_pos) != 7) {
+        return -1;
+    }
+    if (region->end <= region->start) {
+        return -1;
+    }
+
+    // 路径可能为空，去掉行尾换行
+    const char *path = line + path_pos;
+    size_t len = strcspn(path, "\n");
+    if (len >= PROC_MAPS_PATH_MAX) {
+        len = PROC_MAPS_PATH_MAX - 1;
+    }
+    memcpy(region->path, path, len);
+    region->path[len] = '\0';
+    return 0;
+}
+
+int proc_maps_load(pid_t pid, proc_map_table *table) {
+    memset(table, 0, sizeof(*table));
+
+    char maps_path[64];
+    snprintf(maps_path, sizeof(maps_path), "/proc/%d/maps", (int)pid);
+    FILE *fp = fopen(maps_path, "r");
+    if (!fp) {
+        return -1;
+    }
+
+    char line[PROC_MAPS_PATH_MAX + 128];
+    while (fgets(line, sizeof(line), fp)) {
+        // 超长路径截断后丢弃该行剩余部分
+        if (!strchr(line, '\n') && !feof(fp)) {
+            int c;
+            while ((c = fgetc(fp)) != EOF && c != '\n') {
+            }
+        }
+
+        proc_map_region region;
+        if (proc_maps_parse_line(line, &region) != 0) {
+            continue;
+        }
+
+        if (table->count == table->cap) {
+            size_t cap = table->cap ? table->cap * 2 : 256;
+            proc_map_region *items = realloc(table->items, cap * sizeof(*items));
+            if (!items) {
+                fclose(fp);
+                proc_maps_free(table);
+                return -1;
+            }
+            table->items = items;
+            table->cap = cap;
+        }
+        table->items[table->count++] = region;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+static bool is_anonymous(const proc_map_region *r) {
+    return r->inode == 0 && r->path[0] == '\0';
+}
+
+static bool is_reserve(const proc_map_region *r) {
+    return is_anonymous(r) && strncmp(r->perms, "---", 3) == 0;
+}
+
+/**
+ * 按文件顺序分类，需要用到相邻区域，必须在排序之前调用
+ */
+static void classify(proc_map_table *table) {
+    for (size_t i = 0; i < table->count; i++) {
+        proc_map_region *r = &table->items[i];
+        const proc_map_region *prev = i > 0 ? &table->items[i - 1] : NULL;
+        const proc_map_region *next = i + 1 < table->count ? &table->items[i + 1] : NULL;
+        uint64_t size = r->end - r->start;
+
+        if (strcmp(r->path, "[heap]") == 0) {
+            r->kind = PROC_MAP_HEAP;
+        } else if (strncmp(r->path, "[stack", 6) == 0) {
+            r->kind = PROC_MAP_STACK;
+        } else if (r->path[0] == '[' && strncmp(r->path, "[anon", 5) != 0) {
+            // [vdso] [vvar] [vsyscall] 等；[anon:name] 仍是普通匿名映射
+            r->kind = PROC_MAP_SPECIAL;
+        } else if (r->inode != 0 || r->path[0] == '/') {
+            r->kind = PROC_MAP_FILE;
+        } else if (r->start % GLIBC_HEAP_MAX_SIZE == 0 && next && is_reserve(next) &&
+                   next->start == r->end && next->end - r->start <= GLIBC_HEAP_MAX_SIZE) {
+            r->kind = PROC_MAP_ARENA;
+        } else if (prev && is_reserve(prev) && prev->end == r->start &&
+                   prev->end - prev->start <= STACK_GUARD_MAX_SIZE) {
+            // 前面紧挨着保护页的匿名映射是 pthread 栈
+            r->kind = PROC_MAP_STACK;
+        } else {
+            r->kind = PROC_MAP_ANON;
+        }
+
+        if (r->perms[0] != 'r' || r->perms[1] != 'w') {
+            r->score = SCORE_DROP;
+            continue;
+        }
+        switch (r->kind) {
+        case PROC_MAP_HEAP:
+            r->score = SCORE_HEAP;
+            break;
+        case PROC_MAP_ARENA:
+            r->score = SCORE_ARENA;
+            break;
+        case PROC_MAP_ANON:
+            r->score = size >= PROC_MAPS_MIN_REGION_SIZE ? SCORE_ANON_LARGE : SCORE_ANON_SMALL;
+            break;
+        case PROC_MAP_FILE:
+            r->score = SCORE_FILE;
+            break;
+        case PROC_MAP_STACK:
+            r->score = SCORE_STACK;
+            break;
+        default:
+            r->score = SCORE_DROP;
+            break;
+        }
+    }
+}
+
+static int compare_region(const void *a, const void *b) {
+    const proc_map_region *ra = a;
+    const proc_map_region *rb = b;
+    if (ra->score != rb->score) {
+        return rb->score - ra->score;
+    }
+    return ra->start < rb->start ? -1 : ra->start > rb->start;
+}
+
+void proc_maps_rank(proc_map_table *table) {
+    classify(table);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < table->count; i++) {
+        if (table->items[i].score >= 0) {
+            table->items[kept++] = table->items[i];
+        }
+    }
+    table->count = kept;
+
+    qsort(table->items, table->count, sizeof(*table->items), compare_region);
+}
+
+void proc_maps_free(proc_map_table *table) {
+    free(table->items);
+    memset(table, 0, sizeof(*table));
+}
@@ -0,0 +1,66 @@
+// /proc/<pid>/maps 解析与扫描顺序排序 (Linux)
+//
+// 原来按文件顺序扫描所有 rw 区域，密钥所在的堆往往排在一堆库的数据段之后。
+// 这里先把 maps 解析成区域表，再按启发式打分排序：
+//   [heap] > glibc 线程 arena（rw 匿名映射后紧跟 ---p 预留区）> 1MB 以上的匿名映射
+//   > 小匿名映射 > 可写的文件映射
+// 栈、vdso/vvar 等特殊映射以及不可读写的区域直接丢弃。
+// 1MB 阈值与 Go 中 filterMemoryRegions 的 MinRegionSize 一致，
+// 小区域只是排到后面，不会被丢掉。
+
+#ifndef CHATLOG_PROC_MAPS_H
+#define CHATLOG_PROC_MAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define PROC_MAPS_PATH_MAX 256
+#define PROC_MAPS_MIN_REGION_SIZE (1024 * 1024)
+
+typedef enum {
+    PROC_MAP_HEAP,      // [heap]
+    PROC_MAP_ARENA,     // glibc 线程 arena
+    PROC_MAP_ANON,      // 其他匿名映射
+    PROC_MAP_FILE,      // 文件映射
+    PROC_MAP_STACK,     // [stack] / [stack:tid]
+    PROC_MAP_SPECIAL,   // [vdso] [vvar] [vsyscall] 等
+} proc_map_kind;
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    char perms[5];
+    uint64_t offset;
+    uint64_t inode;
+    char path[PROC_MAPS_PATH_MAX];
+    proc_map_kind kind;
+    int score;          // 越大越先扫描，< 0 表示丢弃
+} proc_map_region;
+
+typedef struct {
+    proc_map_region *items;
+    size_t count;
+    size_t cap;
+} proc_map_table;
+
+/**
+ * 解析 maps 中的一行
+ * @return 0 成功，-1 格式错误
+ */
+int proc_maps_parse_line(const char *line, proc_map_region *region);
+
+/**
+ * 读取并解析 /proc/<pid>/maps，保持文件顺序
+ * @return 0 成功，-1 失败
+ */
+int proc_maps_load(pid_t pid, proc_map_table *table);
+
+/**
+ * 为每个区域分类打分，丢弃不需要扫描的区域，并按扫描优先级排序
+ */
+void proc_maps_rank(proc_map_table *table);
+
+void proc_maps_free(proc_map_table *table);
+
+#endif // CHATLOG_PROC_MAPS_H
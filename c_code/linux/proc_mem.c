@@ -0,0 +1,160 @@
+// 目标进程内存读取实现，见 proc_mem.h
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "proc_mem.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+void proc_mem_open(proc_mem *m, pid_t pid) {
+    memset(m, 0, sizeof(*m));
+    m->pid = pid;
+    atomic_init(&m->use_pread, false);
+    m->page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/mem", (int)pid);
+    m->mem_fd = open(path, O_RDONLY | O_CLOEXEC);
+}
+
+void proc_mem_open_image(proc_mem *m, const mem_image *image) {
+    memset(m, 0, sizeof(*m));
+    m->mem_fd = -1;
+    atomic_init(&m->use_pread, false);
+    m->page_size = (size_t)sysconf(_SC_PAGESIZE);
+    m->image = image;
+}
+
+void proc_mem_close(proc_mem *m) {
+    if (m->mem_fd >= 0) {
+        close(m->mem_fd);
+        m->mem_fd = -1;
+    }
+}
+
+/**
+ * 从 pos 开始跳过当前页，补零
+ */
+static size_t skip_page(const proc_mem *m, proc_mem_range *r, size_t pos) {
+    size_t skip = m->page_size - (size_t)((r->addr + pos) % m->page_size);
+    if (skip > r->len - pos) {
+        skip = r->len - pos;
+    }
+    memset((unsigned char *)r->buf + pos, 0, skip);
+    return pos + skip;
+}
+
+/**
+ * 用 pread 读取一个区间的 [pos, len) 部分，读不到的页补零
+ */
+static void pread_range(proc_mem *m, proc_mem_range *r, size_t pos) {
+    while (pos < r->len) {
+        ssize_t n = -1;
+        if (m->mem_fd >= 0) {
+            n = pread(m->mem_fd, (unsigned char *)r->buf + pos, r->len - pos,
+                      (off_t)(r->addr + pos));
+        }
+        if (n > 0) {
+            pos += (size_t)n;
+            r->read += (size_t)n;
+            continue;
+        }
+        pos = skip_page(m, r, pos);
+    }
+}
+
+size_t proc_mem_readv(proc_mem *m, proc_mem_range *ranges, size_t n) {
+    struct iovec local[IOV_MAX];
+    struct iovec remote[IOV_MAX];
+    size_t total = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        ranges[i].read = 0;
+    }
+
+    if (m->image) {
+        for (size_t i = 0; i < n; i++) {
+            ranges[i].read = mem_image_copy(m->image, ranges[i].addr, ranges[i].buf, ranges[i].len);
+            total += ranges[i].read;
+        }
+        return total;
+    }
+
+    // idx/pos 指向下一个待读取的字节
+    size_t idx = 0;
+    size_t pos = 0;
+    while (idx < n) {
+        if (atomic_load_explicit(&m->use_pread, memory_order_relaxed)) {
+            size_t before = ranges[idx].read;
+            pread_range(m, &ranges[idx], pos);
+            total += ranges[idx].read - before;
+            idx++;
+            pos = 0;
+            continue;
+        }
+
+        size_t cnt = 0;
+        for (size_t i = idx; i < n && cnt < IOV_MAX; i++, cnt++) {
+            size_t skip = i == idx ? pos : 0;
+            local[cnt].iov_base = (unsigned char *)ranges[i].buf + skip;
+            local[cnt].iov_len = ranges[i].len - skip;
+            remote[cnt].iov_base = (void *)(uintptr_t)(ranges[i].addr + skip);
+            remote[cnt].iov_len = ranges[i].len - skip;
+        }
+
+        ssize_t got = process_vm_readv(m->pid, local, cnt, remote, cnt, 0);
+        if (got < 0 && (errno == ENOSYS || errno == EPERM)) {
+            // 系统调用不可用，之后全部走 /proc/<pid>/mem
+            atomic_store_explicit(&m->use_pread, true, memory_order_relaxed);
+            continue;
+        }
+        if (got < 0 && errno == ESRCH) {
+            // 目标进程已退出，剩余部分补零
+            for (; idx < n; idx++, pos = 0) {
+                memset((unsigned char *)ranges[idx].buf + pos, 0, ranges[idx].len - pos);
+            }
+            break;
+        }
+        if (got <= 0) {
+            // 第一个区间的当前页不可读，跳过这一页继续
+            pos = skip_page(m, &ranges[idx], pos);
+        }
+
+        // 按区间顺序分摊读到的字节数
+        size_t left = got > 0 ? (size_t)got : 0;
+        while (left > 0 && idx < n) {
+            size_t take = ranges[idx].len - pos < left ? ranges[idx].len - pos : left;
+            ranges[idx].read += take;
+            total += take;
+            pos += take;
+            left -= take;
+            if (pos == ranges[idx].len) {
+                idx++;
+                pos = 0;
+            }
+        }
+        if (idx < n && pos == ranges[idx].len) {
+            idx++;
+            pos = 0;
+        }
+    }
+
+    return total;
+}
+
+size_t proc_mem_read(proc_mem *m, uint64_t addr, void *buf, size_t len) {
+    proc_mem_range r = {addr, buf, len, 0};
+    return proc_mem_readv(m, &r, 1);
+}
@@ -0,0 +1,62 @@
+// 目标进程内存读取 (Linux)
+//
+// 优先使用 process_vm_readv，一次系统调用最多打包 IOV_MAX 个远端区间，
+// 微信进程里成千上万个小的可读写映射不再是一个映射一次系统调用。
+// 某个区间中途遇到未映射的页时只跳过该页并补零，其余区间继续读取。
+// process_vm_readv 不可用时（内核不支持、被 seccomp 拦截等）退回到
+// 对 /proc/<pid>/mem 的 pread，与 Go 中 V4Extractor.initMemoryFile 的做法一致。
+// 扫描离线内存镜像时改为从镜像拷贝（见 ../common/mem_image.h），调用方不用区分。
+
+#ifndef CHATLOG_PROC_MEM_H
+#define CHATLOG_PROC_MEM_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "mem_image.h"
+
+// 一个远端区间及其本地目标缓冲区
+typedef struct {
+    uint64_t addr;
+    void *buf;
+    size_t len;
+    size_t read;   // 输出：实际读到的字节数，未读到的页已补零
+} proc_mem_range;
+
+// 可以被多个线程共用
+typedef struct {
+    pid_t pid;
+    int mem_fd;            // /proc/<pid>/mem，未打开时为 -1
+    atomic_bool use_pread; // process_vm_readv 不可用，全部走 pread
+    size_t page_size;
+    const mem_image *image; // 不为NULL时从离线镜像读取，pid 和 mem_fd 不使用
+} proc_mem;
+
+/**
+ * 打开目标进程，同时打开 /proc/<pid>/mem 备用（打开失败不影响 process_vm_readv）
+ */
+void proc_mem_open(proc_mem *m, pid_t pid);
+
+/**
+ * 改为从离线镜像读取，镜像在 proc_mem_close 之前必须保持打开
+ */
+void proc_mem_open_image(proc_mem *m, const mem_image *image);
+
+void proc_mem_close(proc_mem *m);
+
+/**
+ * 批量读取多个远端区间，任意数量，内部按 IOV_MAX 分批
+ * @return 所有区间实际读到的总字节数
+ */
+size_t proc_mem_readv(proc_mem *m, proc_mem_range *ranges, size_t n);
+
+/**
+ * 读取单个区间，读不到的页补零
+ * @return 实际读到的字节数
+ */
+size_t proc_mem_read(proc_mem *m, uint64_t addr, void *buf, size_t len);
+
+#endif // CHATLOG_PROC_MEM_H
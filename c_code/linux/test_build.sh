@@ -39,29 +39,31 @@ fi
 echo ""
 echo "3. 尝试编译..."
 
-# 尝试编译
+# 尝试编译：两个平台都交给顶层 Makefile
 if [[ "$OSTYPE" == "darwin"* ]]; then
     # macOS 编译
-    gcc v4_testkey.c -o v4_testkey_test -O3 -I/opt/homebrew/include -L/opt/homebrew/lib -lcrypto
+    TARGET=c_code/darwin/v4_testkey
 else
     # Linux 编译
-    gcc v4_testkey_linux.c -o v4_testkey_linux -O3 -lcrypto
+    TARGET=c_code/linux/v4_testkey
 fi
+BINARY="$(dirname "$0")/../../$TARGET"
+make -C "$(dirname "$0")/../.." "$TARGET"
 
 if [ $? -eq 0 ]; then
     echo "✓ 编译成功!"
-    echo "生成的可执行文件: v4_testkey_test"
+    echo "生成的可执行文件: $TARGET"
     
     # 显示文件信息
-    if [ -f "v4_testkey_test" ]; then
+    if [ -f "$BINARY" ]; then
         echo ""
         echo "文件信息:"
-        ls -la v4_testkey_test
-        file v4_testkey_test
+        ls -la "$BINARY"
+        file "$BINARY"
         
         echo ""
         echo "使用方法:"
-        echo "  sudo ./v4_testkey_test <pid> <dbfile>"
+        echo "  sudo $TARGET <pid> <dbfile>"
         
         # 清理测试文件
 #        rm -f v4_testkey_test
@@ -1,14 +1,17 @@
 // Ubuntu版本的V4 testkey实现，与v4.go逻辑一致
-// 编译命令: gcc v4_testkey_linux.c -o v4_testkey_linux -O3 -lcrypto
+// 编译命令: gcc v4_testkey_linux.c ../common/candidate_filter.c ../common/candidate_list.c
+//              ../common/derived_keys.c ../common/key_cache.c ../common/key_hint.c ../common/key_offsets.c
+//              ../common/log.c ../common/mem_image.c ../common/pattern_scan.c
+//              ../common/region_stream.c ../common/scan_stats.c ../common/sha1.c ../common/sha512_mb.c
+//              ../common/v3_validate.c ../common/v4_validate.c proc_maps.c proc_mem.c
+//              -I../common -o v4_testkey_linux -O3 -lcrypto -pthread
 // 
 // 依赖安装 (Ubuntu/Debian):
 // sudo apt-get install build-essential libssl-dev
 //
 // 注意: 此代码专为Linux设计，使用OpenSSL和ptrace系统调用
 
-#include <openssl/evp.h>
-#include <openssl/hmac.h>
-#include <openssl/sha.h>
+#include <openssl/crypto.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,125 +19,169 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "candidate_filter.h"
+#include "candidate_list.h"
+#include "db_format.h"
+#include "db_page_v4.h"
+#include "derived_keys.h"
+#include "key_cache.h"
+#include "key_hint.h"
+#include "key_offsets.h"
+#include "log.h"
+#include "mem_image.h"
+#include "pattern_scan.h"
+#include "proc_maps.h"
+#include "proc_mem.h"
+#include "region_stream.h"
+#include "scan_stats.h"
+#include "sha512_mb.h"
+#include "v3_validate.h"
+#include "v4_validate.h"
 
 // Linux特有的头文件，只在Linux系统上包含
 #ifdef __linux__
 #include <sys/ptrace.h>
 #include <sys/wait.h>
-#include <sys/uio.h>
 #endif
 
-// V4版本常量 - 与Go代码中的常量保持一致
-#define V4_PAGE_SIZE 4096
-#define KEY_SIZE 32
-#define SALT_SIZE 16
-#define HMAC_SHA512_SIZE 64
-#define IV_SIZE 16
-#define AES_BLOCK_SIZE 16
-#define V4_ITER_COUNT 256000
+// V4版本常量 - 与Go代码中的常量保持一致，页布局见 db_format.h
+#define V4_PAGE_SIZE DB_V4_PAGE_SIZE
+#define KEY_SIZE DB_KEY_SIZE
+#define SALT_SIZE DB_SALT_SIZE
+#define HMAC_SHA512_SIZE DB_V4_HMAC_SIZE
+#define V4_ITER_COUNT DB_V4_ITER_COUNT
+
+// 每次特征码扫描最多取回的命中数
+#define SCAN_MAX_HITS 256
+// 特征码附近尝试的密钥偏移量，按命中次数排序，main 中读入后扫描期间只读
+// 流式读取的窗口重叠由 key_offsets_span 按最小和最大偏移算出
+static key_offset_table key_offsets;
+
+/**
+ * 每个数据库页一个的校验上下文
+ * salt、mac_salt 只计算一次；reserve、data_end 等页布局是编译期常量，
+ * HMAC 直接对页内数据计算，逐个候选校验时不再有堆分配
+ */
+typedef struct {
+    unsigned char salt[SALT_SIZE];
+    unsigned char mac_salt[SALT_SIZE];
+    const unsigned char *page;
+} testkey_ctx;
+
+/**
+ * 初始化校验上下文
+ * @param page 数据库第一页内容，上下文使用期间必须保持有效
+ */
+void testkey_ctx_init(testkey_ctx *ctx, const unsigned char *page) {
+    // 从第一页提取salt (前16字节)，生成MAC salt - salt XOR 0x3A
+    memcpy(ctx->salt, page, SALT_SIZE);
+    for (int i = 0; i < SALT_SIZE; i++) {
+        ctx->mac_salt[i] = ctx->salt[i] ^ DB_MAC_SALT_XOR;
+    }
+    ctx->page = page;
+}
 
 /**
- * PBKDF2-SHA512实现
+ * PBKDF2-SHA512实现，HMAC 的 ipad/opad 中间状态只算一次，每轮直接复用
  */
-int pbkdf2_sha512(const unsigned char *password, int password_len,
-                  const unsigned char *salt, int salt_len,
-                  int iterations, unsigned char *key, int key_len) {
-    return PKCS5_PBKDF2_HMAC((const char *)password, password_len,
-                             salt, salt_len, iterations,
-                             EVP_sha512(), key_len, key);
+static void pbkdf2_sha512(const unsigned char *password, const unsigned char *salt,
+                          int iterations, unsigned char *out) {
+    const unsigned char *passwords[1] = {password};
+    unsigned char *outs[1] = {out};
+    pbkdf2_hmac_sha512_batch(passwords, KEY_SIZE, salt, SALT_SIZE, iterations, outs, KEY_SIZE, 1);
 }
 
 /**
  * V4版本的testkey函数 - 与Go代码中的V4Decryptor.Validate逻辑完全一致
- * @param page 数据库第一页内容
+ * @param ctx 由 testkey_ctx_init 根据数据库第一页创建
  * @param key 待验证的密钥
+ * @param out_enc_key 验证成功时写出派生的加密密钥，可以为NULL
+ * @param out_mac_key 验证成功时写出派生的MAC密钥，可以为NULL
  * @return 密钥是否有效
  */
-bool testkey_v4(const unsigned char *page, const unsigned char *key) {
-    if (!page || !key) {
+bool testkey_v4_ctx(testkey_ctx *ctx, const unsigned char *key,
+                    unsigned char *out_enc_key, unsigned char *out_mac_key) {
+    if (!ctx || !key) {
         return false;
     }
 
-    // 1. 从第一页提取salt (前16字节)
-    unsigned char salt[SALT_SIZE];
-    memcpy(salt, page, SALT_SIZE);
-
-    // 2. 派生加密密钥 - 使用PBKDF2-SHA512，迭代256000次
+    // 1. 派生加密密钥 - 使用PBKDF2-SHA512，迭代256000次
     unsigned char enc_key[KEY_SIZE];
-    if (pbkdf2_sha512(key, KEY_SIZE, salt, SALT_SIZE, 
-                      V4_ITER_COUNT, enc_key, KEY_SIZE) != 1) {
-        return false;
-    }
+    pbkdf2_sha512(key, ctx->salt, V4_ITER_COUNT, enc_key);
 
-    // 3. 生成MAC salt - salt XOR 0x3A
-    unsigned char mac_salt[SALT_SIZE];
-    for (int i = 0; i < SALT_SIZE; i++) {
-        mac_salt[i] = salt[i] ^ 0x3A;
-    }
-
-    // 4. 派生MAC密钥 - 使用enc_key作为输入，迭代2次
+    // 2. 派生MAC密钥 - 使用enc_key作为输入，迭代2次
     unsigned char mac_key[KEY_SIZE];
-    if (pbkdf2_sha512(enc_key, KEY_SIZE, mac_salt, SALT_SIZE,
-                      2, mac_key, KEY_SIZE) != 1) {
-        return false;
-    }
+    pbkdf2_sha512(enc_key, ctx->mac_salt, DB_MAC_ITER_COUNT, mac_key);
 
-    // 5. 计算reserve大小
-    int reserve = IV_SIZE + HMAC_SHA512_SIZE;
-    if (reserve % AES_BLOCK_SIZE != 0) {
-        reserve = ((reserve / AES_BLOCK_SIZE) + 1) * AES_BLOCK_SIZE;
-    }
+    // 3. 计算HMAC-SHA512 - 从salt后开始到数据结束位置，再追加页码 (第一页 = 1，小端序)
+    unsigned char calculated_hmac[HMAC_SHA512_SIZE];
+    hmac_sha512_ctx hmac;
+    hmac_sha512_init(&hmac, mac_key, KEY_SIZE);
+    db_v4_page_mac(&hmac, ctx->page, 0, calculated_hmac);
 
-    // 6. 计算数据结束位置
-    int data_end = V4_PAGE_SIZE - reserve + IV_SIZE;
+    // 4. 提取存储的HMAC并比较
+    const unsigned char *stored_hmac = ctx->page + DB_V4_DATA_END;
 
-    // 7. 计算HMAC-SHA512 - 使用简化的HMAC接口
-    unsigned char calculated_hmac[HMAC_SHA512_SIZE];
-    unsigned int hmac_len = HMAC_SHA512_SIZE;
+    // 调试输出，-vv 时打开
+    log_trace("Reserve: %d, Data end: %d", DB_V4_RESERVE, DB_V4_DATA_END);
+    log_trace_hex("Calculated HMAC", calculated_hmac, HMAC_SHA512_SIZE);
+    log_trace_hex("Stored HMAC", stored_hmac, HMAC_SHA512_SIZE);
 
-    // 准备要计算HMAC的数据
-    size_t data_len = (data_end - SALT_SIZE) + 4; // 数据长度 + 页码长度
-    unsigned char *hmac_data = malloc(data_len);
-    if (!hmac_data) {
+    // 5. 比较HMAC值
+    if (CRYPTO_memcmp(calculated_hmac, stored_hmac, HMAC_SHA512_SIZE) != 0) {
         return false;
     }
 
-    // 8. 拷贝数据 - 从salt后开始到数据结束位置
-    memcpy(hmac_data, page + SALT_SIZE, data_end - SALT_SIZE);
-
-    // 9. 添加页码 (第一页 = 1，小端序)
-    unsigned char page_no[4] = {1, 0, 0, 0};  // 小端序的1
-    memcpy(hmac_data + (data_end - SALT_SIZE), page_no, 4);
+    if (out_enc_key) {
+        memcpy(out_enc_key, enc_key, KEY_SIZE);
+    }
+    if (out_mac_key) {
+        memcpy(out_mac_key, mac_key, KEY_SIZE);
+    }
+    return true;
+}
 
-    // 10. 计算HMAC-SHA512
-    unsigned char *result = HMAC(EVP_sha512(), mac_key, KEY_SIZE, 
-                                hmac_data, data_len, calculated_hmac, &hmac_len);
-    free(hmac_data);
-    
-    if (!result || hmac_len != HMAC_SHA512_SIZE) {
+/**
+ * 单次校验，内部临时初始化上下文；逐个校验大量候选时应当复用 testkey_ctx
+ */
+bool testkey_v4(const unsigned char *page, const unsigned char *key) {
+    if (!page || !key) {
         return false;
     }
+    testkey_ctx ctx;
+    testkey_ctx_init(&ctx, page);
+    return testkey_v4_ctx(&ctx, key, NULL, NULL);
+}
 
-    // 11. 提取存储的HMAC并比较
-    const unsigned char *stored_hmac = page + data_end;
-    
-    // 调试输出（可选）
-//    #ifdef DEBUG
-    printf("Reserve: %d, Data end: %d\n", reserve, data_end);
-    printf("Calculated HMAC: ");
-    for (int i = 0; i < HMAC_SHA512_SIZE; i++) {
-        printf("%02x", calculated_hmac[i]);
+/**
+ * 带缓存的testkey_v4，重复出现的候选直接使用缓存结论
+ * @param cache 派生结果缓存，为NULL时不使用缓存
+ */
+bool testkey_v4_cached(key_cache *cache, testkey_ctx *ctx, const unsigned char *key) {
+    if (!cache) {
+        return testkey_v4_ctx(ctx, key, NULL, NULL);
     }
-    printf("\n");
-    printf("Stored HMAC: ");
-    for (int i = 0; i < HMAC_SHA512_SIZE; i++) {
-        printf("%02x", stored_hmac[i]);
+
+    switch (key_cache_lookup(cache, key, NULL, NULL)) {
+    case KEY_CACHE_GOOD:
+        return true;
+    case KEY_CACHE_BAD:
+        return false;
+    default:
+        break;
     }
-    printf("\n");
-//    #endif
 
-    // 12. 比较HMAC值
-    return memcmp(calculated_hmac, stored_hmac, HMAC_SHA512_SIZE) == 0;
+    unsigned char enc_key[KEY_SIZE];
+    unsigned char mac_key[KEY_SIZE];
+    bool ok = testkey_v4_ctx(ctx, key, enc_key, mac_key);
+    key_cache_store(cache, key, ok, enc_key, mac_key);
+    return ok;
 }
 
 /**
@@ -146,207 +193,1384 @@ bool testkey_v4(const unsigned char *page, const unsigned char *key) {
 bool testkey(const unsigned char *page, const unsigned char *key) {
     // 先尝试V4版本
     if (testkey_v4(page, key)) {
-        printf("Key validated with V4 algorithm\n");
+        log_debug("Key validated with V4 algorithm");
         return true;
     }
     
-    // 如果V4失败，可以在这里添加V3的fallback逻辑
-    printf("Key validation failed with V4 algorithm\n");
+    // V4失败时再按V3校验，只需要2轮PBKDF2-HMAC-SHA1
+    if (testkey_v3(page, key)) {
+        log_debug("Key validated with V3 algorithm");
+        return true;
+    }
+    log_debug("Key validation failed with V4 and V3 algorithms");
     return false;
 }
 
+// 找到的密钥及其位置
+typedef struct {
+    char key[KEY_SIZE * 2 + 1];
+    uint64_t tag; // key_hint_tag，用来记录位置提示
+} scan_result;
+
+static int stream_read(void *ctx, uint64_t addr, void *buf, size_t len) {
+    // 读不到的页已补零，只要读到了内容就照常扫描
+    return proc_mem_read(ctx, addr, buf, len) > 0 ? 0 : -1;
+}
+
+/**
+ * 扫描一个窗口，命中的候选加入批次
+ * @param collect 不为NULL时候选只拷贝进列表，留到目标进程恢复运行后再校验
+ * @return 已经找到有效密钥时返回 true
+ */
+static bool scan_window(v4_candidate_batch *batch, candidate_filter *filter,
+                        candidate_list *collect, const region_window *w) {
+    // 只接受起点落在本窗口负责范围内的特征码，重叠部分留给相邻窗口
+    size_t limit = w->len - w->scan_end > PATTERN_SCAN_LEN - 1
+                       ? w->scan_end + PATTERN_SCAN_LEN - 1
+                       : w->len;
+    size_t hits[SCAN_MAX_HITS];
+    size_t pos = w->scan_begin;
+    while (!batch->found && pos + PATTERN_SCAN_LEN <= limit) {
+        size_t n = pattern_scan(w->data, limit, pos, v4_key_pattern, hits, SCAN_MAX_HITS, &pos);
+        SCAN_STATS_ADD(batch->stats, pattern_hits, n);
+        for (size_t h = 0; h < n && !batch->found; h++) {
+            log_trace("Pattern hit at 0x%llx", (unsigned long long)(w->addr + hits[h]));
+            for (size_t j = 0; j < key_offsets.count; j++) {
+                uint64_t tag = key_hint_tag(w->addr + hits[h], key_offsets.offsets[j]);
+                long key_offset = (long)hits[h] + key_offsets.offsets[j];
+
+                // 检查边界
+                if (key_offset < 0 || key_offset + KEY_SIZE > (long)w->len) {
+                    continue;
+                }
+
+                // 先过廉价的预过滤，明显不是密钥的候选不进入PBKDF2
+                if (!candidate_filter_accept(filter, w->data + key_offset, j)) {
+                    continue;
+                }
+
+                if (collect) {
+                    // 内存不足时丢弃该候选，与读不到的页一样按未命中处理
+                    candidate_list_push(collect, w->data + key_offset, tag);
+                    continue;
+                }
+                if (v4_batch_add_tagged(batch, w->data + key_offset, tag)) {
+                    break;
+                }
+            }
+        }
+    }
+    return batch->found;
+}
+
+/**
+ * 校验批次中剩余的候选，找到时把密钥转换为十六进制字符串
+ */
+static int finish_batch(v4_candidate_batch *batch, scan_result *out) {
+    if (!v4_batch_flush(batch)) {
+        return -1;
+    }
+    for (int k = 0; k < KEY_SIZE; k++) {
+        sprintf(out->key + k * 2, "%02x", batch->key[k]);
+    }
+    out->key[KEY_SIZE * 2] = '\0';
+    out->tag = batch->tag;
+    log_debug("Key validated with %s algorithm", db_format_name(batch->format));
+    return 0;
+}
+
+/**
+ * 搜索进程内存中的密钥模式
+ * @param stream 分块读取器，每个工作线程一个，缓冲区在区域之间复用
+ * @param collect 不为NULL时只收集候选，不做校验，总是返回-1
+ * @param formats 要尝试的 DB_FORMAT_* 组合
+ * @param cancel 其他线程找到密钥后置位，为NULL时不检查
+ * @param stats 扫描统计，可以为NULL
+ */
+int search_memory_region(region_stream *stream, unsigned long start, unsigned long end,
+                        const unsigned char *page, unsigned formats, key_cache *cache,
+                        candidate_filter *filter, candidate_list *collect, atomic_bool *cancel,
+                        scan_stats *stats, scan_result *out) {
+    // 候选先攒成一批，再用多路PBKDF2统一校验
+    v4_candidate_batch batch;
+    v4_batch_init(&batch, page, cache);
+    batch.stats = stats;
+    batch.formats = formats;
+
+    uint64_t bytes_read = stream->bytes_read;
+    uint64_t failed_windows = stream->failed_windows;
+    bool canceled = false;
+    region_window w;
+    region_stream_begin(stream, start, end);
+    while (region_stream_next(stream, &w)) {
+        // 每个窗口检查一次是否已被其他线程取消
+        if (cancel && atomic_load_explicit(cancel, memory_order_relaxed)) {
+            canceled = true;
+            break;
+        }
+        if (scan_window(&batch, filter, collect, &w)) {
+            break;
+        }
+    }
+
+    bytes_read = stream->bytes_read - bytes_read;
+    SCAN_STATS_ADD(stats, bytes_read, bytes_read);
+    SCAN_STATS_ADD(stats, read_errors, stream->failed_windows - failed_windows);
+    if (bytes_read > 0) {
+        SCAN_STATS_ADD(stats, regions_scanned, 1);
+    } else if (!canceled) {
+        SCAN_STATS_SKIP(stats, SCAN_SKIP_UNREADABLE, 1);
+    }
+    return canceled ? -1 : finish_batch(&batch, out);
+}
+
+// 扫描期间目标进程的暂停方式
+typedef enum {
+    SCAN_STOP_SNAPSHOT, // 暂停期间只收集候选，恢复运行后再校验
+    SCAN_STOP_FULL,     // 整个扫描和校验期间都保持暂停
+    SCAN_STOP_NONE,     // 不暂停，只依赖 process_vm_readv 的读权限
+} scan_stop_mode;
+
+// 扫描参数
+typedef struct {
+    const char *cache_dir; // 磁盘缓存目录，为NULL时只使用进程内缓存
+    const char *key_store; // 派生密钥存储文件，为NULL时不写出
+    const char *stats;     // 统计输出文件，"-" 表示 stderr，为NULL时不输出
+    int jobs;              // 扫描线程数，<= 0 时使用在线CPU数
+    unsigned progress_ms;  // 进度输出间隔，0 表示不输出
+    scan_stop_mode stop;
+    unsigned formats;      // 要尝试的 DB_FORMAT_* 组合
+    const char *hints;     // 密钥位置提示文件，为NULL时不使用
+    const char *app_version; // 微信版本，为NULL时用可执行文件的大小和修改时间代替
+    const char *offsets;   // 偏移表文件，为NULL时使用默认偏移表且不记录命中
+    int sweep;             // > 0 时额外尝试 ±sweep 字节内每个 8 字节对齐的偏移
+    const char *image;     // 离线内存镜像，不为NULL时不读取目标进程
+    const char *batch;     // 批量模式的目标清单，每行 "pid 数据库 [数据库...]"
+} scan_options;
+
+typedef struct {
+    unsigned long start;
+    unsigned long end;
+    size_t target;     // 所属目标在 scan_context.targets 中的下标
+} scan_region;
+
+// 与 Linux 的 IOV_MAX 一致，一次最多把这么多个小区域打包进一次 process_vm_readv
+#define REGION_QUEUE_CAPACITY 1024
+#define SCAN_BATCH_MAX_REGIONS REGION_QUEUE_CAPACITY
+// 小区域批量读取的本地缓冲区大小，超过它的区域走分块流式读取
+#define SCAN_BATCH_BYTES REGION_STREAM_DEFAULT_CHUNK
+
+/**
+ * 有界区域队列：一个生产者枚举/proc/pid/maps，多个工作线程取区域扫描
+ * 与Go中V4Extractor.Extract的producer/worker结构一致；批量模式下所有目标的区域进同一个队列
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    scan_region items[REGION_QUEUE_CAPACITY];
+    size_t head;
+    size_t count;
+    bool closed;
+} region_queue;
+
+static void region_queue_init(region_queue *q) {
+    memset(q, 0, sizeof(*q));
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+}
+
+static void region_queue_destroy(region_queue *q) {
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+}
+
+/**
+ * 放入一个区域，队列满时阻塞
+ * @return 队列已关闭（扫描被取消）时返回false
+ */
+static bool region_queue_push(region_queue *q, scan_region region) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == REGION_QUEUE_CAPACITY && !q->closed) {
+        pthread_cond_wait(&q->not_full, &q->lock);
+    }
+    if (q->closed) {
+        pthread_mutex_unlock(&q->lock);
+        return false;
+    }
+    q->items[(q->head + q->count) % REGION_QUEUE_CAPACITY] = region;
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+    return true;
+}
+
+/**
+ * 取出一批区域，队列空时阻塞
+ * 第一个区域不小于 max_bytes 时单独返回；否则继续取出后续属于同一目标的小区域，
+ * 直到总大小达到 max_bytes、数量达到 max 或遇到另一个目标的区域
+ * @return 取出的区域数，队列已关闭且为空时返回0
+ */
+static size_t region_queue_pop_batch(region_queue *q, scan_region *regions, size_t max,
+                                     size_t max_bytes) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && !q->closed) {
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+
+    size_t n = 0;
+    size_t bytes = 0;
+    while (q->count > 0 && n < max) {
+        scan_region region = q->items[q->head];
+        size_t size = region.end - region.start;
+        if (n > 0 && (size >= max_bytes || bytes + size > max_bytes ||
+                      region.target != regions[0].target)) {
+            break;
+        }
+        regions[n++] = region;
+        bytes += size;
+        q->head = (q->head + 1) % REGION_QUEUE_CAPACITY;
+        q->count--;
+        if (size >= max_bytes) {
+            break;
+        }
+    }
+    if (n > 0) {
+        pthread_cond_broadcast(&q->not_full);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+/**
+ * 关闭队列：生产者结束时调用，工作线程取完剩余区域后退出
+ * discard为true时丢弃未处理的区域（找到密钥后取消扫描）
+ */
+static void region_queue_close(region_queue *q, bool discard) {
+    pthread_mutex_lock(&q->lock);
+    q->closed = true;
+    if (discard) {
+        q->count = 0;
+    }
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_cond_broadcast(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+}
+
+/**
+ * 用一次（或少数几次）scatter-gather 读取多个小区域后逐个搜索
+ * @param arena 本地缓冲区，至少容纳所有区域的总大小
+ */
+int search_memory_batch(proc_mem *mem, unsigned char *arena,
+                        const scan_region *regions, size_t n,
+                        const unsigned char *page, unsigned formats, key_cache *cache,
+                        candidate_filter *filter, candidate_list *collect, atomic_bool *cancel,
+                        scan_stats *stats, scan_result *out) {
+    proc_mem_range ranges[SCAN_BATCH_MAX_REGIONS];
+    size_t off = 0;
+    for (size_t i = 0; i < n; i++) {
+        ranges[i].addr = regions[i].start;
+        ranges[i].buf = arena + off;
+        ranges[i].len = regions[i].end - regions[i].start;
+        off += ranges[i].len;
+    }
+    proc_mem_readv(mem, ranges, n);
+
+    for (size_t i = 0; i < n; i++) {
+        SCAN_STATS_ADD(stats, bytes_read, ranges[i].read);
+        if (ranges[i].read < ranges[i].len) {
+            SCAN_STATS_ADD(stats, read_errors, 1);
+        }
+        if (ranges[i].read > 0) {
+            SCAN_STATS_ADD(stats, regions_scanned, 1);
+        } else {
+            SCAN_STATS_SKIP(stats, SCAN_SKIP_UNREADABLE, 1);
+        }
+    }
+
+    if (cancel && atomic_load_explicit(cancel, memory_order_relaxed)) {
+        return -1;
+    }
+
+    // 每个区域单独作为一个窗口，候选不会跨越区域边界
+    v4_candidate_batch batch;
+    v4_batch_init(&batch, page, cache);
+    batch.stats = stats;
+    batch.formats = formats;
+    for (size_t i = 0; i < n; i++) {
+        if (ranges[i].read == 0) {
+            continue;
+        }
+        region_window w = {ranges[i].buf, ranges[i].len, ranges[i].addr, 0, ranges[i].len};
+        if (scan_window(&batch, filter, collect, &w)) {
+            break;
+        }
+    }
+
+    return finish_batch(&batch, out);
+}
+
+/**
+ * 一个目标进程及其数据库，批量模式下多个目标共用一组工作线程和预过滤
+ * 候选只按本进程的数据库校验，找到密钥后本进程剩余的区域不再扫描
+ */
+typedef struct {
+    pid_t pid;
+    char **dbfiles;               // 候选按第一个数据库校验，其余的用找到的密钥确认
+    size_t dbcount;
+    unsigned char page[V4_PAGE_SIZE];
+    key_cache *cache;
+    proc_mem mem;                 // 目标进程内存，所有工作线程共用
+    proc_map_table maps;          // 按扫描优先级排序
+    char version[KEY_HINT_VERSION_SIZE];
+    bool stopped;                 // 已被 PTRACE_ATTACH 暂停
+    struct timespec stop_begin;
+    atomic_bool done;             // 找到密钥或放弃这个目标后置位，剩余区域跳过
+    bool found;
+    scan_result result;
+    // 两阶段扫描：工作线程收集的候选按扫描顺序汇总到这里
+    candidate_list candidates;
+    atomic_size_t next_candidate; // 离线校验阶段下一个待取的候选下标
+} scan_target;
+
+typedef struct {
+    scan_target *targets;
+    size_t target_count;
+    unsigned formats;             // 要尝试的 DB_FORMAT_* 组合
+    scan_stats *stats;            // 可以为NULL
+    region_queue queue;
+    atomic_bool cancel;           // 所有目标都找到密钥或扫描线程分配失败后置位
+    atomic_size_t pending;        // 还没有找到密钥的目标数
+    pthread_mutex_t result_lock;  // 保护各目标的 found/result/candidates 和 filter
+    bool stream;                  // 批量模式：每找到一个密钥立即输出到 stdout
+    candidate_filter filter;      // 各线程预过滤统计的汇总
+    bool collect;                 // 两阶段扫描：工作线程只收集候选
+    // 进度统计，工作线程每处理完一批区域累加一次
+    log_progress progress;
+    size_t total_regions;
+    uint64_t total_bytes;
+    atomic_size_t done_regions;
+    _Atomic uint64_t done_bytes;
+    _Atomic uint64_t candidates_seen; // 通过预过滤的候选数
+} scan_context;
+
+/**
+ * 记录一个目标找到的密钥，所有目标都找到后取消其余线程和生产者
+ */
+static void target_found(scan_context *ctx, scan_target *t, const scan_result *result) {
+    bool first = false;
+    pthread_mutex_lock(&ctx->result_lock);
+    if (!t->found) {
+        t->found = true;
+        t->result = *result;
+        first = true;
+        if (ctx->stream) {
+            printf("Found key for %d: %s\n", t->pid, result->key);
+            fflush(stdout);
+        }
+    }
+    pthread_mutex_unlock(&ctx->result_lock);
+    atomic_store(&t->done, true);
+    if (!first) {
+        return;
+    }
+    scan_stats_key_found(ctx->stats);
+    if (atomic_fetch_sub(&ctx->pending, 1) == 1) {
+        atomic_store(&ctx->cancel, true);
+        region_queue_close(&ctx->queue, true);
+    }
+}
+
+/**
+ * 累加一批区域的进度，到了输出间隔时打印一行汇总
+ */
+static void report_progress(scan_context *ctx, const scan_region *regions, size_t n,
+                            uint64_t candidates) {
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < n; i++) {
+        bytes += regions[i].end - regions[i].start;
+    }
+    size_t done_regions = atomic_fetch_add(&ctx->done_regions, n) + n;
+    uint64_t done_bytes = atomic_fetch_add(&ctx->done_bytes, bytes) + bytes;
+    uint64_t total = atomic_fetch_add(&ctx->candidates_seen, candidates) + candidates;
+
+    if (log_progress_due(&ctx->progress)) {
+        log_info("Progress: %zu/%zu regions, %llu/%llu MB, %llu candidates",
+                 done_regions, ctx->total_regions, (unsigned long long)(done_bytes >> 20),
+                 (unsigned long long)(ctx->total_bytes >> 20), (unsigned long long)total);
+    }
+}
+
+static void *scan_worker(void *arg) {
+    scan_context *ctx = arg;
+    scan_region regions[SCAN_BATCH_MAX_REGIONS];
+    scan_result result;
+
+    // 大区域分块流式读取，小区域批量读进 arena
+    region_stream stream;
+    unsigned char *arena = malloc(SCAN_BATCH_BYTES);
+    candidate_filter *filter = malloc(sizeof(*filter));
+    candidate_list local;
+    candidate_list_init(&local);
+    candidate_list *collect = ctx->collect ? &local : NULL;
+    if (filter) {
+        candidate_filter_init(filter);
+    }
+    size_t back, fwd;
+    key_offsets_span(&key_offsets, &back, &fwd);
+    if (!arena || !filter || region_stream_init(&stream, 0, back, fwd, stream_read, NULL) != 0) {
+        log_error("Failed to allocate scan buffers");
+        free(arena);
+        free(filter);
+        atomic_store(&ctx->cancel, true);
+        region_queue_close(&ctx->queue, true);
+        return NULL;
+    }
+
+    size_t n;
+    size_t current = SIZE_MAX;
+    while ((n = region_queue_pop_batch(&ctx->queue, regions, SCAN_BATCH_MAX_REGIONS,
+                                       SCAN_BATCH_BYTES)) > 0) {
+        if (atomic_load(&ctx->cancel)) {
+            break;
+        }
+
+        // 一批区域总是属于同一个目标；已经找到密钥的目标跳过，计入 canceled
+        scan_target *t = &ctx->targets[regions[0].target];
+        if (atomic_load(&t->done)) {
+            continue;
+        }
+        if (regions[0].target != current) {
+            current = regions[0].target;
+            stream.ctx = &t->mem;
+            candidate_filter_reset_dedup(filter);
+        }
+
+        uint64_t passed = filter->passed;
+        int ret;
+        if (n == 1 && regions[0].end - regions[0].start >= SCAN_BATCH_BYTES) {
+            ret = search_memory_region(&stream, regions[0].start, regions[0].end, t->page,
+                                       ctx->formats, t->cache, filter, collect, &t->done, ctx->stats, &result);
+        } else {
+            ret = search_memory_batch(&t->mem, arena, regions, n, t->page,
+                                      ctx->formats, t->cache, filter, collect, &t->done, ctx->stats, &result);
+        }
+        report_progress(ctx, regions, n, filter->passed - passed);
+        if (collect && local.count > 0) {
+            // 每批区域汇总一次，目标的列表大致保持区域的优先级顺序
+            pthread_mutex_lock(&ctx->result_lock);
+            if (!candidate_list_append(&t->candidates, &local)) {
+                log_warn("Out of memory, dropped %zu candidates", local.count);
+            }
+            pthread_mutex_unlock(&ctx->result_lock);
+            candidate_list_clear(&local);
+        }
+        if (ret == 0) {
+            target_found(ctx, t, &result);
+        }
+    }
+    pthread_mutex_lock(&ctx->result_lock);
+    candidate_filter_merge(&ctx->filter, filter);
+    pthread_mutex_unlock(&ctx->result_lock);
+
+    region_stream_destroy(&stream);
+    candidate_list_free(&local);
+    free(arena);
+    free(filter);
+    return NULL;
+}
+
+/**
+ * 离线校验阶段的工作线程：按目标顺序每次取一批候选，用多路PBKDF2校验
+ * 每个目标的候选只按这个目标的数据库校验
+ */
+static void *validate_worker(void *arg) {
+    scan_context *ctx = arg;
+    scan_result result;
+
+    for (size_t i = 0; i < ctx->target_count && !atomic_load(&ctx->cancel); i++) {
+        scan_target *t = &ctx->targets[i];
+        size_t total = t->candidates.count;
+        while (!atomic_load(&t->done)) {
+            size_t begin = atomic_fetch_add(&t->next_candidate, V4_VALIDATE_BATCH_SIZE);
+            if (begin >= total) {
+                break;
+            }
+            size_t end = begin + V4_VALIDATE_BATCH_SIZE < total ? begin + V4_VALIDATE_BATCH_SIZE : total;
+
+            v4_candidate_batch batch;
+            v4_batch_init(&batch, t->page, t->cache);
+            batch.stats = ctx->stats;
+            batch.formats = ctx->formats;
+            for (size_t j = begin; j < end && !v4_batch_add_tagged(&batch, t->candidates.keys[j],
+                                                                  t->candidates.tags[j]); j++) {
+            }
+            if (finish_batch(&batch, &result) == 0) {
+                target_found(ctx, t, &result);
+                break;
+            }
+
+            if (log_progress_due(&ctx->progress)) {
+                log_info("Progress: %zu/%zu candidates validated", end, total);
+            }
+        }
+    }
+    return NULL;
+}
+
 /**
- * 读取进程内存 - 仅在Linux上可用
+ * 启动 jobs 个工作线程
+ * @return 实际启动的线程数
  */
-int read_process_memory(pid_t pid, unsigned long addr, void *buffer, size_t size) {
+static int start_workers(pthread_t *workers, int jobs, void *(*fn)(void *), void *arg) {
+    int started = 0;
+    for (int i = 0; workers && i < jobs; i++) {
+        int rc = pthread_create(&workers[i], NULL, fn, arg);
+        if (rc != 0) {
+            log_error("Failed to start worker thread: %s", strerror(rc));
+            break;
+        }
+        started++;
+    }
+    return started;
+}
+
+static double elapsed_ms(const struct timespec *since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1e3 + (now.tv_nsec - since->tv_nsec) / 1e6;
+}
+
 #ifdef __linux__
-    struct iovec local[1];
-    struct iovec remote[1];
-    
-    local[0].iov_base = buffer;
-    local[0].iov_len = size;
-    remote[0].iov_base = (void *)addr;
-    remote[0].iov_len = size;
-    
-    ssize_t bytes_read = process_vm_readv(pid, local, 1, remote, 1, 0);
-    return (bytes_read == (ssize_t)size) ? 0 : -1;
-#else
-    fprintf(stderr, "Error: Memory reading is only supported on Linux\n");
-    return -1;
+/**
+ * 解除对目标进程的暂停并报告暂停时长，未暂停时什么都不做
+ */
+static void resume_target(pid_t pid, bool *stopped, const struct timespec *since) {
+    if (!*stopped) {
+        return;
+    }
+    ptrace(PTRACE_DETACH, pid, NULL, NULL);
+    *stopped = false;
+    log_info("Target process was stopped for %.1f ms", elapsed_ms(since));
+}
 #endif
+
+/**
+ * 把找到的密钥对这个数据库的派生结果写入派生密钥存储，之后 v4_decrypt -k 和
+ * chatlog 服务解密这个数据库时不用再跑一遍 PBKDF2
+ * 派生结果在校验时已经存进 key_cache，缓存不可用时才重新派生
+ */
+static void remember_derived_keys(const char *path, key_cache *cache, const unsigned char *page,
+                                  const char *hexkey) {
+    unsigned char key[KEY_SIZE];
+    for (int i = 0; i < KEY_SIZE; i++) {
+        unsigned int b;
+        if (sscanf(hexkey + i * 2, "%2x", &b) != 1) {
+            return;
+        }
+        key[i] = (unsigned char)b;
+    }
+
+    // 派生密钥存储只记录 V4 的 256000 轮派生结果，V3 的派生本来就只有 2 轮
+    if (testkey_v3(page, key)) {
+        log_info("Key belongs to a V3 database, nothing to save to %s", path);
+        return;
+    }
+
+    unsigned char enc_key[KEY_SIZE];
+    unsigned char mac_key[KEY_SIZE];
+    if (key_cache_lookup(cache, key, enc_key, mac_key) != KEY_CACHE_GOOD) {
+        testkey_ctx ctx;
+        testkey_ctx_init(&ctx, page);
+        if (!testkey_v4_ctx(&ctx, key, enc_key, mac_key)) {
+            return;
+        }
+    }
+
+    derived_keys *store = derived_keys_open(path);
+    derived_keys_put(store, DERIVED_KEYS_KDF_V4, key, page, enc_key, mac_key);
+    if (store && derived_keys_save(store) == 0) {
+        log_info("Saved derived keys to %s", path);
+    }
+    derived_keys_close(store);
+    memset(key, 0, sizeof(key));
+    memset(enc_key, 0, sizeof(enc_key));
+    memset(mac_key, 0, sizeof(mac_key));
 }
 
+#ifdef __linux__
 /**
- * 搜索进程内存中的密钥模式
+ * 读取区域表，保持地址顺序：扫描离线镜像时由镜像的区域转换，否则读 /proc/<pid>/maps
+ * 镜像里文件映射的路径照搬，其余都按匿名映射处理（清单中的 MALLOC_NANO 之类只是名称）
+ * @return 0 成功，-1 失败
  */
-int search_memory_region(pid_t pid, unsigned long start, unsigned long end, 
-                        const unsigned char *page, char *outkey) {
-    unsigned char *buffer;
-    size_t region_size = end - start;
-    
-    // 限制搜索区域大小，避免内存过大
-    if (region_size > 100 * 1024 * 1024) { // 100MB限制
+static int load_maps(pid_t pid, const mem_image *image, proc_map_table *maps) {
+    if (!image) {
+        return proc_maps_load(pid, maps);
+    }
+    memset(maps, 0, sizeof(*maps));
+    maps->items = calloc(image->count, sizeof(proc_map_region));
+    if (!maps->items) {
         return -1;
     }
-    
-    buffer = malloc(region_size);
-    if (!buffer) {
+    for (size_t i = 0; i < image->count; i++) {
+        const mem_image_region *src = &image->items[i];
+        proc_map_region *r = &maps->items[i];
+        r->start = src->start;
+        r->end = src->end;
+        memcpy(r->perms, src->perms, sizeof(r->perms));
+        if (src->name[0] == '/' || src->name[0] == '[') {
+            snprintf(r->path, sizeof(r->path), "%s", src->name);
+        }
+    }
+    maps->count = maps->cap = image->count;
+    return 0;
+}
+
+static void open_mem(proc_mem *mem, pid_t pid, const mem_image *image) {
+    if (image) {
+        proc_mem_open_image(mem, image);
+    } else {
+        proc_mem_open(mem, pid);
+    }
+}
+
+/**
+ * 微信版本：优先使用 --app-version（Go 侧由 pkg/appver 取得），
+ * 否则用可执行文件的大小和修改时间代替，升级之后旧的提示自然不再匹配
+ */
+static void app_version_of(pid_t pid, const mem_image *image, const char *given, char *out,
+                           size_t len) {
+    if (given || image) {
+        // 离线镜像没有可执行文件可看，只按 --app-version 区分
+        snprintf(out, len, "%s", given ? given : "");
+        return;
+    }
+    char path[64];
+    struct stat st;
+    snprintf(path, sizeof(path), "/proc/%d/exe", pid);
+    if (stat(path, &st) == 0) {
+        snprintf(out, len, "exe:%llx-%llx", (unsigned long long)st.st_size,
+                 (unsigned long long)st.st_mtime);
+    } else {
+        out[0] = '\0';
+    }
+}
+
+/**
+ * 在区域表中找到密钥所在的区域，记录一条位置提示
+ */
+static void record_hint(key_hint_store *hints, const char *version, const proc_map_table *maps,
+                        uint64_t tag) {
+    uint64_t addr = key_hint_tag_addr(tag);
+    for (size_t i = 0; hints && tag && i < maps->count; i++) {
+        const proc_map_region *r = &maps->items[i];
+        if (addr >= r->start && addr < r->end) {
+            key_hint_region region = {r->start, r->end, r->kind};
+            key_hint_record(hints, version, &region, tag);
+            log_debug("Recorded key location: %s region +0x%llx",
+                      r->path[0] ? r->path : "anonymous", (unsigned long long)(addr - r->start));
+            return;
+        }
+    }
+}
+
+/**
+ * 记录找到的密钥相对特征码的偏移：写进统计，指定了 -O 时累加到偏移表文件
+ */
+static void record_key_offset(const scan_options *opts, scan_stats *stats, uint64_t tag) {
+    if (tag == 0) {
+        return;
+    }
+    int offset = key_hint_tag_key_offset(tag);
+    scan_stats_key_offset(stats, offset);
+    log_debug("Key found at offset %+d from the pattern", offset);
+    if (opts->offsets) {
+        key_offsets_record_hit(&key_offsets, offset);
+        key_offsets_save(&key_offsets, opts->offsets);
+    }
+}
+
+/**
+ * 先只读位置提示指向的几个地址，命中就不用完整扫描
+ * 密钥对象在进程里长期存在，这一步不暂停目标进程
+ * @return 0 找到，-1 没有命中
+ */
+static int probe_hints(pid_t pid, const mem_image *image, key_hint_store *hints,
+                       const char *version, const unsigned char *page, unsigned formats,
+                       key_cache *cache, scan_stats *stats, scan_result *out) {
+    proc_map_table maps;
+    if (hints->count == 0 || load_maps(pid, image, &maps) != 0) {
         return -1;
     }
-    
-    if (read_process_memory(pid, start, buffer, region_size) != 0) {
-        free(buffer);
+    proc_maps_rank(&maps);
+
+    key_hint_region *regions = malloc((maps.count ? maps.count : 1) * sizeof(*regions));
+    if (!regions) {
+        proc_maps_free(&maps);
         return -1;
     }
-    
-    // 密钥搜索模式
-    unsigned char pattern[8] = {0x20, 0x66, 0x74, 0x73, 0x35, 0x28, 0x25, 0x00};
-    
-    for (size_t i = 0; i <= region_size - sizeof(pattern); i++) {
-        if (memcmp(buffer + i, pattern, sizeof(pattern)) == 0) {
-         printf("11111111\n");
-            // 尝试不同的偏移量
-            int offsets[] = {16, -80, 64, -16, 32, -32};
-            int num_offsets = sizeof(offsets) / sizeof(offsets[0]);
-            
-            for (int j = 0; j < num_offsets; j++) {
-                long key_offset = (long)i + offsets[j];
-                
-                // 检查边界
-                if (key_offset < 0 || key_offset + KEY_SIZE > (long)region_size) {
-                    continue;
-                }
-                
-                unsigned char *key = buffer + key_offset;
-                
-                // 测试密钥
-                if (testkey_v4(page, key)) {
-                    // 找到有效密钥，转换为十六进制字符串
-                    for (int k = 0; k < KEY_SIZE; k++) {
-                        sprintf(outkey + k * 2, "%02x", key[k]);
-                    }
-                    outkey[KEY_SIZE * 2] = '\0';
-                    
-                    free(buffer);
-                    return 0;
-                }
-            }
-        }
+    for (size_t i = 0; i < maps.count; i++) {
+        regions[i] = (key_hint_region){maps.items[i].start, maps.items[i].end, maps.items[i].kind};
     }
-    
-    free(buffer);
-    return -1;
+
+    proc_mem mem;
+    open_mem(&mem, pid, image);
+    candidate_list candidates;
+    candidate_list_init(&candidates);
+    key_hint_collect(hints, version, regions, maps.count, stream_read, &mem, &candidates);
+    proc_mem_close(&mem);
+    free(regions);
+
+    v4_candidate_batch batch;
+    v4_batch_init(&batch, page, cache);
+    batch.stats = stats;
+    batch.formats = formats;
+    for (size_t i = 0; i < candidates.count &&
+                       !v4_batch_add_tagged(&batch, candidates.keys[i], candidates.tags[i]); i++) {
+    }
+    int ret = finish_batch(&batch, out);
+    log_info("Key location hints: %zu candidates, %s", candidates.count, ret == 0 ? "hit" : "miss");
+    if (ret == 0) {
+        scan_stats_key_found(stats);
+        record_hint(hints, version, &maps, out->tag);
+    }
+    candidate_list_free(&candidates);
+    proc_maps_free(&maps);
+    return ret;
 }
 
 /**
- * 从/proc/pid/maps读取内存映射信息并搜索密钥 - 仅在Linux上可用
+ * 读取数据库第一页；要尝试 V3 时只要求完整的 1024 字节 V3 页，其余补零
+ * @return 0 成功，-1 失败
  */
-int dumpkey(pid_t pid, const char *filename, char *outkey) {
-#ifndef __linux__
-    fprintf(stderr, "Error: This function is only supported on Linux\n");
-    return -1;
-#else
-    // 读取数据库第一页
-    unsigned char page[V4_PAGE_SIZE];
+static int read_first_page(const char *filename, unsigned formats, unsigned char *page) {
+    memset(page, 0, V4_PAGE_SIZE);
     FILE *fp = fopen(filename, "rb");
     if (!fp) {
-        fprintf(stderr, "Failed to open db file: %s\n", filename);
+        log_error("Failed to open db file: %s", filename);
         return -1;
     }
-    
+
     size_t read_size = fread(page, 1, V4_PAGE_SIZE, fp);
     fclose(fp);
-    
-    if (read_size != V4_PAGE_SIZE) {
-        fprintf(stderr, "Failed to read complete first page (read %zu bytes, expected %d)\n", 
-                read_size, V4_PAGE_SIZE);
+
+    size_t need = (formats & DB_FORMAT_V3) ? DB_V3_PAGE_SIZE : V4_PAGE_SIZE;
+    if (read_size < need) {
+        log_error("Failed to read complete first page of %s (read %zu bytes, expected %zu)",
+                  filename, read_size, need);
         return -1;
     }
+    return 0;
+}
 
-    // 附加到目标进程
-    if (ptrace(PTRACE_ATTACH, pid, NULL, NULL) == -1) {
-        fprintf(stderr, "Failed to attach to process %d: %s\n", pid, strerror(errno));
+/**
+ * 打开一个目标：读入第一个数据库的第一页，打开这个 salt 的派生结果缓存
+ * @return 0 成功，-1 失败
+ */
+static int target_open(scan_target *t, pid_t pid, const mem_image *image, char **dbfiles,
+                       size_t dbcount, const scan_options *opts) {
+    memset(t, 0, sizeof(*t));
+    t->pid = pid;
+    t->dbfiles = dbfiles;
+    t->dbcount = dbcount;
+    if (read_first_page(dbfiles[0], opts->formats, t->page) != 0) {
         return -1;
     }
-    
-    // 等待进程停止
-    int status;
-    waitpid(pid, &status, 0);
-    
-    // 读取内存映射信息
-    char maps_path[256];
-    snprintf(maps_path, sizeof(maps_path), "/proc/%d/maps", pid);
-    
-    FILE *maps_file = fopen(maps_path, "r");
-    if (!maps_file) {
-        fprintf(stderr, "Failed to open %s: %s\n", maps_path, strerror(errno));
-        ptrace(PTRACE_DETACH, pid, NULL, NULL);
-        return -1;
+
+    // 同一salt下的派生结果缓存，磁盘缓存只记录被拒绝候选的指纹
+    t->cache = key_cache_open(t->page, 0, opts->cache_dir);
+    if (t->cache && t->cache->loaded > 0) {
+        log_info("Loaded %llu rejected candidates from key cache",
+                 (unsigned long long)t->cache->loaded);
     }
-    
-    char line[512];
-    while (fgets(line, sizeof(line), maps_file)) {
-        unsigned long start, end;
-        char permissions[5];
-        fprintf(stderr, "%s \n",line );
-        bool heap_start = false;
-        if (sscanf(line, "%lx-%lx %4s", &start, &end, permissions) == 3) {
-            if (  strstr(line, "[heap]")) {
-                heap_start= true;
-//                continue;
+    open_mem(&t->mem, pid, image);
+    app_version_of(pid, image, opts->app_version, t->version, sizeof(t->version));
+    atomic_init(&t->done, false);
+    candidate_list_init(&t->candidates);
+    atomic_init(&t->next_candidate, 0);
+    return 0;
+}
+
+static void target_close(scan_target *t) {
+    resume_target(t->pid, &t->stopped, &t->stop_begin);
+    proc_mem_close(&t->mem);
+    proc_maps_free(&t->maps);
+    candidate_list_free(&t->candidates);
+    key_cache_close(t->cache);
+    t->cache = NULL;
+}
+
+/**
+ * 找到密钥之后：记录位置提示和命中的偏移，用同一个密钥确认这个进程的其余数据库，
+ * 指定了 -k 时为每个能打开的数据库保存派生密钥
+ */
+static void target_finish(scan_target *t, key_hint_store *hints, const scan_options *opts,
+                          scan_stats *stats) {
+    record_hint(hints, t->version, &t->maps, t->result.tag);
+    record_key_offset(opts, stats, t->result.tag);
+    if (opts->key_store) {
+        remember_derived_keys(opts->key_store, t->cache, t->page, t->result.key);
+    }
+
+    unsigned char key[KEY_SIZE];
+    for (int i = 0; i < KEY_SIZE; i++) {
+        unsigned int b;
+        sscanf(t->result.key + i * 2, "%2x", &b);
+        key[i] = (unsigned char)b;
+    }
+    for (size_t i = 1; i < t->dbcount; i++) {
+        unsigned char page[V4_PAGE_SIZE];
+        if (read_first_page(t->dbfiles[i], opts->formats, page) != 0) {
+            continue;
+        }
+        bool ok = ((opts->formats & DB_FORMAT_V4) && testkey_v4(page, key)) ||
+                  ((opts->formats & DB_FORMAT_V3) && testkey_v3(page, key));
+        if (!ok) {
+            log_warn("Key found in process %d does not open %s", t->pid, t->dbfiles[i]);
+            continue;
+        }
+        log_debug("Key also opens %s", t->dbfiles[i]);
+        if (opts->key_store) {
+            remember_derived_keys(opts->key_store, NULL, page, t->result.key);
+        }
+    }
+    memset(key, 0, sizeof(key));
+}
+
+/**
+ * 释放 scan_targets 的扫描状态，输出找到的密钥
+ * @return 找到密钥的目标数
+ */
+static int finish_targets(scan_context *ctx, key_hint_store *hints, const scan_options *opts,
+                          scan_stats *stats) {
+    region_queue_destroy(&ctx->queue);
+    pthread_mutex_destroy(&ctx->result_lock);
+
+    int found = 0;
+    for (size_t i = 0; i < ctx->target_count; i++) {
+        if (ctx->targets[i].found) {
+            target_finish(&ctx->targets[i], hints, opts, stats);
+            found++;
+        }
+    }
+    key_hint_close(hints);
+    return found;
+}
+
+/**
+ * 在一组目标中搜索密钥，所有目标共用一个区域队列、一组扫描/校验线程
+ * 目标已由 target_open 打开；找到的密钥在 targets[i].result 中
+ * @param stream 每找到一个密钥立即输出到 stdout
+ * @return 找到密钥的目标数，-1 表示没能开始扫描
+ */
+static int scan_targets(scan_target *targets, size_t count, const mem_image *image,
+                        const scan_options *opts, scan_stats *stats, bool stream) {
+    scan_stage_timer timer;
+    scan_context ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.targets = targets;
+    ctx.target_count = count;
+    ctx.formats = opts->formats;
+    ctx.stats = stats;
+    ctx.stream = stream;
+    region_queue_init(&ctx.queue);
+    atomic_init(&ctx.cancel, false);
+    atomic_init(&ctx.pending, count);
+    pthread_mutex_init(&ctx.result_lock, NULL);
+    candidate_filter_init(&ctx.filter);
+    ctx.collect = opts->stop == SCAN_STOP_SNAPSHOT;
+    log_progress_init(&ctx.progress, opts->progress_ms);
+
+    // 微信重启后密钥通常还在上次的位置，先按提示试几个候选；所有目标共用一个提示文件
+    key_hint_store *hints = opts->hints ? key_hint_open(opts->hints) : NULL;
+    if (hints) {
+        scan_stage_begin(&timer);
+        for (size_t i = 0; i < count; i++) {
+            scan_result result;
+            if (probe_hints(targets[i].pid, image, hints, targets[i].version, targets[i].page,
+                            opts->formats, targets[i].cache, stats, &result) == 0) {
+                target_found(&ctx, &targets[i], &result);
+            }
+        }
+        scan_stage_end(stats, SCAN_STAGE_HINT, &timer);
+    }
+    // 提示已经找到所有目标的密钥时不再附加、停止目标进程，也不启动扫描线程
+    if (atomic_load(&ctx.pending) == 0) {
+        return finish_targets(&ctx, hints, opts, stats);
+    }
+
+    // 附加到还没找到密钥的目标并等待停止；SCAN_STOP_NONE 或扫描离线镜像时不附加
+    scan_stage_begin(&timer);
+    for (size_t i = 0; i < count && opts->stop != SCAN_STOP_NONE && !image; i++) {
+        scan_target *t = &targets[i];
+        if (atomic_load(&t->done)) {
+            continue;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t->stop_begin);
+        if (ptrace(PTRACE_ATTACH, t->pid, NULL, NULL) == -1) {
+            log_error("Failed to attach to process %d: %s", t->pid, strerror(errno));
+            atomic_store(&t->done, true);
+            continue;
+        }
+        t->stopped = true;
+
+        int status;
+        waitpid(t->pid, &status, 0);
+    }
+    scan_stage_end(stats, SCAN_STAGE_SETUP, &timer);
+
+    // 读取内存映射信息，按扫描优先级排序
+    scan_stage_begin(&timer);
+    size_t max_regions = 0;
+    for (size_t i = 0; i < count; i++) {
+        scan_target *t = &targets[i];
+        if (atomic_load(&t->done)) {
+            continue;
+        }
+        if (load_maps(t->pid, image, &t->maps) != 0) {
+            if (image) {
+                log_error("Out of memory loading image regions");
+            } else {
+                log_error("Failed to read /proc/%d/maps: %s", t->pid, strerror(errno));
             }
-            if (heap_start && strstr(line, "[") ) {
-            heap_start = false;
-//                break;
+            resume_target(t->pid, &t->stopped, &t->stop_begin);
+            atomic_store(&t->done, true);
+            continue;
+        }
+        size_t total_regions = t->maps.count;
+        size_t not_rw = 0;
+        for (size_t j = 0; j < t->maps.count; j++) {
+            if (t->maps.items[j].perms[0] != 'r' || t->maps.items[j].perms[1] != 'w') {
+                not_rw++;
             }
+        }
+        proc_maps_rank(&t->maps);
+        SCAN_STATS_ADD(stats, regions_seen, total_regions);
+        SCAN_STATS_SKIP(stats, SCAN_SKIP_PERMS, not_rw);
+        SCAN_STATS_SKIP(stats, SCAN_SKIP_KIND, total_regions - not_rw - t->maps.count);
 
-             fprintf(stderr, "permissions %c %c %d\n", permissions[0] ,  permissions[1], heap_start );
-            // 只搜索可读写的区域，主要是堆区域
-            if (permissions[0] == 'r' && permissions[1] == 'w'  ) {
-                fprintf(stderr, "try %ld %ld\n", start, end);
-                if (search_memory_region(pid, start, end, page, outkey) == 0) {
-                    fclose(maps_file);
-                    ptrace(PTRACE_DETACH, pid, NULL, NULL);
-                    return 0;
-                }
+        uint64_t scan_bytes = 0;
+        for (size_t j = 0; j < t->maps.count; j++) {
+            scan_bytes += t->maps.items[j].end - t->maps.items[j].start;
+        }
+        if (count > 1) {
+            log_info("Process %d: scanning %zu of %zu regions (%llu MB)", t->pid, t->maps.count,
+                     total_regions, (unsigned long long)(scan_bytes >> 20));
+        } else {
+            log_info("Scanning %zu of %zu regions (%llu MB)", t->maps.count, total_regions,
+                     (unsigned long long)(scan_bytes >> 20));
+        }
+        ctx.total_regions += t->maps.count;
+        ctx.total_bytes += scan_bytes;
+        max_regions = t->maps.count > max_regions ? t->maps.count : max_regions;
+    }
+    scan_stage_end(stats, SCAN_STAGE_REGIONS, &timer);
+
+    // 启动工作线程
+    int jobs = opts->jobs > 0 ? opts->jobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (jobs < 1) {
+        jobs = 1;
+    }
+    pthread_t *workers = calloc(jobs, sizeof(pthread_t));
+    int started = start_workers(workers, jobs, scan_worker, &ctx);
+    if (started == 0) {
+        log_error("No scan threads available");
+        free(workers);
+        for (size_t i = 0; i < count; i++) {
+            resume_target(targets[i].pid, &targets[i].stopped, &targets[i].stop_begin);
+        }
+        region_queue_destroy(&ctx.queue);
+        pthread_mutex_destroy(&ctx.result_lock);
+        key_hint_close(hints);
+        return -1;
+    }
+    log_info("Scanning with %d threads", started);
+    scan_stage_begin(&timer);
+
+    // 当前线程作为生产者投递区域：各目标按优先级轮流，每个进程的堆都先于任何一个进程的小区域
+    bool open = true;
+    for (size_t j = 0; open && j < max_regions && !atomic_load(&ctx.cancel); j++) {
+        for (size_t i = 0; open && i < count; i++) {
+            scan_target *t = &targets[i];
+            if (j >= t->maps.count || atomic_load(&t->done)) {
+                continue;
             }
+            scan_region region = {t->maps.items[j].start, t->maps.items[j].end, i};
+            open = region_queue_push(&ctx.queue, region);
         }
     }
-    
-    fclose(maps_file);
-    ptrace(PTRACE_DETACH, pid, NULL, NULL);
+
+    region_queue_close(&ctx.queue, false);
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    // 候选已经全部拷贝出来，先让目标进程恢复运行，再离线校验
+    for (size_t i = 0; i < count; i++) {
+        resume_target(targets[i].pid, &targets[i].stopped, &targets[i].stop_begin);
+    }
+    if (opts->stop == SCAN_STOP_NONE && !image) {
+        log_info("Target process was not stopped");
+    }
+    scan_stage_end(stats, SCAN_STAGE_SCAN, &timer);
+
+    size_t collected = 0;
+    for (size_t i = 0; ctx.collect && i < count; i++) {
+        if (!atomic_load(&targets[i].done)) {
+            // 所有命中的最可能偏移先校验，其余偏移按命中次数依次排在后面
+            key_offsets_order_candidates(&key_offsets, &targets[i].candidates);
+            collected += targets[i].candidates.count;
+        }
+    }
+    if (collected > 0 && !atomic_load(&ctx.cancel)) {
+        log_info("Validating %zu candidates", collected);
+        scan_stage_begin(&timer);
+        started = start_workers(workers, jobs, validate_worker, &ctx);
+        for (int i = 0; i < started; i++) {
+            pthread_join(workers[i], NULL);
+        }
+        scan_stage_end(stats, SCAN_STAGE_VALIDATE, &timer);
+    }
+    free(workers);
+
+    if (stats) {
+        // 没有轮到的区域：已经找到密钥或扫描线程分配缓冲区失败
+        uint64_t done = atomic_load(&stats->regions_scanned) +
+                        atomic_load(&stats->regions_skipped[SCAN_SKIP_UNREADABLE]);
+        SCAN_STATS_SKIP(stats, SCAN_SKIP_CANCELED, done < ctx.total_regions ? ctx.total_regions - done : 0);
+        SCAN_STATS_ADD(stats, candidates_seen, ctx.filter.seen);
+        SCAN_STATS_ADD(stats, candidates_filtered, ctx.filter.seen - ctx.filter.passed);
+    }
+    if (LOG_ENABLED(LOG_LEVEL_DEBUG)) {
+        candidate_filter_print(&ctx.filter, key_offsets.offsets, key_offsets.count, stderr);
+    }
+    return finish_targets(&ctx, hints, opts, stats);
+}
+#endif
+
+/**
+ * 从/proc/pid/maps读取内存映射信息并搜索密钥 - 仅在Linux上可用
+ * @param image 不为NULL时扫描这个离线镜像，pid 不使用，也不附加任何进程
+ * @param stats 输出扫描统计，调用前由 scan_stats_init 初始化，可以为NULL
+ */
+int dumpkey(pid_t pid, const mem_image *image, const char *filename, const scan_options *opts,
+            scan_stats *stats, char *outkey) {
+#ifndef __linux__
+    log_error("This function is only supported on Linux");
     return -1;
+#else
+    scan_stage_timer timer;
+    scan_stage_begin(&timer);
+    char *dbfiles[1] = {(char *)filename};
+    scan_target target;
+    if (target_open(&target, pid, image, dbfiles, 1, opts) != 0) {
+        return -1;
+    }
+    scan_stage_end(stats, SCAN_STAGE_SETUP, &timer);
+
+    int found = scan_targets(&target, 1, image, opts, stats, false);
+    if (found == 1) {
+        memcpy(outkey, target.result.key, sizeof(target.result.key));
+    }
+    target_close(&target);
+    return found == 1 ? 0 : -1;
 #endif
 }
 
-int main(int argc, char *argv[]) {
-    printf("WeChat V4 TestKey Tool - Ubuntu Version\n");
-    
+/**
+ * 批量模式：清单每行 "pid 数据库 [数据库...]"，'#' 开头为注释，路径中不能有空白
+ * 所有进程一起扫描，每找到一个密钥立即输出 "Found key for <pid>: <key>"
+ * @return 所有进程都找到密钥时返回0
+ */
+int dumpkey_batch(const char *manifest, const scan_options *opts, scan_stats *stats) {
 #ifndef __linux__
-    fprintf(stderr, "Error: This tool is designed for Linux systems only\n");
-    fprintf(stderr, "Current platform is not supported for memory operations\n");
-    fprintf(stderr, "However, the testkey validation function can still be used\n");
+    (void)manifest;
+    (void)opts;
+    (void)stats;
+    log_error("This function is only supported on Linux");
+    return -1;
+#else
+    FILE *fp = fopen(manifest, "r");
+    if (!fp) {
+        log_error("Failed to open batch manifest %s: %s", manifest, strerror(errno));
+        return -1;
+    }
+
+    scan_stage_timer timer;
+    scan_stage_begin(&timer);
+    scan_target *targets = NULL;
+    size_t count = 0;
+    size_t cap = 0;
+    int ret = 0;
+    char line[4096];
+    int lineno = 0;
+    while (ret == 0 && fgets(line, sizeof(line), fp)) {
+        lineno++;
+        char *save = NULL;
+        char *tok = strtok_r(line, " \t\r\n", &save);
+        if (!tok || tok[0] == '#') {
+            continue;
+        }
+        pid_t pid = atoi(tok);
+        char **dbfiles = NULL;
+        size_t dbcount = 0;
+        while ((tok = strtok_r(NULL, " \t\r\n", &save))) {
+            char **grown = realloc(dbfiles, (dbcount + 1) * sizeof(char *));
+            if (!grown || !(grown[dbcount] = strdup(tok))) {
+                dbfiles = grown ? grown : dbfiles;
+                ret = -1;
+                break;
+            }
+            dbfiles = grown;
+            dbcount++;
+        }
+        if (ret == 0 && (pid <= 0 || dbcount == 0)) {
+            log_error("Invalid target at %s:%d, expected \"pid dbfile [dbfile...]\"", manifest, lineno);
+            ret = -1;
+        }
+        if (ret == 0 && count == cap) {
+            cap = cap ? cap * 2 : 8;
+            scan_target *grown = realloc(targets, cap * sizeof(*targets));
+            if (!grown) {
+                ret = -1;
+            } else {
+                targets = grown;
+            }
+        }
+        if (ret == 0 && target_open(&targets[count], pid, NULL, dbfiles, dbcount, opts) == 0) {
+            count++;
+            continue;
+        }
+        // 打不开数据库的目标跳过，其余照常扫描
+        for (size_t i = 0; i < dbcount; i++) {
+            free(dbfiles[i]);
+        }
+        free(dbfiles);
+    }
+    fclose(fp);
+    scan_stage_end(stats, SCAN_STAGE_SETUP, &timer);
+
+    int found = -1;
+    if (ret == 0 && count > 0) {
+        log_info("Searching for V4 encryption keys in %zu processes...", count);
+        found = scan_targets(targets, count, NULL, opts, stats, true);
+    } else if (ret == 0) {
+        log_error("No targets in %s", manifest);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (found >= 0 && !targets[i].found) {
+            printf("Key not found for %d\n", targets[i].pid);
+        }
+        target_close(&targets[i]);
+        for (size_t j = 0; j < targets[i].dbcount; j++) {
+            free(targets[i].dbfiles[j]);
+        }
+        free(targets[i].dbfiles);
+    }
+    free(targets);
+    return ret == 0 && count > 0 && found == (int)count ? 0 : -1;
 #endif
+}
 
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <pid> <dbfile>\n", argv[0]);
-        fprintf(stderr, "Extract WeChat database encryption key from process memory (V4 - Linux)\n");
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-v] [-c cache_dir] [-k file] [-j jobs] [-s mode] [-f formats] [-H file] [-O file] [-w bytes] [-p ms] [--stats file] <pid> <dbfile>\n", prog);
+    fprintf(stderr, "       %s [options] -i image <dbfile>\n", prog);
+    fprintf(stderr, "       %s [options] -b manifest\n", prog);
+    fprintf(stderr, "Extract WeChat database encryption key from process memory (V4 - Linux)\n");
+    fprintf(stderr, "  -c, --cache-dir DIR  remember rejected candidates per DB salt in DIR\n");
+    fprintf(stderr, "  -k, --key-store FILE save the keys derived for <dbfile> to FILE for v4_decrypt -k\n");
+    fprintf(stderr, "  -j, --jobs N         scan with N threads (default: online CPU count)\n");
+    fprintf(stderr, "  -s, --stop MODE      how long the target is stopped (default: snapshot)\n");
+    fprintf(stderr, "                         snapshot  only while candidates are copied out\n");
+    fprintf(stderr, "                         full      for the whole scan and validation\n");
+    fprintf(stderr, "                         none      never; needs process_vm_readv access only\n");
+    fprintf(stderr, "  -f, --format LIST    database formats to test each candidate against (default: v4)\n");
+    fprintf(stderr, "                         e.g. v4,v3 to find a V3 or V4 key in one scan\n");
+    fprintf(stderr, "  -H, --hints FILE     try the key locations remembered in FILE before a full scan,\n");
+    fprintf(stderr, "                       and remember where the key was found\n");
+    fprintf(stderr, "      --app-version V  WeChat version the hints are keyed by\n");
+    fprintf(stderr, "                       (default: size and mtime of the target executable)\n");
+    fprintf(stderr, "  -O, --offsets FILE   key offsets around the pattern, one \"offset hits\" per line;\n");
+    fprintf(stderr, "                       tried by hit count, updated when the key is found\n");
+    fprintf(stderr, "  -w, --sweep N        also try every 8-byte aligned offset within +-N bytes\n");
+    fprintf(stderr, "  -i, --image FILE     scan a saved memory image instead of a live process:\n");
+    fprintf(stderr, "                       an ELF core file, or a raw dump with FILE.regions\n");
+    fprintf(stderr, "  -b, --batch FILE     scan every process listed in FILE, one \"pid dbfile [dbfile...]\"\n");
+    fprintf(stderr, "                       per line, in one pass; prints each key as soon as it is found\n");
+    fprintf(stderr, "  -p, --progress-ms N  print progress at most every N ms, 0 to disable (default: 1000)\n");
+    fprintf(stderr, "      --stats FILE     write scan statistics as JSON to FILE, - for stderr\n");
+    fprintf(stderr, "  -v, --verbose        print debug output, repeat (-vv) for per-candidate trace\n");
 #ifdef __linux__
-        fprintf(stderr, "Note: This program requires root privileges or CAP_SYS_PTRACE capability\n");
+    fprintf(stderr, "Note: This program requires root privileges or CAP_SYS_PTRACE capability\n");
 #endif
-        return -1;
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"app-version", required_argument, NULL, 'A'},
+        {"batch", required_argument, NULL, 'b'},
+        {"cache-dir", required_argument, NULL, 'c'},
+        {"format", required_argument, NULL, 'f'},
+        {"hints", required_argument, NULL, 'H'},
+        {"image", required_argument, NULL, 'i'},
+        {"jobs", required_argument, NULL, 'j'},
+        {"key-store", required_argument, NULL, 'k'},
+        {"offsets", required_argument, NULL, 'O'},
+        {"progress-ms", required_argument, NULL, 'p'},
+        {"stop", required_argument, NULL, 's'},
+        {"stats", required_argument, NULL, 'S'},
+        {"sweep", required_argument, NULL, 'w'},
+        {"verbose", no_argument, NULL, 'v'},
+        {NULL, 0, NULL, 0},
+    };
+
+    scan_options opts = {NULL, NULL, NULL, 0, 1000, SCAN_STOP_SNAPSHOT, DB_FORMAT_V4, NULL, NULL, NULL, 0, NULL, NULL};
+    int verbose = 0;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "b:c:f:H:i:j:k:O:p:s:vw:", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'A':
+            opts.app_version = optarg;
+            break;
+        case 'b':
+            opts.batch = optarg;
+            break;
+        case 'c':
+            opts.cache_dir = optarg;
+            break;
+        case 'f':
+            opts.formats = db_formats_parse(optarg);
+            if (opts.formats == 0) {
+                log_error("Invalid database formats: %s", optarg);
+                return -1;
+            }
+            break;
+        case 'H':
+            opts.hints = optarg;
+            break;
+        case 'i':
+            opts.image = optarg;
+            break;
+        case 'k':
+            opts.key_store = optarg;
+            break;
+        case 'O':
+            opts.offsets = optarg;
+            break;
+        case 'w':
+            opts.sweep = atoi(optarg);
+            if (opts.sweep <= 0) {
+                log_error("Invalid sweep radius: %s", optarg);
+                return -1;
+            }
+            break;
+        case 'S':
+            opts.stats = optarg;
+            break;
+        case 'j':
+            opts.jobs = atoi(optarg);
+            if (opts.jobs <= 0) {
+                log_error("Invalid job count: %s", optarg);
+                return -1;
+            }
+            break;
+        case 'p':
+            opts.progress_ms = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            if (strcmp(optarg, "snapshot") == 0) {
+                opts.stop = SCAN_STOP_SNAPSHOT;
+            } else if (strcmp(optarg, "full") == 0) {
+                opts.stop = SCAN_STOP_FULL;
+            } else if (strcmp(optarg, "none") == 0) {
+                opts.stop = SCAN_STOP_NONE;
+            } else {
+                log_error("Invalid stop mode: %s", optarg);
+                return -1;
+            }
+            break;
+        case 'v':
+            verbose++;
+            break;
+        default:
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    log_set_level(LOG_LEVEL_INFO + verbose);
+
+    log_info("WeChat V4 TestKey Tool - Ubuntu Version");
+    if (opts.offsets) {
+        if (key_offsets_load(&key_offsets, opts.offsets) != 0) {
+            return -1;
+        }
+    } else {
+        key_offsets_default(&key_offsets);
+    }
+    if (opts.sweep > 0) {
+        key_offsets_sweep(&key_offsets, opts.sweep);
+    }
+    log_debug("Trying %zu key offsets, most likely %+d", key_offsets.count, key_offsets.offsets[0]);
+#ifndef __linux__
+    log_error("This tool is designed for Linux systems only");
+    log_error("Current platform is not supported for memory operations");
+    log_error("However, the testkey validation function can still be used");
+#endif
+
+    // 批量模式没有位置参数，目标都在清单里
+    if (opts.batch) {
+        if (opts.image || argc > optind) {
+            print_usage(argv[0]);
+            return -1;
+        }
+        scan_stats stats;
+        scan_stats_init(&stats);
+        int ret = dumpkey_batch(opts.batch, &opts, &stats);
+        if (opts.stats) {
+            scan_stats_write(&stats, ret == 0, opts.stats);
+        }
+        return ret;
     }
 
-    pid_t pid = atoi(argv[1]);
-    if (pid <= 0) {
-        fprintf(stderr, "Invalid PID: %s\n", argv[1]);
+    // 扫描离线镜像时只有数据库一个位置参数
+    if (argc - optind < (opts.image ? 1 : 2)) {
+        print_usage(argv[0]);
         return -1;
     }
 
+    pid_t pid = 0;
+    mem_image image;
+    if (opts.image) {
+        if (mem_image_open(&image, opts.image) != 0) {
+            return -1;
+        }
+        log_info("Searching for V4 encryption key in %s image %s (%zu regions)...",
+                 mem_image_format_name(image.format), opts.image, image.count);
+    } else {
+        pid = atoi(argv[optind]);
+        if (pid <= 0) {
+            log_error("Invalid PID: %s", argv[optind]);
+            return -1;
+        }
+        log_info("Searching for V4 encryption key in process %d...", pid);
+    }
+    const char *dbfile = argv[opts.image ? optind : optind + 1];
+
     char key[KEY_SIZE * 2 + 1] = {0};
-    printf("Searching for V4 encryption key in process %d...\n", pid);
-    
-    if (dumpkey(pid, argv[2], key) == 0) {
+    scan_stats stats;
+    scan_stats_init(&stats);
+    int ret = dumpkey(pid, opts.image ? &image : NULL, dbfile, &opts, &stats, key);
+    if (opts.image) {
+        mem_image_close(&image);
+    }
+    if (opts.stats) {
+        scan_stats_write(&stats, ret == 0, opts.stats);
+    }
+    if (ret == 0) {
         printf("Found key: %s\n", key);
         return 0;
     } else {
@@ -71,6 +71,13 @@ var dumpmemoryCmd = &cobra.Command{
 			return
 		}
 
+		// region manifest, lets v4_testkey -i scan the dump at the original addresses
+		manifest := file + ".regions"
+		if err = os.WriteFile(filepath.Join(dir, manifest), []byte(g.Manifest()), 0644); err != nil {
+			log.Fatal().Err(err).Msg("write region manifest failed")
+			return
+		}
+
 		log.Info().Msg("dump memory success")
 
 		// step 3. copy encrypted database file
@@ -107,7 +114,7 @@ var dumpmemoryCmd = &cobra.Command{
 
 		zw := zip.NewWriter(zf)
 
-		for _, file := range []string{file, to} {
+		for _, file := range []string{file, manifest, to} {
 			f, err := os.Open(file)
 			if err != nil {
 				log.Fatal().Err(err).Msg("open file failed")
@@ -2,6 +2,7 @@ package wechat
 
 import (
 	"context"
+	"encoding/hex"
 	"fmt"
 	"os"
 	"path/filepath"
@@ -15,6 +16,7 @@ import (
 	"github.com/sjzar/chatlog/internal/errors"
 	"github.com/sjzar/chatlog/internal/wechat"
 	"github.com/sjzar/chatlog/internal/wechat/decrypt"
+	"github.com/sjzar/chatlog/internal/wechat/decrypt/common"
 	"github.com/sjzar/chatlog/pkg/filemonitor"
 	"github.com/sjzar/chatlog/pkg/util"
 )
@@ -128,7 +130,12 @@ func (s *Service) waitAndProcess(dbFile string) {
 }
 
 func (s *Service) DecryptDBFile(dbFile string) error {
+	defer common.DefaultKeyStore.Flush()
+	return s.decryptDBFile(context.Background(), dbFile)
+}
 
+// decryptDBFile 解密一个数据库，ctx 由 DecryptDBFiles 的调度器传入时携带分给这个文件的并行度
+func (s *Service) decryptDBFile(ctx context.Context, dbFile string) error {
 	decryptor, err := decrypt.NewDecryptor(s.ctx.Platform, s.ctx.Version)
 	if err != nil {
 		return err
@@ -139,6 +146,24 @@ func (s *Service) DecryptDBFile(dbFile string) error {
 		return err
 	}
 
+	// 派生密钥封装后与解密结果放在同一个工作目录，重启后不用为每个数据库重新跑 PBKDF2
+	if s.ctx.WorkDir != "" {
+		common.DefaultKeyStore.SetFile(filepath.Join(s.ctx.WorkDir, common.DerivedKeyFileName))
+	}
+
+	// V4 只重新解密变化的页面，改名替换输出的方式不变
+	if inc, ok := decryptor.(decrypt.IncrementalDecryptor); ok {
+		stats, err := inc.DecryptIncremental(ctx, dbFile, s.ctx.DataKey, output)
+		if err == nil {
+			log.Debug().Msgf("Decrypted %s to %s (%d/%d pages, full: %t)", dbFile, output, stats.ChangedPages, stats.TotalPages, stats.Full)
+			return nil
+		}
+		if err != errors.ErrAlreadyDecrypted {
+			log.Err(err).Msgf("failed to decrypt %s", dbFile)
+			return err
+		}
+	}
+
 	outputTemp := output + ".tmp"
 	outputFile, err := os.Create(outputTemp)
 	if err != nil {
@@ -151,7 +176,7 @@ func (s *Service) DecryptDBFile(dbFile string) error {
 		}
 	}()
 
-	if err := decryptor.Decrypt(context.Background(), dbFile, s.ctx.DataKey, outputFile); err != nil {
+	if err := decryptor.Decrypt(ctx, dbFile, s.ctx.DataKey, outputFile); err != nil {
 		if err == errors.ErrAlreadyDecrypted {
 			if data, err := os.ReadFile(dbFile); err == nil {
 				outputFile.Write(data)
@@ -178,12 +203,69 @@ func (s *Service) DecryptDBFiles() error {
 		return err
 	}
 
+	// 先按 salt 分组并行校验所有文件，解密时直接使用留在派生密钥存储中的结果
+	if key, err := hex.DecodeString(s.ctx.DataKey); err == nil {
+		if s.ctx.WorkDir != "" {
+			common.DefaultKeyStore.SetFile(filepath.Join(s.ctx.WorkDir, common.DerivedKeyFileName))
+		}
+		start := time.Now()
+		results, err := decrypt.ValidateFiles(context.Background(), s.ctx.Platform, s.ctx.Version, dbFiles, key)
+		if err != nil {
+			return err
+		}
+		dbFiles = dbFiles[:0]
+		for _, r := range results {
+			if r.Err == nil && !r.Valid {
+				log.Debug().Msgf("skip %s: key does not match", r.Path)
+				continue
+			}
+			dbFiles = append(dbFiles, r.Path)
+		}
+		log.Debug().Msgf("validated %d files in %s", len(results), time.Since(start))
+	}
+
+	// 大文件先开始并按页并行，小文件同时解密填满其余的核，总耗时接近最大的那个文件
+	jobs := make([]common.DecryptJob, 0, len(dbFiles))
+	var total int64
 	for _, dbFile := range dbFiles {
-		if err := s.DecryptDBFile(dbFile); err != nil {
-			log.Debug().Msgf("DecryptDBFile %s failed: %v", dbFile, err)
-			continue
+		job := common.DecryptJob{Path: dbFile}
+		if fi, err := os.Stat(dbFile); err == nil {
+			job.Size = fi.Size()
+		}
+		total += job.Size
+		jobs = append(jobs, job)
+	}
+	start := time.Now()
+	opts := common.ScheduleOptions{Progress: s.reportDecryptProgress}
+	errs := common.ScheduleDecrypt(context.Background(), jobs, opts, s.decryptDBFile)
+	// 解密中新派生的密钥在全部文件结束后一次性落盘
+	common.DefaultKeyStore.Flush()
+	failed := 0
+	for i, err := range errs {
+		if err != nil {
+			log.Debug().Msgf("DecryptDBFile %s failed: %v", jobs[i].Path, err)
+			failed++
 		}
 	}
+	elapsed := time.Since(start)
+	log.Info().Msgf("decrypted %d/%d files (%.1f MB) in %s, %.1f MB/s", len(jobs)-failed, len(jobs),
+		float64(total)/(1<<20), elapsed.Round(time.Millisecond), float64(total)/(1<<20)/max(elapsed.Seconds(), 1e-3))
 
 	return nil
 }
+
+// reportDecryptProgress 解密时间较长的文件定期输出进度，每个文件完成时输出耗时和吞吐量
+func (s *Service) reportDecryptProgress(p common.DecryptProgress) {
+	name := p.Path[min(len(s.ctx.DataDir), len(p.Path)):]
+	if !p.Finished {
+		if p.TotalPages > 0 {
+			log.Info().Msgf("decrypting %s: %d/%d pages (%.0f%%), %d workers, %.1f MB/s", name, p.DonePages, p.TotalPages,
+				float64(p.DonePages)*100/float64(p.TotalPages), p.Workers, p.Throughput())
+		}
+		return
+	}
+	if p.Err == nil {
+		log.Debug().Msgf("decrypted %s (%.1f MB, %d workers) in %s, %.1f MB/s", name, float64(p.Size)/(1<<20), p.Workers,
+			p.Elapsed.Round(time.Millisecond), p.Throughput())
+	}
+}
@@ -0,0 +1,95 @@
+package common
+
+import (
+	"bytes"
+	"context"
+	"crypto/sha512"
+	"fmt"
+	"os"
+	"path/filepath"
+	"runtime"
+	"testing"
+
+	"golang.org/x/crypto/pbkdf2"
+)
+
+// 与 c_code/bench/v4_bench 的 validate、decrypt、decrypt_file 阶段对应的 Go 路径，
+// 指标使用同样的键（candidates_per_sec、pages_per_sec），可以直接与 bin/bench.json 对比：
+//
+//	go test -run '^$' -bench . ./internal/wechat/decrypt/common
+
+// benchV4IterCount 与 linux/darwin/windows V4IterCount 相同
+const benchV4IterCount = 256000
+
+// benchDeriveKeysV4 与各平台 V4Decryptor.deriveKeys 相同的 PBKDF2-HMAC-SHA512 派生
+func benchDeriveKeysV4(key []byte, salt []byte) ([]byte, []byte) {
+	encKey := pbkdf2.Key(key, salt, benchV4IterCount, KeySize, sha512.New)
+	macKey := pbkdf2.Key(encKey, XorBytes(salt, 0x3a), 2, KeySize, sha512.New)
+	return encKey, macKey
+}
+
+// BenchmarkValidateKeyV4 每个候选一次完整的 V4 派生加第一页 HMAC 校验，对应 v4_bench 的 validate
+func BenchmarkValidateKeyV4(b *testing.B) {
+	db := newTestDB(21, 1)
+	page1 := db.encrypt(b)
+	candidate := db.random(KeySize)
+
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		candidate[0] = byte(i)
+		ValidateKey(page1, candidate, db.salt, sha512.New, testHMACSize, testReserve, testPageSize, benchDeriveKeysV4)
+	}
+	b.ReportMetric(float64(b.N)/b.Elapsed().Seconds(), "candidates_per_sec")
+}
+
+// BenchmarkDecryptPage 单线程内存内逐页 DecryptPage，对应 v4_bench 的 decrypt
+func BenchmarkDecryptPage(b *testing.B) {
+	const pages = 256
+	db := newTestDB(22, pages)
+	enc := db.encrypt(b)
+	encKey, macKey := testDeriveKeys(db.key, db.salt)
+
+	b.SetBytes(testPageSize)
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		pgno := int64(i % pages)
+		page := enc[pgno*testPageSize : (pgno+1)*testPageSize]
+		if _, err := DecryptPage(page, encKey, macKey, pgno, sha512.New, testHMACSize, testReserve, testPageSize); err != nil {
+			b.Fatal(err)
+		}
+	}
+	b.ReportMetric(float64(b.N)/b.Elapsed().Seconds(), "pages_per_sec")
+}
+
+// BenchmarkDecryptPagesParallel 整库解密到文件，对应 v4_bench 的 decrypt_file
+func BenchmarkDecryptPagesParallel(b *testing.B) {
+	const pages = 4096 // 16MB
+	db := newTestDB(23, pages)
+	enc := db.encrypt(b)
+	encKey, macKey := testDeriveKeys(db.key, db.salt)
+
+	workerCounts := []int{1}
+	if n := runtime.NumCPU(); n > 1 {
+		workerCounts = append(workerCounts, n)
+	}
+	for _, workers := range workerCounts {
+		b.Run(fmt.Sprintf("workers=%d", workers), func(b *testing.B) {
+			out, err := os.Create(filepath.Join(b.TempDir(), "out.db"))
+			if err != nil {
+				b.Fatal(err)
+			}
+			defer out.Close()
+
+			b.SetBytes(pages * testPageSize)
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				err := DecryptPagesParallel(context.Background(), "bench.db", bytes.NewReader(enc), out, pages,
+					encKey, macKey, sha512.New, testHMACSize, testReserve, testPageSize, workers)
+				if err != nil {
+					b.Fatal(err)
+				}
+			}
+			b.ReportMetric(float64(b.N)*pages/b.Elapsed().Seconds(), "pages_per_sec")
+		})
+	}
+}
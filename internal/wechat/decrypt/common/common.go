@@ -83,7 +83,11 @@ func ValidateKey(page1 []byte, key []byte, salt []byte, hashFunc func() hash.Has
 	}
 
 	_, macKey := deriveKeys(key, salt)
+	return VerifyFirstPage(page1, macKey, hashFunc, hmacSize, reserve, pageSize)
+}
 
+// VerifyFirstPage 用派生出的 macKey 校验第一页的 HMAC
+func VerifyFirstPage(page1 []byte, macKey []byte, hashFunc func() hash.Hash, hmacSize int, reserve int, pageSize int) bool {
 	mac := hmac.New(hashFunc, macKey)
 	dataEnd := pageSize - reserve + IVSize
 	mac.Write(page1[SaltSize:dataEnd])
@@ -0,0 +1,191 @@
+package common
+
+import (
+	"bytes"
+	"context"
+	"encoding/binary"
+	"fmt"
+	"hash"
+	"io"
+	"os"
+
+	"github.com/rs/zerolog/log"
+
+	"github.com/sjzar/chatlog/internal/errors"
+)
+
+const (
+	// PageIndexSuffix 页面索引文件的后缀，与解密输出放在一起
+	PageIndexSuffix = ".pages"
+
+	// PageTagSize 索引中每页保存的 HMAC 前缀长度
+	// 每页的 HMAC 覆盖页面内容和页号，且微信每次写页面都会换新的 IV，
+	// 标签不变即页面未被改写，取前 16 字节已经足够区分
+	PageTagSize = 16
+
+	pageIndexMagic = "CLPGIDX1"
+)
+
+// IncrementalStats 一次增量解密的统计
+type IncrementalStats struct {
+	TotalPages   int64
+	ChangedPages int64 // 重新解密并写出的页数
+	Full         bool  // 没有可用的上次结果，做了一次完整解密
+}
+
+// pageIndex 上次解密时加密文件每页的 HMAC 标签
+// 文件格式：magic(8) | pageSize(4, LE) | salt(16) | tags(pages * PageTagSize)
+type pageIndex struct {
+	pageSize int
+	salt     []byte
+	tags     []byte
+}
+
+func (p *pageIndex) pages() int64 {
+	return int64(len(p.tags) / PageTagSize)
+}
+
+// loadPageIndex 读取页面索引，文件不存在、格式不对或与当前数据库不匹配时返回 nil
+func loadPageIndex(path string, pageSize int, salt []byte) *pageIndex {
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return nil
+	}
+	headerSize := len(pageIndexMagic) + 4 + SaltSize
+	if len(data) < headerSize || string(data[:len(pageIndexMagic)]) != pageIndexMagic {
+		return nil
+	}
+	if int(binary.LittleEndian.Uint32(data[len(pageIndexMagic):])) != pageSize {
+		return nil
+	}
+	idxSalt := data[len(pageIndexMagic)+4 : headerSize]
+	tags := data[headerSize:]
+	// 数据库被重建时 salt 会变化，旧索引作废
+	if !bytes.Equal(idxSalt, salt) || len(tags)%PageTagSize != 0 {
+		return nil
+	}
+	return &pageIndex{pageSize: pageSize, salt: idxSalt, tags: tags}
+}
+
+// save 先写临时文件再改名，避免留下半个索引
+func (p *pageIndex) save(path string) error {
+	buf := make([]byte, 0, len(pageIndexMagic)+4+SaltSize+len(p.tags))
+	buf = append(buf, pageIndexMagic...)
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(p.pageSize))
+	buf = append(buf, p.salt...)
+	buf = append(buf, p.tags...)
+
+	tmp := path + ".tmp"
+	if err := os.WriteFile(tmp, buf, 0644); err != nil {
+		return err
+	}
+	return os.Rename(tmp, path)
+}
+
+// DecryptIncremental 增量解密 dbfile 到 outputPath
+// 与输出保存在一起的页面索引（outputPath + PageIndexSuffix）记录了上次解密时每页的 HMAC 标签。
+// 这次先把上次的输出复制到 outputPath.tmp，只重新解密标签变化的页面并写到对应偏移，
+// 按新的页数截断或扩展，最后把 .tmp 改名为 outputPath。改名会产生 Create 事件，
+// 数据库连接和缓存的刷新方式与完整解密相同。
+// 没有可用的索引或上次输出时做一次完整解密，同时建立索引。
+func DecryptIncremental(ctx context.Context, dbfile string, key []byte, outputPath string, kdf string,
+	deriveKeys func([]byte, []byte) ([]byte, []byte), hashFunc func() hash.Hash, hmacSize int, reserve int, pageSize int) (IncrementalStats, error) {
+	var stats IncrementalStats
+
+	dbInfo, err := OpenDBFile(dbfile, pageSize)
+	if err != nil {
+		return stats, err
+	}
+
+	// 用第一页校验密钥，密钥错误时不动已有的输出
+	encKey, macKey, ok := DeriveValidKeys(kdf, dbInfo.FirstPage, key, deriveKeys, hashFunc, hmacSize, reserve, pageSize)
+	if !ok {
+		return stats, errors.ErrDecryptIncorrectKey
+	}
+
+	dbFile, err := os.Open(dbfile)
+	if err != nil {
+		return stats, errors.OpenFileFailed(dbfile, err)
+	}
+	defer dbFile.Close()
+	fileInfo, err := dbFile.Stat()
+	if err != nil {
+		return stats, errors.StatFileFailed(dbfile, err)
+	}
+	// 末尾不足一页的部分与完整解密一样忽略
+	stats.TotalPages = fileInfo.Size() / int64(pageSize)
+
+	indexPath := outputPath + PageIndexSuffix
+	prev := loadPageIndex(indexPath, pageSize, dbInfo.Salt)
+
+	tmpPath := outputPath + ".tmp"
+	tmp, err := os.Create(tmpPath)
+	if err != nil {
+		return stats, errors.WriteOutputFailed(err)
+	}
+	defer func() {
+		if tmp != nil {
+			tmp.Close()
+			os.Remove(tmpPath)
+		}
+	}()
+
+	// 上次的输出与索引对不上（被删除、被其他方式重写过）时放弃增量
+	if prev != nil {
+		if err := copyPrevOutput(outputPath, tmp, prev.pages()*int64(pageSize)); err != nil {
+			prev = nil
+			if err := tmp.Truncate(0); err != nil {
+				return stats, errors.WriteOutputFailed(err)
+			}
+		}
+	}
+	var prevTags []byte
+	if prev != nil {
+		prevTags = prev.tags
+	}
+	stats.Full = prev == nil
+
+	if err := tmp.Truncate(stats.TotalPages * int64(pageSize)); err != nil {
+		return stats, errors.WriteOutputFailed(err)
+	}
+	tags := make([]byte, stats.TotalPages*PageTagSize)
+	stats.ChangedPages, err = decryptPages(ctx, dbfile, dbFile, tmp, stats.TotalPages, encKey, macKey, hashFunc, hmacSize, reserve, pageSize, 0, prevTags, tags)
+	if err != nil {
+		return stats, err
+	}
+
+	if err := tmp.Close(); err != nil {
+		return stats, errors.WriteOutputFailed(err)
+	}
+	tmp = nil
+	if err := os.Rename(tmpPath, outputPath); err != nil {
+		os.Remove(tmpPath)
+		return stats, errors.WriteOutputFailed(err)
+	}
+
+	// 输出先于索引落地：即使索引没有写成功，下次按旧索引比较也只会多解密一些页面
+	idx := &pageIndex{pageSize: pageSize, salt: dbInfo.Salt, tags: tags}
+	if err := idx.save(indexPath); err != nil {
+		log.Debug().Err(err).Msgf("failed to save page index %s", indexPath)
+	}
+	return stats, nil
+}
+
+// copyPrevOutput 把上次的输出复制到 dst，大小必须与索引记录的页数一致
+// Linux 上 io.Copy 在两个文件之间使用 copy_file_range，数据不经过用户态
+func copyPrevOutput(path string, dst *os.File, size int64) error {
+	src, err := os.Open(path)
+	if err != nil {
+		return err
+	}
+	defer src.Close()
+	fi, err := src.Stat()
+	if err != nil {
+		return err
+	}
+	if fi.Size() != size {
+		return fmt.Errorf("previous output is %d bytes, index expects %d", fi.Size(), size)
+	}
+	_, err = io.Copy(dst, src)
+	return err
+}
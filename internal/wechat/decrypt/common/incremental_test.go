@@ -0,0 +1,138 @@
+package common
+
+import (
+	"bytes"
+	"context"
+	"crypto/sha512"
+	"os"
+	"path/filepath"
+	"testing"
+)
+
+func TestDecryptIncremental(t *testing.T) {
+	tests := []struct {
+		name      string
+		pages     int
+		zeroPages []int
+		changed   []int // 第二次解密前重新写入的页
+		grow      int   // 第二次解密前追加的页数
+		truncate  int   // 第二次解密前截掉的页数
+	}{
+		{name: "unchanged", pages: 10},
+		{name: "one chunk", pages: 10, changed: []int{0, 3}},
+		{name: "several chunks", pages: 3*ParallelChunkPages + 5, changed: []int{1, 64, 65, 196}},
+		{name: "zero page filled", pages: 2 * ParallelChunkPages, zeroPages: []int{5, 64, 127}, changed: []int{5}},
+		{name: "grow", pages: ParallelChunkPages + 1, grow: ParallelChunkPages},
+		{name: "shrink", pages: 2*ParallelChunkPages + 3, changed: []int{2}, truncate: ParallelChunkPages},
+	}
+
+	for i, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			ctx := context.Background()
+			dir := t.TempDir()
+			db := newTestDB(int64(i+100), tt.pages, tt.zeroPages...)
+			enc := db.encrypt(t)
+			dbPath := filepath.Join(dir, "test.db")
+			writeFile(t, dbPath, enc)
+
+			// 第一次没有索引，完整解密并建立 .pages
+			outPath := filepath.Join(dir, "incremental.db")
+			stats, err := DecryptIncremental(ctx, dbPath, db.key, outPath, "", testDeriveKeys,
+				sha512.New, testHMACSize, testReserve, testPageSize)
+			if err != nil {
+				t.Fatal(err)
+			}
+			if !stats.Full || stats.TotalPages != int64(tt.pages) {
+				t.Fatalf("first run: %+v", stats)
+			}
+			got, _ := os.ReadFile(outPath)
+			if !bytes.Equal(got, decryptFull(t, enc, db.key)) {
+				t.Fatal("incremental output differs from full decryption")
+			}
+			if _, err := os.Stat(outPath + PageIndexSuffix); err != nil {
+				t.Fatal("page index not written:", err)
+			}
+
+			// 改写、追加或截断页面后再做一次，只有变化的页重新解密
+			for _, pgno := range tt.changed {
+				db.plain[pgno] = db.random(testPageSize - testReserve)
+			}
+			for j := 0; j < tt.grow; j++ {
+				db.plain = append(db.plain, db.random(testPageSize-testReserve))
+			}
+			db.plain = db.plain[:len(db.plain)-tt.truncate]
+			// 重新加密会给所有页换新的 IV，没变化的页沿用上次的密文
+			enc2 := db.encrypt(t)
+			changed := make(map[int]bool)
+			for _, pgno := range tt.changed {
+				changed[pgno] = true
+			}
+			for pgno := 0; pgno < tt.pages-tt.truncate; pgno++ {
+				if !changed[pgno] {
+					copy(enc2[pgno*testPageSize:(pgno+1)*testPageSize], enc[pgno*testPageSize:])
+				}
+			}
+			writeFile(t, dbPath, enc2)
+
+			stats, err = DecryptIncremental(ctx, dbPath, db.key, outPath, "", testDeriveKeys,
+				sha512.New, testHMACSize, testReserve, testPageSize)
+			if err != nil {
+				t.Fatal(err)
+			}
+			if wantChanged := int64(len(tt.changed) + tt.grow); stats.Full || stats.ChangedPages != wantChanged {
+				t.Fatalf("second run: %+v, want %d changed pages", stats, wantChanged)
+			}
+			got, _ = os.ReadFile(outPath)
+			if !bytes.Equal(got, decryptFull(t, enc2, db.key)) {
+				t.Fatal("incremental update differs from full decryption")
+			}
+		})
+	}
+}
+
+func TestDecryptIncrementalStaleIndex(t *testing.T) {
+	ctx := context.Background()
+	dir := t.TempDir()
+	db := newTestDB(9, 5)
+	enc := db.encrypt(t)
+	dbPath := filepath.Join(dir, "test.db")
+	writeFile(t, dbPath, enc)
+	outPath := filepath.Join(dir, "out.db")
+	if _, err := DecryptIncremental(ctx, dbPath, db.key, outPath, "", testDeriveKeys,
+		sha512.New, testHMACSize, testReserve, testPageSize); err != nil {
+		t.Fatal(err)
+	}
+
+	// 输出被其他方式改写过（大小与索引对不上）时做完整解密
+	writeFile(t, outPath, []byte("rewritten"))
+	stats, err := DecryptIncremental(ctx, dbPath, db.key, outPath, "", testDeriveKeys,
+		sha512.New, testHMACSize, testReserve, testPageSize)
+	if err != nil {
+		t.Fatal(err)
+	}
+	got, _ := os.ReadFile(outPath)
+	if !stats.Full || !bytes.Equal(got, decryptFull(t, enc, db.key)) {
+		t.Fatalf("stale output not replaced: %+v", stats)
+	}
+}
+
+func TestDecryptIncrementalWrongKey(t *testing.T) {
+	dir := t.TempDir()
+	db := newTestDB(7, 4)
+	dbPath := filepath.Join(dir, "test.db")
+	writeFile(t, dbPath, db.encrypt(t))
+	outPath := filepath.Join(dir, "out.db")
+	writeFile(t, outPath, []byte("previous output"))
+
+	key := append([]byte(nil), db.key...)
+	key[0] ^= 1
+	_, err := DecryptIncremental(context.Background(), dbPath, key, outPath, "", testDeriveKeys,
+		sha512.New, testHMACSize, testReserve, testPageSize)
+	if err == nil {
+		t.Fatal("wrong key accepted")
+	}
+	got, _ := os.ReadFile(outPath)
+	if string(got) != "previous output" {
+		t.Fatal("wrong key modified the existing output")
+	}
+}
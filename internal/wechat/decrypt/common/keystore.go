@@ -0,0 +1,204 @@
+package common
+
+import (
+	"bytes"
+	"crypto/hmac"
+	"crypto/sha512"
+	"hash"
+	"os"
+	"sync"
+
+	"github.com/rs/zerolog/log"
+)
+
+const (
+	// DerivedKeyFileName 派生密钥存储在工作目录下的文件名
+	DerivedKeyFileName = ".derived_keys"
+
+	// KDFV4 V4 的派生方式：PBKDF2-HMAC-SHA512 256000 轮，与 C 侧 DERIVED_KEYS_KDF_V4 一致
+	KDFV4 = "pbkdf2-sha512-256000"
+	// KDFV3 Windows V3 的派生方式：PBKDF2-HMAC-SHA1 64000 轮
+	KDFV3 = "pbkdf2-sha1-64000"
+
+	derivedKeyMagic   = "CLDKEYS1"
+	derivedKeyIDSize  = 16
+	derivedKeyTagSize = 16
+	derivedKeyRecord  = derivedKeyIDSize + KeySize*2 + derivedKeyTagSize
+
+	derivedKeySealLabel = "chatlog derived key seal"
+	derivedKeyIDLabel   = "chatlog derived key id:"
+)
+
+// KeyStore 派生密钥存储，格式与 c_code/common/derived_keys.h 一致
+//
+// 一个微信账号下所有数据库的原始密钥相同，但 salt 各不相同，每个数据库都要单独跑一遍
+// PBKDF2。这里按 (kdf, 原始密钥, salt) 记录已经用第一页校验通过的派生结果，
+// 服务运行期间每个数据库只派生一次。设置了文件时由 Flush 落盘（与 C 侧显式调用
+// derived_keys_save 一样，一批校验或解密结束后写一次），重启后直接读出；
+// testkey 和 v4_decrypt -k 写入的记录也能直接使用。
+// 落盘记录由原始密钥封装，没有原始密钥既无法解开也无法判断属于哪个数据库。
+type KeyStore struct {
+	mu      sync.Mutex
+	records map[[derivedKeyIDSize]byte][]byte // id -> sealed | tag
+	path    string
+	dirty   bool // 有还没落盘的记录
+}
+
+// DefaultKeyStore 解密器共用的派生密钥存储
+var DefaultKeyStore = NewKeyStore()
+
+func NewKeyStore() *KeyStore {
+	return &KeyStore{records: make(map[[derivedKeyIDSize]byte][]byte)}
+}
+
+// SetFile 设置落盘文件并读入其中的记录，路径不变时什么都不做
+func (s *KeyStore) SetFile(path string) {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.path == path {
+		return
+	}
+	s.path = path
+	s.loadLocked()
+}
+
+// loadLocked 读入落盘文件中内存里还没有的记录
+func (s *KeyStore) loadLocked() {
+	if s.path == "" {
+		return
+	}
+	data, err := os.ReadFile(s.path)
+	if err != nil || !bytes.HasPrefix(data, []byte(derivedKeyMagic)) {
+		return
+	}
+	data = data[len(derivedKeyMagic):]
+	for ; len(data) >= derivedKeyRecord; data = data[derivedKeyRecord:] {
+		var id [derivedKeyIDSize]byte
+		copy(id[:], data)
+		if _, ok := s.records[id]; !ok {
+			s.records[id] = append([]byte(nil), data[derivedKeyIDSize:derivedKeyRecord]...)
+		}
+	}
+}
+
+// saveLocked 合并其他进程写入的记录后整体重写，先写临时文件再改名
+func (s *KeyStore) saveLocked() error {
+	s.loadLocked()
+	buf := make([]byte, 0, len(derivedKeyMagic)+len(s.records)*derivedKeyRecord)
+	buf = append(buf, derivedKeyMagic...)
+	for id, rec := range s.records {
+		buf = append(buf, id[:]...)
+		buf = append(buf, rec...)
+	}
+	tmp := s.path + ".tmp"
+	if err := os.WriteFile(tmp, buf, 0600); err != nil {
+		return err
+	}
+	return os.Rename(tmp, s.path)
+}
+
+func derivedKeyHMAC(key []byte, parts ...[]byte) []byte {
+	mac := hmac.New(sha512.New, key)
+	for _, p := range parts {
+		mac.Write(p)
+	}
+	return mac.Sum(nil)
+}
+
+func derivedKeyID(kdf string, key, salt []byte) [derivedKeyIDSize]byte {
+	var id [derivedKeyIDSize]byte
+	copy(id[:], derivedKeyHMAC(key, []byte(derivedKeyIDLabel), []byte(kdf), []byte(":"), salt))
+	return id
+}
+
+// sealMaterial 返回 id 对应的密钥流和认证密钥
+func sealMaterial(key []byte, id []byte) (stream []byte, tagKey []byte) {
+	seal := derivedKeyHMAC(key, []byte(derivedKeySealLabel))
+	return derivedKeyHMAC(seal[:32], id), seal[32:]
+}
+
+// Get 查询派生结果，命中并通过认证时返回 enc_key/mac_key
+func (s *KeyStore) Get(kdf string, key, salt []byte) ([]byte, []byte, bool) {
+	id := derivedKeyID(kdf, key, salt)
+	s.mu.Lock()
+	rec, ok := s.records[id]
+	s.mu.Unlock()
+	if !ok {
+		return nil, nil, false
+	}
+
+	stream, tagKey := sealMaterial(key, id[:])
+	sealed, tag := rec[:KeySize*2], rec[KeySize*2:]
+	if !hmac.Equal(derivedKeyHMAC(tagKey, id[:], sealed)[:derivedKeyTagSize], tag) {
+		log.Debug().Msg("derived key record failed authentication, ignoring")
+		return nil, nil, false
+	}
+	keys := make([]byte, KeySize*2)
+	for i := range keys {
+		keys[i] = sealed[i] ^ stream[i]
+	}
+	return keys[:KeySize], keys[KeySize:], true
+}
+
+// Put 记录一个已经用数据库第一页校验过的派生结果，不要存未经校验的候选
+// 只修改内存中的记录，落盘由 Flush 完成
+func (s *KeyStore) Put(kdf string, key, salt, encKey, macKey []byte) {
+	id := derivedKeyID(kdf, key, salt)
+	stream, tagKey := sealMaterial(key, id[:])
+	rec := make([]byte, 0, KeySize*2+derivedKeyTagSize)
+	for i := 0; i < KeySize; i++ {
+		rec = append(rec, encKey[i]^stream[i])
+	}
+	for i := 0; i < KeySize; i++ {
+		rec = append(rec, macKey[i]^stream[KeySize+i])
+	}
+	rec = append(rec, derivedKeyHMAC(tagKey, id[:], rec)[:derivedKeyTagSize]...)
+
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if old, ok := s.records[id]; ok && bytes.Equal(old, rec) {
+		return
+	}
+	s.records[id] = rec
+	s.dirty = true
+}
+
+// Flush 把 Put 之后新增的记录写入落盘文件，没有新记录或没有设置文件时什么都不做
+func (s *KeyStore) Flush() {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if !s.dirty || s.path == "" {
+		return
+	}
+	if err := s.saveLocked(); err != nil {
+		log.Debug().Err(err).Msgf("failed to save derived keys to %s", s.path)
+		return
+	}
+	s.dirty = false
+}
+
+// DeriveValidKeys 派生 page1 所属数据库的 enc_key/mac_key 并用第一页的 HMAC 校验
+// 存储中已有结果时跳过 PBKDF2；记录校验不通过（例如存储文件被改动过）时重新派生，
+// 只有校验通过的结果才会写入存储，扫描密钥时大量的错误候选不会进入存储。
+// kdf 为空时不使用存储（派生本身很便宜的版本）
+func DeriveValidKeys(kdf string, page1 []byte, key []byte, deriveKeys func([]byte, []byte) ([]byte, []byte),
+	hashFunc func() hash.Hash, hmacSize int, reserve int, pageSize int) ([]byte, []byte, bool) {
+	if len(page1) < pageSize || len(key) != KeySize {
+		return nil, nil, false
+	}
+	salt := page1[:SaltSize]
+	if kdf != "" {
+		encKey, macKey, cached := DefaultKeyStore.Get(kdf, key, salt)
+		if cached && VerifyFirstPage(page1, macKey, hashFunc, hmacSize, reserve, pageSize) {
+			return encKey, macKey, true
+		}
+	}
+	encKey, macKey := deriveKeys(key, salt)
+	if !VerifyFirstPage(page1, macKey, hashFunc, hmacSize, reserve, pageSize) {
+		return nil, nil, false
+	}
+	if kdf != "" {
+		DefaultKeyStore.Put(kdf, key, salt, encKey, macKey)
+	}
+	return encKey, macKey, true
+}
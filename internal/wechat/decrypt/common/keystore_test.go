@@ -0,0 +1,193 @@
+package common
+
+import (
+	"bytes"
+	"crypto/sha512"
+	"os"
+	"path/filepath"
+	"testing"
+)
+
+func TestKeyStoreRejectsTamperedRecord(t *testing.T) {
+	db := newTestDB(11, 1)
+	encKey, macKey := testDeriveKeys(db.key, db.salt)
+
+	tests := []struct {
+		name   string
+		offset int // 相对于记录开头：id(16) | sealed(64) | tag(16)
+		ok     bool
+	}{
+		{name: "untouched", offset: -1, ok: true},
+		{name: "id", offset: 0},
+		{name: "sealed enc_key", offset: derivedKeyIDSize},
+		{name: "sealed mac_key", offset: derivedKeyIDSize + KeySize + 5},
+		{name: "tag", offset: derivedKeyRecord - 1},
+	}
+
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			path := filepath.Join(t.TempDir(), DerivedKeyFileName)
+			s := NewKeyStore()
+			s.SetFile(path)
+			s.Put(KDFV4, db.key, db.salt, encKey, macKey)
+			s.Flush()
+
+			data, err := os.ReadFile(path)
+			if err != nil {
+				t.Fatal(err)
+			}
+			if len(data) != len(derivedKeyMagic)+derivedKeyRecord || !bytes.HasPrefix(data, []byte(derivedKeyMagic)) {
+				t.Fatalf("unexpected store file size %d", len(data))
+			}
+			if tt.offset >= 0 {
+				data[len(derivedKeyMagic)+tt.offset] ^= 0x01
+			}
+			writeFile(t, path, data)
+
+			s = NewKeyStore()
+			s.SetFile(path)
+			gotEnc, gotMac, ok := s.Get(KDFV4, db.key, db.salt)
+			if ok != tt.ok {
+				t.Fatalf("Get ok = %v, want %v", ok, tt.ok)
+			}
+			if ok && (!bytes.Equal(gotEnc, encKey) || !bytes.Equal(gotMac, macKey)) {
+				t.Fatal("Get returned different keys")
+			}
+		})
+	}
+
+	// 记录只能用原始密钥和同一个 kdf 解开
+	s := NewKeyStore()
+	s.Put(KDFV4, db.key, db.salt, encKey, macKey)
+	other := append([]byte(nil), db.key...)
+	other[0] ^= 1
+	if _, _, ok := s.Get(KDFV4, other, db.salt); ok {
+		t.Fatal("record opened with another key")
+	}
+	if _, _, ok := s.Get(KDFV3, db.key, db.salt); ok {
+		t.Fatal("record opened with another kdf")
+	}
+}
+
+func TestKeyStoreFlush(t *testing.T) {
+	path := filepath.Join(t.TempDir(), DerivedKeyFileName)
+	s := NewKeyStore()
+	s.SetFile(path)
+
+	// Put 只改内存，多个记录在 Flush 时一次写入
+	var dbs []*testDB
+	for i := 0; i < 3; i++ {
+		db := newTestDB(int64(30+i), 1)
+		encKey, macKey := testDeriveKeys(db.key, db.salt)
+		s.Put(KDFV4, db.key, db.salt, encKey, macKey)
+		dbs = append(dbs, db)
+	}
+	if _, err := os.Stat(path); !os.IsNotExist(err) {
+		t.Fatalf("Put wrote the store file: %v", err)
+	}
+	s.Flush()
+	data, err := os.ReadFile(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(data) != len(derivedKeyMagic)+len(dbs)*derivedKeyRecord {
+		t.Fatalf("store file has %d bytes, want %d records", len(data), len(dbs))
+	}
+
+	// 没有新记录时不再重写；其他进程写入的记录在下次落盘时合并保留
+	other := NewKeyStore()
+	other.SetFile(path)
+	extra := newTestDB(40, 1)
+	encKey, macKey := testDeriveKeys(extra.key, extra.salt)
+	other.Put(KDFV4, extra.key, extra.salt, encKey, macKey)
+	other.Flush()
+	s.Flush()
+	if got, _ := os.ReadFile(path); len(got) != len(data)+derivedKeyRecord {
+		t.Fatalf("store file has %d bytes after a clean Flush, want %d", len(got), len(data)+derivedKeyRecord)
+	}
+
+	reloaded := NewKeyStore()
+	reloaded.SetFile(path)
+	for _, db := range append(dbs, extra) {
+		if _, _, ok := reloaded.Get(KDFV4, db.key, db.salt); !ok {
+			t.Fatal("flushed record missing after reload")
+		}
+	}
+}
+
+// useTestKeyStore 在测试期间把 DefaultKeyStore 换成空的存储
+func useTestKeyStore(t *testing.T) {
+	saved := DefaultKeyStore
+	DefaultKeyStore = NewKeyStore()
+	t.Cleanup(func() { DefaultKeyStore = saved })
+}
+
+func TestDeriveValidKeysCachesResult(t *testing.T) {
+	const kdf = "test-cache"
+	useTestKeyStore(t)
+	db := newTestDB(13, 1)
+	page1 := db.encrypt(t)
+
+	derived := 0
+	derive := func(key, salt []byte) ([]byte, []byte) {
+		derived++
+		return testDeriveKeys(key, salt)
+	}
+	for i := 0; i < 3; i++ {
+		if _, _, ok := DeriveValidKeys(kdf, page1, db.key, derive, sha512.New, testHMACSize, testReserve, testPageSize); !ok {
+			t.Fatal("valid key rejected")
+		}
+	}
+	if derived != 1 {
+		t.Fatalf("derived %d times, want 1", derived)
+	}
+
+	// 校验不通过的候选不进入存储
+	other := append([]byte(nil), db.key...)
+	other[0] ^= 1
+	if _, _, ok := DeriveValidKeys(kdf, page1, other, testDeriveKeys, sha512.New, testHMACSize, testReserve, testPageSize); ok {
+		t.Fatal("wrong key accepted")
+	}
+	if _, _, ok := DefaultKeyStore.Get(kdf, other, db.salt); ok {
+		t.Fatal("wrong key stored")
+	}
+}
+
+func TestDeriveValidKeysStaleRecord(t *testing.T) {
+	const kdf = "test-stale-record"
+	useTestKeyStore(t)
+	db := newTestDB(12, 1)
+	page1 := db.encrypt(t)
+	encKey, macKey := testDeriveKeys(db.key, db.salt)
+
+	// 认证通过但与数据库对不上的记录（例如用错误的派生结果写入）
+	DefaultKeyStore.Put(kdf, db.key, db.salt, macKey, encKey)
+
+	derived := 0
+	derive := func(key, salt []byte) ([]byte, []byte) {
+		derived++
+		return testDeriveKeys(key, salt)
+	}
+	gotEnc, gotMac, ok := DeriveValidKeys(kdf, page1, db.key, derive, sha512.New, testHMACSize, testReserve, testPageSize)
+	if !ok || !bytes.Equal(gotEnc, encKey) || !bytes.Equal(gotMac, macKey) {
+		t.Fatal("stale record was not replaced by a fresh derivation")
+	}
+	if derived != 1 {
+		t.Fatalf("derived %d times, want 1", derived)
+	}
+
+	// 重新派生的结果已经写回存储，不再派生
+	if _, _, ok := DeriveValidKeys(kdf, page1, db.key, derive, sha512.New, testHMACSize, testReserve, testPageSize); !ok || derived != 1 {
+		t.Fatalf("cached record not used: ok=%v derived=%d", ok, derived)
+	}
+
+	// 重新派生也校验不过时才失败
+	wrong := func(key, salt []byte) ([]byte, []byte) {
+		return macKey, encKey
+	}
+	other := append([]byte(nil), db.key...)
+	other[0] ^= 1
+	if _, _, ok := DeriveValidKeys(kdf, page1, other, wrong, sha512.New, testHMACSize, testReserve, testPageSize); ok {
+		t.Fatal("wrong key accepted")
+	}
+}
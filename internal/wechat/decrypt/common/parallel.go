@@ -0,0 +1,207 @@
+package common
+
+import (
+	"bytes"
+	"context"
+	"crypto/aes"
+	"crypto/cipher"
+	"crypto/hmac"
+	"encoding/binary"
+	"hash"
+	"io"
+	"os"
+	"runtime"
+	"sync"
+	"sync/atomic"
+
+	"github.com/sjzar/chatlog/internal/errors"
+)
+
+// ParallelChunkPages 每个 worker 一次领取的页数
+const ParallelChunkPages = 64
+
+// ParallelOutput 判断输出能否按页偏移并行写入
+// 只有当前偏移为 0 的普通文件才走并行路径，管道、网络连接等仍按顺序写出
+func ParallelOutput(output io.Writer) (*os.File, bool) {
+	if runtime.NumCPU() < 2 {
+		return nil, false
+	}
+	f, ok := output.(*os.File)
+	if !ok {
+		return nil, false
+	}
+	fi, err := f.Stat()
+	if err != nil || !fi.Mode().IsRegular() {
+		return nil, false
+	}
+	if off, err := f.Seek(0, io.SeekCurrent); err != nil || off != 0 {
+		return nil, false
+	}
+	return f, true
+}
+
+// DecryptPagesParallel 多线程解密前 totalPages 个完整页面
+// V4 每页有独立的 IV 和按页号计算的 HMAC，页面之间没有依赖：worker 按 ParallelChunkPages
+// 领取页面区间，原地校验并解密后写回 page * pageSize 处，不需要排序。
+// 输出与逐页调用 DecryptPage 的结果一致，第 0 页的 salt 位置写 SQLite 文件头。
+func DecryptPagesParallel(ctx context.Context, dbPath string, input io.ReaderAt, output io.WriterAt, totalPages int64,
+	encKey []byte, macKey []byte, hashFunc func() hash.Hash, hmacSize int, reserve int, pageSize int, workers int) error {
+	_, err := decryptPages(ctx, dbPath, input, output, totalPages, encKey, macKey, hashFunc, hmacSize, reserve, pageSize, workers, nil, nil)
+	return err
+}
+
+// decryptPages DecryptPagesParallel 的实现
+// tags 不为 nil 时把每页 HMAC 的前 PageTagSize 字节记录到 tags[pgno*PageTagSize:]；
+// prevTags 不为 nil 时跳过标签与上次相同的页面，只写出变化的页面，返回写出的页数
+// 由 ScheduleDecrypt 调度时 workers <= 0 使用调度器分给这个文件的 worker 数，并报告处理过的页数
+func decryptPages(ctx context.Context, dbPath string, input io.ReaderAt, output io.WriterAt, totalPages int64,
+	encKey []byte, macKey []byte, hashFunc func() hash.Hash, hmacSize int, reserve int, pageSize int, workers int,
+	prevTags []byte, tags []byte) (int64, error) {
+	tuning := tuningFrom(ctx)
+	if workers <= 0 && tuning != nil {
+		workers = tuning.workers
+	}
+	if workers <= 0 {
+		workers = runtime.NumCPU()
+	}
+	if tuning != nil {
+		tuning.total.Store(totalPages)
+	}
+	if chunks := (totalPages + ParallelChunkPages - 1) / ParallelChunkPages; int64(workers) > chunks {
+		workers = int(chunks)
+	}
+
+	block, err := aes.NewCipher(encKey)
+	if err != nil {
+		return 0, errors.DecryptCreateCipherFailed(err)
+	}
+
+	tagOffset := int64(pageSize - reserve + IVSize)
+	prevPages := int64(len(prevTags) / PageTagSize)
+	var next atomic.Int64
+	var changed atomic.Int64
+	var failed atomic.Bool
+	var firstErr error
+	var errOnce sync.Once
+	fail := func(err error) {
+		errOnce.Do(func() {
+			firstErr = err
+			failed.Store(true)
+		})
+	}
+
+	var wg sync.WaitGroup
+	for i := 0; i < workers; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+
+			buf := make([]byte, ParallelChunkPages*pageSize)
+			mac := hmac.New(hashFunc, macKey)
+			for !failed.Load() {
+				if ctx.Err() != nil {
+					fail(errors.ErrDecryptOperationCanceled)
+					return
+				}
+
+				start := next.Add(ParallelChunkPages) - ParallelChunkPages
+				if start >= totalPages {
+					return
+				}
+				count := min(int64(ParallelChunkPages), totalPages-start)
+				chunk := buf[:count*int64(pageSize)]
+				if _, err := input.ReadAt(chunk, start*int64(pageSize)); err != nil {
+					fail(errors.ReadFileFailed(dbPath, err))
+					return
+				}
+
+				// 连续变化的页面合并成一次写入
+				runStart := int64(-1)
+				flush := func(end int64) bool {
+					if runStart < 0 {
+						return true
+					}
+					run := chunk[runStart*int64(pageSize) : end*int64(pageSize)]
+					if _, err := output.WriteAt(run, (start+runStart)*int64(pageSize)); err != nil {
+						fail(errors.WriteOutputFailed(err))
+						return false
+					}
+					changed.Add(end - runStart)
+					runStart = -1
+					return true
+				}
+
+				for j := int64(0); j < count; j++ {
+					pgno := start + j
+					page := chunk[j*int64(pageSize) : (j+1)*int64(pageSize)]
+					tag := page[tagOffset : tagOffset+PageTagSize]
+					if tags != nil {
+						copy(tags[pgno*PageTagSize:], tag)
+					}
+					if pgno < prevPages && bytes.Equal(tag, prevTags[pgno*PageTagSize:(pgno+1)*PageTagSize]) {
+						if !flush(j) {
+							return
+						}
+						continue
+					}
+
+					if !isZeroPage(page) {
+						if err := decryptPageInPlace(page, block, mac, pgno, hmacSize, reserve, pageSize); err != nil {
+							fail(err)
+							return
+						}
+						if pgno == 0 {
+							copy(page, SQLiteHeader)
+						}
+					}
+					if runStart < 0 {
+						runStart = j
+					}
+				}
+				if !flush(count) {
+					return
+				}
+				if tuning != nil {
+					tuning.done.Add(count)
+				}
+			}
+		}()
+	}
+	wg.Wait()
+
+	return changed.Load(), firstErr
+}
+
+// decryptPageInPlace 与 DecryptPage 相同的校验和解密，HMAC 由调用方复用，结果写回 pageBuf
+// 第 0 页的前 SaltSize 字节保持不变
+func decryptPageInPlace(pageBuf []byte, block cipher.Block, mac hash.Hash, pageNum int64, hmacSize int, reserve int, pageSize int) error {
+	offset := 0
+	if pageNum == 0 {
+		offset = SaltSize
+	}
+
+	mac.Reset()
+	mac.Write(pageBuf[offset : pageSize-reserve+IVSize])
+	var pageNoBytes [4]byte
+	binary.LittleEndian.PutUint32(pageNoBytes[:], uint32(pageNum+1))
+	mac.Write(pageNoBytes[:])
+
+	var sum [64]byte
+	hashMacStartOffset := pageSize - reserve + IVSize
+	if !bytes.Equal(mac.Sum(sum[:0]), pageBuf[hashMacStartOffset:hashMacStartOffset+hmacSize]) {
+		return errors.ErrDecryptHashVerificationFailed
+	}
+
+	iv := pageBuf[pageSize-reserve : pageSize-reserve+IVSize]
+	cipher.NewCBCDecrypter(block, iv).CryptBlocks(pageBuf[offset:pageSize-reserve], pageBuf[offset:pageSize-reserve])
+	return nil
+}
+
+func isZeroPage(page []byte) bool {
+	for _, b := range page {
+		if b != 0 {
+			return false
+		}
+	}
+	return true
+}
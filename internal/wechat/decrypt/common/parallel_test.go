@@ -0,0 +1,187 @@
+package common
+
+import (
+	"bytes"
+	"context"
+	"crypto/aes"
+	"crypto/cipher"
+	"crypto/hmac"
+	"crypto/sha512"
+	"encoding/binary"
+	"math/rand"
+	"os"
+	"path/filepath"
+	"testing"
+)
+
+// 与 V4 相同的页面布局
+const (
+	testPageSize = 4096
+	testReserve  = 80
+	testHMACSize = 64
+)
+
+// testDeriveKeys 代替 PBKDF2 的廉价派生，页面格式与真实数据库相同
+func testDeriveKeys(key []byte, salt []byte) ([]byte, []byte) {
+	mac := hmac.New(sha512.New, key)
+	mac.Write(salt)
+	encKey := mac.Sum(nil)[:KeySize]
+	mac = hmac.New(sha512.New, encKey)
+	mac.Write(XorBytes(salt, 0x3a))
+	return encKey, mac.Sum(nil)[:KeySize]
+}
+
+// testDB 合成的加密数据库，plain[i] 为 nil 的页是全零页（不加密）
+type testDB struct {
+	key   []byte
+	salt  []byte
+	plain [][]byte
+	rng   *rand.Rand
+}
+
+func newTestDB(seed int64, pages int, zeroPages ...int) *testDB {
+	db := &testDB{rng: rand.New(rand.NewSource(seed))}
+	db.key = db.random(KeySize)
+	db.salt = db.random(SaltSize)
+	zero := make(map[int]bool)
+	for _, i := range zeroPages {
+		zero[i] = true
+	}
+	for i := 0; i < pages; i++ {
+		if zero[i] {
+			db.plain = append(db.plain, nil)
+		} else {
+			db.plain = append(db.plain, db.random(testPageSize-testReserve))
+		}
+	}
+	return db
+}
+
+func (db *testDB) random(n int) []byte {
+	b := make([]byte, n)
+	db.rng.Read(b)
+	return b
+}
+
+// encrypt 按 V4 的格式加密所有页面：AES-256-CBC，IV 和 HMAC-SHA512 在页尾的保留区
+func (db *testDB) encrypt(t testing.TB) []byte {
+	t.Helper()
+	encKey, macKey := testDeriveKeys(db.key, db.salt)
+	block, err := aes.NewCipher(encKey)
+	if err != nil {
+		t.Fatal(err)
+	}
+	out := make([]byte, len(db.plain)*testPageSize)
+	for pgno, plain := range db.plain {
+		if plain == nil {
+			continue
+		}
+		page := out[pgno*testPageSize : (pgno+1)*testPageSize]
+		offset := 0
+		if pgno == 0 {
+			offset = SaltSize
+			copy(page, db.salt)
+		}
+		dataEnd := testPageSize - testReserve
+		iv := db.random(IVSize)
+		copy(page[dataEnd:], iv)
+		cipher.NewCBCEncrypter(block, iv).CryptBlocks(page[offset:dataEnd], plain[offset:])
+
+		mac := hmac.New(sha512.New, macKey)
+		mac.Write(page[offset : dataEnd+IVSize])
+		binary.Write(mac, binary.LittleEndian, uint32(pgno+1))
+		copy(page[dataEnd+IVSize:], mac.Sum(nil))
+	}
+	return out
+}
+
+// decryptFull 逐页调用 DecryptPage 得到的完整解密结果，作为其他路径的参照
+func decryptFull(t testing.TB, enc []byte, key []byte) []byte {
+	t.Helper()
+	encKey, macKey := testDeriveKeys(key, enc[:SaltSize])
+	out := make([]byte, 0, len(enc))
+	for pgno := int64(0); pgno < int64(len(enc)/testPageSize); pgno++ {
+		page := enc[pgno*testPageSize : (pgno+1)*testPageSize]
+		if isZeroPage(page) {
+			out = append(out, page...)
+			continue
+		}
+		data, err := DecryptPage(page, encKey, macKey, pgno, sha512.New, testHMACSize, testReserve, testPageSize)
+		if err != nil {
+			t.Fatalf("page %d: %v", pgno, err)
+		}
+		if pgno == 0 {
+			out = append(out, SQLiteHeader...)
+		}
+		out = append(out, data...)
+	}
+	return out
+}
+
+func writeFile(t testing.TB, path string, data []byte) {
+	t.Helper()
+	if err := os.WriteFile(path, data, 0644); err != nil {
+		t.Fatal(err)
+	}
+}
+
+func TestDecryptPagesParallel(t *testing.T) {
+	tests := []struct {
+		name      string
+		pages     int
+		zeroPages []int
+		workers   int
+	}{
+		{name: "single page", pages: 1, workers: 1},
+		{name: "one chunk", pages: 10, workers: 4},
+		{name: "several chunks", pages: 3*ParallelChunkPages + 5, workers: 4},
+		{name: "more workers than chunks", pages: ParallelChunkPages + 1, workers: 16},
+		{name: "zero pages", pages: 2 * ParallelChunkPages, zeroPages: []int{5, 64, 127}, workers: 3},
+		{name: "default workers", pages: 2*ParallelChunkPages + 1, workers: 0},
+	}
+
+	for i, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			db := newTestDB(int64(i+1), tt.pages, tt.zeroPages...)
+			enc := db.encrypt(t)
+			want := decryptFull(t, enc, db.key)
+			if !bytes.Equal(want[:len(SQLiteHeader)], []byte(SQLiteHeader)) {
+				t.Fatal("full decryption did not produce a SQLite header")
+			}
+
+			out, err := os.Create(filepath.Join(t.TempDir(), "parallel.db"))
+			if err != nil {
+				t.Fatal(err)
+			}
+			defer out.Close()
+			encKey, macKey := testDeriveKeys(db.key, db.salt)
+			err = DecryptPagesParallel(context.Background(), "test.db", bytes.NewReader(enc), out, int64(tt.pages),
+				encKey, macKey, sha512.New, testHMACSize, testReserve, testPageSize, tt.workers)
+			if err != nil {
+				t.Fatal(err)
+			}
+			got, _ := os.ReadFile(out.Name())
+			if !bytes.Equal(got, want) {
+				t.Fatal("parallel output differs from full decryption")
+			}
+		})
+	}
+}
+
+func TestDecryptPagesParallelBadPage(t *testing.T) {
+	db := newTestDB(8, 2*ParallelChunkPages)
+	enc := db.encrypt(t)
+	enc[100*testPageSize+7] ^= 1
+
+	out, err := os.Create(filepath.Join(t.TempDir(), "parallel.db"))
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer out.Close()
+	encKey, macKey := testDeriveKeys(db.key, db.salt)
+	err = DecryptPagesParallel(context.Background(), "test.db", bytes.NewReader(enc), out, int64(len(db.plain)),
+		encKey, macKey, sha512.New, testHMACSize, testReserve, testPageSize, 4)
+	if err == nil {
+		t.Fatal("tampered page accepted")
+	}
+}
@@ -0,0 +1,223 @@
+package common
+
+import (
+	"context"
+	"runtime"
+	"sort"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+const (
+	// DefaultDecryptBudget 同时在解密的文件总大小上限，限制的是同时进行的文件 I/O 量
+	// （读输入、写输出、增量解密复制上次的输出），超过预算的文件排队等待；
+	// 单个文件比预算还大时独占预算运行。内存不随文件大小增长：每个 worker 只持有
+	// ParallelChunkPages 页的缓冲区，总量由 Workers 决定
+	DefaultDecryptBudget = 512 << 20
+
+	// DefaultProgressInterval 解密中的文件每隔多久报告一次进度
+	DefaultProgressInterval = 2 * time.Second
+
+	// bytesPerWorker 每个页面 worker 至少分到的数据量，约 16 个 ParallelChunkPages 区间，
+	// 小文件只用一个 worker，多出来的核给其他文件
+	bytesPerWorker = 4 << 20
+)
+
+// DecryptJob 调度器中的一个待解密文件
+type DecryptJob struct {
+	Path string
+	Size int64
+}
+
+// DecryptProgress 一个文件的解密进度
+type DecryptProgress struct {
+	Path       string
+	Size       int64
+	DonePages  int64 // 已经处理的页数，增量解密中未变化而跳过的页也计入
+	TotalPages int64 // 还没开始按页解密时为 0
+	Workers    int
+	Elapsed    time.Duration
+	Finished   bool
+	Err        error // Finished 时的结果
+}
+
+// Throughput 按文件大小计算的吞吐量，单位 MB/s；还没完成时按已处理的页数估算
+func (p DecryptProgress) Throughput() float64 {
+	secs := p.Elapsed.Seconds()
+	if secs <= 0 {
+		return 0
+	}
+	done := float64(p.Size)
+	if !p.Finished && p.TotalPages > 0 {
+		done = float64(p.Size) * float64(p.DonePages) / float64(p.TotalPages)
+	}
+	return done / secs / (1 << 20)
+}
+
+// ScheduleOptions 调度参数，零值使用默认值
+type ScheduleOptions struct {
+	Workers          int           // 所有文件的页面 worker 之和，<= 0 时使用 CPU 数
+	Budget           int64         // 同时解密的文件总大小（I/O 量）上限，<= 0 时使用 DefaultDecryptBudget
+	ProgressInterval time.Duration // <= 0 时使用 DefaultProgressInterval
+	Progress         func(DecryptProgress)
+}
+
+// decryptTuning 调度器分给一个文件的 worker 数和进度计数，经 context 传给 decryptPages
+type decryptTuning struct {
+	workers int
+	total   atomic.Int64
+	done    atomic.Int64
+}
+
+type decryptTuningKey struct{}
+
+func tuningFrom(ctx context.Context) *decryptTuning {
+	t, _ := ctx.Value(decryptTuningKey{}).(*decryptTuning)
+	return t
+}
+
+// ScheduleDecrypt 解密一个账号下的所有数据库
+// 文件按大小从大到小开始：大文件按页区间并行解密，分到的 worker 数与大小成正比，
+// 但在还有文件排队时留出一个核；小文件只用一个 worker，多个文件同时进行填满其余的核。
+// 正在解密的文件总大小不超过 Budget。decrypt 收到的 ctx 携带分给这个文件的 worker 数，
+// 各平台解密器的按页并行路径（DecryptPagesParallel、DecryptIncremental）从中读取并报告进度。
+// 返回与 jobs 下标对应的错误；ctx 取消后还没开始的文件返回 ctx.Err()。
+func ScheduleDecrypt(ctx context.Context, jobs []DecryptJob, opts ScheduleOptions,
+	decrypt func(ctx context.Context, path string) error) []error {
+	results := make([]error, len(jobs))
+	workers := opts.Workers
+	if workers <= 0 {
+		workers = runtime.NumCPU()
+	}
+	budget := opts.Budget
+	if budget <= 0 {
+		budget = DefaultDecryptBudget
+	}
+	interval := opts.ProgressInterval
+	if interval <= 0 {
+		interval = DefaultProgressInterval
+	}
+
+	order := make([]int, len(jobs))
+	for i := range order {
+		order[i] = i
+	}
+	sort.SliceStable(order, func(a, b int) bool {
+		return jobs[order[a]].Size > jobs[order[b]].Size
+	})
+
+	type running struct {
+		job    DecryptJob
+		tuning *decryptTuning
+		start  time.Time
+	}
+	var mu sync.Mutex
+	cond := sync.NewCond(&mu)
+	free := workers
+	var used int64
+	active := make(map[int]*running)
+	stop := context.AfterFunc(ctx, func() {
+		mu.Lock()
+		cond.Broadcast()
+		mu.Unlock()
+	})
+	defer stop()
+
+	report := func(r *running, finished bool, err error) {
+		if opts.Progress == nil {
+			return
+		}
+		opts.Progress(DecryptProgress{
+			Path:       r.job.Path,
+			Size:       r.job.Size,
+			DonePages:  r.tuning.done.Load(),
+			TotalPages: r.tuning.total.Load(),
+			Workers:    r.tuning.workers,
+			Elapsed:    time.Since(r.start),
+			Finished:   finished,
+			Err:        err,
+		})
+	}
+
+	// 解密时间较长的文件定期报告进度
+	ticker := time.NewTicker(interval)
+	tickDone := make(chan struct{})
+	go func() {
+		defer ticker.Stop()
+		for {
+			select {
+			case <-ticker.C:
+				mu.Lock()
+				snapshot := make([]*running, 0, len(active))
+				for _, r := range active {
+					snapshot = append(snapshot, r)
+				}
+				mu.Unlock()
+				for _, r := range snapshot {
+					report(r, false, nil)
+				}
+			case <-tickDone:
+				return
+			}
+		}
+	}()
+
+	// 按大小顺序开始；排在前面的文件超出预算时，让后面放得下的小文件先开始
+	var wg sync.WaitGroup
+	pending := order
+	mu.Lock()
+	for len(pending) > 0 {
+		k := -1
+		for j, i := range pending {
+			if free > 0 && (used == 0 || used+min(jobs[i].Size, budget) <= budget) {
+				k = j
+				break
+			}
+		}
+		if ctx.Err() != nil {
+			for _, i := range pending {
+				results[i] = ctx.Err()
+			}
+			break
+		}
+		if k < 0 {
+			cond.Wait()
+			continue
+		}
+		i := pending[k]
+		pending = append(pending[:k:k], pending[k+1:]...)
+
+		job := jobs[i]
+		want := int((job.Size + bytesPerWorker - 1) / bytesPerWorker)
+		want = max(1, min(want, workers))
+		if len(pending) > 0 && want == workers && workers > 1 {
+			want = workers - 1
+		}
+		n := min(want, free)
+		cost := min(job.Size, budget)
+		free -= n
+		used += cost
+		r := &running{job: job, tuning: &decryptTuning{workers: n}, start: time.Now()}
+		active[i] = r
+
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			err := decrypt(context.WithValue(ctx, decryptTuningKey{}, r.tuning), job.Path)
+			results[i] = err
+
+			mu.Lock()
+			delete(active, i)
+			free += n
+			used -= cost
+			cond.Broadcast()
+			mu.Unlock()
+			report(r, true, err)
+		}()
+	}
+	mu.Unlock()
+	wg.Wait()
+	close(tickDone)
+	return results
+}
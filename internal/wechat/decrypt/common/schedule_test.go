@@ -0,0 +1,119 @@
+package common
+
+import (
+	"context"
+	"errors"
+	"strings"
+	"sync"
+	"testing"
+	"time"
+)
+
+func TestScheduleDecrypt(t *testing.T) {
+	tests := []struct {
+		name    string
+		sizes   []int64
+		workers int
+		budget  int64
+		order   string // 开始的顺序，只在同一时间只有一个文件时确定
+	}{
+		{name: "budget", sizes: []int64{60, 50, 40, 30, 10}, workers: 8, budget: 100},
+		{name: "file larger than budget", sizes: []int64{500, 20, 20}, workers: 4, budget: 100},
+		{name: "many small files", sizes: []int64{1, 2, 3, 4, 5, 6, 7, 8}, workers: 3, budget: 100},
+		{name: "largest first", sizes: []int64{10, 30, 20}, workers: 1, budget: 1000, order: "bca"},
+		{name: "budget for one", sizes: []int64{40, 60, 50}, workers: 4, budget: 60, order: "bca"},
+	}
+
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			var jobs []DecryptJob
+			size := make(map[string]int64)
+			for i, s := range tt.sizes {
+				path := string(rune('a' + i))
+				jobs = append(jobs, DecryptJob{Path: path, Size: s})
+				size[path] = s
+			}
+
+			var mu sync.Mutex
+			var started []string
+			var used int64
+			var workers int
+			decrypt := func(ctx context.Context, path string) error {
+				tuning := tuningFrom(ctx)
+				if tuning == nil || tuning.workers < 1 {
+					t.Errorf("%s: no workers assigned", path)
+					return nil
+				}
+				mu.Lock()
+				started = append(started, path)
+				used += min(size[path], tt.budget)
+				workers += tuning.workers
+				if used > tt.budget && used != min(size[path], tt.budget) {
+					t.Errorf("%s: %d bytes in flight, budget %d", path, used, tt.budget)
+				}
+				if workers > tt.workers {
+					t.Errorf("%s: %d workers in use, limit %d", path, workers, tt.workers)
+				}
+				mu.Unlock()
+
+				time.Sleep(5 * time.Millisecond)
+
+				mu.Lock()
+				used -= min(size[path], tt.budget)
+				workers -= tuning.workers
+				mu.Unlock()
+				return nil
+			}
+
+			var progress int
+			opts := ScheduleOptions{
+				Workers: tt.workers,
+				Budget:  tt.budget,
+				Progress: func(p DecryptProgress) {
+					mu.Lock()
+					if p.Finished {
+						progress++
+					}
+					mu.Unlock()
+				},
+			}
+			for i, err := range ScheduleDecrypt(context.Background(), jobs, opts, decrypt) {
+				if err != nil {
+					t.Errorf("%s: %v", jobs[i].Path, err)
+				}
+			}
+			if len(started) != len(jobs) {
+				t.Fatalf("%d jobs started, want %d", len(started), len(jobs))
+			}
+			if order := strings.Join(started, ""); tt.order != "" && order != tt.order {
+				t.Fatalf("start order %s, want %s", order, tt.order)
+			}
+			if progress != len(jobs) {
+				t.Fatalf("%d finished reports, want %d", progress, len(jobs))
+			}
+		})
+	}
+}
+
+func TestScheduleDecryptCancel(t *testing.T) {
+	ctx, cancel := context.WithCancel(context.Background())
+	jobs := []DecryptJob{{Path: "a", Size: 3}, {Path: "b", Size: 2}, {Path: "c", Size: 1}}
+	failed := errors.New("decrypt failed")
+
+	// 一个 worker，第一个文件执行时取消，后面的文件不再开始
+	results := ScheduleDecrypt(ctx, jobs, ScheduleOptions{Workers: 1}, func(ctx context.Context, path string) error {
+		if path != "a" {
+			t.Errorf("%s started after cancel", path)
+		}
+		cancel()
+		return failed
+	})
+	if !errors.Is(results[0], failed) {
+		t.Fatalf("a: %v", results[0])
+	}
+	for _, err := range results[1:] {
+		if !errors.Is(err, context.Canceled) {
+			t.Fatalf("pending job: %v, want context.Canceled", err)
+		}
+	}
+}
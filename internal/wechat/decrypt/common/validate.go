@@ -0,0 +1,105 @@
+package common
+
+import (
+	"context"
+	"hash"
+	"runtime"
+	"sync"
+)
+
+// ValidatePages 用同一个密钥校验多个数据库的第一页，返回每一页是否有效
+// 真正耗时的 PBKDF2 只取决于 salt：按 salt 分组后每组只派生一次（存储命中时不派生），
+// 组内每一页只做一次 HMAC 校验；各组之间并行，jobs <= 0 时使用 CPU 数。
+// 有一页校验通过的组会把派生结果写入 DefaultKeyStore，之后解密这些文件时不再派生。
+// kdf 为空时不使用存储（派生本身很便宜的版本）。
+func ValidatePages(ctx context.Context, kdf string, pages [][]byte, key []byte, deriveKeys func([]byte, []byte) ([]byte, []byte),
+	hashFunc func() hash.Hash, hmacSize int, reserve int, pageSize int, jobs int) []bool {
+	results := make([]bool, len(pages))
+	if len(key) != KeySize {
+		return results
+	}
+
+	// 按 salt 分组，保持文件的原始顺序
+	var groups [][]int
+	index := make(map[string]int)
+	for i, page := range pages {
+		if len(page) < pageSize {
+			continue
+		}
+		salt := string(page[:SaltSize])
+		g, ok := index[salt]
+		if !ok {
+			g = len(groups)
+			index[salt] = g
+			groups = append(groups, nil)
+		}
+		groups[g] = append(groups[g], i)
+	}
+
+	if jobs <= 0 {
+		jobs = runtime.NumCPU()
+	}
+	if jobs > len(groups) {
+		jobs = len(groups)
+	}
+
+	work := make(chan []int)
+	var wg sync.WaitGroup
+	for j := 0; j < jobs; j++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for group := range work {
+				validateGroup(kdf, pages, group, key, deriveKeys, hashFunc, hmacSize, reserve, pageSize, results)
+			}
+		}()
+	}
+	for _, group := range groups {
+		select {
+		case work <- group:
+		case <-ctx.Done():
+		}
+		if ctx.Err() != nil {
+			break
+		}
+	}
+	close(work)
+	wg.Wait()
+	return results
+}
+
+// validateGroup 校验 salt 相同的一组页面，每组的结果写到各自的下标，不需要加锁
+func validateGroup(kdf string, pages [][]byte, group []int, key []byte, deriveKeys func([]byte, []byte) ([]byte, []byte),
+	hashFunc func() hash.Hash, hmacSize int, reserve int, pageSize int, results []bool) {
+	salt := pages[group[0]][:SaltSize]
+	var encKey, macKey []byte
+	cached := false
+	if kdf != "" {
+		encKey, macKey, cached = DefaultKeyStore.Get(kdf, key, salt)
+	}
+	if !cached {
+		encKey, macKey = deriveKeys(key, salt)
+	}
+
+	valid := verifyGroup(pages, group, macKey, hashFunc, hmacSize, reserve, pageSize, results)
+	if !valid && cached {
+		// 存储中的记录对不上时重新派生一次，与 DeriveValidKeys 一致
+		encKey, macKey = deriveKeys(key, salt)
+		cached = false
+		valid = verifyGroup(pages, group, macKey, hashFunc, hmacSize, reserve, pageSize, results)
+	}
+	if valid && !cached && kdf != "" {
+		DefaultKeyStore.Put(kdf, key, salt, encKey, macKey)
+	}
+}
+
+// verifyGroup 用同一个 mac_key 校验一组页面，有一页通过时返回 true
+func verifyGroup(pages [][]byte, group []int, macKey []byte, hashFunc func() hash.Hash, hmacSize int, reserve int,
+	pageSize int, results []bool) bool {
+	valid := false
+	for _, i := range group {
+		results[i] = VerifyFirstPage(pages[i], macKey, hashFunc, hmacSize, reserve, pageSize)
+		valid = valid || results[i]
+	}
+	return valid
+}
@@ -6,6 +6,7 @@ import (
 	"io"
 
 	"github.com/sjzar/chatlog/internal/errors"
+	"github.com/sjzar/chatlog/internal/wechat/decrypt/common"
 	"github.com/sjzar/chatlog/internal/wechat/decrypt/darwin"
 	"github.com/sjzar/chatlog/internal/wechat/decrypt/windows"
 )
@@ -31,6 +32,18 @@ type Decryptor interface {
 	GetVersion() string
 }
 
+// IncrementalDecryptor 可以只重新解密变化页面的解密器，目前只有 V4 实现
+// 页面索引保存在 output + common.PageIndexSuffix，输出仍以临时文件改名的方式替换
+type IncrementalDecryptor interface {
+	DecryptIncremental(ctx context.Context, dbfile string, key string, output string) (common.IncrementalStats, error)
+}
+
+// MultiValidator 可以一次校验多个数据库的解密器
+// 按 salt 分组派生、组间并行，结果与逐个调用 Validate 相同
+type MultiValidator interface {
+	ValidatePages(ctx context.Context, pages [][]byte, key []byte) []bool
+}
+
 // NewDecryptor 创建一个新的解密器
 func NewDecryptor(platform string, version int) (Decryptor, error) {
 	log.Debug().Msgf("platform: %s %d ", platform, version)
@@ -67,8 +67,14 @@ func (d *V3Decryptor) Validate(page1 []byte, key []byte) bool {
 		return false
 	}
 
-	salt := page1[:common.SaltSize]
-	return common.ValidateKey(page1, key, salt, d.hashFunc, d.hmacSize, d.reserve, d.pageSize, d.deriveKeys)
+	_, _, ok := common.DeriveValidKeys("", page1, key, d.deriveKeys, d.hashFunc, d.hmacSize, d.reserve, d.pageSize)
+	return ok
+}
+
+// ValidatePages 用同一个密钥校验多个数据库的第一页，相同 salt 的文件只派生一次
+// Linux V3 的派生只有 2 轮，不使用派生密钥存储
+func (d *V3Decryptor) ValidatePages(ctx context.Context, pages [][]byte, key []byte) []bool {
+	return common.ValidatePages(ctx, "", pages, key, d.deriveKeys, d.hashFunc, d.hmacSize, d.reserve, d.pageSize, 0)
 }
 
 // Decrypt 解密数据库
@@ -85,14 +91,12 @@ func (d *V3Decryptor) Decrypt(ctx context.Context, dbfile string, hexKey string,
 		return err
 	}
 
-	// 验证密钥
-	if !d.Validate(dbInfo.FirstPage, key) {
+	// 计算并验证密钥
+	encKey, macKey, ok := common.DeriveValidKeys("", dbInfo.FirstPage, key, d.deriveKeys, d.hashFunc, d.hmacSize, d.reserve, d.pageSize)
+	if !ok {
 		return errors.ErrDecryptIncorrectKey
 	}
 
-	// 计算密钥
-	encKey, macKey := d.deriveKeys(key, dbInfo.Salt)
-
 	// 打开数据库文件
 	dbFile, err := os.Open(dbfile)
 	if err != nil {
@@ -69,8 +69,13 @@ func (d *V4Decryptor) Validate(page1 []byte, key []byte) bool {
 		return false
 	}
 
-	salt := page1[:common.SaltSize]
-	return common.ValidateKey(page1, key, salt, d.hashFunc, d.hmacSize, d.reserve, d.pageSize, d.deriveKeys)
+	_, _, ok := common.DeriveValidKeys(common.KDFV4, page1, key, d.deriveKeys, d.hashFunc, d.hmacSize, d.reserve, d.pageSize)
+	return ok
+}
+
+// ValidatePages 用同一个密钥校验多个数据库的第一页，相同 salt 的文件只派生一次
+func (d *V4Decryptor) ValidatePages(ctx context.Context, pages [][]byte, key []byte) []bool {
+	return common.ValidatePages(ctx, common.KDFV4, pages, key, d.deriveKeys, d.hashFunc, d.hmacSize, d.reserve, d.pageSize, 0)
 }
 
 // Decrypt 解密数据库
@@ -87,14 +92,12 @@ func (d *V4Decryptor) Decrypt(ctx context.Context, dbfile string, hexKey string,
 		return err
 	}
 
-	// 验证密钥
-	if !d.Validate(dbInfo.FirstPage, key) {
+	// 计算并验证密钥，同一个数据库只派生一次
+	encKey, macKey, ok := common.DeriveValidKeys(common.KDFV4, dbInfo.FirstPage, key, d.deriveKeys, d.hashFunc, d.hmacSize, d.reserve, d.pageSize)
+	if !ok {
 		return errors.ErrDecryptIncorrectKey
 	}
 
-	// 计算密钥
-	encKey, macKey := d.deriveKeys(key, dbInfo.Salt)
-
 	// 打开数据库文件
 	dbFile, err := os.Open(dbfile)
 	if err != nil {
@@ -102,6 +105,26 @@ func (d *V4Decryptor) Decrypt(ctx context.Context, dbfile string, hexKey string,
 	}
 	defer dbFile.Close()
 
+	// 输出是普通文件时按页并行解密，直接写到各页的偏移处
+	if out, ok := common.ParallelOutput(output); ok {
+		fileInfo, err := dbFile.Stat()
+		if err != nil {
+			return errors.StatFileFailed(dbfile, err)
+		}
+		// 末尾不足一页的部分与顺序解密一样忽略
+		fullPages := fileInfo.Size() / int64(d.pageSize)
+		if err := out.Truncate(fullPages * int64(d.pageSize)); err != nil {
+			return errors.WriteOutputFailed(err)
+		}
+		if err := common.DecryptPagesParallel(ctx, dbfile, dbFile, out, fullPages, encKey, macKey, d.hashFunc, d.hmacSize, d.reserve, d.pageSize, 0); err != nil {
+			return err
+		}
+		if _, err := out.Seek(0, io.SeekEnd); err != nil {
+			return errors.WriteOutputFailed(err)
+		}
+		return nil
+	}
+
 	// 写入SQLite头
 	_, err = output.Write([]byte(common.SQLiteHeader))
 	if err != nil {
@@ -166,6 +189,15 @@ func (d *V4Decryptor) Decrypt(ctx context.Context, dbfile string, hexKey string,
 	return nil
 }
 
+// DecryptIncremental 增量解密数据库到 output，只重新解密上次解密之后变化的页面
+func (d *V4Decryptor) DecryptIncremental(ctx context.Context, dbfile string, hexKey string, output string) (common.IncrementalStats, error) {
+	key, err := hex.DecodeString(hexKey)
+	if err != nil {
+		return common.IncrementalStats{}, errors.DecodeKeyFailed(err)
+	}
+	return common.DecryptIncremental(ctx, dbfile, key, output, common.KDFV4, d.deriveKeys, d.hashFunc, d.hmacSize, d.reserve, d.pageSize)
+}
+
 // GetPageSize 返回页面大小
 func (d *V4Decryptor) GetPageSize() int {
 	return d.pageSize
@@ -1,6 +1,7 @@
 package decrypt
 
 import (
+	"context"
 	"path/filepath"
 
 	"github.com/sjzar/chatlog/internal/wechat/decrypt/common"
@@ -44,6 +45,59 @@ func (v *Validator) Validate(key []byte) bool {
 	return v.decryptor.Validate(v.dbFile.FirstPage, key)
 }
 
+// FirstPage 返回用于验证的数据库第一页
+func (v *Validator) FirstPage() []byte {
+	return v.dbFile.FirstPage
+}
+
+// FileValidation 一个数据库文件的校验结果
+type FileValidation struct {
+	Path  string
+	Valid bool
+	Err   error // 文件无法读取或已经是明文（errors.ErrAlreadyDecrypted）时非空，此时 Valid 为 false
+}
+
+// ValidateFiles 用同一个密钥校验多个数据库文件
+// 一个账号下的几十个数据库各有自己的 salt，逐个调用 Validate 时每个文件都要跑一遍 PBKDF2；
+// 这里只读取各文件的第一页，交给 MultiValidator 按 salt 分组并行校验，
+// 校验通过的派生结果留在派生密钥存储中并落盘，随后解密这些文件时不再派生
+func ValidateFiles(ctx context.Context, platform string, version int, files []string, key []byte) ([]FileValidation, error) {
+	decryptor, err := NewDecryptor(platform, version)
+	if err != nil {
+		return nil, err
+	}
+
+	results := make([]FileValidation, len(files))
+	pages := make([][]byte, 0, len(files))
+	readable := make([]int, 0, len(files))
+	for i, file := range files {
+		results[i].Path = file
+		d, err := common.OpenDBFile(file, decryptor.GetPageSize())
+		if err != nil {
+			results[i].Err = err
+			continue
+		}
+		pages = append(pages, d.FirstPage)
+		readable = append(readable, i)
+	}
+
+	var valid []bool
+	if mv, ok := decryptor.(MultiValidator); ok {
+		valid = mv.ValidatePages(ctx, pages, key)
+	} else {
+		valid = make([]bool, len(pages))
+		for i, page := range pages {
+			valid[i] = decryptor.Validate(page, key)
+		}
+	}
+	for i, idx := range readable {
+		results[idx].Valid = valid[i]
+	}
+	// 所有组都校验完后一次性落盘
+	common.DefaultKeyStore.Flush()
+	return results, nil
+}
+
 func GetSimpleDBFile(platform string, version int) string {
 	switch {
 	case platform == "windows" && version == 3:
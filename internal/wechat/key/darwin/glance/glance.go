@@ -7,6 +7,7 @@ import (
 	"os"
 	"os/exec"
 	"path/filepath"
+	"strings"
 	"time"
 
 	"github.com/rs/zerolog/log"
@@ -119,3 +120,20 @@ func (g *Glance) Read() ([]byte, error) {
 
 	return g.data, nil
 }
+
+// Manifest 返回 Read 转储内容的区域清单，格式见 c_code/common/mem_image.h，
+// v4_testkey -i 据此把转储中的字节放回原来的地址扫描
+func (g *Glance) Manifest() string {
+	if g.data == nil || len(g.MemRegions) == 0 {
+		return ""
+	}
+	region := g.MemRegions[0]
+
+	// vmmap 的权限形如 "rw-/rwx"，只取当前权限
+	perms := strings.SplitN(region.Permissions, "/", 2)[0]
+	if len(perms) != 3 {
+		perms = "rw-"
+	}
+	return fmt.Sprintf("# chatlog dumpmemory, pid %d\n%x %x %x %sp %s\n",
+		g.PID, region.Start, region.Start+uint64(len(g.data)), 0, perms, region.RegionType)
+}
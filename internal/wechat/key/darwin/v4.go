@@ -12,6 +12,7 @@ import (
 	"github.com/sjzar/chatlog/internal/errors"
 	"github.com/sjzar/chatlog/internal/wechat/decrypt"
 	"github.com/sjzar/chatlog/internal/wechat/key/darwin/glance"
+	"github.com/sjzar/chatlog/internal/wechat/key/native"
 	"github.com/sjzar/chatlog/internal/wechat/model"
 )
 
@@ -54,6 +55,19 @@ func (e *V4Extractor) Extract(ctx context.Context, proc *model.Process) (string,
 		return "", errors.ErrValidatorNotSet
 	}
 
+	// 优先使用 libchatlogkey，失败时退回纯 Go 实现
+	if native.Available {
+		key, stats, err := native.Extract(ctx, int(proc.PID), e.validator.FirstPage())
+		if err == nil {
+			log.Debug().Object("stats", stats).Msg("Native engine found key")
+			return key, nil
+		}
+		if ctx.Err() != nil {
+			return "", ctx.Err()
+		}
+		log.Debug().Err(err).Object("stats", stats).Msg("Native key engine failed, falling back to Go implementation")
+	}
+
 	// Create context to control all goroutines
 	searchCtx, cancel := context.WithCancel(ctx)
 	defer cancel()
@@ -16,6 +16,7 @@ import (
 	"github.com/sjzar/chatlog/internal/errors"
 	"github.com/sjzar/chatlog/internal/wechat/decrypt"
 	linux_glance "github.com/sjzar/chatlog/internal/wechat/key/linux/glance"
+	"github.com/sjzar/chatlog/internal/wechat/key/native"
 	"github.com/sjzar/chatlog/internal/wechat/model"
 )
 
@@ -43,6 +44,19 @@ func (e *V4Extractor) Extract(ctx context.Context, proc *model.Process) (string,
 		return "", errors.ErrWeChatOffline
 	}
 
+	// 优先使用 libchatlogkey，失败时退回纯 Go 实现
+	if native.Available && e.validator != nil {
+		key, stats, err := native.Extract(ctx, int(proc.PID), e.validator.FirstPage())
+		if err == nil {
+			log.Debug().Object("stats", stats).Msg("Native engine found key")
+			return key, nil
+		}
+		if ctx.Err() != nil {
+			return "", ctx.Err()
+		}
+		log.Debug().Err(err).Object("stats", stats).Msg("Native key engine failed, falling back to Go implementation")
+	}
+
 	// 设置当前PID并初始化内存文件句柄
 	e.currentPID = uint32(proc.PID)
 	if err := e.initMemoryFile(); err != nil {
@@ -0,0 +1,56 @@
+// Package native 通过 cgo 调用 c_code/lib 下的 libchatlogkey 搜索 V4 密钥
+//
+// 默认不启用，需要先执行 c_code/lib/build.sh 编译静态库，再以
+// go build -tags chatlogkey 构建；未启用时 Available 为 false，
+// 各平台的 V4Extractor 继续使用纯 Go 实现。
+package native
+
+import (
+	"errors"
+	"time"
+
+	"github.com/rs/zerolog"
+)
+
+// ErrUnavailable 表示当前构建没有链接 libchatlogkey
+var ErrUnavailable = errors.New("native key engine not available")
+
+// ErrNotFound 表示扫描完所有区域也没有找到有效密钥
+var ErrNotFound = errors.New("no valid key found")
+
+// Stats 对应 chatlogkey_stats，字段含义与 testkey 工具 --stats 输出的 JSON 一致
+type Stats struct {
+	RegionsScanned    uint64
+	BytesScanned      uint64
+	CandidatesSeen    uint64 // 特征码命中后按偏移取出的候选
+	CandidatesPassed  uint64 // 通过预过滤、进入 PBKDF2 的候选
+	ScanNanos         uint64
+	RegionsUnreadable uint64 // 一个字节都没读到的区域
+	RegionsSkipped    uint64 // 找到密钥或被取消时还没有轮到的区域
+	BytesRead         uint64
+	ReadErrors        uint64
+	PatternHits       uint64
+	CandidatesCached  uint64
+	PBKDF2Calls       uint64
+	ScanCPUNanos      uint64
+	FirstKeyNanos     uint64 // 扫描开始到找到密钥，0 表示没有找到
+}
+
+// MarshalZerologObject 以结构化字段输出统计，用法：log.Debug().Object("stats", stats)
+func (s Stats) MarshalZerologObject(e *zerolog.Event) {
+	e.Uint64("regions_scanned", s.RegionsScanned).
+		Uint64("regions_unreadable", s.RegionsUnreadable).
+		Uint64("regions_skipped", s.RegionsSkipped).
+		Uint64("bytes_read", s.BytesRead).
+		Uint64("read_errors", s.ReadErrors).
+		Uint64("pattern_hits", s.PatternHits).
+		Uint64("candidates_seen", s.CandidatesSeen).
+		Uint64("candidates_passed", s.CandidatesPassed).
+		Uint64("candidates_cached", s.CandidatesCached).
+		Uint64("pbkdf2_calls", s.PBKDF2Calls).
+		Dur("scan", time.Duration(s.ScanNanos)).
+		Dur("scan_cpu", time.Duration(s.ScanCPUNanos))
+	if s.FirstKeyNanos > 0 {
+		e.Dur("first_key", time.Duration(s.FirstKeyNanos))
+	}
+}
@@ -0,0 +1,127 @@
+//go:build chatlogkey && cgo && (linux || darwin)
+
+package native
+
+/*
+#cgo CFLAGS: -I${SRCDIR}/../../../../c_code/lib
+#cgo LDFLAGS: ${SRCDIR}/../../../../c_code/lib/libchatlogkey.a -lpthread
+#include <stdlib.h>
+#include "chatlogkey.h"
+*/
+import "C"
+
+import (
+	"context"
+	"encoding/hex"
+	"fmt"
+	"unsafe"
+)
+
+// Available 表示当前构建是否链接了 libchatlogkey
+const Available = true
+
+func init() {
+	if v := int(C.chatlogkey_abi_version()); v != C.CHATLOGKEY_ABI_VERSION {
+		panic(fmt.Sprintf("libchatlogkey ABI version mismatch: library %d, header %d", v, C.CHATLOGKEY_ABI_VERSION))
+	}
+}
+
+func codeError(code C.int) error {
+	switch code {
+	case C.CHATLOGKEY_NOT_FOUND:
+		return ErrNotFound
+	case C.CHATLOGKEY_ECANCELED:
+		return context.Canceled
+	default:
+		return fmt.Errorf("libchatlogkey: %s", C.GoString(C.chatlogkey_strerror(code)))
+	}
+}
+
+// Extract 扫描目标进程内存，返回十六进制密钥
+// ctx 取消时通过 chatlogkey_cancel 中止扫描
+func Extract(ctx context.Context, pid int, firstPage []byte) (string, Stats, error) {
+	if len(firstPage) != C.CHATLOGKEY_PAGE_SIZE {
+		return "", Stats{}, fmt.Errorf("first page must be %d bytes, got %d", C.CHATLOGKEY_PAGE_SIZE, len(firstPage))
+	}
+
+	// 第一页在库内复制一份，调用返回后不再引用 Go 内存
+	var target *C.chatlogkey_target
+	page := (*C.uchar)(unsafe.Pointer(&firstPage[0]))
+	if code := C.chatlogkey_open(C.int32_t(pid), page, C.size_t(len(firstPage)), &target); code != C.CHATLOGKEY_OK {
+		return "", Stats{}, codeError(code)
+	}
+	defer C.chatlogkey_close(target)
+
+	done := make(chan struct{})
+	defer close(done)
+	go func() {
+		select {
+		case <-ctx.Done():
+			C.chatlogkey_cancel(target)
+		case <-done:
+		}
+	}()
+
+	key := (*C.uchar)(C.malloc(C.CHATLOGKEY_KEY_SIZE))
+	defer C.free(unsafe.Pointer(key))
+	code := C.chatlogkey_scan(target, nil, 0, 0, key)
+
+	var cs C.chatlogkey_stats
+	C.chatlogkey_get_stats(target, &cs, C.size_t(unsafe.Sizeof(cs)))
+	stats := Stats{
+		RegionsScanned:    uint64(cs.regions_scanned),
+		BytesScanned:      uint64(cs.bytes_scanned),
+		CandidatesSeen:    uint64(cs.candidates_seen),
+		CandidatesPassed:  uint64(cs.candidates_passed),
+		ScanNanos:         uint64(cs.scan_ns),
+		RegionsUnreadable: uint64(cs.regions_unreadable),
+		RegionsSkipped:    uint64(cs.regions_skipped),
+		BytesRead:         uint64(cs.bytes_read),
+		ReadErrors:        uint64(cs.read_errors),
+		PatternHits:       uint64(cs.pattern_hits),
+		CandidatesCached:  uint64(cs.candidates_cached),
+		PBKDF2Calls:       uint64(cs.pbkdf2_calls),
+		ScanCPUNanos:      uint64(cs.scan_cpu_ns),
+		FirstKeyNanos:     uint64(cs.first_key_ns),
+	}
+
+	if code != C.CHATLOGKEY_OK {
+		if code == C.CHATLOGKEY_ECANCELED && ctx.Err() != nil {
+			return "", stats, ctx.Err()
+		}
+		return "", stats, codeError(code)
+	}
+	return hex.EncodeToString(C.GoBytes(unsafe.Pointer(key), C.CHATLOGKEY_KEY_SIZE)), stats, nil
+}
+
+// Validate 批量校验候选密钥，每个候选 32 字节
+func Validate(firstPage []byte, keys [][]byte) ([]bool, error) {
+	if len(firstPage) != C.CHATLOGKEY_PAGE_SIZE {
+		return nil, fmt.Errorf("first page must be %d bytes, got %d", C.CHATLOGKEY_PAGE_SIZE, len(firstPage))
+	}
+	if len(keys) == 0 {
+		return nil, nil
+	}
+
+	packed := make([]byte, 0, len(keys)*C.CHATLOGKEY_KEY_SIZE)
+	for i, key := range keys {
+		if len(key) != C.CHATLOGKEY_KEY_SIZE {
+			return nil, fmt.Errorf("key %d must be %d bytes, got %d", i, C.CHATLOGKEY_KEY_SIZE, len(key))
+		}
+		packed = append(packed, key...)
+	}
+
+	// 参数中的 Go 内存只在调用期间使用，没有被 C 侧保存
+	results := make([]uint8, len(keys))
+	code := C.chatlogkey_validate((*C.uchar)(unsafe.Pointer(&firstPage[0])), C.size_t(len(firstPage)),
+		(*C.uchar)(unsafe.Pointer(&packed[0])), C.size_t(len(keys)), (*C.uint8_t)(unsafe.Pointer(&results[0])))
+	if code < 0 {
+		return nil, codeError(code)
+	}
+
+	valid := make([]bool, len(keys))
+	for i, r := range results {
+		valid[i] = r != 0
+	}
+	return valid, nil
+}
@@ -0,0 +1,16 @@
+//go:build !chatlogkey || !cgo || !(linux || darwin)
+
+package native
+
+import "context"
+
+// Available 表示当前构建是否链接了 libchatlogkey
+const Available = false
+
+func Extract(ctx context.Context, pid int, firstPage []byte) (string, Stats, error) {
+	return "", Stats{}, ErrUnavailable
+}
+
+func Validate(firstPage []byte, keys [][]byte) ([]bool, error) {
+	return nil, ErrUnavailable
+}